@@ -196,6 +196,9 @@ bbl_print_version (void)
         printf("  SHA: %s\n", GIT_SHA);
     }
     printf("IO Modes: packet_mmap_raw (default), packet_mmap, raw");
+#ifdef BNGBLASTER_AF_XDP
+    printf(", af_xdp");
+#endif
 #ifdef BNGBLASTER_DPDK
     printf(", dpdk");
 #endif
@@ -220,11 +223,175 @@ bbl_print_usage(void)
 void
 bbl_smear_job(timer_s *timer)
 {
+    bbl_session_shard_s *shard = &g_ctx->session_shard;
+
     UNUSED(timer);
     /* LCP Keepalive Interval */
     if(g_ctx->config.lcp_keepalive_interval) {
-        /* Adding 1 nanoseconds to enforce a dedicated timer bucket. */
-        timer_smear_bucket(&g_ctx->timer_root, g_ctx->config.lcp_keepalive_interval, 1);
+        while(shard) {
+            /* Adding 1 nanoseconds to enforce a dedicated timer bucket. */
+            bbl_session_worker_lock(shard->worker);
+            timer_smear_bucket(shard->timer_root, g_ctx->config.lcp_keepalive_interval, 1);
+            bbl_session_worker_unlock(shard->worker);
+            shard = shard->next;
+        }
+    }
+}
+
+/**
+ * bbl_pacing_update
+ *
+ * Update the session start rate once per second.
+ *
+ * With adaptive pacing enabled, the start rate is increased
+ * additive towards the configured start rate and decreased
+ * multiplicative if the BNG is slowing down, detected by
+ * retransmitted session requests or max outstanding sessions
+ * reached (AIMD).
+ */
+static void
+bbl_pacing_update()
+{
+    double target = g_ctx->config.sessions_start_rate;
+    double rate = g_ctx->stats.cps_target;
+    bbl_session_counters_s counters;
+    bbl_pacing_sample_s *sample;
+    uint64_t retries;
+    uint32_t started;
+
+    bbl_session_counters(&counters);
+    retries = counters.session_retries - g_ctx->pacing.retries;
+    started = counters.sessions_started - g_ctx->pacing.started;
+
+    g_ctx->stats.cps_current = counters.sessions_established_max - g_ctx->pacing.established;
+    g_ctx->pacing.established = counters.sessions_established_max;
+    g_ctx->pacing.retries = counters.session_retries;
+    g_ctx->pacing.started = counters.sessions_started;
+
+    if(!g_ctx->config.sessions_start_adaptive) {
+        rate = target;
+    } else if(rate == 0) {
+        /* Slow start */
+        rate = target * BBL_PACING_INCREASE;
+    } else if(retries > started * BBL_PACING_RETRY_THRESHOLD ||
+              counters.sessions_outstanding >= g_ctx->config.sessions_max_outstanding) {
+        rate *= BBL_PACING_DECREASE;
+    } else if(started) {
+        rate += target * BBL_PACING_INCREASE;
+    }
+    if(rate > target) rate = target;
+    if(rate < 1.0) rate = 1.0;
+    g_ctx->stats.cps_target = rate;
+
+    /* Record samples while sessions are started or established. */
+    if((started || g_ctx->stats.cps_current) && g_ctx->pacing.history_len < BBL_PACING_HISTORY) {
+        sample = &g_ctx->pacing.history[g_ctx->pacing.history_len++];
+        sample->target = rate;
+        sample->achieved = g_ctx->stats.cps_current;
+    }
+}
+
+/**
+ * bbl_session_start_job
+ *
+ * Start idle sessions of a shard evenly distributed
+ * over BBL_PACING_SLOTS slots per second as permitted
+ * by the current start rate and max outstanding.
+ * Both are divided between shards proportional to
+ * the number of sessions per shard.
+ */
+void
+bbl_session_start_job(timer_s *timer)
+{
+    bbl_session_shard_s *shard = timer->data;
+    bbl_session_counters_s *counters = &shard->counters;
+    bbl_session_s *session;
+    double share;
+    double credit;
+    uint32_t max_outstanding;
+
+    struct timespec timestamp;
+    struct timespec time_diff;
+
+    if(g_init_phase || g_teardown || g_ctx->stats.cps_target == 0 || !counters->sessions) {
+        return;
+    }
+    /* Wait N seconds (default 0) before we start to setup sessions. */
+    if(g_ctx->config.sessions_start_delay) {
+        clock_gettime(CLOCK_MONOTONIC, &timestamp);
+        timespec_sub(&time_diff, &timestamp, &g_ctx->timestamp_resolved);
+        if(time_diff.tv_sec < g_ctx->config.sessions_start_delay) {
+            return;
+        }
+    }
+
+    /* Fractional credits are carried over to the next slot
+     * but limited to one slot to prevent bursts. */
+    share = (double)counters->sessions / g_ctx->sessions;
+    credit = g_ctx->stats.cps_target * share / BBL_PACING_SLOTS;
+    shard->credit += credit;
+    if(shard->credit > credit + 1.0) {
+        shard->credit = credit + 1.0;
+    }
+    max_outstanding = g_ctx->config.sessions_max_outstanding * share;
+    if(max_outstanding < 1) max_outstanding = 1;
+
+    /* Iterate over all idle session (list of pending sessions)
+     * and start as much as permitted per slot based on max
+     * outstanding and setup rate. Sessions started will be removed
+     * from idle list. */
+    while(!CIRCLEQ_EMPTY(&shard->sessions_idle_qhead)) {
+        if(shard->credit < 1.0 ||
+           counters->sessions_outstanding >= max_outstanding) {
+            break;
+        }
+        session = CIRCLEQ_FIRST(&shard->sessions_idle_qhead);
+        shard->credit -= 1.0;
+        counters->sessions_started++;
+        counters->sessions_outstanding++;
+        session->setup_phases = 0;
+        bbl_session_setup_start(session, BBL_SETUP_SESSION);
+        /* Start session */
+        if(session->cfm_cc) {
+            bbl_cfm_cc_start(session);
+        }
+        switch(session->access_type) {
+            case ACCESS_TYPE_PPPOE:
+                /* PPP over Ethernet (PPPoE) */
+                session->session_state = BBL_PPPOE_INIT;
+                session->send_requests = BBL_SEND_DISCOVERY;
+                bbl_session_setup_start(session, BBL_SETUP_PPPOE_DISCOVERY);
+                break;
+            case ACCESS_TYPE_IPOE:
+                /* IP over Ethernet (IPoE) */
+                session->session_state = BBL_IPOE_SETUP;
+                session->send_requests = 0;
+                if(session->access_config->ipv4_enable) {
+                    if(session->dhcp_state > BBL_DHCP_DISABLED) {
+                        /* Start IPoE session by sending DHCP discovery if enabled. */
+                        bbl_dhcp_start(session);
+                    } else if(session->ip_address && session->peer_ip_address) {
+                        /* Start IPoE session by sending ARP request if local and
+                         * remote IP addresses are already provided. */
+                        session->send_requests |= BBL_SEND_ARP_REQUEST;
+                    }
+                }
+                if(session->access_config->ipv6_enable) {
+                    if(session->dhcpv6_state > BBL_DHCP_DISABLED) {
+                        /* Start IPoE session by sending DHCPv6 request if enabled. */
+                        bbl_dhcpv6_start(session);
+                    } else {
+                        /* Start IPoE session by sending RS. */
+                        session->send_requests |= BBL_SEND_ICMPV6_RS;
+                    }
+                }
+                break;
+        }
+        bbl_session_tx_qnode_insert(session);
+        /* Remove from idle queue */
+        CIRCLEQ_REMOVE(&shard->sessions_idle_qhead, session, session_idle_qnode);
+        CIRCLEQ_NEXT(session, session_idle_qnode) = NULL;
+        CIRCLEQ_PREV(session, session_idle_qnode) = NULL;
     }
 }
 
@@ -233,6 +400,8 @@ bbl_ctrl_job(timer_s *timer)
 {
     UNUSED(timer);
     bbl_session_s *session;
+    bbl_session_shard_s *shard;
+    bbl_session_counters_s counters;
     bbl_interface_s *interface;
     bbl_network_interface_s *network_interface;
 
@@ -270,18 +439,22 @@ bbl_ctrl_job(timer_s *timer)
     }
 
     if(g_teardown) {
-        if(g_ctx->l2tp_tunnels && g_ctx->sessions_terminated >= g_ctx->sessions) {
-            bbl_l2tp_stop_all_tunnel();
+        if(g_ctx->l2tp_tunnels) {
+            bbl_session_counters(&counters);
+            if(counters.sessions_terminated >= g_ctx->sessions) {
+                bbl_l2tp_stop_all_tunnel();
+            }
         }
         /* Teardown phase ... */
         if(g_teardown_request) {
-            /* Put all sessions on the teardown list. */
+            /* Put all sessions on the teardown list of their shard. */
             for(i = 0; i < g_ctx->sessions; i++) {
                 session = &g_ctx->session_list[i];
                 if(session) {
                     if(!CIRCLEQ_NEXT(session, session_teardown_qnode)) {
                         /* Add only if not already on teardown list. */
-                        CIRCLEQ_INSERT_TAIL(&g_ctx->sessions_teardown_qhead, session, session_teardown_qnode);
+                        shard = session->access_interface->shard;
+                        CIRCLEQ_INSERT_TAIL(&shard->sessions_teardown_qhead, session, session_teardown_qnode);
                     }
                 }
             }
@@ -292,20 +465,26 @@ bbl_ctrl_job(timer_s *timer)
             bgp_teardown();
             g_teardown_request = false;
         } else {
-            /* Process teardown list in chunks. */
+            /* Process teardown lists in chunks. */
             rate = g_ctx->config.sessions_stop_rate;
-            while(!CIRCLEQ_EMPTY(&g_ctx->sessions_teardown_qhead)) {
-                session = CIRCLEQ_FIRST(&g_ctx->sessions_teardown_qhead);
-                if(rate > 0) {
-                    if(session->session_state != BBL_IDLE) rate--;
-                    bbl_session_clear(session);
-                    /* Remove from teardown queue. */
-                    CIRCLEQ_REMOVE(&g_ctx->sessions_teardown_qhead, session, session_teardown_qnode);
-                    CIRCLEQ_NEXT(session, session_teardown_qnode) = NULL;
-                    CIRCLEQ_PREV(session, session_teardown_qnode) = NULL;
-                } else {
-                    break;
+            shard = &g_ctx->session_shard;
+            while(shard && rate > 0) {
+                bbl_session_worker_lock(shard->worker);
+                while(!CIRCLEQ_EMPTY(&shard->sessions_teardown_qhead)) {
+                    session = CIRCLEQ_FIRST(&shard->sessions_teardown_qhead);
+                    if(rate > 0) {
+                        if(session->session_state != BBL_IDLE) rate--;
+                        bbl_session_clear(session);
+                        /* Remove from teardown queue. */
+                        CIRCLEQ_REMOVE(&shard->sessions_teardown_qhead, session, session_teardown_qnode);
+                        CIRCLEQ_NEXT(session, session_teardown_qnode) = NULL;
+                        CIRCLEQ_PREV(session, session_teardown_qnode) = NULL;
+                    } else {
+                        break;
+                    }
                 }
+                bbl_session_worker_unlock(shard->worker);
+                shard = shard->next;
             }
         }
     } else {
@@ -317,64 +496,8 @@ bbl_ctrl_job(timer_s *timer)
                 return;
             }
         }
-        /* Iterate over all idle session (list of pending sessions)
-         * and start as much as permitted per interval based on max
-         * outstanding and setup rate. Sessions started will be removed
-         * from idle list. */
         bbl_stats_update_cps();
-        rate = g_ctx->config.sessions_start_rate;
-        while(!CIRCLEQ_EMPTY(&g_ctx->sessions_idle_qhead)) {
-            session = CIRCLEQ_FIRST(&g_ctx->sessions_idle_qhead);
-            if(rate > 0) {
-                if(g_ctx->sessions_outstanding < g_ctx->config.sessions_max_outstanding) {
-                    g_ctx->sessions_outstanding++;
-                    /* Start session */
-                    if(session->cfm_cc) {
-                        bbl_cfm_cc_start(session);
-                    }
-                    switch(session->access_type) {
-                        case ACCESS_TYPE_PPPOE:
-                            /* PPP over Ethernet (PPPoE) */
-                            session->session_state = BBL_PPPOE_INIT;
-                            session->send_requests = BBL_SEND_DISCOVERY;
-                            break;
-                        case ACCESS_TYPE_IPOE:
-                            /* IP over Ethernet (IPoE) */
-                            session->session_state = BBL_IPOE_SETUP;
-                            session->send_requests = 0;
-                            if(session->access_config->ipv4_enable) {
-                                if(session->dhcp_state > BBL_DHCP_DISABLED) {
-                                    /* Start IPoE session by sending DHCP discovery if enabled. */
-                                    bbl_dhcp_start(session);
-                                } else if(session->ip_address && session->peer_ip_address) {
-                                    /* Start IPoE session by sending ARP request if local and
-                                     * remote IP addresses are already provided. */
-                                    session->send_requests |= BBL_SEND_ARP_REQUEST;
-                                }
-                            }
-                            if(session->access_config->ipv6_enable) {
-                                if(session->dhcpv6_state > BBL_DHCP_DISABLED) {
-                                    /* Start IPoE session by sending DHCPv6 request if enabled. */
-                                    bbl_dhcpv6_start(session);
-                                } else {
-                                    /* Start IPoE session by sending RS. */
-                                    session->send_requests |= BBL_SEND_ICMPV6_RS;
-                                }
-                            }
-                            break;
-                    }
-                    bbl_session_tx_qnode_insert(session);
-                    /* Remove from idle queue */
-                    CIRCLEQ_REMOVE(&g_ctx->sessions_idle_qhead, session, session_idle_qnode);
-                    CIRCLEQ_NEXT(session, session_idle_qnode) = NULL;
-                    CIRCLEQ_PREV(session, session_idle_qnode) = NULL;
-                } else {
-                    break;
-                }
-            } else {
-                break;
-            }
-        }
+        bbl_pacing_update();
     }
 }
 
@@ -392,6 +515,8 @@ main(int argc, char *argv[])
     int ch = 0;
     uint32_t ipv4;
     bbl_stats_s stats = {0};
+    bbl_session_shard_s *shard;
+    bbl_session_counters_s counters;
     int exit_status = 1;
 
     const char *config_file = NULL;
@@ -503,6 +628,9 @@ main(int argc, char *argv[])
     /* Open logfile. */
     log_open();
 
+    /* Select checksum kernel. */
+    LOG(INFO, "Using %s checksum kernel\n", bbl_checksum_init());
+
     /* Init config. */
     bbl_config_init_defaults();
     if(!bbl_config_load_json(config_file)) {
@@ -566,6 +694,16 @@ main(int argc, char *argv[])
         goto CLEANUP;
     }
 
+    /* Init session workers. */
+    if(g_ctx->config.sessions_worker_threads && interactive) {
+        fprintf(stderr, "Error: Session worker threads not supported in interactive mode\n");
+        goto CLEANUP;
+    }
+    if(!bbl_session_worker_init()) {
+        fprintf(stderr, "Error: Failed to init session workers\n");
+        goto CLEANUP;
+    }
+
     /* Init BGP sessions. */
     if(!bgp_init()) {
         fprintf(stderr, "Error: Failed to init BGP\n");
@@ -594,6 +732,14 @@ main(int argc, char *argv[])
     timer_add_periodic(&g_ctx->timer_root, &g_ctx->control_timer, "Control Timer", 
                        1, 0, g_ctx, &bbl_ctrl_job);
 
+    /* Setup session start job per shard. */
+    shard = &g_ctx->session_shard;
+    while(shard) {
+        timer_add_periodic(shard->timer_root, &shard->start_timer, "Session Start", 
+                           0, SEC / BBL_PACING_SLOTS, shard, &bbl_session_start_job);
+        shard = shard->next;
+    }
+
     /* Setup control socket and job */
     if(g_ctx->ctrl_socket_path) {
         if(!bbl_ctrl_socket_init()) {
@@ -619,6 +765,7 @@ main(int argc, char *argv[])
 
     /* Start threads. */
     io_thread_start_all();
+    bbl_session_worker_start_all();
 
     /* Smear all buckets. */
     timer_smear_all_buckets(&g_ctx->timer_root);
@@ -641,7 +788,8 @@ main(int argc, char *argv[])
                 if(g_ctx->sessions) {
                     /* With sessions, wait for all sessions
                      * to be terminated. */
-                    if(g_ctx->sessions_terminated >= g_ctx->sessions) {
+                    bbl_session_counters(&counters);
+                    if(counters.sessions_terminated >= g_ctx->sessions) {
                         break;
                     }
                 } else {
@@ -657,6 +805,7 @@ main(int argc, char *argv[])
     clock_gettime(CLOCK_MONOTONIC, &g_ctx->timestamp_stop);
 
     /* Stop threads. */
+    bbl_session_worker_stop_all();
     io_thread_stop_all();
 
     /* Stop curses. Do this before the final reports. */
@@ -39,6 +39,7 @@
 #include "bbl_l2tp.h"
 #include "bbl_igmp.h"
 #include "bbl_session.h"
+#include "bbl_session_worker.h"
 #include "bbl_ctx.h"
 #include "bbl_txq.h"
 #include "bbl_interface.h"
@@ -51,6 +52,7 @@
 #include "bbl_tcp.h"
 #include "bbl_http_client.h"
 #include "bbl_http_server.h"
+#include "bbl_mrt.h"
 
 #include "io/io.h"
 #include "bgp/bgp.h"
@@ -64,6 +64,7 @@ bbl_access_interfaces_add()
             access_interface->name = access_config->interface;
             access_interface->interface = interface;
             access_interface->ifindex = interface->ifindex;
+            access_interface->shard = &g_ctx->session_shard;
             
             /* Init TXQ */
             access_interface->txq = calloc(1, sizeof(bbl_txq_s));
@@ -383,6 +384,9 @@ bbl_access_igmp_initial_join(timer_s *timer)
     }
     initial_group = htobe32(be32toh(g_ctx->config.igmp_group) + (group_start_index * be32toh(g_ctx->config.igmp_group_iter)));
 
+    if(!bbl_igmp_groups_init(session)) {
+        return;
+    }
     group = &session->igmp_groups[0];
     memset(group, 0x0, sizeof(bbl_igmp_group_s));
     group->group = initial_group;
@@ -412,11 +416,11 @@ bbl_access_igmp_initial_join(timer_s *timer)
         }
 
         /* Adding 2 nanoseconds to enforce a dedicated timer bucket for zapping. */
-        timer_add_periodic(&g_ctx->timer_root, &session->timer_zapping, "IGMP Zapping", g_ctx->config.igmp_zap_interval, 2, session, &bbl_access_igmp_zapping);
+        timer_add_periodic(session->access_interface->shard->timer_root, &session->timer_zapping, "IGMP Zapping", g_ctx->config.igmp_zap_interval, 2, session, &bbl_access_igmp_zapping);
         LOG(IGMP, "IGMP (ID: %u) ZAPPING start zapping with interval %u\n",
             session->session_id, g_ctx->config.igmp_zap_interval);
 
-        timer_smear_bucket(&g_ctx->timer_root, g_ctx->config.igmp_zap_interval, 2);
+        timer_smear_bucket(session->access_interface->shard->timer_root, g_ctx->config.igmp_zap_interval, 2);
     }
 }
 
@@ -483,15 +487,16 @@ bbl_access_rx_established_ipoe(bbl_access_interface_s *interface,
 
     if(ipv4 && ipv6) {
         if(session->session_state != BBL_ESTABLISHED) {
-            if(g_ctx->sessions_established_max < g_ctx->sessions) {
-                g_ctx->stats.last_session_established.tv_sec = eth->timestamp.tv_sec;
-                g_ctx->stats.last_session_established.tv_nsec = eth->timestamp.tv_nsec;
+            bbl_session_counters_s *counters = &session->access_interface->shard->counters;
+            if(counters->sessions_established_max < counters->sessions) {
+                counters->last_session_established.tv_sec = eth->timestamp.tv_sec;
+                counters->last_session_established.tv_nsec = eth->timestamp.tv_nsec;
             }
             bbl_session_update_state(session, BBL_ESTABLISHED);
             if(session->access_config->ipv4_enable) {
                 if(g_ctx->config.igmp_group && g_ctx->config.igmp_autostart && g_ctx->config.igmp_start_delay) {
                     /* Start IGMP */
-                    timer_add(&g_ctx->timer_root, &session->timer_igmp, "IGMP", g_ctx->config.igmp_start_delay, 0, session, &bbl_access_igmp_initial_join);
+                    timer_add(session->access_interface->shard->timer_root, &session->timer_igmp, "IGMP", g_ctx->config.igmp_start_delay, 0, session, &bbl_access_igmp_initial_join);
                 }
             }
         }
@@ -579,7 +584,7 @@ bbl_access_rx_ipv4_mc(bbl_access_interface_s *interface,
     uint64_t loss;
     int i;
 
-    for(i=0; i < IGMP_MAX_GROUPS; i++) {
+    for(i=0; session->igmp_groups && i < IGMP_MAX_GROUPS; i++) {
         group = &session->igmp_groups[i];
         if(ipv4->dst == group->group) {
             group->packets++;
@@ -781,6 +786,7 @@ bbl_access_rx_chap(bbl_access_interface_s *interface,
     bbl_chap_s *chap;
 
     MD5_CTX md5_ctx;
+    const char *password;
 
     char substring[16];
     char *tok;
@@ -809,7 +815,8 @@ bbl_access_rx_chap(bbl_access_interface_s *interface,
                 } else {
                     MD5_Init(&md5_ctx);
                     MD5_Update(&md5_ctx, &chap->identifier, 1);
-                    MD5_Update(&md5_ctx, session->password, strlen(session->password));
+                    password = bbl_session_string(session, BBL_SESSION_PASSWORD);
+                    MD5_Update(&md5_ctx, password, strlen(password));
                     MD5_Update(&md5_ctx, chap->challenge, chap->challenge_len);
                     MD5_Final(session->chap_response, &md5_ctx);
                     session->chap_identifier = chap->identifier;
@@ -949,18 +956,19 @@ bbl_access_rx_established_pppoe(bbl_access_interface_s *interface,
 
     if(ipcp && ip6cp) {
         if(session->session_state != BBL_ESTABLISHED) {
-            if(g_ctx->sessions_established_max < g_ctx->sessions) {
-                g_ctx->stats.last_session_established.tv_sec = eth->timestamp.tv_sec;
-                g_ctx->stats.last_session_established.tv_nsec = eth->timestamp.tv_nsec;
+            bbl_session_counters_s *counters = &session->access_interface->shard->counters;
+            if(counters->sessions_established_max < counters->sessions) {
+                counters->last_session_established.tv_sec = eth->timestamp.tv_sec;
+                counters->last_session_established.tv_nsec = eth->timestamp.tv_nsec;
             }
             bbl_session_update_state(session, BBL_ESTABLISHED);
             if(g_ctx->config.lcp_keepalive_interval) {
                 /* Start LCP echo request / keep alive */
-                timer_add_periodic(&g_ctx->timer_root, &session->timer_lcp_echo, "LCP ECHO", g_ctx->config.lcp_keepalive_interval, 1, session, &bbl_access_lcp_echo);
+                timer_add_periodic(session->access_interface->shard->timer_root, &session->timer_lcp_echo, "LCP ECHO", g_ctx->config.lcp_keepalive_interval, 1, session, &bbl_access_lcp_echo);
             }
             if(g_ctx->config.pppoe_session_time) {
                 /* Start Session Timer */
-                timer_add(&g_ctx->timer_root, &session->timer_session, "Session", g_ctx->config.pppoe_session_time, 0, session, &bbl_access_session_timeout);
+                timer_add(session->access_interface->shard->timer_root, &session->timer_session, "Session", g_ctx->config.pppoe_session_time, 0, session, &bbl_access_session_timeout);
             }
             if(session->ipcp_state == BBL_PPP_OPENED) {
                 if(session->l2tp == false && !session->a10nsp_session &&
@@ -968,7 +976,7 @@ bbl_access_rx_established_pppoe(bbl_access_interface_s *interface,
                    g_ctx->config.igmp_autostart && 
                    g_ctx->config.igmp_start_delay) {
                     /* Start IGMP */
-                    timer_add(&g_ctx->timer_root, &session->timer_igmp, "IGMP", g_ctx->config.igmp_start_delay, 0, session, &bbl_access_igmp_initial_join);
+                    timer_add(session->access_interface->shard->timer_root, &session->timer_igmp, "IGMP", g_ctx->config.igmp_start_delay, 0, session, &bbl_access_igmp_initial_join);
                 }
             }
         }
@@ -1019,6 +1027,7 @@ bbl_access_rx_ip6cp(bbl_access_interface_s *interface,
                     break;
                 case BBL_PPP_LOCAL_ACK:
                     session->ip6cp_state = BBL_PPP_OPENED;
+                    bbl_session_setup_done(session, BBL_SETUP_IP6CP);
                     bbl_access_rx_established_pppoe(interface, session, eth);
                     session->link_local_ipv6_address[0] = 0xfe;
                     session->link_local_ipv6_address[1] = 0x80;
@@ -1053,6 +1062,7 @@ bbl_access_rx_ip6cp(bbl_access_interface_s *interface,
                     break;
                 case BBL_PPP_PEER_ACK:
                     session->ip6cp_state = BBL_PPP_OPENED;
+                    bbl_session_setup_done(session, BBL_SETUP_IP6CP);
                     bbl_access_rx_established_pppoe(interface, session, eth);
                     session->link_local_ipv6_address[0] = 0xfe;
                     session->link_local_ipv6_address[1] = 0x80;
@@ -1125,6 +1135,7 @@ bbl_access_rx_ipcp(bbl_access_interface_s *interface,
                     break;
                 case BBL_PPP_LOCAL_ACK:
                     session->ipcp_state = BBL_PPP_OPENED;
+                    bbl_session_setup_done(session, BBL_SETUP_IPCP);
                     bbl_access_rx_established_pppoe(interface, session, eth);
                     ACTIVATE_ENDPOINT(session->endpoint.ipv4);
                     LOG(IP, "IPv4 (ID: %u) address %s\n", session->session_id, 
@@ -1183,6 +1194,7 @@ bbl_access_rx_ipcp(bbl_access_interface_s *interface,
                     break;
                 case BBL_PPP_PEER_ACK:
                     session->ipcp_state = BBL_PPP_OPENED;
+                    bbl_session_setup_done(session, BBL_SETUP_IPCP);
                     bbl_access_rx_established_pppoe(interface, session, eth);
                     ACTIVATE_ENDPOINT(session->endpoint.ipv4);
                     LOG(IP, "IPv4 (ID: %u) address %s\n", session->session_id,
@@ -1601,7 +1613,7 @@ bbl_access_rx_discovery(bbl_access_interface_s *interface,
                     session->lcp_request_code = PPP_CODE_CONF_REQUEST;
                     session->lcp_state = BBL_PPP_INIT;
                     if(g_ctx->config.lcp_start_delay) {
-                        timer_add(&g_ctx->timer_root, &session->timer_lcp, "LCP timeout",
+                        timer_add(session->access_interface->shard->timer_root, &session->timer_lcp, "LCP timeout",
                                   0, g_ctx->config.lcp_start_delay * MSEC, session, &bbl_access_lcp_start_delay);
                     } else {
                         session->send_requests = BBL_SEND_LCP_REQUEST;
@@ -1644,7 +1656,7 @@ bbl_access_rx_arp(bbl_access_interface_s *interface,
                 memcpy(session->server_mac, arp->sender, ETH_ADDR_LEN);
                 bbl_access_rx_established_ipoe(interface, session, eth);
                 if(g_ctx->config.arp_interval) {
-                    timer_add(&g_ctx->timer_root, &session->timer_arp, "ARP timeout", g_ctx->config.arp_interval, 0, session, &bbl_arp_timeout);
+                    timer_add(session->access_interface->shard->timer_root, &session->timer_arp, "ARP timeout", g_ctx->config.arp_interval, 0, session, &bbl_arp_timeout);
                 } else {
                     timer_del(session->timer_arp);
                 }
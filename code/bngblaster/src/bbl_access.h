@@ -18,6 +18,9 @@ typedef struct bbl_access_interface_
     /* parent */
     bbl_interface_s *interface; 
 
+    /* session shard processing this interface */
+    bbl_session_shard_s *shard;
+
     bbl_txq_s *txq;
 
     uint8_t mac[ETH_ADDR_LEN];
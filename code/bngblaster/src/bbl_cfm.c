@@ -22,7 +22,7 @@ void
 bbl_cfm_cc_start(bbl_session_s *session)
 {
     /* Start CFM CC (currently fixed set to 1s) */
-    timer_add_periodic(&g_ctx->timer_root, &session->timer_cfm_cc, "CFM-CC", 
+    timer_add_periodic(session->access_interface->shard->timer_root, &session->timer_cfm_cc, "CFM-CC", 
                        1, 0, session, &bbl_cfm_cc_job);
 }
 
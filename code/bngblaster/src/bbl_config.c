@@ -461,6 +461,11 @@ link_add(char *interface_name)
     link_config->io_mode = g_ctx->config.io_mode;
     link_config->io_slots_rx = g_ctx->config.io_slots;
     link_config->io_slots_tx = g_ctx->config.io_slots;
+    link_config->io_rx_tpacket_v3 = g_ctx->config.io_rx_tpacket_v3;
+    link_config->io_rx_block_timeout = g_ctx->config.io_rx_block_timeout;
+    link_config->io_timestamping = g_ctx->config.io_timestamping;
+    link_config->io_event_loop = g_ctx->config.io_event_loop;
+    link_config->io_busy_poll = g_ctx->config.io_busy_poll;
     link_config->qdisc_bypass = g_ctx->config.qdisc_bypass;
     link_config->tx_interval = g_ctx->config.tx_interval;
     link_config->rx_interval = g_ctx->config.rx_interval;
@@ -480,10 +485,11 @@ json_parse_link(json_t *link, bbl_link_config_s *link_config)
     const char *schema[] = {
         "interface", "description", "mac",
         "io-mode", "io-slots", "io-slots-tx",
-        "io-slots-rx", "qdisc-bypass", "tx-interval",
-        "rx-interval", "tx-threads", "rx-threads",
-        "rx-cpuset", "tx-cpuset", "lag-interface",
-        "lacp-priority"
+        "io-slots-rx", "io-rx-tpacket-v3", "io-rx-block-timeout",
+        "io-timestamping", "io-event-loop", "io-busy-poll",
+        "qdisc-bypass", "tx-interval", "rx-interval",
+        "tx-threads", "rx-threads", "rx-cpuset",
+        "tx-cpuset", "lag-interface", "lacp-priority"
     };
     if(!schema_validate(link, "links", schema, 
     sizeof(schema)/sizeof(schema[0]))) {
@@ -525,6 +531,11 @@ json_parse_link(json_t *link, bbl_link_config_s *link_config)
             io_packet_mmap_set_max_stream_len();
         } else if(strcmp(s, "raw") == 0) {
             link_config->io_mode = IO_MODE_RAW;
+#if BNGBLASTER_AF_XDP
+        } else if(strcmp(s, "af_xdp") == 0) {
+            link_config->io_mode = IO_MODE_AF_XDP;
+            io_af_xdp_set_max_stream_len();
+#endif
 #if BNGBLASTER_DPDK
         } else if(strcmp(s, "dpdk") == 0) {
             link_config->io_mode = IO_MODE_DPDK;
@@ -554,6 +565,47 @@ json_parse_link(json_t *link, bbl_link_config_s *link_config)
         link_config->io_slots_rx = json_number_value(value);
     }
 
+    JSON_OBJ_GET_BOOL(link, value, "links", "io-rx-tpacket-v3");
+    if(value) {
+        link_config->io_rx_tpacket_v3 = json_boolean_value(value);
+    } else {
+        link_config->io_rx_tpacket_v3 = g_ctx->config.io_rx_tpacket_v3;
+    }
+    JSON_OBJ_GET_NUMBER(link, value, "links", "io-rx-block-timeout", 0, 1000);
+    if(value) {
+        link_config->io_rx_block_timeout = json_number_value(value);
+    } else {
+        link_config->io_rx_block_timeout = g_ctx->config.io_rx_block_timeout;
+    }
+    if(json_unpack(link, "{s:s}", "io-timestamping", &s) == 0) {
+        if(strcmp(s, "timer") == 0) {
+            link_config->io_timestamping = IO_TIMESTAMP_TIMER;
+        } else if(strcmp(s, "user") == 0) {
+            link_config->io_timestamping = IO_TIMESTAMP_USER;
+        } else if(strcmp(s, "kernel") == 0) {
+            link_config->io_timestamping = IO_TIMESTAMP_KERNEL;
+        } else if(strcmp(s, "hardware") == 0) {
+            link_config->io_timestamping = IO_TIMESTAMP_HARDWARE;
+        } else {
+            fprintf(stderr, "JSON config error: Invalid value for links->io-timestamping\n");
+            return false;
+        }
+    } else {
+        link_config->io_timestamping = g_ctx->config.io_timestamping;
+    }
+    JSON_OBJ_GET_BOOL(link, value, "links", "io-event-loop");
+    if(value) {
+        link_config->io_event_loop = json_boolean_value(value);
+    } else {
+        link_config->io_event_loop = g_ctx->config.io_event_loop;
+    }
+    JSON_OBJ_GET_NUMBER(link, value, "links", "io-busy-poll", 0, 10000);
+    if(value) {
+        link_config->io_busy_poll = json_number_value(value);
+    } else {
+        link_config->io_busy_poll = g_ctx->config.io_busy_poll;
+    }
+
     JSON_OBJ_GET_BOOL(link, value, "links", "qdisc-bypass");
     if(value) {
         link_config->qdisc_bypass = json_boolean_value(value);
@@ -2756,9 +2808,9 @@ json_parse_config(json_t *root)
     if(json_is_object(section)) {
 
         const char *sessions_schema[] = {
-            "count", "max-outstanding", "start-rate", "stop-rate", 
-            "iterate-vlan-outer", "start-delay", "autostart", 
-            "reconnect", "monkey-autostart"
+            "count", "max-outstanding", "start-rate", "start-rate-adaptive",
+            "stop-rate", "iterate-vlan-outer", "start-delay", "autostart", 
+            "reconnect", "monkey-autostart", "worker-threads"
         };
         if(!schema_validate(section, "sessions", sessions_schema, 
            sizeof(sessions_schema)/sizeof(sessions_schema[0]))) {
@@ -2776,6 +2828,14 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.sessions_start_rate = json_number_value(value);
         }
+        JSON_OBJ_GET_BOOL(section, value, "sessions", "start-rate-adaptive");
+        if(value) {
+            g_ctx->config.sessions_start_adaptive = json_boolean_value(value);
+        }
+        JSON_OBJ_GET_BOOL(section, value, "sessions", "worker-threads");
+        if(value) {
+            g_ctx->config.sessions_worker_threads = json_boolean_value(value);
+        }
         JSON_OBJ_GET_NUMBER(section, value, "sessions", "stop-rate", 1, 65535);
         if(value) {
             g_ctx->config.sessions_stop_rate = json_number_value(value);
@@ -3571,7 +3631,9 @@ json_parse_config(json_t *root)
     if(json_is_object(section)) {
 
         const char *schema[] = {
-            "io-mode", "io-slots", "qdisc-bypass",
+            "io-mode", "io-slots", "io-rx-tpacket-v3",
+            "io-rx-block-timeout", "io-timestamping", "io-event-loop",
+            "io-busy-poll", "qdisc-bypass",
             "tx-interval", "rx-interval", "tx-threads",
             "rx-threads", "capture-include-streams", "mac-modifier",
             "lag", "network", "access", "a10nsp", "links"
@@ -3590,6 +3652,11 @@ json_parse_config(json_t *root)
                 io_packet_mmap_set_max_stream_len();
             } else if(strcmp(s, "raw") == 0) {
                 g_ctx->config.io_mode = IO_MODE_RAW;
+#if BNGBLASTER_AF_XDP
+            } else if(strcmp(s, "af_xdp") == 0) {
+                g_ctx->config.io_mode = IO_MODE_AF_XDP;
+                io_af_xdp_set_max_stream_len();
+#endif
 #if BNGBLASTER_DPDK
             } else if(strcmp(s, "dpdk") == 0) {
                 g_ctx->config.io_mode = IO_MODE_DPDK;
@@ -3608,6 +3675,36 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.io_slots = json_number_value(value);
         }
+        JSON_OBJ_GET_BOOL(section, value, "interfaces", "io-rx-tpacket-v3");
+        if(value) {
+            g_ctx->config.io_rx_tpacket_v3 = json_boolean_value(value);
+        }
+        JSON_OBJ_GET_NUMBER(section, value, "interfaces", "io-rx-block-timeout", 0, 1000);
+        if(value) {
+            g_ctx->config.io_rx_block_timeout = json_number_value(value);
+        }
+        if(json_unpack(section, "{s:s}", "io-timestamping", &s) == 0) {
+            if(strcmp(s, "timer") == 0) {
+                g_ctx->config.io_timestamping = IO_TIMESTAMP_TIMER;
+            } else if(strcmp(s, "user") == 0) {
+                g_ctx->config.io_timestamping = IO_TIMESTAMP_USER;
+            } else if(strcmp(s, "kernel") == 0) {
+                g_ctx->config.io_timestamping = IO_TIMESTAMP_KERNEL;
+            } else if(strcmp(s, "hardware") == 0) {
+                g_ctx->config.io_timestamping = IO_TIMESTAMP_HARDWARE;
+            } else {
+                fprintf(stderr, "JSON config error: Invalid value for interfaces->io-timestamping\n");
+                return false;
+            }
+        }
+        JSON_OBJ_GET_BOOL(section, value, "interfaces", "io-event-loop");
+        if(value) {
+            g_ctx->config.io_event_loop = json_boolean_value(value);
+        }
+        JSON_OBJ_GET_NUMBER(section, value, "interfaces", "io-busy-poll", 0, 10000);
+        if(value) {
+            g_ctx->config.io_busy_poll = json_number_value(value);
+        }
         JSON_OBJ_GET_BOOL(section, value, "interfaces", "qdisc-bypass");
         if(value) {
             g_ctx->config.qdisc_bypass = json_boolean_value(value);
@@ -4045,6 +4142,7 @@ bbl_config_init_defaults()
     g_ctx->config.rx_interval = 1 * MSEC;
     g_ctx->config.io_slots = 4096;
     g_ctx->config.io_max_stream_len = 9000;
+    g_ctx->config.io_rx_block_timeout = 1;
     g_ctx->config.qdisc_bypass = true;
     g_ctx->config.sessions = 1;
     g_ctx->config.sessions_max_outstanding = 800;
@@ -26,6 +26,8 @@ typedef struct bbl_access_config_
     uint16_t session_group_id;
     uint16_t http_client_group_id;
 
+    bbl_setup_latency_s setup_latency[BBL_SETUP_MAX];
+
     uint16_t access_outer_vlan;
     uint16_t access_outer_vlan_min;
     uint16_t access_outer_vlan_max;
@@ -150,6 +152,13 @@ typedef struct bbl_link_config_
     uint16_t io_slots_tx;
     uint16_t io_slots_rx;
 
+    bool io_rx_tpacket_v3;
+    uint16_t io_rx_block_timeout; /* TPACKET_V3 block retire timeout in msec */
+    io_timestamp_t io_timestamping;
+
+    bool io_event_loop;
+    uint16_t io_busy_poll; /* busy poll time in usec */
+
     bool qdisc_bypass;
 
     uint64_t tx_interval; /* TX interval in nsec */
@@ -17,6 +17,10 @@
 #include <signal.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <ctype.h>
 
 #include "bbl.h"
 #include "bbl_ctrl.h"
@@ -25,8 +29,6 @@
 #include "bbl_dhcp.h"
 #include "bbl_dhcpv6.h"
 
-#define BACKLOG 4
-
 extern volatile bool g_teardown;
 extern volatile bool g_teardown_request;
 extern volatile uint8_t g_teardown_request_count;
@@ -161,115 +163,204 @@ struct action {
     char *name;
     callback_function *fn;
     bool thread_safe;
+    bool sessions; /* access state owned by session workers */
 };
 
 struct action actions[] = {
-    {"interfaces", bbl_interface_ctrl, true},
-    {"access-interfaces", bbl_access_ctrl_interfaces, true},
-    {"network-interfaces", bbl_network_ctrl_interfaces, true},
-    {"a10nsp-interfaces", bbl_a10nsp_ctrl_interfaces, true},
-    {"interface-enable", bbl_interface_ctrl_enable, false},
-    {"interface-disable", bbl_interface_ctrl_disable, false},
-    {"terminate", bbl_ctrl_terminate, false},
-    {"sessions-pending", bbl_session_ctrl_pending, true},
-    {"session-counters", bbl_session_ctrl_counters, true},
-    {"session-info", bbl_session_ctrl_info, true},
-    {"session-start", bbl_session_ctrl_start, true},
-    {"session-stop", bbl_session_ctrl_stop, true},
-    {"session-restart", bbl_session_ctrl_restart, true},
-    {"session-traffic", bbl_session_ctrl_traffic_stats, true},
-    {"session-traffic-enabled", bbl_session_ctrl_traffic_start, false},
-    {"session-traffic-start", bbl_session_ctrl_traffic_start, false},
-    {"session-traffic-disabled", bbl_session_ctrl_traffic_stop, false},
-    {"session-traffic-stop", bbl_session_ctrl_traffic_stop, false},
-    {"session-traffic-reset", bbl_session_ctrl_traffic_reset, false},
-    {"session-streams", bbl_stream_ctrl_session, true},
-    {"stream-traffic-enabled", bbl_stream_ctrl_traffic_start, false},
-    {"stream-traffic-start", bbl_stream_ctrl_traffic_start, false},
-    {"stream-traffic-disabled", bbl_stream_ctrl_traffic_stop, false},
-    {"stream-traffic-stop", bbl_stream_ctrl_traffic_stop, false},
-    {"stream-info", bbl_stream_ctrl_info, true},
-    {"stream-summary", bbl_stream_ctrl_summary, true},
-    {"stream-stats", bbl_stream_ctrl_stats, true},
-    {"stream-reset", bbl_stream_ctrl_reset, false},
-    {"stream-start", bbl_stream_ctrl_start, false},
-    {"stream-stop", bbl_stream_ctrl_stop, false},
-    {"streams-pending", bbl_stream_ctrl_pending, true},
-    {"multicast-traffic-start", bbl_ctrl_multicast_traffic_start, false},
-    {"multicast-traffic-stop", bbl_ctrl_multicast_traffic_stop, false},
-    {"igmp-join", bbl_igmp_ctrl_join, false},
-    {"igmp-join-iter", bbl_igmp_ctrl_join_iter, false},
-    {"igmp-leave", bbl_igmp_ctrl_leave, false},
-    {"igmp-leave-all", bbl_igmp_ctrl_leave_all, false},
-    {"igmp-info", bbl_igmp_ctrl_info, true},
-    {"zapping-start", bbl_igmp_ctrl_zapping_start, true},
-    {"zapping-stop", bbl_igmp_ctrl_zapping_stop, false},
-    {"zapping-stats", bbl_igmp_ctrl_zapping_stats, true},
-    {"li-flows", bbl_li_ctrl_flows, true},
-    {"l2tp-tunnels", bbl_l2tp_ctrl_tunnels, true},
-    {"l2tp-sessions", bbl_l2tp_ctrl_sessions, true},
-    {"l2tp-csurq", bbl_l2tp_ctrl_csurq, false},
-    {"l2tp-tunnel-terminate", bbl_l2tp_ctrl_tunnel_terminate, false},
-    {"l2tp-session-terminate", bbl_l2tp_ctrl_session_terminate, false},
-    {"ipcp-open", bbl_session_ctrl_ipcp_open, false},
-    {"ipcp-close", bbl_session_ctrl_ipcp_close, false},
-    {"ip6cp-open", bbl_session_ctrl_ip6cp_open, false},
-    {"ip6cp-close", bbl_session_ctrl_ip6cp_close, false},
-    {"cfm-cc-start", bbl_cfm_ctrl_cc_start, false},
-    {"cfm-cc-stop", bbl_cfm_ctrl_cc_stop, false},
-    {"cfm-cc-rdi-on", bbl_cfm_ctrl_cc_rdi_on, false},
-    {"cfm-cc-rdi-off", bbl_cfm_ctrl_cc_rdi_off, false},
-    {"traffic-start", bbl_ctrl_traffic_start, false},
-    {"traffic-stop", bbl_ctrl_traffic_stop, false},
-    {"isis-adjacencies", isis_ctrl_adjacencies, true},
-    {"isis-database", isis_ctrl_database, true},
-    {"isis-load-mrt", isis_ctrl_load_mrt, false},
-    {"isis-lsp-update", isis_ctrl_lsp_update, false},
-    {"isis-lsp-purge", isis_ctrl_lsp_purge, false},
-    {"isis-lsp-flap", isis_ctrl_lsp_flap, false},
-    {"isis-teardown", isis_ctrl_teardown, false},
-    {"ospf-interfaces", ospf_ctrl_interfaces, true},
-    {"ospf-neighbors", ospf_ctrl_neighbors, true},
-    {"ospf-database", ospf_ctrl_database, true},
-    {"ospf-load-mrt", ospf_ctrl_load_mrt, false},
-    {"ospf-lsa-update", ospf_ctrl_lsa_update, false},
-    {"ospf-pdu-update", ospf_ctrl_pdu_update, false},
-    {"ospf-teardown", ospf_ctrl_teardown, false},
-    {"bgp-sessions", bgp_ctrl_sessions, true},
-    {"bgp-disconnect", bgp_ctrl_disconnect, false},
-    {"bgp-teardown", bgp_ctrl_teardown, true},
-    {"bgp-raw-update-list", bgp_ctrl_raw_update_list, true},
-    {"bgp-raw-update", bgp_ctrl_raw_update, false},
-    {"ldp-adjacencies", ldp_ctrl_adjacencies, true},
-    {"ldp-sessions", ldp_ctrl_sessions, true},
-    {"ldp-database", ldb_ctrl_database, true},
-    {"ldp-disconnect", ldp_ctrl_disconnect, false},
-    {"ldp-teardown", ldp_ctrl_teardown, true},
-    {"ldp-raw-update-list", ldp_ctrl_raw_update_list, true},
-    {"ldp-raw-update", ldp_ctrl_raw_update, false},
-    {"monkey-start", bbl_ctrl_monkey_start, false},
-    {"monkey-stop", bbl_ctrl_monkey_stop, false},
-    {"lag-info", bbl_lag_ctrl_info, true},
-    {"test-info", bbl_ctrl_test_info, true},
-    {"test-stop", bbl_ctrl_test_stop, true},
-    {"http-clients", bbl_http_client_ctrl, true},
-    {"http-clients-start", bbl_http_client_ctrl_start, false},
-    {"http-clients-stop", bbl_http_client_ctrl_stop, false},
-    {NULL, NULL, false},
+    {"interfaces", bbl_interface_ctrl, true, false},
+    {"access-interfaces", bbl_access_ctrl_interfaces, true, false},
+    {"network-interfaces", bbl_network_ctrl_interfaces, true, false},
+    {"a10nsp-interfaces", bbl_a10nsp_ctrl_interfaces, true, false},
+    {"interface-enable", bbl_interface_ctrl_enable, false, true},
+    {"interface-disable", bbl_interface_ctrl_disable, false, true},
+    {"terminate", bbl_ctrl_terminate, false, true},
+    {"sessions-pending", bbl_session_ctrl_pending, true, true},
+    {"session-counters", bbl_session_ctrl_counters, true, false},
+    {"session-setup-latency", bbl_session_ctrl_setup_latency, true, true},
+    {"session-info", bbl_session_ctrl_info, true, true},
+    {"sessions-info", bbl_session_ctrl_sessions_info, true, true},
+    {"session-start", bbl_session_ctrl_start, true, true},
+    {"session-stop", bbl_session_ctrl_stop, true, true},
+    {"session-restart", bbl_session_ctrl_restart, true, true},
+    {"session-traffic", bbl_session_ctrl_traffic_stats, true, true},
+    {"session-traffic-enabled", bbl_session_ctrl_traffic_start, false, true},
+    {"session-traffic-start", bbl_session_ctrl_traffic_start, false, true},
+    {"session-traffic-disabled", bbl_session_ctrl_traffic_stop, false, true},
+    {"session-traffic-stop", bbl_session_ctrl_traffic_stop, false, true},
+    {"session-traffic-reset", bbl_session_ctrl_traffic_reset, false, true},
+    {"session-streams", bbl_stream_ctrl_session, true, true},
+    {"stream-traffic-enabled", bbl_stream_ctrl_traffic_start, false, true},
+    {"stream-traffic-start", bbl_stream_ctrl_traffic_start, false, true},
+    {"stream-traffic-disabled", bbl_stream_ctrl_traffic_stop, false, true},
+    {"stream-traffic-stop", bbl_stream_ctrl_traffic_stop, false, true},
+    {"stream-info", bbl_stream_ctrl_info, true, false},
+    {"stream-summary", bbl_stream_ctrl_summary, true, false},
+    {"stream-stats", bbl_stream_ctrl_stats, true, false},
+    {"stream-reset", bbl_stream_ctrl_reset, false, true},
+    {"stream-start", bbl_stream_ctrl_start, false, true},
+    {"stream-stop", bbl_stream_ctrl_stop, false, true},
+    {"streams-pending", bbl_stream_ctrl_pending, true, true},
+    {"multicast-traffic-start", bbl_ctrl_multicast_traffic_start, false, false},
+    {"multicast-traffic-stop", bbl_ctrl_multicast_traffic_stop, false, false},
+    {"igmp-join", bbl_igmp_ctrl_join, false, true},
+    {"igmp-join-iter", bbl_igmp_ctrl_join_iter, false, true},
+    {"igmp-leave", bbl_igmp_ctrl_leave, false, true},
+    {"igmp-leave-all", bbl_igmp_ctrl_leave_all, false, true},
+    {"igmp-info", bbl_igmp_ctrl_info, true, true},
+    {"zapping-start", bbl_igmp_ctrl_zapping_start, true, true},
+    {"zapping-stop", bbl_igmp_ctrl_zapping_stop, false, true},
+    {"zapping-stats", bbl_igmp_ctrl_zapping_stats, true, true},
+    {"li-flows", bbl_li_ctrl_flows, true, false},
+    {"l2tp-tunnels", bbl_l2tp_ctrl_tunnels, true, false},
+    {"l2tp-sessions", bbl_l2tp_ctrl_sessions, true, false},
+    {"l2tp-csurq", bbl_l2tp_ctrl_csurq, false, false},
+    {"l2tp-tunnel-terminate", bbl_l2tp_ctrl_tunnel_terminate, false, false},
+    {"l2tp-session-terminate", bbl_l2tp_ctrl_session_terminate, false, false},
+    {"ipcp-open", bbl_session_ctrl_ipcp_open, false, true},
+    {"ipcp-close", bbl_session_ctrl_ipcp_close, false, true},
+    {"ip6cp-open", bbl_session_ctrl_ip6cp_open, false, true},
+    {"ip6cp-close", bbl_session_ctrl_ip6cp_close, false, true},
+    {"cfm-cc-start", bbl_cfm_ctrl_cc_start, false, true},
+    {"cfm-cc-stop", bbl_cfm_ctrl_cc_stop, false, true},
+    {"cfm-cc-rdi-on", bbl_cfm_ctrl_cc_rdi_on, false, true},
+    {"cfm-cc-rdi-off", bbl_cfm_ctrl_cc_rdi_off, false, true},
+    {"traffic-start", bbl_ctrl_traffic_start, false, true},
+    {"traffic-stop", bbl_ctrl_traffic_stop, false, true},
+    {"isis-adjacencies", isis_ctrl_adjacencies, true, false},
+    {"isis-database", isis_ctrl_database, true, false},
+    {"isis-load-mrt", isis_ctrl_load_mrt, false, false},
+    {"isis-lsp-update", isis_ctrl_lsp_update, false, false},
+    {"isis-lsp-purge", isis_ctrl_lsp_purge, false, false},
+    {"isis-lsp-flap", isis_ctrl_lsp_flap, false, false},
+    {"isis-teardown", isis_ctrl_teardown, false, false},
+    {"ospf-interfaces", ospf_ctrl_interfaces, true, false},
+    {"ospf-neighbors", ospf_ctrl_neighbors, true, false},
+    {"ospf-database", ospf_ctrl_database, true, false},
+    {"ospf-load-mrt", ospf_ctrl_load_mrt, false, false},
+    {"ospf-lsa-update", ospf_ctrl_lsa_update, false, false},
+    {"ospf-pdu-update", ospf_ctrl_pdu_update, false, false},
+    {"ospf-teardown", ospf_ctrl_teardown, false, false},
+    {"bgp-sessions", bgp_ctrl_sessions, true, false},
+    {"bgp-disconnect", bgp_ctrl_disconnect, false, false},
+    {"bgp-teardown", bgp_ctrl_teardown, true, false},
+    {"bgp-raw-update-list", bgp_ctrl_raw_update_list, true, false},
+    {"bgp-raw-update", bgp_ctrl_raw_update, false, false},
+    {"ldp-adjacencies", ldp_ctrl_adjacencies, true, false},
+    {"ldp-sessions", ldp_ctrl_sessions, true, false},
+    {"ldp-database", ldb_ctrl_database, true, false},
+    {"ldp-disconnect", ldp_ctrl_disconnect, false, false},
+    {"ldp-teardown", ldp_ctrl_teardown, true, false},
+    {"ldp-raw-update-list", ldp_ctrl_raw_update_list, true, false},
+    {"ldp-raw-update", ldp_ctrl_raw_update, false, false},
+    {"monkey-start", bbl_ctrl_monkey_start, false, false},
+    {"monkey-stop", bbl_ctrl_monkey_stop, false, false},
+    {"lag-info", bbl_lag_ctrl_info, true, false},
+    {"test-info", bbl_ctrl_test_info, true, false},
+    {"test-stop", bbl_ctrl_test_stop, true, false},
+    {"http-clients", bbl_http_client_ctrl, true, false},
+    {"http-clients-start", bbl_http_client_ctrl_start, false, false},
+    {"http-clients-stop", bbl_http_client_ctrl_stop, false, false},
+    {"mrt-info", bbl_mrt_ctrl_info, false, false},
+    {NULL, NULL, false, false},
+};
+
+struct stream {
+    char *name;
+    bbl_ctrl_stream_fn *fn;
 };
 
+struct stream streams[] = {
+    {"isis-lsp-stream", isis_ctrl_lsp_stream},
+    {"ospf-pdu-stream", ospf_ctrl_pdu_stream},
+    {NULL, NULL},
+};
+
+/**
+ * bbl_ctrl_stream_batch
+ *
+ * Process all PDUs of a completely received
+ * batch (executed in main thread).
+ *
+ * @param connection client connection
+ */
+static void
+bbl_ctrl_stream_batch(bbl_ctrl_connection_s *connection)
+{
+    uint8_t *buf = connection->stream.batch;
+    size_t len = connection->stream.batch_len;
+    uint16_t pdu_len;
+
+    connection->stream.pdus = 0;
+    connection->stream.errors = 0;
+    while(len >= BBL_CTRL_STREAM_HDR_LEN) {
+        pdu_len = read_be_uint(buf, BBL_CTRL_STREAM_HDR_LEN);
+        buf += BBL_CTRL_STREAM_HDR_LEN;
+        len -= BBL_CTRL_STREAM_HDR_LEN;
+        if(pdu_len > len) break;
+        if(!connection->stream.fn(connection->stream.instance_id, buf, pdu_len)) {
+            connection->stream.errors++;
+        }
+        connection->stream.pdus++;
+        buf += pdu_len;
+        len -= pdu_len;
+    }
+}
+
+/**
+ * bbl_ctrl_action
+ *
+ * Execute action with the session workers locked if the
+ * action accesses state owned by them. Only the worker of
+ * the given session is locked for per session commands.
+ * Responses are written to the connection memory file,
+ * so no lock is held while sending to the client.
+ *
+ * @param action action index
+ * @param fd response file descriptor
+ * @param session_id session identifier or 0
+ * @param arguments JSON arguments
+ */
+static void
+bbl_ctrl_action(size_t action, int fd, uint32_t session_id, json_t *arguments)
+{
+    bbl_session_s *session;
+    bbl_session_worker_s *worker = NULL;
+
+    if(!actions[action].sessions || !g_ctx->session_workers) {
+        actions[action].fn(fd, session_id, arguments);
+    } else if(session_id) {
+        session = bbl_session_get(session_id);
+        if(session) {
+            worker = session->access_interface->shard->worker;
+        }
+        bbl_session_worker_lock(worker);
+        actions[action].fn(fd, session_id, arguments);
+        bbl_session_worker_unlock(worker);
+    } else {
+        bbl_session_worker_lock_all();
+        actions[action].fn(fd, session_id, arguments);
+        bbl_session_worker_unlock_all();
+    }
+}
+
 static void
 bbl_ctrl_socket_main(bbl_ctrl_thread_s *ctrl)
 {
     if(ctrl->main.fd) {
         pthread_mutex_lock(&ctrl->mutex);
-        actions[ctrl->main.action].fn(ctrl->main.fd, ctrl->main.session_id, (json_t*)ctrl->main.arguments);
+        bbl_ctrl_action(ctrl->main.action, ctrl->main.fd, ctrl->main.session_id, (json_t*)ctrl->main.arguments);
         ctrl->main.action = 0;
         ctrl->main.fd = 0;
         ctrl->main.session_id = 0;
         ctrl->main.arguments = NULL;
         pthread_cond_signal(&ctrl->cond);
         pthread_mutex_unlock(&ctrl->mutex);
+    } else if(ctrl->main.stream) {
+        pthread_mutex_lock(&ctrl->mutex);
+        bbl_ctrl_stream_batch(ctrl->main.stream);
+        ctrl->main.stream = NULL;
+        pthread_cond_signal(&ctrl->cond);
+        pthread_mutex_unlock(&ctrl->mutex);
     }
 }
 
@@ -279,15 +370,30 @@ bbl_ctrl_socket_main_job(timer_s *timer)
     bbl_ctrl_socket_main(timer->data);
 }
 
-void *
-bbl_ctrl_socket_thread(void *thread_data)
+/**
+ * bbl_ctrl_request
+ *
+ * Execute a single command request and write
+ * the response to the given file descriptor.
+ *
+ * Each command request should be formatted as shown in the example below
+ * with a mandatory command element and optional arguments.
+ * {
+ *    "command": "session-info",
+ *    "arguments": {
+ *        "outer-vlan": 1,
+ *        "inner-vlan": 2
+ *    }
+ * }
+ *
+ * @param ctrl control socket thread
+ * @param fd client file descriptor
+ * @param root JSON request
+ */
+static void
+bbl_ctrl_request(bbl_ctrl_thread_s *ctrl, int fd, json_t *root)
 {
-    bbl_ctrl_thread_s *ctrl = thread_data;
-
     size_t i;
-    size_t flags = JSON_DISABLE_EOF_CHECK;
-    json_error_t error;
-    json_t *root = NULL;
     json_t* arguments = NULL;
     json_t* value = NULL;
     const char *command = NULL;
@@ -299,139 +405,547 @@ bbl_ctrl_socket_thread(void *thread_data)
     bbl_session_s *session;
     void **search;
 
-    /* ToDo: Add connection manager!
-     * This is just a temporary workaround! Finally we need
-     * to create a connection manager. */
-    static int fd = 0;
-    struct timespec sleep, rem;
-    sleep.tv_sec = 0;
-    sleep.tv_nsec = 200 * MSEC;
-
-    ctrl->active = true;
-    while(ctrl->active) {
-        fd = accept(ctrl->socket, 0, 0);
-        if(fd > 0) {
-            /* New connection. */
-            root = json_loadfd(fd, flags, &error);
-            if(!root) {
-                LOG(ERROR, "Invalid json via ctrl socket: line %d: %s\n", error.line, error.text);
-                bbl_ctrl_status(fd, "error", 400, "invalid json");
+    if(json_unpack(root, "{s:s, s?o}", "command", &command, "arguments", &arguments) != 0) {
+        LOG_NOARG(ERROR, "Invalid command via ctrl socket\n");
+        bbl_ctrl_status(fd, "error", 400, "invalid request");
+        return;
+    }
+    if(arguments) {
+        value = json_object_get(arguments, "session-id");
+        if(value) {
+            if(json_is_number(value)) {
+                session_id = json_number_value(value);
             } else {
-                    /* Each command request should be formatted as shown in the example below
-                    * with a mandatory command element and optional arguments.
-                    * {
-                    *    "command": "session-info",
-                    *    "arguments": {
-                    *        "outer-vlan": 1,
-                    *        "inner-vlan": 2
-                    *    }
-                    * }
-                    */
-                command = NULL;
-                arguments = NULL;
-                session_id = 0;
-                key.ifindex = 0;
-                key.inner_vlan_id = 0;
-                key.outer_vlan_id = 0;
-                if(json_unpack(root, "{s:s, s?o}", "command", &command, "arguments", &arguments) != 0) {
-                    LOG_NOARG(ERROR, "Invalid command via ctrl socket\n");
-                    bbl_ctrl_status(fd, "error", 400, "invalid request");
+                bbl_ctrl_status(fd, "error", 400, "invalid session-id");
+                return;
+            }
+        } else {
+            /* Deprecated!
+             * For backward compatibility with version 0.4.X, we still
+             * support per session commands using VLAN index instead of
+             * new session-id. */
+            value = json_object_get(arguments, "ifindex");
+            if(value) {
+                if(json_is_number(value)) {
+                    key.ifindex = json_number_value(value);
+                } else {
+                    bbl_ctrl_status(fd, "error", 400, "invalid ifindex");
+                    return;
+                }
+            } else {
+                value = json_object_get(arguments, "interface");
+                if(value && json_is_string(value)) {
+                    access_interface = bbl_access_interface_get((char*)json_string_value(value));
+                } else {
+                    /* Use first interface as default. */
+                    access_interface = bbl_access_interface_get(NULL);
+                }
+                if(access_interface) {
+                    key.ifindex = access_interface->ifindex;
+                }
+            }
+            value = json_object_get(arguments, "outer-vlan");
+            if(value) {
+                if(json_is_number(value)) {
+                    key.outer_vlan_id = json_number_value(value);
+                } else {
+                    bbl_ctrl_status(fd, "error", 400, "invalid outer-vlan");
+                    return;
+                }
+            }
+            value = json_object_get(arguments, "inner-vlan");
+            if(value) {
+                if(json_is_number(value)) {
+                    key.inner_vlan_id = json_number_value(value);
+                } else {
+                    bbl_ctrl_status(fd, "error", 400, "invalid inner-vlan");
+                    return;
+                }
+            }
+            if(key.outer_vlan_id) {
+                search = dict_search(g_ctx->vlan_session_dict, &key);
+                if(search) {
+                    session = *search;
+                    session_id = session->session_id;
                 } else {
-                    if(arguments) {
-                        value = json_object_get(arguments, "session-id");
-                        if(value) {
-                            if(json_is_number(value)) {
-                                session_id = json_number_value(value);
-                            } else {
-                                bbl_ctrl_status(fd, "error", 400, "invalid session-id");
-                                goto CLOSE;
-                            }
-                        } else {
-                            /* Deprecated!
-                             * For backward compatibility with version 0.4.X, we still
-                             * support per session commands using VLAN index instead of
-                             * new session-id. */
-                            value = json_object_get(arguments, "ifindex");
-                            if(value) {
-                                if(json_is_number(value)) {
-                                    key.ifindex = json_number_value(value);
-                                } else {
-                                    bbl_ctrl_status(fd, "error", 400, "invalid ifindex");
-                                    goto CLOSE;
-                                }
-                            } else {
-                                value = json_object_get(arguments, "interface");
-                                if(value && json_is_string(value)) {
-                                    access_interface = bbl_access_interface_get((char*)json_string_value(value));
-                                } else {
-                                    /* Use first interface as default. */
-                                    access_interface = bbl_access_interface_get(NULL);
-                                }
-                                if(access_interface) {
-                                    key.ifindex = access_interface->ifindex;
-                                }
-                            }
-                            value = json_object_get(arguments, "outer-vlan");
-                            if(value) {
-                                if(json_is_number(value)) {
-                                    key.outer_vlan_id = json_number_value(value);
-                                } else {
-                                    bbl_ctrl_status(fd, "error", 400, "invalid outer-vlan");
-                                    goto CLOSE;
-                                }
-                            }
-                            value = json_object_get(arguments, "inner-vlan");
-                            if(value) {
-                                if(json_is_number(value)) {
-                                    key.inner_vlan_id = json_number_value(value);
-                                } else {
-                                    bbl_ctrl_status(fd, "error", 400, "invalid inner-vlan");
-                                    goto CLOSE;
-                                }
-                            }
-                            if(key.outer_vlan_id) {
-                                search = dict_search(g_ctx->vlan_session_dict, &key);
-                                if(search) {
-                                    session = *search;
-                                    session_id = session->session_id;
-                                } else {
-                                    bbl_ctrl_status(fd, "warning", 404, "session not found");
-                                    goto CLOSE;
-                                }
-                            }
-                        }
-                    }
-                    for(i = 0; true; i++) {
-                        if(actions[i].name == NULL) {
-                            bbl_ctrl_status(fd, "error", 400, "unknown command");
-                            break;
-                        } else if(strcmp(actions[i].name, command) == 0) {
-                            if(actions[i].thread_safe) {
-                                actions[i].fn(fd, session_id, arguments);
-                            } else {
-                                pthread_mutex_lock(&ctrl->mutex);
-                                ctrl->main.fd = fd;
-                                ctrl->main.action = i;
-                                ctrl->main.session_id = session_id;
-                                ctrl->main.arguments = (void*)arguments;
-                                pthread_cond_wait(&ctrl->cond, &ctrl->mutex);
-                                pthread_mutex_unlock(&ctrl->mutex);
-                            }
-                            break;
-                        }
-                    }
+                    bbl_ctrl_status(fd, "warning", 404, "session not found");
+                    return;
                 }
-CLOSE:
-                json_decref(root);
-                root = NULL;
             }
+        }
+    }
+    for(i = 0; true; i++) {
+        if(actions[i].name == NULL) {
+            bbl_ctrl_status(fd, "error", 400, "unknown command");
+            break;
+        } else if(strcmp(actions[i].name, command) == 0) {
+            if(actions[i].thread_safe) {
+                bbl_ctrl_action(i, fd, session_id, arguments);
+            } else {
+                pthread_mutex_lock(&ctrl->mutex);
+                ctrl->main.fd = fd;
+                ctrl->main.action = i;
+                ctrl->main.session_id = session_id;
+                ctrl->main.arguments = (void*)arguments;
+                pthread_cond_wait(&ctrl->cond, &ctrl->mutex);
+                pthread_mutex_unlock(&ctrl->mutex);
+            }
+            break;
+        }
+    }
+}
+
+static void
+bbl_ctrl_connection_close(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    epoll_ctl(ctrl->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    shutdown(connection->fd, SHUT_WR);
+    close(connection->fd);
+    close(connection->out_fd);
+    CIRCLEQ_REMOVE(&ctrl->connection_qhead, connection, connection_qnode);
+    ctrl->connections--;
+    if(connection->buf) {
+        free(connection->buf);
+    }
+    free(connection);
+}
+
+/**
+ * bbl_ctrl_connection_flush
+ *
+ * Send pending responses without blocking. The memory
+ * file is reset as soon as all responses are sent.
+ *
+ * @param connection client connection
+ * @return false if connection should be closed
+ */
+static bool
+bbl_ctrl_connection_flush(bbl_ctrl_connection_s *connection)
+{
+    off_t len = lseek(connection->out_fd, 0, SEEK_CUR);
+    ssize_t sent;
+
+    while(connection->out_sent < len) {
+        sent = sendfile(connection->fd, connection->out_fd, &connection->out_sent,
+                        len - connection->out_sent);
+        if(sent > 0) {
+            continue;
+        } else if(sent < 0 && errno == EINTR) {
+            continue;
+        } else if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            connection->pending = true;
+            return true;
+        } else {
+            return false;
+        }
+    }
+    connection->pending = false;
+    if(len) {
+        connection->out_sent = 0;
+        if(ftruncate(connection->out_fd, 0) != 0 ||
+           lseek(connection->out_fd, 0, SEEK_SET) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * bbl_ctrl_connection_update
+ *
+ * Wait for the connection to become writable while
+ * responses are pending, otherwise for new requests.
+ *
+ * @param ctrl control socket thread
+ * @param connection client connection
+ * @return false if connection should be closed
+ */
+static bool
+bbl_ctrl_connection_update(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    struct epoll_event event = {0};
+
+    if(connection->pending) {
+        event.events = EPOLLOUT;
+    } else if(connection->closing) {
+        return false;
+    } else {
+        event.events = EPOLLIN;
+    }
+    if(event.events != connection->events) {
+        event.data.ptr = connection;
+        if(epoll_ctl(ctrl->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event) != 0) {
+            return false;
+        }
+        connection->events = event.events;
+    }
+    return true;
+}
+
+static void
+bbl_ctrl_connection_accept(bbl_ctrl_thread_s *ctrl)
+{
+    bbl_ctrl_connection_s *connection;
+    struct epoll_event event = {0};
+    int fd;
+
+    while(true) {
+        fd = accept(ctrl->socket, 0, 0);
+        if(fd < 0) {
+            return;
+        }
+        if(ctrl->connections >= BBL_CTRL_CONNECTIONS_MAX) {
+            LOG_NOARG(ERROR, "Failed to accept ctrl connection (max connections reached)\n");
+            bbl_ctrl_status(fd, "error", 503, "max connections reached");
             shutdown(fd, SHUT_WR);
+            close(fd);
+            continue;
+        }
+        connection = calloc(1, sizeof(bbl_ctrl_connection_s));
+        if(!connection) {
+            close(fd);
+            continue;
         }
-        nanosleep(&sleep, &rem);
-        if(fd > 0) {
+        /* Responses are written to a memory file and sent
+         * non-blocking, such that a single client, which is
+         * not reading, is not blocking all other clients. */
+        connection->out_fd = memfd_create("bbl-ctrl", MFD_CLOEXEC);
+        if(connection->out_fd < 0) {
+            LOG(ERROR, "Failed to create ctrl connection buffer (error %d)\n", errno);
+            free(connection);
             close(fd);
+            continue;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        CIRCLEQ_INSERT_TAIL(&ctrl->connection_qhead, connection, connection_qnode);
+        ctrl->connections++;
+
+        event.events = connection->events;
+        event.data.ptr = connection;
+        if(epoll_ctl(ctrl->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            LOG(ERROR, "Failed to add ctrl connection to epoll (error %d)\n", errno);
+            bbl_ctrl_connection_close(ctrl, connection);
+        }
+    }
+}
+
+/**
+ * bbl_ctrl_stream_start
+ *
+ * Change the connection to binary PDU stream mode
+ * if the request is one of the stream commands.
+ *
+ * @param connection client connection
+ * @param root JSON request
+ * @return true if request was a stream command
+ */
+static bool
+bbl_ctrl_stream_start(bbl_ctrl_connection_s *connection, json_t *root)
+{
+    json_t* arguments = NULL;
+    const char *command = NULL;
+    int instance_id = 0;
+    size_t i;
+
+    if(json_unpack(root, "{s:s, s?o}", "command", &command, "arguments", &arguments) != 0) {
+        return false;
+    }
+    for(i = 0; streams[i].name; i++) {
+        if(strcmp(streams[i].name, command) == 0) {
+            if(!arguments || json_unpack(arguments, "{s:i}", "instance", &instance_id) != 0) {
+                bbl_ctrl_status(connection->out_fd, "error", 400, "missing instance");
+                return true;
+            }
+            connection->stream.fn = streams[i].fn;
+            connection->stream.instance_id = instance_id;
+            connection->stream.offset = 0;
+            LOG(DEBUG, "Start %s via ctrl socket (instance %d)\n", command, instance_id);
+            bbl_ctrl_status(connection->out_fd, "ok", 200, NULL);
+            dprintf(connection->out_fd, "\n");
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * bbl_ctrl_stream_process
+ *
+ * Process binary PDU stream received on a connection.
+ *
+ * Each PDU is prefixed by its length as 16 bit unsigned integer
+ * in network byte order, where a length of zero marks the end
+ * of a batch. All PDUs of a batch are processed at once in the
+ * main thread, followed by an acknowledgement with the number
+ * of processed PDUs and errors (two 32 bit unsigned integers
+ * in network byte order). A single batch must not exceed
+ * BBL_CTRL_REQUEST_MAX, the client is responsible to limit
+ * the number of unacknowledged batches (flow control).
+ * Further batches are not processed while acknowledgements
+ * are pending.
+ *
+ * @param ctrl control socket thread
+ * @param connection client connection
+ * @param buf received data (updated)
+ * @param len received data length (updated)
+ * @return false if connection should be closed
+ */
+static bool
+bbl_ctrl_stream_process(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection,
+                        char **buf, size_t *len)
+{
+    uint8_t *batch = (uint8_t*)*buf;
+    size_t batch_len = *len;
+    size_t offset = connection->stream.offset;
+    uint16_t pdu_len;
+    uint8_t ack[BBL_CTRL_STREAM_ACK_LEN];
+
+    while(ctrl->active && !connection->pending && batch_len - offset >= BBL_CTRL_STREAM_HDR_LEN) {
+        pdu_len = read_be_uint(batch + offset, BBL_CTRL_STREAM_HDR_LEN);
+        if(pdu_len) {
+            if(batch_len - offset - BBL_CTRL_STREAM_HDR_LEN < pdu_len) {
+                /* Incomplete PDU. */
+                break;
+            }
+            offset += BBL_CTRL_STREAM_HDR_LEN + pdu_len;
+            continue;
+        }
+        /* End of batch. */
+        pthread_mutex_lock(&ctrl->mutex);
+        connection->stream.batch = batch;
+        connection->stream.batch_len = offset;
+        ctrl->main.stream = connection;
+        pthread_cond_wait(&ctrl->cond, &ctrl->mutex);
+        pthread_mutex_unlock(&ctrl->mutex);
+
+        write_be_uint(ack, sizeof(uint32_t), connection->stream.pdus);
+        write_be_uint(ack+sizeof(uint32_t), sizeof(uint32_t), connection->stream.errors);
+        if(write(connection->out_fd, ack, sizeof(ack)) != sizeof(ack) ||
+           !bbl_ctrl_connection_flush(connection)) {
+            return false;
+        }
+        offset += BBL_CTRL_STREAM_HDR_LEN;
+        batch += offset;
+        batch_len -= offset;
+        offset = 0;
+    }
+    connection->stream.offset = offset;
+    *buf = (char*)batch;
+    *len = batch_len;
+    return true;
+}
+
+/**
+ * bbl_ctrl_connection_process
+ *
+ * Process all requests received on a connection.
+ *
+ * Per default, the connection is closed after the response
+ * to the first request (one-shot). A request with the element
+ * keep-alive set to true changes the connection to persistent,
+ * where further requests can be pipelined and each response is
+ * terminated by a newline. The connection is closed by the client.
+ * A stream command changes the connection to binary PDU stream
+ * mode (see bbl_ctrl_stream_process) until closed by the client.
+ *
+ * Responses are written to the connection memory file and sent
+ * non-blocking. Further requests are not processed while
+ * responses are pending.
+ *
+ * @param ctrl control socket thread
+ * @param connection client connection
+ * @return false if connection should be closed
+ */
+static bool
+bbl_ctrl_connection_process(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    char *buf = connection->buf;
+    char *end;
+    size_t len = connection->len;
+    bool keep = true;
+
+    json_error_t error;
+    json_t *root;
+    json_t *value;
+
+    while(ctrl->active && !connection->closing && !connection->pending) {
+        if(connection->stream.fn) {
+            if(!bbl_ctrl_stream_process(ctrl, connection, &buf, &len)) {
+                keep = false;
+            } else if(connection->eof) {
+                connection->closing = true;
+            }
+            break;
+        }
+        /* Skip whitespace and newlines between requests. */
+        while(len && isspace((unsigned char)*buf)) {
+            buf++;
+            len--;
+        }
+        if(!len) {
+            if(connection->eof) {
+                connection->closing = true;
+            }
+            break;
+        }
+
+        root = json_loadb(buf, len, JSON_DISABLE_EOF_CHECK, &error);
+        if(!root) {
+            if(!connection->eof && (size_t)error.position >= len) {
+                /* Incomplete request. */
+                break;
+            }
+            LOG(ERROR, "Invalid json via ctrl socket: line %d: %s\n", error.line, error.text);
+            bbl_ctrl_status(connection->out_fd, "error", 400, "invalid json");
+            if(!connection->persistent) {
+                connection->closing = true;
+                break;
+            }
+            dprintf(connection->out_fd, "\n");
+            /* Skip invalid request up to the next newline. */
+            end = memchr(buf, '\n', len);
+            if(!end) {
+                len = 0;
+            } else {
+                len -= (end - buf) + 1;
+                buf = end + 1;
+            }
+            if(!bbl_ctrl_connection_flush(connection)) {
+                keep = false;
+                break;
+            }
+            continue;
+        }
+        buf += error.position;
+        len -= error.position;
+
+        value = json_object_get(root, "keep-alive");
+        if(value && json_is_true(value)) {
+            connection->persistent = true;
+        }
+        if(bbl_ctrl_stream_start(connection, root)) {
+            json_decref(root);
+            if(!connection->stream.fn) {
+                connection->closing = true;
+                break;
+            }
+        } else {
+            bbl_ctrl_request(ctrl, connection->out_fd, root);
+            json_decref(root);
+            if(!connection->persistent) {
+                connection->closing = true;
+                break;
+            }
+            /* Responses of persistent connections are newline delimited. */
+            dprintf(connection->out_fd, "\n");
+        }
+        if(!bbl_ctrl_connection_flush(connection)) {
+            keep = false;
+            break;
+        }
+    }
+    if(len && buf != connection->buf) {
+        memmove(connection->buf, buf, len);
+    }
+    connection->len = len;
+    if(keep) {
+        keep = bbl_ctrl_connection_flush(connection);
+    }
+    return keep;
+}
+
+static bool
+bbl_ctrl_connection_read(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    ssize_t len;
+    size_t size;
+    char *buf;
+
+    while(!connection->pending && !connection->closing) {
+        if(connection->size - connection->len < BBL_CTRL_READ_SIZE) {
+            size = connection->size + BBL_CTRL_READ_SIZE;
+            if(size > BBL_CTRL_REQUEST_MAX) {
+                LOG_NOARG(ERROR, "Invalid request via ctrl socket (max request size exceeded)\n");
+                bbl_ctrl_status(connection->out_fd, "error", 413, "request too large");
+                connection->closing = true;
+                return bbl_ctrl_connection_flush(connection);
+            }
+            buf = realloc(connection->buf, size);
+            if(!buf) {
+                return false;
+            }
+            connection->buf = buf;
+            connection->size = size;
+        }
+        len = recv(connection->fd, connection->buf + connection->len,
+                   connection->size - connection->len, MSG_DONTWAIT);
+        if(len > 0) {
+            connection->len += len;
+            if(!bbl_ctrl_connection_process(ctrl, connection)) {
+                return false;
+            }
+        } else if(len == 0) {
+            connection->eof = true;
+            return bbl_ctrl_connection_process(ctrl, connection);
+        } else if(errno == EINTR) {
+            continue;
+        } else {
+            return (errno == EAGAIN || errno == EWOULDBLOCK);
         }
     }
+    return true;
+}
+
+static bool
+bbl_ctrl_connection_write(bbl_ctrl_thread_s *ctrl, bbl_ctrl_connection_s *connection)
+{
+    if(!bbl_ctrl_connection_flush(connection)) {
+        return false;
+    }
+    if(connection->pending || connection->closing) {
+        return true;
+    }
+    /* Continue with requests received while
+     * responses have been pending. */
+    return bbl_ctrl_connection_process(ctrl, connection);
+}
+
+void *
+bbl_ctrl_socket_thread(void *thread_data)
+{
+    bbl_ctrl_thread_s *ctrl = thread_data;
+    bbl_ctrl_connection_s *connection;
+
+    struct epoll_event events[BBL_CTRL_EPOLL_EVENTS];
+    int i, n;
+    bool keep;
+
+    ctrl->active = true;
+    while(ctrl->active) {
+        n = epoll_wait(ctrl->epoll_fd, events, BBL_CTRL_EPOLL_EVENTS, BBL_CTRL_EPOLL_TIMEOUT);
+        for(i = 0; i < n; i++) {
+            connection = events[i].data.ptr;
+            if(!connection) {
+                /* New connection(s). */
+                bbl_ctrl_connection_accept(ctrl);
+                continue;
+            }
+            if(events[i].events & EPOLLOUT) {
+                keep = bbl_ctrl_connection_write(ctrl, connection);
+            } else {
+                keep = bbl_ctrl_connection_read(ctrl, connection);
+            }
+            if(!keep || !bbl_ctrl_connection_update(ctrl, connection)) {
+                bbl_ctrl_connection_close(ctrl, connection);
+            }
+        }
+    }
+    while(!CIRCLEQ_EMPTY(&ctrl->connection_qhead)) {
+        bbl_ctrl_connection_close(ctrl, CIRCLEQ_FIRST(&ctrl->connection_qhead));
+    }
     return NULL;
 }
 
@@ -440,6 +954,7 @@ bbl_ctrl_socket_init()
 {
     bbl_ctrl_thread_s *ctrl;
     struct sockaddr_un addr = {0};
+    struct epoll_event event = {0};
 
     if(!g_ctx->ctrl_socket_path) {
         return true;
@@ -464,7 +979,7 @@ bbl_ctrl_socket_init()
         fprintf(stderr, "Error: Failed to bind ctrl socket %s (error %d)\n", g_ctx->ctrl_socket_path, errno);
         return false;
     }
-    if(listen(ctrl->socket, BACKLOG) != 0) {
+    if(listen(ctrl->socket, BBL_CTRL_BACKLOG) != 0) {
         fprintf(stderr, "Error: Failed to listen on ctrl socket %s (error %d)\n", g_ctx->ctrl_socket_path, errno);
         return false;
     }
@@ -472,6 +987,20 @@ bbl_ctrl_socket_init()
     /* Change socket to non-blocking */
     fcntl(ctrl->socket, F_SETFL, O_NONBLOCK);
 
+    /* Create epoll instance for listen socket and all connections */
+    CIRCLEQ_INIT(&ctrl->connection_qhead);
+    ctrl->epoll_fd = epoll_create1(0);
+    if(ctrl->epoll_fd < 0) {
+        fprintf(stderr, "Error: Failed to create ctrl socket epoll (error %d)\n", errno);
+        return false;
+    }
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if(epoll_ctl(ctrl->epoll_fd, EPOLL_CTL_ADD, ctrl->socket, &event) != 0) {
+        fprintf(stderr, "Error: Failed to add ctrl socket to epoll (error %d)\n", errno);
+        return false;
+    }
+
     /* Create ctrl thread */
     if(pthread_mutex_init(&ctrl->mutex, NULL) != 0) {
         LOG_NOARG(ERROR, "Failed to init ctrl mutex\n");
@@ -487,7 +1016,7 @@ bbl_ctrl_socket_init()
     }
 
     /* Start ctrl main job */
-    timer_add_periodic(&g_ctx->timer_root, &ctrl->main.timer, "CTRL Socket Main Timer", 0, 1000 * MSEC, ctrl, &bbl_ctrl_socket_main_job);
+    timer_add_periodic(&g_ctx->timer_root, &ctrl->main.timer, "CTRL Socket Main Timer", 0, BBL_CTRL_MAIN_INTERVAL * MSEC, ctrl, &bbl_ctrl_socket_main_job);
 
     LOG(INFO, "Opened control socket %s\n", g_ctx->ctrl_socket_path);
 
@@ -512,6 +1041,9 @@ bbl_ctrl_socket_close()
         if(ctrl->socket) {
             close(ctrl->socket);
         }
+        if(ctrl->epoll_fd > 0) {
+            close(ctrl->epoll_fd);
+        }
         unlink(g_ctx->ctrl_socket_path);
         free(g_ctx->ctrl_thread);
         g_ctx->ctrl_thread = NULL;
@@ -10,8 +10,61 @@
 #ifndef __BBL_CTRL_H__
 #define __BBL_CTRL_H__
 
+#define BBL_CTRL_BACKLOG            64
+#define BBL_CTRL_CONNECTIONS_MAX    64
+#define BBL_CTRL_EPOLL_EVENTS       16
+#define BBL_CTRL_EPOLL_TIMEOUT      100 /* msec */
+#define BBL_CTRL_READ_SIZE          4096
+#define BBL_CTRL_REQUEST_MAX        1048576 /* 1 MB */
+#define BBL_CTRL_MAIN_INTERVAL      10 /* msec */
+#define BBL_CTRL_STREAM_HDR_LEN     2
+#define BBL_CTRL_STREAM_ACK_LEN     8
+
+/** Function to process a single PDU received via binary PDU stream. */
+typedef bool bbl_ctrl_stream_fn(int instance_id, uint8_t *buf, uint16_t len);
+
+/** Control socket client connection */
+typedef struct bbl_ctrl_connection_ {
+    int fd;
+
+    /** Connection is kept open after a request
+     * with keep-alive until closed by the client. */
+    bool persistent;
+
+    char *buf;
+    size_t len;
+    size_t size;
+
+    /** Responses are written to a memory file and sent
+     * non-blocking as fast as the client is reading. */
+    int out_fd;
+    off_t out_sent; /* bytes of out_fd already sent */
+    uint32_t events; /* epoll events */
+    bool pending; /* unsent responses */
+    bool eof; /* connection closed by client */
+    bool closing; /* close after pending responses are sent */
+
+    /** Binary PDU stream mode, enabled by a stream
+     * command like isis-lsp-stream or ospf-pdu-stream. */
+    struct {
+        bbl_ctrl_stream_fn *fn;
+        int instance_id;
+        size_t offset; /* parsed bytes of current batch */
+        uint8_t *batch;
+        size_t batch_len;
+        uint32_t pdus;
+        uint32_t errors;
+    } stream;
+
+    CIRCLEQ_ENTRY(bbl_ctrl_connection_) connection_qnode;
+} bbl_ctrl_connection_s;
+
 typedef struct bbl_ctrl_thread_ {
     int socket;
+    int epoll_fd;
+
+    uint32_t connections;
+    CIRCLEQ_HEAD(ctrl_connection_, bbl_ctrl_connection_) connection_qhead;
 
     pthread_t thread;
     pthread_mutex_t mutex;
@@ -26,6 +79,7 @@ typedef struct bbl_ctrl_thread_ {
         volatile int fd;
         volatile uint32_t session_id;
         volatile json_t *arguments;
+        bbl_ctrl_connection_s * volatile stream;
     } main;
 } bbl_ctrl_thread_s;
 
@@ -64,8 +64,11 @@ bbl_ctx_add()
     /* Initialize timer root. */
     timer_init_root(&g_ctx->timer_root);
 
-    CIRCLEQ_INIT(&g_ctx->sessions_idle_qhead);
-    CIRCLEQ_INIT(&g_ctx->sessions_teardown_qhead);
+    /* Initialize main loop session shard. */
+    g_ctx->session_shard.timer_root = &g_ctx->timer_root;
+    CIRCLEQ_INIT(&g_ctx->session_shard.sessions_idle_qhead);
+    CIRCLEQ_INIT(&g_ctx->session_shard.sessions_teardown_qhead);
+
     CIRCLEQ_INIT(&g_ctx->interface_qhead);
     CIRCLEQ_INIT(&g_ctx->lag_qhead);
     CIRCLEQ_INIT(&g_ctx->access_interface_qhead);
@@ -81,6 +84,10 @@ bbl_ctx_add()
     g_ctx->l2tp_session_dict = hashtable_dict_new((dict_compare_func)bbl_compare_key32, bbl_key32_hash, BBL_SESSION_HASHTABLE_SIZE);
     g_ctx->li_flow_dict = hashtable_dict_new((dict_compare_func)bbl_compare_key32, bbl_key32_hash, BBL_LI_HASHTABLE_SIZE);
     g_ctx->stream_flow_dict = hashtable_dict_new((dict_compare_func)bbl_compare_key64, bbl_key64_hash, BBL_STREAM_FLOW_HASHTABLE_SIZE);
+    g_ctx->stream_flow_index = calloc(BBL_STREAM_FLOW_INDEX_SIZE, sizeof(bbl_stream_s**));
+    if(!g_ctx->stream_flow_index) {
+        return false;
+    }
 
     return true;
 }
@@ -99,6 +106,7 @@ bbl_ctx_del() {
     if(!g_ctx) return;
 
     timer_flush_root(&g_ctx->timer_root);
+    bbl_session_worker_free_all();
     
     /* Free access configuration memory. */
     access_config = g_ctx->config.access_config;
@@ -127,6 +135,16 @@ bbl_ctx_del() {
     dict_free(g_ctx->li_flow_dict, NULL);
     dict_free(g_ctx->stream_flow_dict, NULL);
 
+    /* Free stream index. */
+    if(g_ctx->stream_flow_index) {
+        for(i = 0; i < BBL_STREAM_FLOW_INDEX_SIZE; i++) {
+            if(g_ctx->stream_flow_index[i]) {
+                free(g_ctx->stream_flow_index[i]);
+            }
+        }
+        free(g_ctx->stream_flow_index);
+    }
+
     pcapng_free();
     free(g_ctx);
     g_ctx = NULL;
@@ -21,6 +21,12 @@ typedef struct bbl_secondary_ip6_
     void *next;
 } bbl_secondary_ip6_s;
 
+/* Session start pacing sample per second. */
+typedef struct bbl_pacing_sample_ {
+    uint32_t target; /* session start rate */
+    uint32_t achieved; /* sessions established */
+} bbl_pacing_sample_s;
+
 /*
  * BBL context. Top level data structure.
  */
@@ -37,24 +43,11 @@ typedef struct bbl_ctx_
     struct timespec timestamp_start;
     struct timespec timestamp_stop;
     struct timespec timestamp_resolved;
-    struct timespec timestamp_established;
 
     uint32_t interfaces;
     uint32_t sessions;
     uint32_t sessions_pppoe;
     uint32_t sessions_ipoe;
-    uint32_t sessions_established;
-    uint32_t sessions_established_max;
-    uint32_t sessions_outstanding;
-    uint32_t sessions_terminated;
-    uint32_t sessions_flapped;
-
-    uint32_t dhcp_requested;
-    uint32_t dhcp_established;
-    uint32_t dhcp_established_max;
-    uint32_t dhcpv6_requested;
-    uint32_t dhcpv6_established;
-    uint32_t dhcpv6_established_max;
 
     uint32_t l2tp_sessions;
     uint32_t l2tp_sessions_max;
@@ -65,8 +58,9 @@ typedef struct bbl_ctx_
 
     uint32_t routing_sessions;
 
-    CIRCLEQ_HEAD(sessions_idle_, bbl_session_ ) sessions_idle_qhead;
-    CIRCLEQ_HEAD(sessions_teardown_, bbl_session_ ) sessions_teardown_qhead;
+    bbl_session_shard_s session_shard; /* sessions processed by main loop (first shard) */
+    bbl_session_worker_s *session_workers; /* single linked list of session workers */
+
     CIRCLEQ_HEAD(interface_, bbl_interface_ ) interface_qhead; /* list of interfaces */
     CIRCLEQ_HEAD(lag_, bbl_lag_ ) lag_qhead; /* list of LAG groups */
     CIRCLEQ_HEAD(access_interface_, bbl_access_interface_ ) access_interface_qhead; /* list of interfaces */
@@ -79,6 +73,7 @@ typedef struct bbl_ctx_
     dict *l2tp_session_dict; /* hashtable for L2TP sessions */
     dict *li_flow_dict; /* hashtable for LI flows */
     dict *stream_flow_dict; /* hashtable for traffic stream flows */
+    bbl_stream_s ***stream_flow_index; /* flow-id indexed traffic streams */
 
     bbl_stream_group_s *stream_groups;
 
@@ -99,6 +94,7 @@ typedef struct bbl_ctx_
     ospf_instance_s *ospf_instances;
     ldp_instance_s *ldp_instances;
     ldp_raw_update_s *ldp_raw_updates;
+    bbl_mrt_loader_s *mrt_loaders; /* single linked list of MRT loaders */
 
     /* Scratchpad memory */
     uint8_t *sp;
@@ -122,8 +118,8 @@ typedef struct bbl_ctx_
         double cps_max;
         double cps_sum;
         double cps_count;
-        struct timespec first_session_tx;
-        struct timespec last_session_established;
+        double cps_target; /* current session start rate */
+        uint32_t cps_current; /* sessions established in last second */
         uint32_t sessions_established_max;
         uint32_t session_traffic_flows;
         uint32_t session_traffic_flows_verified;
@@ -133,6 +129,15 @@ typedef struct bbl_ctx_
         uint32_t multicast_traffic_flows_verified;
     } stats;
 
+    /* Session start pacing */
+    struct {
+        uint32_t started; /* sessions started at last update */
+        uint32_t established; /* sessions established at last update */
+        uint64_t retries; /* session retries at last update */
+        uint32_t history_len;
+        bbl_pacing_sample_s history[BBL_PACING_HISTORY];
+    } pacing;
+
     endpoint_state_t multicast_endpoint;
     bool zapping;
 
@@ -148,6 +153,13 @@ typedef struct bbl_ctx_
         uint16_t io_slots;
         uint16_t io_max_stream_len;
 
+        bool io_rx_tpacket_v3;
+        uint16_t io_rx_block_timeout; /* TPACKET_V3 block retire timeout in msec */
+        io_timestamp_t io_timestamping;
+
+        bool io_event_loop;
+        uint16_t io_busy_poll; /* busy poll time in usec */
+
         bool qdisc_bypass;
 
         uint64_t tx_interval; /* TX interval in nsec */
@@ -213,6 +225,8 @@ typedef struct bbl_ctx_
         uint16_t sessions_start_rate;
         uint16_t sessions_stop_rate;
         uint16_t sessions_start_delay;
+        bool sessions_start_adaptive;
+        bool sessions_worker_threads;
         bool sessions_reconnect;
         bool sessions_autostart;
         bool monkey_autostart;
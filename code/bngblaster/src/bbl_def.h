@@ -12,6 +12,9 @@
 #include <string.h>
 #include <arpa/inet.h>
 #include <linux/if_packet.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
 #include <sys/queue.h>
 #include <sys/time.h>
 #include <signal.h>
@@ -52,8 +55,21 @@
 #define FILE_PATH_LEN               128
 
 #define BBL_SESSION_HASHTABLE_SIZE 128993 /* is a prime number */
+#define BBL_PACING_SLOTS 10 /* session start slots per second */
+#define BBL_PACING_HISTORY 3600 /* session start pacing samples (seconds) */
+#define BBL_PACING_INCREASE 0.1 /* additive increase as fraction of start-rate */
+#define BBL_PACING_DECREASE 0.5 /* multiplicative decrease */
+#define BBL_PACING_RETRY_THRESHOLD 0.1 /* retries per started session */
+#define BBL_SETUP_LATENCY_BUCKETS 96 /* log-linear setup latency histogram buckets (up to 29 sec) */
+#define BBL_SESSION_CTRL_LIMIT 1000 /* default page size of bulk session commands */
+#define BBL_SESSION_CTRL_BUF 65536 /* write buffer of bulk session commands */
 #define BBL_LI_HASHTABLE_SIZE 32771 /* is a prime number */
 #define BBL_STREAM_FLOW_HASHTABLE_SIZE 128993 /* is a prime number */
+#define BBL_STREAM_FLOW_BLOCK_BITS 16 /* flows per stream index block (65536) */
+#define BBL_STREAM_FLOW_BLOCK_SIZE (1 << BBL_STREAM_FLOW_BLOCK_BITS)
+#define BBL_STREAM_FLOW_INDEX_SIZE 16384 /* stream index blocks */
+#define BBL_STREAM_DELAY_BUCKETS 64 /* log-linear delay histogram buckets (up to 114 msec) */
+#define BBL_STREAM_TX_PACKET_COST 512 /* per packet cost in bits used for TX thread balancing */
 
 /* Mock Addresses */
 #define MOCK_IP_LOCAL               167772170   /* 10.0.0.10 */
@@ -184,6 +200,30 @@ typedef enum {
     BBL_MAX
 } __attribute__ ((__packed__)) session_state_t;
 
+/*
+ * Session setup phases
+ */
+typedef enum {
+    BBL_SETUP_SESSION = 0,          /* session start to established */
+    BBL_SETUP_PPPOE_DISCOVERY,      /* PADI to PADO */
+    BBL_SETUP_PPPOE_REQUEST,        /* PADR to PADS */
+    BBL_SETUP_LCP,                  /* LCP request to LCP opened */
+    BBL_SETUP_AUTH,                 /* LCP opened to authentication success */
+    BBL_SETUP_IPCP,                 /* IPCP request to IPCP opened */
+    BBL_SETUP_IP6CP,                /* IP6CP request to IP6CP opened */
+    BBL_SETUP_DHCP,                 /* DHCP discover to ACK */
+    BBL_SETUP_DHCPV6,               /* DHCPv6 solicit to reply */
+    BBL_SETUP_MAX
+} __attribute__ ((__packed__)) bbl_setup_phase_t;
+
+/* Session setup latency per phase */
+typedef struct bbl_setup_latency_ {
+    uint64_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+    uint32_t hist[BBL_SETUP_LATENCY_BUCKETS];
+} bbl_setup_latency_s;
+
 /*
  * PPP state (LCP, IPCP and IP6CP)
  *
@@ -230,9 +270,12 @@ typedef struct bbl_network_interface_ bbl_network_interface_s;
 typedef struct bbl_a10nsp_interface_ bbl_a10nsp_interface_s;
 typedef struct bbl_a10nsp_session_ bbl_a10nsp_session_s;
 typedef struct bbl_session_ bbl_session_s;
+typedef struct bbl_session_shard_ bbl_session_shard_s;
+typedef struct bbl_session_worker_ bbl_session_worker_s;
 typedef struct bbl_stream_thread_ bbl_stream_thread_s;
 typedef struct bbl_stream_config_ bbl_stream_config_s;
 typedef struct bbl_stream_group_ bbl_stream_group_s;
+typedef struct bbl_stream_delay_ bbl_stream_delay_s;
 typedef struct bbl_stream_ bbl_stream_s;
 typedef struct bbl_tcp_ctx_ bbl_tcp_ctx_s;
 typedef struct bbl_ctrl_thread_ bbl_ctrl_thread_s;
@@ -241,5 +284,6 @@ typedef struct bbl_http_client_ bbl_http_client_s;
 typedef struct bbl_http_server_config_ bbl_http_server_config_s;
 typedef struct bbl_http_server_ bbl_http_server_s;
 typedef struct bbl_http_server_connection_ bbl_http_server_connection_s;
+typedef struct bbl_mrt_loader_ bbl_mrt_loader_s;
 
 #endif
\ No newline at end of file
@@ -20,6 +20,8 @@
 void
 bbl_dhcp_stop(bbl_session_s *session)
 {
+    bbl_session_counters_s *counters = &session->access_interface->shard->counters;
+
     LOG(DHCP, "DHCP (ID: %u) Stop DHCP\n", session->session_id);
 
     /* Reset session IP configuration */
@@ -65,12 +67,12 @@ bbl_dhcp_stop(bbl_session_s *session)
         session->dhcp_domain_name = NULL;
     }
 
-    if(session->dhcp_established && g_ctx->dhcp_established) {
-        g_ctx->dhcp_established--;
+    if(session->dhcp_established && counters->dhcp_established) {
+        counters->dhcp_established--;
     }
     session->dhcp_established = false;
-    if(session->dhcp_requested && g_ctx->dhcp_requested) {
-        g_ctx->dhcp_requested--;
+    if(session->dhcp_requested && counters->dhcp_requested) {
+        counters->dhcp_requested--;
     }
     session->dhcp_requested = false;
 }
@@ -87,7 +89,7 @@ bbl_dhcp_start(bbl_session_s *session)
 {
     if(!session->dhcp_requested) {
         session->dhcp_requested = true;
-        g_ctx->dhcp_requested++;
+        session->access_interface->shard->counters.dhcp_requested++;
 
         /* Init DHCP */
         session->dhcp_state = BBL_DHCP_SELECTING;
@@ -96,6 +98,7 @@ bbl_dhcp_start(bbl_session_s *session)
         session->dhcp_request_timestamp.tv_nsec = 0;
         session->dhcp_retry = 0;
         session->send_requests |= BBL_SEND_DHCP_REQUEST;
+        bbl_session_setup_start(session, BBL_SETUP_DHCP);
 
         LOG(DHCP, "DHCP (ID: %u) Start DHCP\n", session->session_id);
     }
@@ -195,7 +198,7 @@ bbl_dhcp_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcp_s *dhcp
                     bbl_dhcp_restart(session);
                     return;
                 }
-                timer_add(&g_ctx->timer_root, &session->timer_dhcp_t2, "DHCP T2", session->dhcp_lease_time, 0, session, &bbl_dhcp_s2);
+                timer_add(session->access_interface->shard->timer_root, &session->timer_dhcp_t2, "DHCP T2", session->dhcp_lease_time, 0, session, &bbl_dhcp_s2);
                 session->dhcp_request_timestamp.tv_sec = 0;
                 session->dhcp_request_timestamp.tv_nsec = 0;
                 session->dhcp_retry = 0;
@@ -258,15 +261,17 @@ bbl_dhcp_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcp_s *dhcp
 
                 session->send_requests &= ~BBL_SEND_DHCP_REQUEST;
                 if(!session->dhcp_established) {
+                    bbl_session_counters_s *counters = &session->access_interface->shard->counters;
                     session->dhcp_established = true;
-                    g_ctx->dhcp_established++;
-                    if(g_ctx->dhcp_established > g_ctx->dhcp_established_max) {
-                        g_ctx->dhcp_established_max = g_ctx->dhcp_established;
+                    counters->dhcp_established++;
+                    if(counters->dhcp_established > counters->dhcp_established_max) {
+                        counters->dhcp_established_max = counters->dhcp_established;
                     }
                 }
                 session->dhcp_state = BBL_DHCP_BOUND;
-                timer_add(&g_ctx->timer_root, &session->timer_dhcp_t1, "DHCP T1", session->dhcp_t1, 0, session, &bbl_dhcp_s1);
-                timer_add(&g_ctx->timer_root, &session->timer_dhcp_t2, "DHCP T2", session->dhcp_t2, 0, session, &bbl_dhcp_s2);
+                bbl_session_setup_done(session, BBL_SETUP_DHCP);
+                timer_add(session->access_interface->shard->timer_root, &session->timer_dhcp_t1, "DHCP T1", session->dhcp_t1, 0, session, &bbl_dhcp_s1);
+                timer_add(session->access_interface->shard->timer_root, &session->timer_dhcp_t2, "DHCP T2", session->dhcp_t2, 0, session, &bbl_dhcp_s2);
                 session->send_requests |= BBL_SEND_ARP_REQUEST;
                 bbl_session_tx_qnode_insert(session);
             } else if(dhcp->type == DHCP_MESSAGE_NAK) {
@@ -289,8 +294,8 @@ bbl_dhcp_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcp_s *dhcp
                 }
                 session->dhcp_t1 = 0.5 * session->dhcp_lease_time; if(!session->dhcp_t1) session->dhcp_t1 = 1;
                 session->dhcp_t2 = 0.875 * session->dhcp_lease_time; if(!session->dhcp_t2) session->dhcp_t2 = 1;
-                timer_add(&g_ctx->timer_root, &session->timer_dhcp_t1, "DHCP T1", session->dhcp_t1, 0, session, &bbl_dhcp_s1);
-                timer_add(&g_ctx->timer_root, &session->timer_dhcp_t2, "DHCP T2", session->dhcp_t2, 0, session, &bbl_dhcp_s2);
+                timer_add(session->access_interface->shard->timer_root, &session->timer_dhcp_t1, "DHCP T1", session->dhcp_t1, 0, session, &bbl_dhcp_s1);
+                timer_add(session->access_interface->shard->timer_root, &session->timer_dhcp_t2, "DHCP T2", session->dhcp_t2, 0, session, &bbl_dhcp_s2);
                 session->send_requests |= BBL_SEND_ARP_REQUEST;
                 bbl_session_tx_qnode_insert(session);
             } else if(dhcp->type == DHCP_MESSAGE_NAK) {
@@ -36,6 +36,8 @@ bbl_dhcpv6_status_code_string(uint16_t status_code)
 void
 bbl_dhcpv6_stop(bbl_session_s *session)
 {
+    bbl_session_counters_s *counters = &session->access_interface->shard->counters;
+
     if(session->dhcpv6_state == BBL_DHCP_DISABLED) {
         return;
     }
@@ -70,16 +72,36 @@ bbl_dhcpv6_stop(bbl_session_s *session)
     session->dhcpv6_lease_timestamp.tv_nsec = 0;
     session->dhcpv6_request_timestamp.tv_sec = 0;
     session->dhcpv6_request_timestamp.tv_nsec = 0;
-    if(session->dhcpv6_established && g_ctx->dhcpv6_established) {
-        g_ctx->dhcpv6_established--;
+    if(session->dhcpv6_established && counters->dhcpv6_established) {
+        counters->dhcpv6_established--;
     }
     session->dhcpv6_established = false;
-    if(session->dhcpv6_requested && g_ctx->dhcpv6_requested) {
-        g_ctx->dhcpv6_requested--;
+    if(session->dhcpv6_requested && counters->dhcpv6_requested) {
+        counters->dhcpv6_requested--;
     }
     session->dhcpv6_requested = false;
 }
 
+/**
+ * bbl_dhcpv6_iaid
+ *
+ * Returns the next IAID, which is shared
+ * by all session worker threads.
+ *
+ * @return IAID (never zero)
+ */
+static uint32_t
+bbl_dhcpv6_iaid()
+{
+    static uint32_t g_dhcpv6_iaid = 0;
+    uint32_t iaid;
+
+    do {
+        iaid = __atomic_add_fetch(&g_dhcpv6_iaid, 1, __ATOMIC_RELAXED);
+    } while(!iaid);
+    return iaid;
+}
+
 /**
  * bbl_dhcpv6_start
  *
@@ -90,25 +112,21 @@ bbl_dhcpv6_stop(bbl_session_s *session)
 void
 bbl_dhcpv6_start(bbl_session_s *session)
 {
-    static uint32_t g_dhcpv6_iaid = 1;
-    if(g_dhcpv6_iaid > UINT32_MAX-10) {
-        g_dhcpv6_iaid = 1;
-    }
-
     if(!session->dhcpv6_requested) {
         session->dhcpv6_requested = true;
-        g_ctx->dhcpv6_requested++;
+        session->access_interface->shard->counters.dhcpv6_requested++;
 
         /* Init DHCPv6 */
         session->dhcpv6_state = BBL_DHCP_SELECTING;
         session->dhcpv6_xid = rand() & 0xffffff;
+        bbl_session_setup_start(session, BBL_SETUP_DHCPV6);
 
         if(g_ctx->config.dhcpv6_ia_na && 
            session->access_type == ACCESS_TYPE_IPOE) {
-            session->dhcpv6_ia_na_iaid = g_dhcpv6_iaid++;
+            session->dhcpv6_ia_na_iaid = bbl_dhcpv6_iaid();
         }
         if(g_ctx->config.dhcpv6_ia_pd) {
-            session->dhcpv6_ia_pd_iaid = g_dhcpv6_iaid++;
+            session->dhcpv6_ia_pd_iaid = bbl_dhcpv6_iaid();
         }
 
         session->dhcpv6_retry = 0;
@@ -251,10 +269,11 @@ bbl_dhcpv6_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcpv6_s *
 
         /* Establish DHCPv6 */
         if(!session->dhcpv6_established) {
+            bbl_session_counters_s *counters = &session->access_interface->shard->counters;
             session->dhcpv6_established = true;
-            g_ctx->dhcpv6_established++;
-            if(g_ctx->dhcpv6_established > g_ctx->dhcpv6_established_max) {
-                g_ctx->dhcpv6_established_max = g_ctx->dhcpv6_established;
+            counters->dhcpv6_established++;
+            if(counters->dhcpv6_established > counters->dhcpv6_established_max) {
+                counters->dhcpv6_established_max = counters->dhcpv6_established;
             }
             if(dhcpv6->dns1) {
                 memcpy(&session->dhcpv6_dns1, dhcpv6->dns1, IPV6_ADDR_LEN);
@@ -292,12 +311,13 @@ bbl_dhcpv6_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcpv6_s *
         session->dhcpv6_lease_timestamp.tv_sec = eth->timestamp.tv_sec;
         session->dhcpv6_lease_timestamp.tv_nsec = eth->timestamp.tv_nsec;
         session->dhcpv6_state = BBL_DHCP_BOUND;
+        bbl_session_setup_done(session, BBL_SETUP_DHCPV6);
         if(session->dhcpv6_t1) {
-            timer_add(&g_ctx->timer_root, &session->timer_dhcpv6_t1, "DHCPv6 T1", 
+            timer_add(session->access_interface->shard->timer_root, &session->timer_dhcpv6_t1, "DHCPv6 T1", 
                       session->dhcpv6_t1, 0, session, &bbl_dhcpv6_s1);
         }
         if(session->dhcpv6_t2) {
-            timer_add(&g_ctx->timer_root, &session->timer_dhcpv6_t2, "DHCPv6 T2", 
+            timer_add(session->access_interface->shard->timer_root, &session->timer_dhcpv6_t2, "DHCPv6 T2", 
                       session->dhcpv6_t2, 0, session, &bbl_dhcpv6_s2);
         }
         if(session->access_type == ACCESS_TYPE_IPOE) {
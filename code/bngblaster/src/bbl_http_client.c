@@ -261,7 +261,7 @@ bbl_http_client_add(bbl_http_client_config_s *config, bbl_session_s *session)
     client->session = session;
     client->config = config;
 
-    if(!session->netif.state) {
+    if(!session->netif) {
         return false;
     }
 
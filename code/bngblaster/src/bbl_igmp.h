@@ -27,6 +27,9 @@ typedef struct bbl_igmp_group_
     struct timespec last_mc_rx_time;
 } bbl_igmp_group_s;
 
+bool
+bbl_igmp_groups_init(bbl_session_s *session);
+
 void
 bbl_igmp_rx(bbl_session_s *session, bbl_ipv4_s *ipv4);
 
@@ -285,12 +285,16 @@ bbl_interactive_window_job(timer_s *timer)
     char strsp[STRING_SP_SIZE];
 
     bbl_session_s *session;
+    bbl_session_counters_s counters;
+    const char *s;
     int i;
     double d;
 
     int pos = 1; /* position */
     bool visible = false;
 
+    bbl_session_counters(&counters);
+
     if(g_banner) {
         wmove(stats_win, 14, 0);
     } else {
@@ -299,8 +303,8 @@ bbl_interactive_window_job(timer_s *timer)
 
     clock_gettime(CLOCK_MONOTONIC, &now);
     timespec_sub(&time_duration, &now, &g_ctx->timestamp_start);
-    if(g_ctx->timestamp_established.tv_sec) {
-        timespec_sub(&time_established, &now, &g_ctx->timestamp_established);
+    if(counters.timestamp_established.tv_sec) {
+        timespec_sub(&time_established, &now, &counters.timestamp_established);
         wprintw(stats_win, "Test Duration: %lus All Sessions Established: %lus\n", 
             time_duration.tv_sec, time_established.tv_sec);
     } else {
@@ -313,59 +317,59 @@ bbl_interactive_window_job(timer_s *timer)
             wprintw(stats_win, "\nSessions      %10u (%u PPPoE / %u IPoE)\n", g_ctx->sessions, g_ctx->sessions_pppoe, g_ctx->sessions_ipoe);
 
             /* Progress bar established sessions */
-            wprintw(stats_win, "  Established %10u [", g_ctx->sessions_established);
-            if(g_ctx->sessions == g_ctx->sessions_established) {
+            wprintw(stats_win, "  Established %10u [", counters.sessions_established);
+            if(g_ctx->sessions == counters.sessions_established) {
                 wattron(stats_win, COLOR_PAIR(COLOR_GREEN));
-                wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->sessions, g_ctx->sessions_established));
+                wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->sessions, counters.sessions_established));
                 wattroff(stats_win, COLOR_PAIR(COLOR_GREEN));
             } else {
                 wattron(stats_win, COLOR_PAIR(COLOR_BLACK));
-                wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->sessions, g_ctx->sessions_established));
+                wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->sessions, counters.sessions_established));
                 wattroff(stats_win, COLOR_PAIR(COLOR_BLACK));
             }
             wprintw(stats_win, "]\n");
 
             /* Progress bar outstanding sessions */
-            wprintw(stats_win, "  Outstanding %10u [", g_ctx->sessions_outstanding);
+            wprintw(stats_win, "  Outstanding %10u [", counters.sessions_outstanding);
             wattron(stats_win, COLOR_PAIR(COLOR_BLACK));
-            wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->config.sessions_max_outstanding, g_ctx->sessions_outstanding));
+            wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->config.sessions_max_outstanding, counters.sessions_outstanding));
             wattroff(stats_win, COLOR_PAIR(COLOR_BLACK));
             wprintw(stats_win, "]\n");
 
             /* Progress bar terminated sessions */
-            wprintw(stats_win, "  Terminated  %10u [", g_ctx->sessions_terminated);
+            wprintw(stats_win, "  Terminated  %10u [", counters.sessions_terminated);
             wattron(stats_win, COLOR_PAIR(COLOR_RED));
-            wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->sessions, g_ctx->sessions_terminated));
+            wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->sessions, counters.sessions_terminated));
             wattroff(stats_win, COLOR_PAIR(COLOR_RED));
             wprintw(stats_win, "]\n");
 
             /* DHCPv4 */
-            if(g_ctx->dhcp_requested || g_ctx->dhcp_established_max) {
+            if(counters.dhcp_requested || counters.dhcp_established_max) {
 
-                snprintf(strsp, STRING_SP_SIZE, "%u/%u", g_ctx->dhcp_established, g_ctx->dhcp_requested);
+                snprintf(strsp, STRING_SP_SIZE, "%u/%u", counters.dhcp_established, counters.dhcp_requested);
                 wprintw(stats_win, "  DHCPv4 %15s [", strsp);
-                if(g_ctx->dhcp_requested == g_ctx->dhcp_established) {
+                if(counters.dhcp_requested == counters.dhcp_established) {
                     wattron(stats_win, COLOR_PAIR(COLOR_GREEN));
-                    wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->dhcp_requested, g_ctx->dhcp_established));
+                    wprintw(stats_win, "%s", bbl_interactive_format_progress(counters.dhcp_requested, counters.dhcp_established));
                     wattroff(stats_win, COLOR_PAIR(COLOR_GREEN));
                 } else {
                     wattron(stats_win, COLOR_PAIR(COLOR_BLACK));
-                    wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->dhcp_requested, g_ctx->dhcp_established));
+                    wprintw(stats_win, "%s", bbl_interactive_format_progress(counters.dhcp_requested, counters.dhcp_established));
                     wattroff(stats_win, COLOR_PAIR(COLOR_BLACK));
                 }
                 wprintw(stats_win, "]\n");
             }
             /* DHCPv6 */
-            if(g_ctx->dhcpv6_requested || g_ctx->dhcpv6_established_max) {
-                snprintf(strsp, STRING_SP_SIZE, "%u/%u", g_ctx->dhcpv6_established, g_ctx->dhcpv6_requested);
+            if(counters.dhcpv6_requested || counters.dhcpv6_established_max) {
+                snprintf(strsp, STRING_SP_SIZE, "%u/%u", counters.dhcpv6_established, counters.dhcpv6_requested);
                 wprintw(stats_win, "  DHCPv6 %15s [", strsp);
-                if(g_ctx->dhcpv6_requested == g_ctx->dhcpv6_established) {
+                if(counters.dhcpv6_requested == counters.dhcpv6_established) {
                     wattron(stats_win, COLOR_PAIR(COLOR_GREEN));
-                    wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->dhcpv6_requested, g_ctx->dhcpv6_established));
+                    wprintw(stats_win, "%s", bbl_interactive_format_progress(counters.dhcpv6_requested, counters.dhcpv6_established));
                     wattroff(stats_win, COLOR_PAIR(COLOR_GREEN));
                 } else {
                     wattron(stats_win, COLOR_PAIR(COLOR_BLACK));
-                    wprintw(stats_win, "%s", bbl_interactive_format_progress(g_ctx->dhcpv6_requested, g_ctx->dhcpv6_established));
+                    wprintw(stats_win, "%s", bbl_interactive_format_progress(counters.dhcpv6_requested, counters.dhcpv6_established));
                     wattroff(stats_win, COLOR_PAIR(COLOR_BLACK));
                 }
                 wprintw(stats_win, "]\n");
@@ -374,7 +378,7 @@ bbl_interactive_window_job(timer_s *timer)
             wprintw(stats_win, "  Setup Time  %10u ms\n", g_ctx->stats.setup_time);
             wprintw(stats_win, "  Setup Rate  %10.02lf CPS (MIN: %0.02lf AVG: %0.02lf MAX: %0.02lf)\n",
                     g_ctx->stats.cps, g_ctx->stats.cps_min, g_ctx->stats.cps_avg, g_ctx->stats.cps_max);
-            wprintw(stats_win, "  Flapped     %10u\n", g_ctx->sessions_flapped);
+            wprintw(stats_win, "  Flapped     %10u\n", counters.sessions_flapped);
         }
 
         if(g_network_if) {
@@ -644,14 +648,17 @@ bbl_interactive_window_job(timer_s *timer)
         session = bbl_session_get(g_session_selected);
         if(session) {
             wprintw(stats_win, "\n     State: %s \n", session_state_string(session->session_state));
-            if(session->username) {
-                wprintw(stats_win, "  Username: %s \n", session->username);
+            s = bbl_session_string(session, BBL_SESSION_USERNAME);
+            if(s) {
+                wprintw(stats_win, "  Username: %s \n", s);
             }
-            if(session->agent_remote_id) {
-                wprintw(stats_win, "       ARI: %s \n", session->agent_remote_id);
+            s = bbl_session_string(session, BBL_SESSION_AGENT_REMOTE_ID);
+            if(s) {
+                wprintw(stats_win, "       ARI: %s \n", s);
             }
-            if(session->agent_remote_id) {
-                wprintw(stats_win, "       ACI: %s \n", session->agent_circuit_id);
+            s = bbl_session_string(session, BBL_SESSION_AGENT_CIRCUIT_ID);
+            if(s) {
+                wprintw(stats_win, "       ACI: %s \n", s);
             }
             if(session->connections_status_message || session->reply_message) {
                 wprintw(stats_win, "\n");
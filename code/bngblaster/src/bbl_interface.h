@@ -41,6 +41,10 @@ typedef struct bbl_interface_
         struct timer_ *tx_job;
         io_handle_s *rx;
         io_handle_s *tx;
+        uint8_t *sp; /* scratchpad of the thread executing RX jobs */
+#ifdef BNGBLASTER_AF_XDP
+        io_xdp_s *xdp;
+#endif
     } io;
 } bbl_interface_s;
 
@@ -0,0 +1,454 @@
+/*
+ * BNG Blaster (BBL) - MRT File Loader
+ *
+ * MRT files are memory mapped and indexed by a loader
+ * thread. The records are validated in parallel by up to
+ * BBL_MRT_WORKER_MAX worker threads before they are
+ * committed to the protocol database in batches from
+ * the main loop, which keeps adjacencies and sessions
+ * running while loading large files.
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bbl.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct bbl_mrt_worker_ {
+    bbl_mrt_loader_s *loader;
+    uint64_t first;
+    uint64_t last;
+    pthread_t thread;
+} bbl_mrt_worker_s;
+
+static const char *
+bbl_mrt_state_string(bbl_mrt_state_t state)
+{
+    switch(state) {
+        case BBL_MRT_INDEX: return "index";
+        case BBL_MRT_COMMIT: return "commit";
+        case BBL_MRT_DONE: return "done";
+        case BBL_MRT_FAILED: return "failed";
+        default: return "unknown";
+    }
+}
+
+static void
+bbl_mrt_unmap(bbl_mrt_loader_s *loader)
+{
+    if(loader->map) {
+        munmap(loader->map, loader->map_len);
+        loader->map = NULL;
+    }
+    if(loader->fd >= 0) {
+        close(loader->fd);
+        loader->fd = -1;
+    }
+    if(loader->records) {
+        free(loader->records);
+        loader->records = NULL;
+    }
+}
+
+/**
+ * bbl_mrt_index
+ *
+ * Walk over all MRT headers and store offset,
+ * length and type of each record in the index.
+ *
+ * @param loader MRT loader
+ * @return true if successful
+ */
+static bool
+bbl_mrt_index(bbl_mrt_loader_s *loader)
+{
+    bbl_mrt_record_s *records;
+    bbl_mrt_record_s *record;
+    uint8_t *hdr;
+    uint64_t offset = 0;
+    uint64_t max;
+
+    while(offset < loader->map_len) {
+        if(loader->map_len - offset < BBL_MRT_HDR_LEN) {
+            loader->error = "truncated MRT header";
+            return false;
+        }
+        if(loader->record_count == loader->record_max) {
+            max = loader->record_max ? loader->record_max * 2 : BBL_MRT_WORKER_RECORDS;
+            records = realloc(loader->records, max * sizeof(bbl_mrt_record_s));
+            if(!records) {
+                loader->error = "failed to allocate MRT index";
+                return false;
+            }
+            loader->records = records;
+            loader->record_max = max;
+        }
+        hdr = loader->map + offset;
+        record = &loader->records[loader->record_count];
+        record->type = read_be_uint(hdr+4, sizeof(uint16_t));
+        record->subtype = read_be_uint(hdr+6, sizeof(uint16_t));
+        record->len = read_be_uint(hdr+8, sizeof(uint32_t));
+        record->offset = offset + BBL_MRT_HDR_LEN;
+        if(record->len > loader->map_len - record->offset) {
+            loader->error = "truncated MRT record";
+            return false;
+        }
+        offset = record->offset + record->len;
+        __atomic_store_n(&loader->record_count, loader->record_count+1, __ATOMIC_RELAXED);
+        __atomic_store_n(&loader->indexed, offset, __ATOMIC_RELAXED);
+    }
+    return true;
+}
+
+/**
+ * bbl_mrt_validate
+ *
+ * Validate records from first to last (excluding) and
+ * store the lowest invalid record in error_record.
+ *
+ * @param loader MRT loader
+ * @param first first record
+ * @param last last record (excluding)
+ */
+static void
+bbl_mrt_validate(bbl_mrt_loader_s *loader, uint64_t first, uint64_t last)
+{
+    bbl_mrt_record_s *record;
+    uint64_t error_record;
+
+    for(uint64_t i = first; i < last; i++) {
+        record = &loader->records[i];
+        if(loader->validate(loader->instance, record->type, record->subtype,
+                            loader->map + record->offset, record->len)) {
+            continue;
+        }
+        error_record = __atomic_load_n(&loader->error_record, __ATOMIC_ACQUIRE);
+        while(error_record == 0 || error_record > i+1) {
+            if(__atomic_compare_exchange_n(&loader->error_record, &error_record, i+1, false,
+                                           __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+        }
+        return;
+    }
+}
+
+static void *
+bbl_mrt_worker_thread(void *arg)
+{
+    bbl_mrt_worker_s *worker = arg;
+    bbl_mrt_validate(worker->loader, worker->first, worker->last);
+    return NULL;
+}
+
+/**
+ * bbl_mrt_thread
+ *
+ * Loader thread which indexes the memory mapped
+ * file and validates all records using worker threads.
+ *
+ * @param arg MRT loader
+ */
+static void *
+bbl_mrt_thread(void *arg)
+{
+    bbl_mrt_loader_s *loader = arg;
+    bbl_mrt_worker_s worker[BBL_MRT_WORKER_MAX] = {0};
+    uint64_t count;
+    uint64_t slice;
+    long cpus;
+    uint8_t workers;
+
+    if(!bbl_mrt_index(loader)) {
+        __atomic_store_n(&loader->state, BBL_MRT_FAILED, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    /* Split the index into slices of at least BBL_MRT_WORKER_RECORDS
+     * records, where the first slice is validated by the loader thread. */
+    count = loader->record_count;
+    workers = BBL_MRT_WORKER_MAX;
+    if(count / BBL_MRT_WORKER_RECORDS + 1 < workers) {
+        workers = count / BBL_MRT_WORKER_RECORDS + 1;
+    }
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cpus > 0 && cpus < workers) {
+        workers = cpus;
+    }
+    slice = (count + workers - 1) / workers;
+    for(uint8_t i = 0; i < workers; i++) {
+        worker[i].loader = loader;
+        worker[i].first = i * slice;
+        worker[i].last = worker[i].first + slice;
+        if(worker[i].first > count) worker[i].first = count;
+        if(worker[i].last > count) worker[i].last = count;
+        if(i > 0 && pthread_create(&worker[i].thread, NULL, bbl_mrt_worker_thread, &worker[i]) != 0) {
+            worker[i].loader = NULL;
+            bbl_mrt_validate(loader, worker[i].first, worker[i].last);
+        }
+    }
+    bbl_mrt_validate(loader, worker[0].first, worker[0].last);
+    for(uint8_t i = 1; i < workers; i++) {
+        if(worker[i].loader) {
+            pthread_join(worker[i].thread, NULL);
+        }
+    }
+    loader->workers = workers;
+
+    if(loader->error_record) {
+        loader->error = "invalid MRT record";
+        __atomic_store_n(&loader->state, BBL_MRT_FAILED, __ATOMIC_RELEASE);
+    } else {
+        __atomic_store_n(&loader->state, BBL_MRT_COMMIT, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/**
+ * bbl_mrt_commit
+ *
+ * Commit validated records up to last (excluding).
+ *
+ * @param loader MRT loader
+ * @param last last record (excluding)
+ * @return new loader state
+ */
+static bbl_mrt_state_t
+bbl_mrt_commit(bbl_mrt_loader_s *loader, uint64_t last)
+{
+    bbl_mrt_record_s *record;
+
+    if(last > loader->record_count) {
+        last = loader->record_count;
+    }
+    while(loader->committed < last) {
+        record = &loader->records[loader->committed];
+        if(!loader->commit(loader->instance, record->type, record->subtype,
+                           loader->map + record->offset, record->len)) {
+            loader->error = "failed to commit MRT record";
+            loader->error_record = loader->committed + 1;
+            return BBL_MRT_FAILED;
+        }
+        loader->committed++;
+    }
+    if(loader->committed == loader->record_count) {
+        if(loader->done) {
+            loader->done(loader->instance, loader->startup);
+        }
+        return BBL_MRT_DONE;
+    }
+    return BBL_MRT_COMMIT;
+}
+
+static void
+bbl_mrt_finish(bbl_mrt_loader_s *loader, bbl_mrt_state_t state)
+{
+    clock_gettime(CLOCK_MONOTONIC, &loader->stop);
+    if(state == BBL_MRT_DONE) {
+        LOG(INFO, "Loaded %lu records from %s MRT file %s\n",
+            loader->committed, loader->protocol, loader->file_path);
+    } else {
+        LOG(ERROR, "Failed to load %s MRT file %s (%s at record %lu)\n",
+            loader->protocol, loader->file_path, loader->error, loader->error_record);
+    }
+    bbl_mrt_unmap(loader);
+}
+
+/**
+ * bbl_mrt_job
+ *
+ * Main loop job which commits the validated
+ * records in batches of BBL_MRT_BATCH records.
+ *
+ * @param timer timer
+ */
+static void
+bbl_mrt_job(timer_s *timer)
+{
+    bbl_mrt_loader_s *loader = timer->data;
+    bbl_mrt_state_t state;
+
+    state = __atomic_load_n(&loader->state, __ATOMIC_ACQUIRE);
+    if(state == BBL_MRT_INDEX) {
+        return;
+    }
+    if(!loader->joined) {
+        pthread_join(loader->thread, NULL);
+        loader->joined = true;
+    }
+    if(state == BBL_MRT_COMMIT) {
+        state = bbl_mrt_commit(loader, loader->committed + BBL_MRT_BATCH);
+        __atomic_store_n(&loader->state, state, __ATOMIC_RELEASE);
+    }
+    if(state == BBL_MRT_DONE || state == BBL_MRT_FAILED) {
+        bbl_mrt_finish(loader, state);
+        timer->periodic = false;
+    }
+}
+
+/**
+ * bbl_mrt_load
+ *
+ * Start loading a MRT file. The file is memory mapped,
+ * indexed and validated in background threads before
+ * records are committed from the main loop. During 
+ * startup, the file is loaded completely before
+ * this function returns.
+ *
+ * @param protocol protocol name (e.g. isis)
+ * @param instance_id protocol instance identifier
+ * @param instance protocol instance
+ * @param file_path MRT file
+ * @param startup true if loaded during startup
+ * @param validate record validation (thread-safe)
+ * @param commit record commit
+ * @param done optional function called after all records are committed
+ * @return true if loading has started (startup: loaded)
+ */
+bool
+bbl_mrt_load(const char *protocol, uint16_t instance_id, void *instance,
+             char *file_path, bool startup,
+             bbl_mrt_record_fn *validate,
+             bbl_mrt_record_fn *commit,
+             bbl_mrt_done_fn *done)
+{
+    bbl_mrt_loader_s *loader;
+    bbl_mrt_state_t state;
+    struct stat st;
+
+    loader = calloc(1, sizeof(bbl_mrt_loader_s));
+    if(!loader) {
+        return false;
+    }
+    loader->protocol = protocol;
+    loader->instance_id = instance_id;
+    loader->instance = instance;
+    loader->startup = startup;
+    loader->validate = validate;
+    loader->commit = commit;
+    loader->done = done;
+
+    loader->fd = open(file_path, O_RDONLY);
+    if(loader->fd < 0 || fstat(loader->fd, &st) != 0) {
+        LOG(ERROR, "Failed to open MRT file %s\n", file_path);
+        goto ERROR;
+    }
+    loader->map_len = st.st_size;
+    if(loader->map_len) {
+        /* The mapping is private and writable as some protocols
+         * modify PDUs temporarily (e.g. checksum verification). */
+        loader->map = mmap(NULL, loader->map_len, PROT_READ|PROT_WRITE, MAP_PRIVATE, loader->fd, 0);
+        if(loader->map == MAP_FAILED) {
+            loader->map = NULL;
+            LOG(ERROR, "Failed to map MRT file %s (%s)\n", file_path, strerror(errno));
+            goto ERROR;
+        }
+        madvise(loader->map, loader->map_len, MADV_WILLNEED);
+    }
+    loader->file_path = strdup(file_path);
+    clock_gettime(CLOCK_MONOTONIC, &loader->start);
+
+    if(pthread_create(&loader->thread, NULL, bbl_mrt_thread, (void *)loader) != 0) {
+        LOG(ERROR, "Failed to create MRT loader thread for %s\n", file_path);
+        free(loader->file_path);
+        goto ERROR;
+    }
+
+    LOG(INFO, "Load %s MRT file %s (%lu bytes)\n", protocol, file_path, loader->map_len);
+
+    if(startup) {
+        /* Invalid files must prevent the startup, therefore 
+         * the loader thread is joined and all records are 
+         * committed before the main loop is started. */
+        pthread_join(loader->thread, NULL);
+        loader->joined = true;
+        state = __atomic_load_n(&loader->state, __ATOMIC_ACQUIRE);
+        if(state == BBL_MRT_COMMIT) {
+            state = bbl_mrt_commit(loader, loader->record_count);
+        }
+        loader->state = state;
+        bbl_mrt_finish(loader, state);
+        if(state != BBL_MRT_DONE) {
+            free(loader->file_path);
+            free(loader);
+            return false;
+        }
+    }
+
+    loader->next = g_ctx->mrt_loaders;
+    g_ctx->mrt_loaders = loader;
+    if(!startup) {
+        timer_add_periodic(&g_ctx->timer_root, &loader->timer, "MRT Loader",
+                           0, BBL_MRT_INTERVAL * MSEC, loader, &bbl_mrt_job);
+    }
+    return true;
+
+ERROR:
+    bbl_mrt_unmap(loader);
+    free(loader);
+    return false;
+}
+
+static json_t *
+bbl_mrt_json(bbl_mrt_loader_s *loader)
+{
+    bbl_mrt_state_t state;
+    struct timespec now;
+    struct timespec time_diff;
+    uint64_t duration_ms;
+
+    state = __atomic_load_n(&loader->state, __ATOMIC_ACQUIRE);
+    if(state == BBL_MRT_DONE || state == BBL_MRT_FAILED) {
+        timespec_sub(&time_diff, &loader->stop, &loader->start);
+    } else {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timespec_sub(&time_diff, &now, &loader->start);
+    }
+    duration_ms = time_diff.tv_sec * 1000 + time_diff.tv_nsec / MSEC;
+
+    return json_pack("{ss ss si ss sI sI sI sI si sI ss*}",
+        "file", loader->file_path,
+        "protocol", loader->protocol,
+        "instance-id", loader->instance_id,
+        "state", bbl_mrt_state_string(state),
+        "bytes", loader->map_len,
+        "bytes-indexed", __atomic_load_n(&loader->indexed, __ATOMIC_RELAXED),
+        "records", __atomic_load_n(&loader->record_count, __ATOMIC_RELAXED),
+        "records-committed", loader->committed,
+        "workers", state == BBL_MRT_INDEX ? 0 : loader->workers,
+        "duration-ms", duration_ms,
+        "error", state == BBL_MRT_FAILED ? loader->error : NULL);
+}
+
+int
+bbl_mrt_ctrl_info(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
+{
+    int result = 0;
+
+    bbl_mrt_loader_s *loader = g_ctx->mrt_loaders;
+    json_t *root, *jobj, *jobj_array;
+
+    jobj_array = json_array();
+    while(loader) {
+        jobj = bbl_mrt_json(loader);
+        if(jobj) {
+            json_array_append_new(jobj_array, jobj);
+        }
+        loader = loader->next;
+    }
+
+    root = json_pack("{ss si so*}",
+        "status", "ok",
+        "code", 200,
+        "mrt-info", jobj_array);
+
+    if(root) {
+        result = json_dumpfd(root, fd, 0);
+        json_decref(root);
+    } else {
+        result = bbl_ctrl_status(fd, "error", 500, "internal error");
+    }
+    return result;
+}
@@ -0,0 +1,82 @@
+/*
+ * BNG Blaster (BBL) - MRT File Loader
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_MRT_H__
+#define __BBL_MRT_H__
+
+#define BBL_MRT_HDR_LEN         12
+#define BBL_MRT_WORKER_MAX      8
+#define BBL_MRT_WORKER_RECORDS  4096 /* min records per worker */
+#define BBL_MRT_BATCH           2048 /* max records committed per interval */
+#define BBL_MRT_INTERVAL        10 /* msec */
+
+typedef enum {
+    BBL_MRT_INDEX = 0,
+    BBL_MRT_COMMIT,
+    BBL_MRT_DONE,
+    BBL_MRT_FAILED,
+} __attribute__ ((__packed__)) bbl_mrt_state_t;
+
+/* Validate a single record (executed in worker threads)
+ * or commit a single record (executed in main thread). */
+typedef bool bbl_mrt_record_fn(void *instance, uint16_t type, uint16_t subtype, uint8_t *buf, uint32_t len);
+
+/* Called in main thread after all records are committed. */
+typedef void bbl_mrt_done_fn(void *instance, bool startup);
+
+typedef struct bbl_mrt_record_ {
+    uint64_t offset; /* offset of record data */
+    uint32_t len;
+    uint16_t type;
+    uint16_t subtype;
+} bbl_mrt_record_s;
+
+typedef struct bbl_mrt_loader_ {
+    char *file_path;
+    const char *protocol;
+    uint16_t instance_id;
+    void *instance;
+    bool startup;
+
+    bbl_mrt_record_fn *validate;
+    bbl_mrt_record_fn *commit;
+    bbl_mrt_done_fn *done;
+
+    int fd;
+    uint8_t *map;
+    size_t map_len;
+
+    bbl_mrt_record_s *records;
+    uint64_t indexed; /* bytes indexed */
+    uint64_t record_count;
+    uint64_t record_max;
+    uint64_t committed;
+    uint64_t error_record; /* first invalid record (index + 1) */
+
+    const char *error;
+    uint8_t workers;
+    pthread_t thread;
+    bool joined;
+    bbl_mrt_state_t state; /* updated atomic */
+
+    struct timer_ *timer;
+    struct timespec start;
+    struct timespec stop;
+
+    bbl_mrt_loader_s *next;
+} bbl_mrt_loader_s;
+
+bool
+bbl_mrt_load(const char *protocol, uint16_t instance_id, void *instance,
+             char *file_path, bool startup,
+             bbl_mrt_record_fn *validate,
+             bbl_mrt_record_fn *commit,
+             bbl_mrt_done_fn *done);
+
+int
+bbl_mrt_ctrl_info(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)));
+
+#endif
@@ -13,6 +13,10 @@
 #include "ospf/ospf_def.h"
 #include "ldp/ldp_def.h"
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 static protocol_error_t decode_l2tp(uint8_t *buf, uint16_t len, uint8_t *sp, uint16_t sp_len, bbl_ethernet_header_s *eth, bbl_l2tp_s **_l2tp);
 static protocol_error_t encode_l2tp(uint8_t *buf, uint16_t *len, bbl_l2tp_s *l2tp);
 
@@ -42,28 +46,172 @@ packet_is_bbl(uint8_t *buf, uint16_t len)
  * ------------------------------------------------------------------------*/
 
 static uint32_t
-_checksum(void *buf, ssize_t len)
+_fold(uint32_t sum)
+{
+    while(sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return sum;
+}
+
+static uint32_t
+_fold64(uint64_t sum)
 {
-    uint32_t result = 0;
-    uint16_t *cur = buf;
-    while (len > 1) {
-        result += *cur++;
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    return _fold(sum);
+}
+
+/*
+ * Generic checksum kernel summing 64 bit words as 
+ * two 32 bit halves, which can't overflow the 64 bit 
+ * accumulator. The one's complement sum is independent
+ * of the word size (RFC 1071), the result is folded 
+ * to 16 bit but not inverted.
+ */
+static uint32_t
+_checksum_generic(void *buf, ssize_t len)
+{
+    uint64_t sum = 0;
+    uint64_t word;
+    uint8_t *cur = buf;
+
+    while(len >= 32) {
+        word = *(uint64_t*)cur;
+        sum += (word & 0xffffffff) + (word >> 32);
+        word = *(uint64_t*)(cur+8);
+        sum += (word & 0xffffffff) + (word >> 32);
+        word = *(uint64_t*)(cur+16);
+        sum += (word & 0xffffffff) + (word >> 32);
+        word = *(uint64_t*)(cur+24);
+        sum += (word & 0xffffffff) + (word >> 32);
+        cur += 32;
+        len -= 32;
+    }
+    while(len >= 8) {
+        word = *(uint64_t*)cur;
+        sum += (word & 0xffffffff) + (word >> 32);
+        cur += 8;
+        len -= 8;
+    }
+    if(len >= 4) {
+        sum += *(uint32_t*)cur;
+        cur += 4;
+        len -= 4;
+    }
+    if(len >= 2) {
+        sum += *(uint16_t*)cur;
+        cur += 2;
         len -= 2;
     }
     /*  Add left-over byte, if any */
     if(len) {
-        result += *(uint8_t*)cur;
+        sum += *cur;
     }
-    return result;
+    return _fold64(sum);
 }
 
+#if defined(__x86_64__)
+/*
+ * AVX2 checksum kernel zero-extending 16 bit words 
+ * to 32 bit lanes using two independent accumulators. 
+ * The lanes are flushed every 64K bytes, before they 
+ * could overflow.
+ */
+__attribute__((target("avx2")))
 static uint32_t
-_fold(uint32_t sum)
+_checksum_avx2(void *buf, ssize_t len)
 {
-    while(sum >> 16) {
-        sum = (sum & 0xffff) + (sum >> 16);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0, acc1;
+    __m256i data0, data1;
+    uint32_t lanes[8];
+    uint64_t sum = 0;
+    uint8_t *cur = buf;
+    int block, i;
+
+    while(len >= 64) {
+        acc0 = zero;
+        acc1 = zero;
+        for(block = 0; block < 1024 && len >= 64; block++) {
+            data0 = _mm256_loadu_si256((const __m256i*)cur);
+            data1 = _mm256_loadu_si256((const __m256i*)(cur+32));
+            acc0 = _mm256_add_epi32(acc0, _mm256_unpacklo_epi16(data0, zero));
+            acc1 = _mm256_add_epi32(acc1, _mm256_unpackhi_epi16(data0, zero));
+            acc0 = _mm256_add_epi32(acc0, _mm256_unpacklo_epi16(data1, zero));
+            acc1 = _mm256_add_epi32(acc1, _mm256_unpackhi_epi16(data1, zero));
+            cur += 64;
+            len -= 64;
+        }
+        _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi32(acc0, acc1));
+        for(i = 0; i < 8; i++) {
+            sum += lanes[i];
+        }
     }
-    return sum;
+    sum += _checksum_generic(cur, len);
+    return _fold64(sum);
+}
+#endif
+
+/* Checksum kernel used for larger buffers, 
+ * selected by bbl_checksum_init. */
+static uint32_t (*_checksum_kernel)(void *buf, ssize_t len) = _checksum_generic;
+static const char *_checksum_kernel_name = "generic";
+
+/* Vector kernels are used for buffers of at 
+ * least this size only, smaller buffers like 
+ * pseudo headers are summed inline. */
+#define CHECKSUM_KERNEL_MIN_LEN 256
+
+static inline uint32_t
+_checksum(void *buf, ssize_t len)
+{
+    if(len < CHECKSUM_KERNEL_MIN_LEN) {
+        return _checksum_generic(buf, len);
+    }
+    return _checksum_kernel(buf, len);
+}
+
+/**
+ * Select the fastest checksum kernel 
+ * supported by the CPU (CPUID). 
+ *
+ * @return kernel name
+ */
+const char *
+bbl_checksum_init()
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        _checksum_kernel = _checksum_avx2;
+        _checksum_kernel_name = "avx2";
+    }
+#endif
+    return _checksum_kernel_name;
+}
+
+/**
+ * Incremental checksum update (RFC 1624). 
+ *
+ * HC' = ~(~HC + ~m + m')
+ *
+ * The changed data must start at an even 
+ * offset relative to the checksummed data.
+ *
+ * @param checksum current checksum (HC)
+ * @param old old data (m)
+ * @param new new data (m')
+ * @param len data length
+ * @return updated checksum (HC')
+ */
+uint16_t
+bbl_checksum_update(uint16_t checksum, void *old, void *new, uint16_t len)
+{
+    uint32_t sum = (uint16_t)~checksum;
+    sum += (uint16_t)~_checksum(old, len);
+    sum += _checksum(new, len);
+    return ~_fold(sum);
 }
 
 uint16_t
@@ -843,6 +991,7 @@ encode_raw_tcp(uint8_t *buf, uint16_t *len,
     BUMP_WRITE_BUFFER(buf, len, sizeof(uint16_t));
     *(uint16_t*)buf = 0xff; /* Set max window size */
     BUMP_WRITE_BUFFER(buf, len, sizeof(uint16_t));
+    *(uint32_t*)buf = 0; /* Checksum and urgent pointer */
     BUMP_WRITE_BUFFER(buf, len, sizeof(uint32_t));
 
     /* Add protocol */
@@ -4633,3 +4782,187 @@ decode_ethernet(uint8_t *buf, uint16_t len,
 
     return UNKNOWN_PROTOCOL;
 }
+
+/*
+ * decode_ethernet_bbl
+ *
+ * Decode BNG Blaster stream traffic with fixed-offset
+ * headers (up to two VLAN tags, optional PPPoE session,
+ * IPv4 without options or IPv6, UDP with BBL destination
+ * port) into the same header chain as decode_ethernet.
+ * All other packets are rejected with UNKNOWN_PROTOCOL
+ * to be decoded by decode_ethernet.
+ */
+static protocol_error_t
+decode_ethernet_bbl(uint8_t *buf, uint16_t len,
+                    uint8_t *sp, uint16_t sp_len,
+                    bbl_ethernet_header_s **_eth)
+{
+    bbl_ethernet_header_s *eth;
+    bbl_pppoe_session_s *pppoe = NULL;
+    bbl_ipv4_s *ipv4 = NULL;
+    bbl_ipv6_s *ipv6 = NULL;
+    bbl_udp_s *udp;
+
+    uint8_t *l3;
+    uint16_t l3_len;
+    uint16_t l3_type;
+    uint16_t ip_len;
+    uint16_t offset = 14;
+    uint16_t type;
+
+    const struct pppoe_ppp_session_header *header;
+
+    if(len < BBL_MIN_LEN || sp_len < (sizeof(bbl_ethernet_header_s) +
+                                      sizeof(bbl_pppoe_session_s) +
+                                      sizeof(bbl_ipv6_s) +
+                                      sizeof(bbl_udp_s) +
+                                      sizeof(bbl_bbl_s))) {
+        return UNKNOWN_PROTOCOL;
+    }
+
+    /* Init ethernet header */
+    eth = (bbl_ethernet_header_s*)sp; BUMP_BUFFER(sp, sp_len, sizeof(bbl_ethernet_header_s));
+    memset(eth, 0x0, sizeof(bbl_ethernet_header_s));
+
+    eth->length = len;
+    eth->dst = buf;
+    eth->src = buf + ETH_ADDR_LEN;
+
+    /* The minimum BBL packet length covers the fixed-offset
+     * headers, which allows to read them without further
+     * length checks before validating the length fields. */
+    type = *(uint16_t*)(buf+12);
+    if(type == NB_ETH_TYPE_VLAN || type == NB_ETH_TYPE_QINQ) {
+        if(type == ETH_TYPE_QINQ) {
+            eth->qinq = true;
+        }
+        eth->vlan_outer_priority = buf[14] >> 5;
+        eth->vlan_outer = be16toh(*(uint16_t*)(buf+14)) & BBL_ETH_VLAN_ID_MAX;
+        type = *(uint16_t*)(buf+16);
+        offset = 18;
+        if(type == NB_ETH_TYPE_VLAN || type == NB_ETH_TYPE_QINQ) {
+            eth->vlan_inner_priority = buf[18] >> 5;
+            eth->vlan_inner = be16toh(*(uint16_t*)(buf+18)) & BBL_ETH_VLAN_ID_MAX;
+            type = *(uint16_t*)(buf+20);
+            offset = 22;
+        }
+    }
+    eth->type = be16toh(type);
+
+    l3 = buf + offset;
+    l3_len = len - offset;
+    l3_type = type;
+    if(type == NB_ETH_TYPE_PPPOE_SESSION) {
+        header = (struct pppoe_ppp_session_header*)l3;
+        if(header->version_type != 17) return UNKNOWN_PROTOCOL;
+        pppoe = (bbl_pppoe_session_s*)sp; BUMP_BUFFER(sp, sp_len, sizeof(bbl_pppoe_session_s));
+        pppoe->lwip = false;
+        pppoe->session_id = be16toh(header->session_id);
+        pppoe->protocol = be16toh(header->protocol);
+        ip_len = be16toh(header->len) - 2;
+        l3 += sizeof(struct pppoe_ppp_session_header);
+        l3_len -= sizeof(struct pppoe_ppp_session_header);
+        if(ip_len > l3_len) return UNKNOWN_PROTOCOL;
+        l3_len = ip_len;
+        switch(pppoe->protocol) {
+            case PROTOCOL_IPV4:
+                l3_type = NB_ETH_TYPE_IPV4;
+                break;
+            case PROTOCOL_IPV6:
+                l3_type = NB_ETH_TYPE_IPV6;
+                break;
+            default:
+                return UNKNOWN_PROTOCOL;
+        }
+    }
+
+    if(l3_type == NB_ETH_TYPE_IPV4) {
+        /* IPv4 header without options (IHL 5), not
+         * fragmented, followed by UDP header. */
+        if(l3_len < 28 || l3[0] != 0x45 || l3[9] != PROTOCOL_IPV4_UDP) return UNKNOWN_PROTOCOL;
+        ip_len = be16toh(*(uint16_t*)(l3+2));
+        if(ip_len < 28 || ip_len > l3_len) return UNKNOWN_PROTOCOL;
+        if(be16toh(*(uint16_t*)(l3+6)) & ~IPV4_DF) return UNKNOWN_PROTOCOL;
+        ipv4 = (bbl_ipv4_s*)sp; BUMP_BUFFER(sp, sp_len, sizeof(bbl_ipv4_s));
+        ipv4->router_alert_option = false;
+        ipv4->hdr = l3;
+        ipv4->tos = l3[1];
+        ipv4->len = ip_len;
+        ipv4->id = be16toh(*(uint16_t*)(l3+4));
+        ipv4->offset = be16toh(*(uint16_t*)(l3+6));
+        ipv4->ttl = l3[8];
+        ipv4->protocol = PROTOCOL_IPV4_UDP;
+        ipv4->src = *(uint32_t*)(l3+12);
+        ipv4->dst = *(uint32_t*)(l3+16);
+        ipv4->payload = l3 + 20;
+        ipv4->payload_len = ip_len - 20;
+        eth->tos = ipv4->tos;
+        l3 += 20;
+        l3_len = ipv4->payload_len;
+    } else if(l3_type == NB_ETH_TYPE_IPV6) {
+        if(l3_len < IPV6_HDR_LEN + 8 || (l3[0] >> 4) != 6 || l3[6] != IPV6_NEXT_HEADER_UDP) return UNKNOWN_PROTOCOL;
+        ip_len = be16toh(*(uint16_t*)(l3+4));
+        if(ip_len > l3_len - IPV6_HDR_LEN) return UNKNOWN_PROTOCOL;
+        ipv6 = (bbl_ipv6_s*)sp; BUMP_BUFFER(sp, sp_len, sizeof(bbl_ipv6_s));
+        ipv6->hdr = l3;
+        ipv6->tos = (be16toh(*(uint16_t*)l3) >> 4);
+        ipv6->payload_len = ip_len;
+        ipv6->protocol = IPV6_NEXT_HEADER_UDP;
+        ipv6->ttl = l3[7];
+        ipv6->src = l3 + 8;
+        ipv6->dst = l3 + 8 + IPV6_ADDR_LEN;
+        ipv6->payload = l3 + IPV6_HDR_LEN;
+        ipv6->len = IPV6_HDR_LEN + ip_len;
+        eth->tos = ipv6->tos;
+        l3 += IPV6_HDR_LEN;
+        l3_len = ip_len;
+    } else {
+        return UNKNOWN_PROTOCOL;
+    }
+
+    /* UDP */
+    if(l3_len < 8 || be16toh(*(uint16_t*)(l3+2)) != BBL_UDP_PORT) return UNKNOWN_PROTOCOL;
+    ip_len = be16toh(*(uint16_t*)(l3+4));
+    if(ip_len < 8 || ip_len > l3_len) return UNKNOWN_PROTOCOL;
+    udp = (bbl_udp_s*)sp; BUMP_BUFFER(sp, sp_len, sizeof(bbl_udp_s));
+    udp->src = be16toh(*(uint16_t*)l3);
+    udp->dst = BBL_UDP_PORT;
+    udp->payload_len = ip_len - 8;
+    udp->protocol = UDP_PROTOCOL_BBL;
+    if(decode_bbl(l3 + 8, udp->payload_len, sp, sp_len, (bbl_bbl_s**)&udp->next) != PROTOCOL_SUCCESS) return UNKNOWN_PROTOCOL;
+    eth->bbl = udp->next;
+
+    if(ipv4) {
+        ipv4->next = udp;
+        eth->next = ipv4;
+    } else {
+        ipv6->next = udp;
+        eth->next = ipv6;
+    }
+    if(pppoe) {
+        pppoe->next = eth->next;
+        eth->next = pppoe;
+    }
+    *_eth = eth;
+    return PROTOCOL_SUCCESS;
+}
+
+/*
+ * decode_ethernet_fast
+ *
+ * Decode ethernet frames received on the data path,
+ * using the fast path for BNG Blaster stream traffic
+ * and decode_ethernet for all other packets.
+ */
+protocol_error_t
+decode_ethernet_fast(uint8_t *buf, uint16_t len,
+                     uint8_t *sp, uint16_t sp_len,
+                     bbl_ethernet_header_s **_eth)
+{
+    if(packet_is_bbl(buf, len) &&
+       decode_ethernet_bbl(buf, len, sp, sp_len, _eth) == PROTOCOL_SUCCESS) {
+        return PROTOCOL_SUCCESS;
+    }
+    return decode_ethernet(buf, len, sp, sp_len, _eth);
+}
@@ -637,6 +637,7 @@ typedef struct bbl_ethernet_header_ {
     void       *next; /* next header */
 
     struct timespec timestamp; /* receive timestamp */
+    uint8_t timestamp_source; /* receive timestamp source (io_timestamp_t) */
 } bbl_ethernet_header_s;
 
 /*
@@ -1022,6 +1023,12 @@ typedef struct bbl_lacp_ {
 bool
 packet_is_bbl(uint8_t *buf, uint16_t len);
 
+const char *
+bbl_checksum_init();
+
+uint16_t
+bbl_checksum_update(uint16_t checksum, void *old, void *new, uint16_t len);
+
 uint16_t
 bbl_checksum(uint8_t *buf, uint16_t len);
 
@@ -1044,6 +1051,11 @@ decode_ethernet(uint8_t *buf, uint16_t len,
                 uint8_t *sp, uint16_t sp_len,
                 bbl_ethernet_header_s **ethernet);
 
+protocol_error_t
+decode_ethernet_fast(uint8_t *buf, uint16_t len,
+                     uint8_t *sp, uint16_t sp_len,
+                     bbl_ethernet_header_s **ethernet);
+
 protocol_error_t
 encode_ethernet(uint8_t *buf, uint16_t *len,
                 bbl_ethernet_header_s *eth);
@@ -36,6 +36,83 @@ session_state_string(uint32_t state)
     }
 }
 
+const char *
+bbl_setup_phase_string(bbl_setup_phase_t phase)
+{
+    switch(phase) {
+        case BBL_SETUP_SESSION: return "session";
+        case BBL_SETUP_PPPOE_DISCOVERY: return "pppoe-discovery";
+        case BBL_SETUP_PPPOE_REQUEST: return "pppoe-request";
+        case BBL_SETUP_LCP: return "lcp";
+        case BBL_SETUP_AUTH: return "authentication";
+        case BBL_SETUP_IPCP: return "ipcp";
+        case BBL_SETUP_IP6CP: return "ip6cp";
+        case BBL_SETUP_DHCP: return "dhcp";
+        case BBL_SETUP_DHCPV6: return "dhcpv6";
+        default: return "N/A";
+    }
+}
+
+static uint32_t
+bbl_session_setup_now_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    /* The timestamp may wrap, which is handled by
+     * unsigned arithmetic for latencies below 71 minutes. */
+    return (now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
+/**
+ * bbl_session_setup_start
+ *
+ * Start setup phase if not already started,
+ * so that retransmissions do not reset the
+ * start time of the phase.
+ *
+ * @param session session
+ * @param phase setup phase
+ */
+void
+bbl_session_setup_start(bbl_session_s *session, bbl_setup_phase_t phase)
+{
+    if(!(session->setup_phases & (1 << phase))) {
+        session->setup_phases |= (1 << phase);
+        session->setup_phase_us[phase] = bbl_session_setup_now_us();
+    }
+}
+
+/**
+ * bbl_session_setup_done
+ *
+ * Complete setup phase if started and add the
+ * latency to the setup latency histogram of the
+ * corresponding access configuration.
+ *
+ * @param session session
+ * @param phase setup phase
+ */
+void
+bbl_session_setup_done(bbl_session_s *session, bbl_setup_phase_t phase)
+{
+    bbl_setup_latency_s *latency;
+    uint32_t latency_us;
+
+    if(!(session->setup_phases & (1 << phase))) {
+        return;
+    }
+    session->setup_phases &= ~(1 << phase);
+    latency_us = bbl_session_setup_now_us() - session->setup_phase_us[phase];
+
+    latency = &session->access_config->setup_latency[phase];
+    latency->count++;
+    latency->sum_us += latency_us;
+    if(latency_us > latency->max_us) {
+        latency->max_us = latency_us;
+    }
+    latency->hist[hist_log_bucket(latency_us, BBL_SETUP_LATENCY_BUCKETS)]++;
+}
+
 const char *
 ppp_state_string(uint32_t state)
 {
@@ -299,29 +376,14 @@ bbl_session_get(uint32_t session_id)
 void
 bbl_session_free(bbl_session_s *session) 
 {
-    if(session->username) {
-        free(session->username);
-        session->username = NULL;
-    }
-    if(session->password) {
-        free(session->password);
-        session->password = NULL;
+    if(session->igmp_groups) {
+        free(session->igmp_groups);
+        session->igmp_groups = NULL;
     }
-    if(session->agent_circuit_id) {
-        free(session->agent_circuit_id);
-        session->agent_circuit_id = NULL;
-    }
-    if(session->agent_remote_id) {
-        free(session->agent_remote_id);
-        session->agent_remote_id = NULL;
-    }
-    if(session->access_aggregation_circuit_id) {
-        free(session->access_aggregation_circuit_id);
-        session->access_aggregation_circuit_id = NULL;
-    }
-    if(session->cfm_ma_name) {
-        free(session->cfm_ma_name);
-        session->cfm_ma_name = NULL;
+
+    if(session->netif) {
+        free(session->netif);
+        session->netif = NULL;
     }
 
     if(session->pppoe_ac_cookie) {
@@ -468,6 +530,8 @@ bbl_session_reset(bbl_session_s *session) {
 static bool
 bbl_session_start(bbl_session_s *session)
 {
+    bbl_session_shard_s *shard = session->access_interface->shard;
+
     if(g_teardown || session->session_state != BBL_TERMINATED) {
         return false;
     }
@@ -475,11 +539,11 @@ bbl_session_start(bbl_session_s *session)
     /* Reset session */    
     session->session_state = BBL_IDLE;
     bbl_session_reset(session);
-    if(g_ctx->sessions_terminated) {
-        g_ctx->sessions_terminated--;
+    if(shard->counters.sessions_terminated) {
+        shard->counters.sessions_terminated--;
     }
     /* Put on idle list */
-    CIRCLEQ_INSERT_TAIL(&g_ctx->sessions_idle_qhead, session, session_idle_qnode);
+    CIRCLEQ_INSERT_TAIL(&shard->sessions_idle_qhead, session, session_idle_qnode);
     return true;
 }
 
@@ -503,6 +567,8 @@ void
 bbl_session_update_state(bbl_session_s *session, session_state_t new_state)
 {
     session_state_t old_state = session->session_state;
+    bbl_session_shard_s *shard = session->access_interface->shard;
+    bbl_session_counters_s *counters = &shard->counters;
 
     if(old_state != new_state) {
         /* State has changed ... */
@@ -511,9 +577,9 @@ bbl_session_update_state(bbl_session_s *session, session_state_t new_state)
 
         if(old_state == BBL_ESTABLISHED) {
             /* Decrement sessions established if old state is established. */
-            if(g_ctx->sessions_established) {
-                g_ctx->sessions_established--;
-                g_ctx->timestamp_established.tv_sec = 0;
+            if(counters->sessions_established) {
+                counters->sessions_established--;
+                counters->timestamp_established.tv_sec = 0;
             }
             ENABLE_ENDPOINT(session->endpoint.ipv4);
             ENABLE_ENDPOINT(session->endpoint.ipv6);
@@ -522,18 +588,55 @@ bbl_session_update_state(bbl_session_s *session, session_state_t new_state)
         
         /* Update outstanding session count. */
         if(old_state > BBL_IDLE && old_state < BBL_ESTABLISHED && new_state >= BBL_ESTABLISHED) {
-            assert(g_ctx->sessions_outstanding);
-            if(g_ctx->sessions_outstanding) g_ctx->sessions_outstanding--;
+            assert(counters->sessions_outstanding);
+            if(counters->sessions_outstanding) counters->sessions_outstanding--;
         }
         
+        /* Update setup phases. */
+        switch(new_state) {
+            case BBL_PPPOE_INIT:
+                session->setup_phases &= (1 << BBL_SETUP_SESSION);
+                bbl_session_setup_start(session, BBL_SETUP_PPPOE_DISCOVERY);
+                break;
+            case BBL_PPPOE_REQUEST:
+                bbl_session_setup_done(session, BBL_SETUP_PPPOE_DISCOVERY);
+                bbl_session_setup_start(session, BBL_SETUP_PPPOE_REQUEST);
+                break;
+            case BBL_PPP_LINK:
+                bbl_session_setup_done(session, BBL_SETUP_PPPOE_REQUEST);
+                bbl_session_setup_start(session, BBL_SETUP_LCP);
+                break;
+            case BBL_PPP_AUTH:
+                bbl_session_setup_done(session, BBL_SETUP_LCP);
+                bbl_session_setup_start(session, BBL_SETUP_AUTH);
+                break;
+            case BBL_PPP_NETWORK:
+                bbl_session_setup_done(session, BBL_SETUP_AUTH);
+                break;
+            case BBL_ESTABLISHED:
+                bbl_session_setup_done(session, BBL_SETUP_SESSION);
+                break;
+            case BBL_PPP_TERMINATING:
+            case BBL_TERMINATING:
+            case BBL_TERMINATED:
+                session->setup_phases = 0;
+                break;
+            default:
+                break;
+        }
+
         if(new_state == BBL_ESTABLISHED) {
             /* Increment sessions established if new state is established. */
-            g_ctx->sessions_established++;
-            assert(g_ctx->sessions_established <= g_ctx->sessions);
-            if(g_ctx->sessions_established > g_ctx->sessions_established_max) g_ctx->sessions_established_max = g_ctx->sessions_established;
-            if(g_ctx->sessions_established == g_ctx->sessions) {
-                LOG_NOARG(INFO, "ALL SESSIONS ESTABLISHED\n");
-                clock_gettime(CLOCK_MONOTONIC, &g_ctx->timestamp_established);
+            counters->sessions_established++;
+            assert(counters->sessions_established <= counters->sessions);
+            if(counters->sessions_established > counters->sessions_established_max) counters->sessions_established_max = counters->sessions_established;
+            if(counters->sessions_established == counters->sessions) {
+                if(shard->worker) {
+                    LOG(INFO, "ALL SESSIONS ESTABLISHED ON %s\n", session->access_interface->name);
+                } else {
+                    LOG_NOARG(INFO, "ALL SESSIONS ESTABLISHED\n");
+                }
+                clock_gettime(CLOCK_MONOTONIC, &counters->timestamp_established);
             }
         } else if(new_state == BBL_PPP_TERMINATING) {
             if(session->ipcp_state > BBL_PPP_DISABLED) {
@@ -547,23 +650,23 @@ bbl_session_update_state(bbl_session_s *session, session_state_t new_state)
             ENABLE_ENDPOINT(session->endpoint.ipv6pd);
         } else if(new_state == BBL_TERMINATED) {
             /* Increment sessions terminated if new state is terminated */
-            g_ctx->sessions_terminated++;
-            assert(g_ctx->sessions_terminated <= g_ctx->sessions);
+            counters->sessions_terminated++;
+            assert(counters->sessions_terminated <= counters->sessions);
             if(session->dhcp_established) {
                 session->dhcp_established = false;
-                g_ctx->dhcp_established--;
+                counters->dhcp_established--;
             }
             if(session->dhcp_requested) {
                 session->dhcp_requested = false;
-                g_ctx->dhcp_requested--;
+                counters->dhcp_requested--;
             }
             if(session->dhcpv6_established) {
                 session->dhcpv6_established = false;
-                g_ctx->dhcpv6_established--;
+                counters->dhcpv6_established--;
             }
             if(session->dhcpv6_requested) {
                 session->dhcpv6_requested = false;
-                g_ctx->dhcpv6_requested--;
+                counters->dhcpv6_requested--;
             }
             /* Stop all session timers */
             timer_del(session->timer_arp);
@@ -604,13 +707,17 @@ bbl_session_update_state(bbl_session_s *session, session_state_t new_state)
             bbl_a10nsp_session_free(session);
 
             if(g_teardown) {
-                if(g_ctx->sessions_terminated == g_ctx->sessions) {
-                    LOG_NOARG(INFO, "ALL SESSIONS TERMINATED\n");
+                if(counters->sessions_terminated == counters->sessions) {
+                    if(shard->worker) {
+                        LOG(INFO, "ALL SESSIONS TERMINATED ON %s\n", session->access_interface->name);
+                    } else {
+                        LOG_NOARG(INFO, "ALL SESSIONS TERMINATED\n");
+                    }
                 }
             } else {
                 /* Increment flap counter */
                 session->stats.flapped++;
-                g_ctx->sessions_flapped++;
+                counters->sessions_flapped++;
 
                 /* Reconnect */
                 if(!session->reconnect_disabled && 
@@ -619,7 +726,7 @@ bbl_session_update_state(bbl_session_s *session, session_state_t new_state)
                     if(!session->reconnect_delay) {
                         session->reconnect_delay = 1;
                     }
-                    timer_add(&g_ctx->timer_root, &session->timer_reconnect, "RECONNECT", 
+                    timer_add(session->access_interface->shard->timer_root, &session->timer_reconnect, "RECONNECT", 
                               session->reconnect_delay, 0, session, &bbl_session_reconnect_job);
                 }
             }
@@ -701,38 +808,193 @@ bbl_session_clear(bbl_session_s *session)
     }
 }
 
-static void
-update_strings(char **target, const char *source, uint32_t *i, bbl_access_config_s *access_config)
+/**
+ * bbl_session_counters
+ *
+ * This function sums up the session counters of all shards.
+ * Counters of session worker shards are written by the worker
+ * thread only and read here without locking, which gives a
+ * snapshot good enough for statistics and pacing.
+ *
+ * @param sum session counters (result)
+ */
+void
+bbl_session_counters(bbl_session_counters_s *sum)
+{
+    bbl_session_shard_s *shard = &g_ctx->session_shard;
+    bbl_session_counters_s *counters;
+    bool established = true;
+
+    memset(sum, 0x0, sizeof(bbl_session_counters_s));
+    while(shard) {
+        counters = &shard->counters;
+        sum->sessions += counters->sessions;
+        sum->sessions_started += counters->sessions_started;
+        sum->sessions_established += counters->sessions_established;
+        sum->sessions_outstanding += counters->sessions_outstanding;
+        sum->sessions_terminated += counters->sessions_terminated;
+        sum->sessions_flapped += counters->sessions_flapped;
+        sum->dhcp_requested += counters->dhcp_requested;
+        sum->dhcp_established += counters->dhcp_established;
+        sum->dhcp_established_max += counters->dhcp_established_max;
+        sum->dhcpv6_requested += counters->dhcpv6_requested;
+        sum->dhcpv6_established += counters->dhcpv6_established;
+        sum->dhcpv6_established_max += counters->dhcpv6_established_max;
+        sum->session_retries += counters->session_retries;
+
+        /* First session send by any shard. */
+        if(counters->first_session_tx.tv_sec && 
+           (!sum->first_session_tx.tv_sec ||
+            counters->first_session_tx.tv_sec < sum->first_session_tx.tv_sec ||
+            (counters->first_session_tx.tv_sec == sum->first_session_tx.tv_sec &&
+             counters->first_session_tx.tv_nsec < sum->first_session_tx.tv_nsec))) {
+            sum->first_session_tx = counters->first_session_tx;
+        }
+        /* Last session established by any shard. */
+        if(counters->last_session_established.tv_sec > sum->last_session_established.tv_sec ||
+           (counters->last_session_established.tv_sec == sum->last_session_established.tv_sec &&
+            counters->last_session_established.tv_nsec > sum->last_session_established.tv_nsec)) {
+            sum->last_session_established = counters->last_session_established;
+        }
+        /* All sessions are established if all shards are established. */
+        if(counters->sessions) {
+            if(!counters->timestamp_established.tv_sec) {
+                established = false;
+            } else if(counters->timestamp_established.tv_sec > sum->timestamp_established.tv_sec ||
+                      (counters->timestamp_established.tv_sec == sum->timestamp_established.tv_sec &&
+                       counters->timestamp_established.tv_nsec > sum->timestamp_established.tv_nsec)) {
+                sum->timestamp_established = counters->timestamp_established;
+            }
+        }
+        shard = shard->next;
+    }
+    if(!established) {
+        sum->timestamp_established.tv_sec = 0;
+        sum->timestamp_established.tv_nsec = 0;
+    }
+    /* The maximum of established sessions is tracked globally
+     * (see bbl_stats_update_cps) as the sum of the per shard
+     * maxima is higher if shards are not established at the
+     * same time. With a single shard, its maximum is exact. */
+    if(g_ctx->session_workers) {
+        sum->sessions_established_max = g_ctx->stats.sessions_established_max;
+        if(sum->sessions_established > sum->sessions_established_max) {
+            sum->sessions_established_max = sum->sessions_established;
+        }
+    } else {
+        sum->sessions_established_max = g_ctx->session_shard.counters.sessions_established_max;
+    }
+}
+
+/* Placeholders supported in session strings like username. */
+static const char *g_session_string_keys[] = {
+    "{session-global}", "{session}", "{i1}", "{i2}", "{outer-vlan}", "{inner-vlan}", NULL
+};
+
+/**
+ * bbl_session_string
+ *
+ * Session strings like username are rendered from the
+ * access configuration templates when needed instead of
+ * storing a copy per session. The returned string is valid
+ * until the next call with the same string type in the
+ * same thread.
+ *
+ * @param session session
+ * @param type session string type
+ * @return string or NULL if not configured
+ */
+char *
+bbl_session_string(bbl_session_s *session, bbl_session_string_t type)
 {
-    static char snum1[32];
-    static char snum2[32];
-    static char si1[32];
-    static char si2[32];
-    static char vlan1[32];
-    static char vlan2[32];
-
-    char *s;
-
-    if(i && access_config) {
-        /* Init iterator */
-        snprintf(snum1, sizeof(snum1), "%d", *i);
-        snprintf(snum2, sizeof(snum2), "%d", access_config->sessions);
-        snprintf(si1, sizeof(si1), "%d", access_config->i1);
-        access_config->i1 += access_config->i1_step;
-        snprintf(si2, sizeof(si2), "%d", access_config->i2);
-        access_config->i2 += access_config->i2_step;
-        snprintf(vlan1, sizeof(si2), "%d", access_config->access_outer_vlan);
-        snprintf(vlan2, sizeof(si2), "%d", access_config->access_inner_vlan);
-    }
-    if(target && source) {
-        s = replace_substring(source, "{session-global}", snum1);
-        s = replace_substring(s, "{session}", snum2);
-        s = replace_substring(s, "{i1}", si1);
-        s = replace_substring(s, "{i2}", si2);
-        s = replace_substring(s, "{outer-vlan}", vlan1);
-        s = replace_substring(s, "{inner-vlan}", vlan2);
-        if(s) *target = strdup(s);
+    static __thread char buf[BBL_SESSION_STRING_MAX][SUB_STR_LEN];
+
+    bbl_access_config_s *access_config = session->access_config;
+    char *source = NULL;
+    const char *cur;
+    char value[32];
+    size_t len = 0;
+    size_t key_len;
+    size_t value_len;
+    int k;
+
+    switch(type) {
+        case BBL_SESSION_USERNAME:
+            source = (char*)access_config->username;
+            break;
+        case BBL_SESSION_PASSWORD:
+            source = (char*)access_config->password;
+            break;
+        case BBL_SESSION_AGENT_CIRCUIT_ID:
+            source = access_config->agent_circuit_id;
+            break;
+        case BBL_SESSION_AGENT_REMOTE_ID:
+            source = access_config->agent_remote_id;
+            break;
+        case BBL_SESSION_ACCESS_AGGREGATION_CIRCUIT_ID:
+            source = access_config->access_aggregation_circuit_id;
+            break;
+        case BBL_SESSION_CFM_MA_NAME:
+            source = access_config->cfm_ma_name;
+            break;
+        default:
+            return NULL;
     }
+    if(!source || !strchr(source, '{')) {
+        /* Strings without placeholders are
+         * shared with the access configuration. */
+        return source;
+    }
+
+    /* Replace all placeholders in a single pass. */
+    cur = source;
+    while(*cur) {
+        if(*cur == '{') {
+            for(k = 0; g_session_string_keys[k]; k++) {
+                key_len = strlen(g_session_string_keys[k]);
+                if(strncmp(cur, g_session_string_keys[k], key_len) == 0) {
+                    break;
+                }
+            }
+            if(g_session_string_keys[k]) {
+                switch(k) {
+                    case 0:
+                        snprintf(value, sizeof(value), "%d", session->session_id);
+                        break;
+                    case 1:
+                        snprintf(value, sizeof(value), "%d", session->access_config_session);
+                        break;
+                    case 2:
+                        snprintf(value, sizeof(value), "%d", access_config->i1 +
+                                 ((session->access_config_session - 1) * access_config->i1_step));
+                        break;
+                    case 3:
+                        snprintf(value, sizeof(value), "%d", access_config->i2 +
+                                 ((session->access_config_session - 1) * access_config->i2_step));
+                        break;
+                    case 4:
+                        snprintf(value, sizeof(value), "%d", session->vlan_key.outer_vlan_id);
+                        break;
+                    default:
+                        snprintf(value, sizeof(value), "%d", session->vlan_key.inner_vlan_id);
+                        break;
+                }
+                value_len = strlen(value);
+                if(len + value_len < SUB_STR_LEN) {
+                    memcpy(buf[type] + len, value, value_len);
+                    len += value_len;
+                }
+                cur += key_len;
+                continue;
+            }
+        }
+        if(len + 1 < SUB_STR_LEN) {
+            buf[type][len++] = *cur;
+        }
+        cur++;
+    }
+    buf[type][len] = '\0';
+    return buf[type];
 }
 
 bool
@@ -824,6 +1086,7 @@ bbl_sessions_init()
         session->vlan_key.inner_vlan_id = access_config->access_inner_vlan;
         session->access_third_vlan = access_config->access_third_vlan;
         session->access_config = access_config;
+        session->access_config_session = access_config->sessions;
 
         /* Set client OUI to locally administered */
         session->client_mac[0] = 0x02;
@@ -861,30 +1124,11 @@ bbl_sessions_init()
         session->dhcpv6_duid[3] = 1;
         memcpy(&session->dhcpv6_duid[4], session->client_mac, ETH_ADDR_LEN);
 
-        /* Init string variables/iterators */
-        update_strings(NULL, NULL, &i, access_config);
-
-        /* Update username */
-        update_strings(&session->username, access_config->username, NULL, NULL);
-
-        /* Update password */
-        update_strings(&session->password, access_config->password, NULL, NULL);
-
-        /* Update ACI */
-        update_strings(&session->agent_circuit_id, access_config->agent_circuit_id, NULL, NULL);
-
-        /* Update ARI */
-        update_strings(&session->agent_remote_id, access_config->agent_remote_id, NULL, NULL);
-
-        /* Update Access-Aggregation-Circuit-ID */
-        update_strings(&session->access_aggregation_circuit_id, access_config->access_aggregation_circuit_id, NULL, NULL);
-
         /* Update CFM */
         if(access_config->cfm_cc) {
             session->cfm_cc = true;
             session->cfm_level = access_config->cfm_level;
             session->cfm_ma_id = access_config->cfm_ma_id;
-            update_strings(&session->cfm_ma_name, access_config->cfm_ma_name, NULL, NULL);
         }
 
         /* Update access rates ... */
@@ -970,12 +1214,13 @@ bbl_sessions_init()
         
         if(g_ctx->config.sessions_autostart) {
             session->session_state = BBL_IDLE;
-            CIRCLEQ_INSERT_TAIL(&g_ctx->sessions_idle_qhead, session, session_idle_qnode);
+            CIRCLEQ_INSERT_TAIL(&session->access_interface->shard->sessions_idle_qhead, session, session_idle_qnode);
         } else {
             session->session_state = BBL_TERMINATED;
-            g_ctx->sessions_terminated++;
+            session->access_interface->shard->counters.sessions_terminated++;
         }
 
+        session->access_interface->shard->counters.sessions++;
         g_ctx->sessions++;
         if(session->access_type == ACCESS_TYPE_PPPOE) {
             g_ctx->sessions_pppoe++;
@@ -1011,10 +1256,10 @@ bbl_sessions_init()
             return false;
         }
 
-        timer_add_periodic(&g_ctx->timer_root, &session->timer_rate, "Rate Computation", 1, 0, session, &bbl_session_rate_job);
+        timer_add_periodic(session->access_interface->shard->timer_root, &session->timer_rate, "Rate Computation", 1, 0, session, &bbl_session_rate_job);
 
         if(access_config->monkey) {
-            timer_add_periodic(&g_ctx->timer_root, &session->timer_monkey, "MONKEY", 1, 1337, session, &bbl_session_monkey_job);
+            timer_add_periodic(session->access_interface->shard->timer_root, &session->timer_monkey, "MONKEY", 1, 1337, session, &bbl_session_monkey_job);
         }
 
         LOG(DEBUG, "Session %u created (%s.%u:%u group %u)\n", i, 
@@ -1271,9 +1516,9 @@ bbl_session_json(bbl_session_s *session)
             "outer-vlan", session->vlan_key.outer_vlan_id,
             "inner-vlan", session->vlan_key.inner_vlan_id,
             "mac", format_mac_address(session->client_mac),
-            "username", session->username,
-            "agent-circuit-id", session->agent_circuit_id,
-            "agent-remote-id", session->agent_remote_id,
+            "username", bbl_session_string(session, BBL_SESSION_USERNAME),
+            "agent-circuit-id", bbl_session_string(session, BBL_SESSION_AGENT_CIRCUIT_ID),
+            "agent-remote-id", bbl_session_string(session, BBL_SESSION_AGENT_REMOTE_ID),
             "reply-message", session->reply_message,
             "connection-status-message", session->connections_status_message,
             "lcp-state", ppp_state_string(session->lcp_state),
@@ -1335,8 +1580,8 @@ bbl_session_json(bbl_session_s *session)
             "outer-vlan", session->vlan_key.outer_vlan_id,
             "inner-vlan", session->vlan_key.inner_vlan_id,
             "mac", format_mac_address(session->client_mac),
-            "agent-circuit-id", session->agent_circuit_id,
-            "agent-remote-id", session->agent_remote_id,
+            "agent-circuit-id", bbl_session_string(session, BBL_SESSION_AGENT_CIRCUIT_ID),
+            "agent-remote-id", bbl_session_string(session, BBL_SESSION_AGENT_REMOTE_ID),
             "ipv4-address", ipv4,
             "ipv4-netmask", ipv4_netmask,
             "ipv4-gateway", ipv4_gw,
@@ -1445,32 +1690,135 @@ bbl_session_ctrl_pending(int fd, uint32_t session_id __attribute__((unused)), js
     return result;
 }
 
+static json_t *
+bbl_session_setup_latency_phase_json(bbl_setup_latency_s *latency)
+{
+    uint64_t hist[BBL_SETUP_LATENCY_BUCKETS];
+    int i;
+
+    for(i = 0; i < BBL_SETUP_LATENCY_BUCKETS; i++) {
+        hist[i] = latency->hist[i];
+    }
+    return json_pack("{sI sI sI sI sI sI}",
+                     "count", latency->count,
+                     "avg-us", latency->sum_us / latency->count,
+                     "max-us", (uint64_t)latency->max_us,
+                     "p50-us", hist_log_percentile(hist, BBL_SETUP_LATENCY_BUCKETS, latency->max_us, 50.0),
+                     "p90-us", hist_log_percentile(hist, BBL_SETUP_LATENCY_BUCKETS, latency->max_us, 90.0),
+                     "p99-us", hist_log_percentile(hist, BBL_SETUP_LATENCY_BUCKETS, latency->max_us, 99.0));
+}
+
+/**
+ * bbl_session_setup_latency_json
+ *
+ * Session setup latency per phase for all access
+ * configurations and summarized over all of them.
+ * Phases without any completed setup are omitted.
+ *
+ * @return JSON object
+ */
+json_t *
+bbl_session_setup_latency_json()
+{
+    bbl_access_config_s *access_config = g_ctx->config.access_config;
+    bbl_setup_latency_s total[BBL_SETUP_MAX] = {0};
+    bbl_setup_latency_s *latency;
+
+    json_t *root = json_object();
+    json_t *jobj_array = json_array();
+    json_t *jobj;
+    json_t *jobj_phases;
+
+    uint32_t index = 0;
+    int phase, i;
+
+    while(access_config) {
+        jobj_phases = json_object();
+        for(phase = 0; phase < BBL_SETUP_MAX; phase++) {
+            latency = &access_config->setup_latency[phase];
+            if(!latency->count) continue;
+            json_object_set_new(jobj_phases, bbl_setup_phase_string(phase),
+                                bbl_session_setup_latency_phase_json(latency));
+            total[phase].count += latency->count;
+            total[phase].sum_us += latency->sum_us;
+            if(latency->max_us > total[phase].max_us) {
+                total[phase].max_us = latency->max_us;
+            }
+            for(i = 0; i < BBL_SETUP_LATENCY_BUCKETS; i++) {
+                total[phase].hist[i] += latency->hist[i];
+            }
+        }
+        jobj = json_pack("{si ss* ss si so}",
+                         "index", index++,
+                         "interface", access_config->interface,
+                         "type", access_config->access_type == ACCESS_TYPE_PPPOE ? "pppoe" : "ipoe",
+                         "session-group-id", access_config->session_group_id,
+                         "phases", jobj_phases);
+        json_array_append_new(jobj_array, jobj);
+        access_config = access_config->next;
+    }
+
+    jobj_phases = json_object();
+    for(phase = 0; phase < BBL_SETUP_MAX; phase++) {
+        if(!total[phase].count) continue;
+        json_object_set_new(jobj_phases, bbl_setup_phase_string(phase),
+                            bbl_session_setup_latency_phase_json(&total[phase]));
+    }
+    json_object_set_new(root, "phases", jobj_phases);
+    json_object_set_new(root, "access-configs", jobj_array);
+    return root;
+}
+
+int
+bbl_session_ctrl_setup_latency(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
+{
+    int result = 0;
+    json_t *root = json_pack("{ss si so}",
+                             "status", "ok",
+                             "code", 200,
+                             "session-setup-latency", bbl_session_setup_latency_json());
+    if(root) {
+        result = json_dumpfd(root, fd, 0);
+        json_decref(root);
+    } else {
+        result = bbl_ctrl_status(fd, "error", 500, "internal error");
+    }
+    return result;
+}
+
 int
 bbl_session_ctrl_counters(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
 {
     int result = 0;
-    json_t *root = json_pack("{ss si s{si si si si si si si si si si si si si si sf sf sf sf si si si si}}",
+    bbl_session_counters_s counters;
+    json_t *root;
+
+    bbl_session_counters(&counters);
+    root = json_pack("{ss si s{si si si si si si si si si si si si si si sf sf sf sf sf si sI si si si si}}",
                              "status", "ok",
                              "code", 200,
                              "session-counters",
                              "sessions", g_ctx->config.sessions,
                              "sessions-pppoe", g_ctx->sessions_pppoe,
                              "sessions-ipoe", g_ctx->sessions_ipoe,
-                             "sessions-established", g_ctx->sessions_established,
-                             "sessions-established-max", g_ctx->sessions_established_max,
-                             "sessions-terminated", g_ctx->sessions_terminated,
-                             "sessions-flapped", g_ctx->sessions_flapped,
-                             "dhcp-sessions", g_ctx->dhcp_requested,
-                             "dhcp-sessions-established", g_ctx->dhcp_established,
-                             "dhcp-sessions-established-max", g_ctx->dhcp_established_max,
-                             "dhcpv6-sessions", g_ctx->dhcpv6_requested,
-                             "dhcpv6-sessions-established", g_ctx->dhcpv6_established,
-                             "dhcpv6-sessions-established-max", g_ctx->dhcpv6_established_max,
+                             "sessions-established", counters.sessions_established,
+                             "sessions-established-max", counters.sessions_established_max,
+                             "sessions-terminated", counters.sessions_terminated,
+                             "sessions-flapped", counters.sessions_flapped,
+                             "dhcp-sessions", counters.dhcp_requested,
+                             "dhcp-sessions-established", counters.dhcp_established,
+                             "dhcp-sessions-established-max", counters.dhcp_established_max,
+                             "dhcpv6-sessions", counters.dhcpv6_requested,
+                             "dhcpv6-sessions-established", counters.dhcpv6_established,
+                             "dhcpv6-sessions-established-max", counters.dhcpv6_established_max,
                              "setup-time", g_ctx->stats.setup_time,
                              "setup-rate", g_ctx->stats.cps,
                              "setup-rate-min", g_ctx->stats.cps_min,
                              "setup-rate-avg", g_ctx->stats.cps_avg,
                              "setup-rate-max", g_ctx->stats.cps_max,
+                             "setup-rate-target", g_ctx->stats.cps_target,
+                             "setup-rate-current", g_ctx->stats.cps_current,
+                             "setup-retries", counters.session_retries,
                              "session-traffic-flows", g_ctx->stats.session_traffic_flows,
                              "session-traffic-flows-verified", g_ctx->stats.session_traffic_flows_verified,
                              "stream-traffic-flows", g_ctx->stats.stream_traffic_flows,
@@ -1522,6 +1870,309 @@ bbl_session_ctrl_info(int fd, uint32_t session_id, json_t *arguments __attribute
     }
 }
 
+/* Session fields which can be serialized without
+ * building the full session JSON object. */
+typedef enum {
+    SESSION_FIELD_FULL = 0, /* taken from bbl_session_json */
+    SESSION_FIELD_TYPE,
+    SESSION_FIELD_SESSION_ID,
+    SESSION_FIELD_SESSION_STATE,
+    SESSION_FIELD_SESSION_SUBSTATE,
+    SESSION_FIELD_FLAPPED,
+    SESSION_FIELD_INTERFACE,
+    SESSION_FIELD_OUTER_VLAN,
+    SESSION_FIELD_INNER_VLAN,
+    SESSION_FIELD_MAC,
+    SESSION_FIELD_USERNAME,
+    SESSION_FIELD_LCP_STATE,
+    SESSION_FIELD_IPCP_STATE,
+    SESSION_FIELD_IP6CP_STATE,
+    SESSION_FIELD_DHCP_STATE,
+    SESSION_FIELD_DHCPV6_STATE,
+    SESSION_FIELD_IPV4_ADDRESS,
+    SESSION_FIELD_IPV6_PREFIX,
+    SESSION_FIELD_IPV6_DELEGATED_PREFIX,
+    SESSION_FIELD_TX_PACKETS,
+    SESSION_FIELD_RX_PACKETS,
+    SESSION_FIELD_TX_BYTES,
+    SESSION_FIELD_RX_BYTES,
+    SESSION_FIELD_MAX
+} bbl_session_field_t;
+
+static const char *g_session_fields[SESSION_FIELD_MAX] = {
+    NULL, "type", "session-id", "session-state", "session-substate",
+    "flapped", "interface", "outer-vlan", "inner-vlan", "mac",
+    "username", "lcp-state", "ipcp-state", "ip6cp-state",
+    "dhcp-state", "dhcpv6-state", "ipv4-address", "ipv6-prefix",
+    "ipv6-delegated-prefix", "tx-packets", "rx-packets",
+    "tx-bytes", "rx-bytes"
+};
+
+static bbl_session_field_t
+bbl_session_field(const char *key)
+{
+    int i;
+    for(i = SESSION_FIELD_FULL+1; i < SESSION_FIELD_MAX; i++) {
+        if(strcmp(key, g_session_fields[i]) == 0) {
+            return i;
+        }
+    }
+    return SESSION_FIELD_FULL;
+}
+
+/* Returns a new reference or NULL if the
+ * field is not present for this session. */
+static json_t *
+bbl_session_field_json(bbl_session_s *session, bbl_session_field_t field)
+{
+    bool pppoe = session->access_type == ACCESS_TYPE_PPPOE;
+
+    switch(field) {
+        case SESSION_FIELD_TYPE:
+            return json_string(pppoe ? "pppoe" : "ipoe");
+        case SESSION_FIELD_SESSION_ID:
+            return json_integer(session->session_id);
+        case SESSION_FIELD_SESSION_STATE:
+            return json_string(session_state_string(session->session_state));
+        case SESSION_FIELD_SESSION_SUBSTATE:
+            return json_string(pppoe ? bbl_session_substate_pppoe(session) : bbl_session_substate_ipoe(session));
+        case SESSION_FIELD_FLAPPED:
+            return json_integer(session->stats.flapped);
+        case SESSION_FIELD_INTERFACE:
+            return json_string(session->access_interface->name);
+        case SESSION_FIELD_OUTER_VLAN:
+            return json_integer(session->vlan_key.outer_vlan_id);
+        case SESSION_FIELD_INNER_VLAN:
+            return json_integer(session->vlan_key.inner_vlan_id);
+        case SESSION_FIELD_MAC:
+            return json_string(format_mac_address(session->client_mac));
+        case SESSION_FIELD_USERNAME:
+            return pppoe ? json_string(bbl_session_string(session, BBL_SESSION_USERNAME)) : NULL;
+        case SESSION_FIELD_LCP_STATE:
+            return pppoe ? json_string(ppp_state_string(session->lcp_state)) : NULL;
+        case SESSION_FIELD_IPCP_STATE:
+            return pppoe ? json_string(ppp_state_string(session->ipcp_state)) : NULL;
+        case SESSION_FIELD_IP6CP_STATE:
+            return pppoe ? json_string(ppp_state_string(session->ip6cp_state)) : NULL;
+        case SESSION_FIELD_DHCP_STATE:
+            return pppoe ? NULL : json_string(dhcp_state_string(session->dhcp_state));
+        case SESSION_FIELD_DHCPV6_STATE:
+            return json_string(dhcp_state_string(session->dhcpv6_state));
+        case SESSION_FIELD_IPV4_ADDRESS:
+            return session->ip_address ? json_string(format_ipv4_address(&session->ip_address)) : NULL;
+        case SESSION_FIELD_IPV6_PREFIX:
+            return session->ipv6_prefix.len ? json_string(format_ipv6_prefix(&session->ipv6_prefix)) : NULL;
+        case SESSION_FIELD_IPV6_DELEGATED_PREFIX:
+            return session->delegated_ipv6_prefix.len ? json_string(format_ipv6_prefix(&session->delegated_ipv6_prefix)) : NULL;
+        case SESSION_FIELD_TX_PACKETS:
+            return json_integer(session->stats.packets_tx);
+        case SESSION_FIELD_RX_PACKETS:
+            return json_integer(session->stats.packets_rx);
+        case SESSION_FIELD_TX_BYTES:
+            return json_integer(session->stats.bytes_tx);
+        case SESSION_FIELD_RX_BYTES:
+            return json_integer(session->stats.bytes_rx);
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * bbl_session_json_fields
+ *
+ * Build session JSON with the requested fields only.
+ * The full session JSON is built only if one of the
+ * fields is not supported by bbl_session_field_json.
+ *
+ * @param session session
+ * @param fields JSON array of field names or NULL for all
+ * @param ids field identifiers resolved from fields
+ * @return JSON object (new reference)
+ */
+static json_t *
+bbl_session_json_fields(bbl_session_s *session, json_t *fields, bbl_session_field_t *ids)
+{
+    json_t *full = NULL;
+    json_t *row;
+    json_t *value;
+    const char *key;
+    size_t i;
+
+    if(!fields) {
+        return bbl_session_json(session);
+    }
+    row = json_object();
+    if(!row) {
+        return NULL;
+    }
+    json_array_foreach(fields, i, value) {
+        key = json_string_value(value);
+        if(!key) continue;
+        if(ids[i] != SESSION_FIELD_FULL) {
+            json_object_set_new(row, key, bbl_session_field_json(session, ids[i]));
+            continue;
+        }
+        if(!full) {
+            full = bbl_session_json(session);
+            if(!full) break;
+        }
+        json_object_set(row, key, json_object_get(full, key));
+    }
+    if(full) json_decref(full);
+    return row;
+}
+
+/**
+ * bbl_session_ctrl_sessions_info
+ *
+ * Bulk session information with optional filters
+ * (session-state, session-group-id and interface),
+ * pagination (cursor and limit) and field projection
+ * (fields). Sessions are serialized one by one into a
+ * buffer, which is written whenever it is full to avoid
+ * building a huge JSON object for all sessions in memory.
+ */
+int
+bbl_session_ctrl_sessions_info(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
+{
+    bbl_session_s *session;
+    bbl_access_interface_s *access_interface = NULL;
+    bbl_session_field_t *ids = NULL;
+    json_t *fields = NULL;
+    json_t *row;
+    json_t *value;
+    const char *state = NULL;
+    const char *interface = NULL;
+    char *buf = NULL;
+    char *tmp;
+
+    int session_group_id = -1;
+    int cursor = 1;
+    int limit = BBL_SESSION_CTRL_LIMIT;
+    int result = -1;
+    uint32_t i;
+    uint32_t rows = 0;
+    uint32_t next = 0;
+    size_t size = BBL_SESSION_CTRL_BUF;
+    size_t len;
+    size_t row_len;
+    size_t idx;
+
+    if(arguments) {
+        if(json_unpack(arguments, "{s:i}", "session-group-id", &session_group_id) == 0) {
+            if(session_group_id < 0 || session_group_id > UINT16_MAX) {
+                return bbl_ctrl_status(fd, "error", 400, "invalid session-group-id");
+            }
+        }
+        if(json_unpack(arguments, "{s:i}", "cursor", &cursor) == 0) {
+            if(cursor < 1) {
+                return bbl_ctrl_status(fd, "error", 400, "invalid cursor");
+            }
+        }
+        if(json_unpack(arguments, "{s:i}", "limit", &limit) == 0) {
+            if(limit < 0) {
+                return bbl_ctrl_status(fd, "error", 400, "invalid limit");
+            }
+        }
+        json_unpack(arguments, "{s:s}", "session-state", &state);
+        if(json_unpack(arguments, "{s:s}", "interface", &interface) == 0) {
+            access_interface = bbl_access_interface_get((char*)interface);
+            if(!access_interface) {
+                return bbl_ctrl_status(fd, "warning", 404, "interface not found");
+            }
+        }
+        fields = json_object_get(arguments, "fields");
+        if(fields && !json_is_array(fields)) {
+            return bbl_ctrl_status(fd, "error", 400, "invalid fields");
+        }
+    }
+
+    /* Resolve field names once for all sessions. */
+    if(fields) {
+        ids = calloc(json_array_size(fields) + 1, sizeof(bbl_session_field_t));
+        if(!ids) {
+            return bbl_ctrl_status(fd, "error", 500, "internal error");
+        }
+        json_array_foreach(fields, idx, value) {
+            if(json_is_string(value)) {
+                ids[idx] = bbl_session_field(json_string_value(value));
+            }
+        }
+    }
+    buf = malloc(size);
+    if(!buf) {
+        free(ids);
+        return bbl_ctrl_status(fd, "error", 500, "internal error");
+    }
+    len = snprintf(buf, size, "{\"status\": \"ok\", \"code\": 200, \"sessions-info\": [");
+
+    for(i = cursor - 1; i < g_ctx->sessions; i++) {
+        session = &g_ctx->session_list[i];
+        if(!session) continue;
+        if(session_group_id >= 0 && session->session_group_id != session_group_id) {
+            continue;
+        }
+        if(access_interface && session->access_interface != access_interface) {
+            continue;
+        }
+        if(state && strcasecmp(state, session_state_string(session->session_state)) != 0) {
+            continue;
+        }
+        if(limit && rows >= (uint32_t)limit) {
+            next = session->session_id;
+            break;
+        }
+        row = bbl_session_json_fields(session, fields, ids);
+        if(!row) continue;
+        if(rows) {
+            buf[len++] = ',';
+            buf[len++] = ' ';
+        }
+        row_len = json_dumpb(row, buf + len, size - len, 0);
+        if(row_len > size - len) {
+            /* Write buffer and retry, the buffer
+             * is increased for huge rows only. */
+            if(write(fd, buf, len) != (ssize_t)len) {
+                json_decref(row);
+                goto CLEANUP;
+            }
+            len = 0;
+            if(row_len > size) {
+                size = row_len + BBL_SESSION_CTRL_BUF;
+                tmp = realloc(buf, size);
+                if(!tmp) {
+                    json_decref(row);
+                    goto CLEANUP;
+                }
+                buf = tmp;
+            }
+            row_len = json_dumpb(row, buf, size, 0);
+        }
+        json_decref(row);
+        len += row_len;
+        rows++;
+        /* Space for separator and trailer. */
+        if(size - len < 64) {
+            if(write(fd, buf, len) != (ssize_t)len) {
+                goto CLEANUP;
+            }
+            len = 0;
+        }
+    }
+    if(next) {
+        len += snprintf(buf + len, size - len, "], \"sessions\": %u, \"next-cursor\": %u}", rows, next);
+    } else {
+        len += snprintf(buf + len, size - len, "], \"sessions\": %u}", rows);
+    }
+    if(write(fd, buf, len) == (ssize_t)len) {
+        result = 0;
+    }
+CLEANUP:
+    free(buf);
+    free(ids);
+    return result;
+}
+
 static int
 bbl_session_ctrl_stop_restart(int fd, uint32_t session_id, json_t *arguments, bool restart)
 {
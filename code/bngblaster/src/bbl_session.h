@@ -16,6 +16,61 @@ typedef struct vlan_session_key_ {
     uint16_t inner_vlan_id;
 } __attribute__ ((__packed__)) vlan_session_key_t;
 
+/* Session strings rendered from access configuration templates. */
+typedef enum {
+    BBL_SESSION_USERNAME = 0,
+    BBL_SESSION_PASSWORD,
+    BBL_SESSION_AGENT_CIRCUIT_ID,
+    BBL_SESSION_AGENT_REMOTE_ID,
+    BBL_SESSION_ACCESS_AGGREGATION_CIRCUIT_ID,
+    BBL_SESSION_CFM_MA_NAME,
+    BBL_SESSION_STRING_MAX
+} __attribute__ ((__packed__)) bbl_session_string_t;
+
+/* Session counters per shard, summed on read. */
+typedef struct bbl_session_counters_ {
+    uint32_t sessions;
+    uint32_t sessions_started;
+    uint32_t sessions_established;
+    uint32_t sessions_established_max;
+    uint32_t sessions_outstanding;
+    uint32_t sessions_terminated;
+    uint32_t sessions_flapped;
+
+    uint32_t dhcp_requested;
+    uint32_t dhcp_established;
+    uint32_t dhcp_established_max;
+    uint32_t dhcpv6_requested;
+    uint32_t dhcpv6_established;
+    uint32_t dhcpv6_established_max;
+
+    uint64_t session_retries; /* retransmitted session setup requests */
+
+    struct timespec timestamp_established;
+    struct timespec first_session_tx;
+    struct timespec last_session_established;
+} bbl_session_counters_s;
+
+/*
+ * Sessions are processed in shards, either by the main loop
+ * (default) or by a session worker thread per access interface.
+ * All state of a shard is owned by the thread processing it,
+ * other threads must lock the worker before accessing it.
+ */
+typedef struct bbl_session_shard_ {
+    bbl_session_worker_s *worker; /* NULL for main loop */
+    struct timer_root_ *timer_root; /* root for session timers */
+    struct timer_ *start_timer;
+
+    bbl_session_counters_s counters;
+    double credit; /* sessions permitted to start */
+
+    CIRCLEQ_HEAD(sessions_idle_, bbl_session_ ) sessions_idle_qhead;
+    CIRCLEQ_HEAD(sessions_teardown_, bbl_session_ ) sessions_teardown_qhead;
+
+    struct bbl_session_shard_ *next;
+} bbl_session_shard_s;
+
 /*
  * Client Session to a BNG device
  */
@@ -25,6 +80,9 @@ typedef struct bbl_session_
     uint16_t session_group_id;
 
     session_state_t session_state;
+
+    uint16_t setup_phases; /* active setup phases */
+    uint32_t setup_phase_us[BBL_SETUP_MAX]; /* setup phase start time */
     uint32_t send_requests;
     uint32_t version;
 
@@ -36,6 +94,7 @@ typedef struct bbl_session_
     CIRCLEQ_ENTRY(bbl_session_) session_a10nsp_tx_qnode;
 
     bbl_access_config_s *access_config;
+    uint32_t access_config_session; /* session number per access configuration */
     bbl_access_interface_s *access_interface; /* where this session is attached to */
     bbl_network_interface_s *network_interface; /* selected network interface */
 
@@ -91,10 +150,6 @@ typedef struct bbl_session_
     bbl_a10nsp_session_s *a10nsp_session;
     bbl_a10nsp_interface_s *a10nsp_interface; /* a10nsp interface */
 
-    /* Authentication */
-    char *username;
-    char *password;
-
     /* Optional reconnect delay in seconds */
     uint32_t reconnect_delay;
     bool reconnect_disabled;
@@ -103,9 +158,6 @@ typedef struct bbl_session_
     uint8_t chap_response[CHALLENGE_LEN];
 
     /* Access Line */
-    char *agent_circuit_id;
-    char *agent_remote_id;
-    char *access_aggregation_circuit_id;
     uint32_t rate_up;
     uint32_t rate_down;
     uint32_t dsl_type;
@@ -114,7 +166,7 @@ typedef struct bbl_session_
 
     /* TCP */
     bbl_http_client_s *http_client;
-    struct netif netif; /* LwIP interface */
+    struct netif *netif; /* LwIP interface (allocated on demand) */
     
     /* Ethernet */
     uint8_t server_mac[ETH_ADDR_LEN];
@@ -126,7 +178,6 @@ typedef struct bbl_session_
     uint32_t cfm_seq;
     uint8_t cfm_level;
     uint16_t cfm_ma_id;
-    char *cfm_ma_name;
 
     /* PPPoE */
     uint16_t pppoe_session_id;
@@ -245,7 +296,7 @@ typedef struct bbl_session_
     bool     igmp_autostart;
     uint8_t  igmp_version;
     uint8_t  igmp_robustness;
-    bbl_igmp_group_s igmp_groups[IGMP_MAX_GROUPS];
+    bbl_igmp_group_s *igmp_groups; /* allocated on demand */
 
     /* IGMP Zapping */
     bbl_igmp_group_s *zapping_joined_group;
@@ -374,6 +425,24 @@ bbl_session_get(uint32_t session_id);
 void
 bbl_session_free(bbl_session_s *session);
 
+char *
+bbl_session_string(bbl_session_s *session, bbl_session_string_t type);
+
+const char *
+bbl_setup_phase_string(bbl_setup_phase_t phase);
+
+void
+bbl_session_setup_start(bbl_session_s *session, bbl_setup_phase_t phase);
+
+void
+bbl_session_setup_done(bbl_session_s *session, bbl_setup_phase_t phase);
+
+json_t *
+bbl_session_setup_latency_json();
+
+int
+bbl_session_ctrl_setup_latency(int fd, uint32_t session_id, json_t *arguments);
+
 void
 bbl_session_reset(bbl_session_s *session);
 
@@ -383,6 +452,9 @@ bbl_session_update_state(bbl_session_s *session, session_state_t state);
 void
 bbl_session_clear(bbl_session_s *session);
 
+void
+bbl_session_counters(bbl_session_counters_s *sum);
+
 bool
 bbl_sessions_init();
 
@@ -401,6 +473,9 @@ bbl_session_ctrl_pending(int fd, uint32_t session_id __attribute__((unused)), js
 int
 bbl_session_ctrl_counters(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)));
 
+int
+bbl_session_ctrl_sessions_info(int fd, uint32_t session_id, json_t *arguments);
+
 int
 bbl_session_ctrl_info(int fd, uint32_t session_id, json_t *arguments __attribute__((unused)));
 
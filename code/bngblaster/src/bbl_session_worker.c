@@ -0,0 +1,245 @@
+/*
+ * BNG Blaster (BBL) - Session Worker Threads
+ *
+ * With sessions worker-threads enabled, the sessions of each
+ * access interface are processed by a dedicated worker thread
+ * with its own timer root, running the RX and TX jobs of the
+ * interface and all session timers. Session counters are kept
+ * per worker and summed on read (see bbl_session_counters).
+ *
+ * The main loop and control socket lock the workers before
+ * accessing session state owned by them. Features sharing
+ * global state with the session processing which is not yet
+ * partitioned are rejected if worker threads are enabled.
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bbl.h"
+
+static bool
+bbl_session_worker_supported(bbl_access_interface_s *access_interface)
+{
+    bbl_interface_s *interface = access_interface->interface;
+
+    if(g_ctx->pcap.filename) {
+        LOG_NOARG(ERROR, "Session worker threads not supported with PCAP capture\n");
+        return false;
+    }
+    if(g_ctx->tcp) {
+        LOG_NOARG(ERROR, "Session worker threads not supported with TCP (lwIP)\n");
+        return false;
+    }
+    if(g_ctx->config.l2tp_server) {
+        LOG_NOARG(ERROR, "Session worker threads not supported with L2TP\n");
+        return false;
+    }
+    if(!CIRCLEQ_EMPTY(&g_ctx->a10nsp_interface_qhead)) {
+        LOG_NOARG(ERROR, "Session worker threads not supported with A10NSP\n");
+        return false;
+    }
+    if(interface->type == LAG_INTERFACE) {
+        LOG(ERROR, "Session worker threads not supported on LAG interface %s\n", interface->name);
+        return false;
+    }
+    if(interface->network) {
+        LOG(ERROR, "Session worker threads not supported on interface %s with network function\n", interface->name);
+        return false;
+    }
+    return true;
+}
+
+static void *
+bbl_session_worker_thread(void *thread_data)
+{
+    bbl_session_worker_s *worker = thread_data;
+    struct timespec next;
+    struct timespec idle = {0, BBL_SESSION_WORKER_IDLE * MSEC};
+
+    pthread_mutex_lock(&worker->mutex);
+    timer_smear_all_buckets(&worker->timer_root);
+    pthread_mutex_unlock(&worker->mutex);
+
+    while(worker->active) {
+        pthread_mutex_lock(&worker->mutex);
+        timer_process(&worker->timer_root, &next);
+        pthread_mutex_unlock(&worker->mutex);
+        if(next.tv_sec || next.tv_nsec) {
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        } else {
+            nanosleep(&idle, NULL);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * bbl_session_worker_init
+ *
+ * Create a session worker per access interface
+ * if enabled and move the RX, TX and rate jobs
+ * of those interfaces to the worker timer root.
+ * This must be called after interfaces are
+ * initialised but before sessions and streams.
+ *
+ * @return true if successful
+ */
+bool
+bbl_session_worker_init()
+{
+    bbl_access_interface_s *access_interface;
+    bbl_interface_s *interface;
+    bbl_session_worker_s *worker;
+    bbl_session_shard_s *shard = &g_ctx->session_shard;
+
+    if(!g_ctx->config.sessions_worker_threads) {
+        return true;
+    }
+
+    CIRCLEQ_FOREACH(access_interface, &g_ctx->access_interface_qhead, access_interface_qnode) {
+        if(!bbl_session_worker_supported(access_interface)) {
+            return false;
+        }
+        interface = access_interface->interface;
+
+        worker = calloc(1, sizeof(bbl_session_worker_s));
+        if(!worker) {
+            return false;
+        }
+        worker->next = g_ctx->session_workers;
+        g_ctx->session_workers = worker;
+        worker->access_interface = access_interface;
+        worker->sp = malloc(SCRATCHPAD_LEN);
+        if(!worker->sp) {
+            return false;
+        }
+        if(pthread_mutex_init(&worker->mutex, NULL) != 0) {
+            LOG_NOARG(ERROR, "Failed to init mutex\n");
+            return false;
+        }
+        timer_init_root(&worker->timer_root);
+
+        worker->shard.worker = worker;
+        worker->shard.timer_root = &worker->timer_root;
+        CIRCLEQ_INIT(&worker->shard.sessions_idle_qhead);
+        CIRCLEQ_INIT(&worker->shard.sessions_teardown_qhead);
+        shard->next = &worker->shard;
+        shard = shard->next;
+
+        access_interface->shard = &worker->shard;
+        interface->io.sp = worker->sp;
+        timer_move(&worker->timer_root, &interface->io.rx_job);
+        timer_move(&worker->timer_root, &interface->io.tx_job);
+        timer_move(&worker->timer_root, &access_interface->rate_job);
+
+        LOG(INFO, "Session worker thread for interface %s\n", interface->name);
+    }
+    return true;
+}
+
+/**
+ * bbl_session_worker_start_all
+ */
+void
+bbl_session_worker_start_all()
+{
+    bbl_session_worker_s *worker = g_ctx->session_workers;
+    while(worker) {
+        worker->active = true;
+        if(pthread_create(&worker->thread, NULL, bbl_session_worker_thread, (void *)worker) != 0) {
+            LOG(ERROR, "Failed to create session worker thread for interface %s\n",
+                worker->access_interface->interface->name);
+            worker->active = false;
+        }
+        worker = worker->next;
+    }
+}
+
+/**
+ * bbl_session_worker_stop_all
+ */
+void
+bbl_session_worker_stop_all()
+{
+    bbl_session_worker_s *worker = g_ctx->session_workers;
+    while(worker) {
+        if(worker->active) {
+            worker->active = false;
+            pthread_join(worker->thread, NULL);
+        }
+        worker = worker->next;
+    }
+}
+
+/**
+ * bbl_session_worker_free_all
+ */
+void
+bbl_session_worker_free_all()
+{
+    bbl_session_worker_s *worker = g_ctx->session_workers;
+    bbl_session_worker_s *next;
+    while(worker) {
+        next = worker->next;
+        timer_flush_root(&worker->timer_root);
+        pthread_mutex_destroy(&worker->mutex);
+        if(worker->sp) {
+            free(worker->sp);
+        }
+        free(worker);
+        worker = next;
+    }
+    g_ctx->session_workers = NULL;
+}
+
+/**
+ * bbl_session_worker_lock
+ *
+ * Lock session worker before accessing state owned
+ * by the worker from another thread. Nothing is
+ * locked if worker is NULL (main loop).
+ *
+ * @param worker session worker or NULL
+ */
+void
+bbl_session_worker_lock(bbl_session_worker_s *worker)
+{
+    if(worker) {
+        pthread_mutex_lock(&worker->mutex);
+    }
+}
+
+void
+bbl_session_worker_unlock(bbl_session_worker_s *worker)
+{
+    if(worker) {
+        pthread_mutex_unlock(&worker->mutex);
+    }
+}
+
+/**
+ * bbl_session_worker_lock_all
+ *
+ * Lock all session workers, always in the same
+ * order to prevent deadlocks between main loop
+ * and control socket thread.
+ */
+void
+bbl_session_worker_lock_all()
+{
+    bbl_session_worker_s *worker = g_ctx->session_workers;
+    while(worker) {
+        pthread_mutex_lock(&worker->mutex);
+        worker = worker->next;
+    }
+}
+
+void
+bbl_session_worker_unlock_all()
+{
+    bbl_session_worker_s *worker = g_ctx->session_workers;
+    while(worker) {
+        pthread_mutex_unlock(&worker->mutex);
+        worker = worker->next;
+    }
+}
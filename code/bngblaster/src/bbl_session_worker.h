@@ -0,0 +1,51 @@
+/*
+ * BNG Blaster (BBL) - Session Worker Threads
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_SESSION_WORKER_H__
+#define __BBL_SESSION_WORKER_H__
+
+#define BBL_SESSION_WORKER_IDLE     1 /* msec */
+
+/* Session worker processing the sessions, RX and TX
+ * jobs of one access interface in a dedicated thread. */
+typedef struct bbl_session_worker_ {
+    bbl_access_interface_s *access_interface;
+    bbl_session_shard_s shard;
+    struct timer_root_ timer_root;
+    uint8_t *sp; /* scratchpad memory */
+
+    pthread_t thread;
+    pthread_mutex_t mutex; /* held while processing timers */
+    bool active;
+
+    bbl_session_worker_s *next;
+} bbl_session_worker_s;
+
+bool
+bbl_session_worker_init();
+
+void
+bbl_session_worker_start_all();
+
+void
+bbl_session_worker_stop_all();
+
+void
+bbl_session_worker_free_all();
+
+void
+bbl_session_worker_lock(bbl_session_worker_s *worker);
+
+void
+bbl_session_worker_unlock(bbl_session_worker_s *worker);
+
+void
+bbl_session_worker_lock_all();
+
+void
+bbl_session_worker_unlock_all();
+
+#endif
@@ -18,22 +18,25 @@ void
 bbl_stats_update_cps()
 {
     struct timespec time_diff = {0};
+    bbl_session_counters_s counters;
     uint32_t ms;
     double x, y;
 
+    bbl_session_counters(&counters);
+
     /* Session setup time and rate */
-    if(g_ctx->sessions_established_max > g_ctx->stats.sessions_established_max) {
-        g_ctx->stats.sessions_established_max = g_ctx->sessions_established_max;
+    if(counters.sessions_established_max > g_ctx->stats.sessions_established_max) {
+        g_ctx->stats.sessions_established_max = counters.sessions_established_max;
 
         timespec_sub(&time_diff,
-             &g_ctx->stats.last_session_established,
-             &g_ctx->stats.first_session_tx);
+             &counters.last_session_established,
+             &counters.first_session_tx);
 
         ms = time_diff.tv_nsec / 1000000; /* convert nanoseconds to milliseconds */
         if(time_diff.tv_nsec % 1000000) ms++; /* simple roundup function */
         g_ctx->stats.setup_time = (time_diff.tv_sec * 1000) + ms; /* Setup time in milliseconds */
 
-        x = g_ctx->sessions_established_max;
+        x = counters.sessions_established_max;
         y = g_ctx->stats.setup_time;
         if(x > 0.0 && y > 0.0) {
             g_ctx->stats.cps = (x / y) * 1000.0;
@@ -396,6 +399,8 @@ bbl_stats_generate(bbl_stats_s * stats)
                     stats->min_stream_delay_us = stream->rx_min_delay_us;
                 }
                 if(stream->rx_max_delay_us > stats->max_stream_delay_us) stats->max_stream_delay_us = stream->rx_max_delay_us;
+                if(bbl_stream_jitter_us(stream) > stats->max_stream_jitter_us) stats->max_stream_jitter_us = bbl_stream_jitter_us(stream);
+                bbl_stream_delay_hist_add(stream, stats->stream_delay_hist);
             }
         }
     }
@@ -410,21 +415,26 @@ bbl_stats_stdout(bbl_stats_s *stats) {
     bbl_a10nsp_interface_s *a10nsp_interface;
     bbl_interface_stats_s interface_stats_tx;
     bbl_interface_stats_s interface_stats_rx;
+    bbl_session_counters_s counters;
     uint64_t violations;
     float percent;
 
+    bbl_session_counters(&counters);
+
     printf("%s", banner);
     printf("Report:");
     printf("\n==============================================================================\n");
     printf("Test Duration: %lus\n", test_duration());
     if(g_ctx->sessions) {
         printf("Sessions PPPoE: %u IPoE: %u\n", g_ctx->sessions_pppoe, g_ctx->sessions_ipoe);
-        printf("Sessions established: %u/%u\n", g_ctx->sessions_established_max, g_ctx->sessions);
-        printf("DHCPv6 sessions established: %u\n", g_ctx->dhcpv6_established_max);
+        printf("Sessions established: %u/%u\n", counters.sessions_established_max, g_ctx->sessions);
+        printf("DHCPv6 sessions established: %u\n", counters.dhcpv6_established_max);
         printf("Setup Time: %u ms\n", g_ctx->stats.setup_time);
         printf("Setup Rate: %0.02lf CPS (MIN: %0.02lf AVG: %0.02lf MAX: %0.02lf)\n",
             g_ctx->stats.cps, g_ctx->stats.cps_min, g_ctx->stats.cps_avg, g_ctx->stats.cps_max);
-        printf("Flapped: %u\n", g_ctx->sessions_flapped);
+        printf("Setup Rate Target: %0.02lf CPS\n", g_ctx->stats.cps_target);
+        printf("Setup Retries: %lu\n", counters.session_retries);
+        printf("Flapped: %u\n", counters.sessions_flapped);
     }
 
     if(dict_count(g_ctx->li_flow_dict)) {
@@ -753,6 +763,11 @@ bbl_stats_stdout(bbl_stats_s *stats) {
             stats->min_stream_loss, stats->max_stream_loss);
         printf("  Flow Receive Delay (usec)       MIN: %8lu MAX: %8lu\n",
             stats->min_stream_delay_us, stats->max_stream_delay_us);
+        printf("  Flow Receive Delay (usec)       P50: %8lu P99: %8lu P99.9: %8lu\n",
+            bbl_stream_delay_percentile(stats->stream_delay_hist, stats->max_stream_delay_us, 50.0),
+            bbl_stream_delay_percentile(stats->stream_delay_hist, stats->max_stream_delay_us, 99.0),
+            bbl_stream_delay_percentile(stats->stream_delay_hist, stats->max_stream_delay_us, 99.9));
+        printf("  Flow Receive Jitter (usec)      MAX: %8.3f\n", stats->max_stream_jitter_us);
     }
 
     if(g_ctx->config.igmp_group_count > 1) {
@@ -804,6 +819,7 @@ bbl_stats_json(bbl_stats_s * stats)
     bbl_interface_stats_s interface_stats_rx;
     bbl_session_s *session;
     bbl_stream_s *stream;
+    bbl_session_counters_s counters;
 
     struct dict_itor *itor;
 
@@ -821,18 +837,29 @@ bbl_stats_json(bbl_stats_s * stats)
     root = json_object();
     jobj = json_object();
     if(g_ctx->sessions) {
+        bbl_session_counters(&counters);
         json_object_set(jobj, "sessions", json_integer(g_ctx->config.sessions));
         json_object_set(jobj, "sessions-pppoe", json_integer(g_ctx->sessions_pppoe));
         json_object_set(jobj, "sessions-ipoe", json_integer(g_ctx->sessions_ipoe));
-        json_object_set(jobj, "sessions-established", json_integer(g_ctx->sessions_established_max));
-        json_object_set(jobj, "sessions-flapped", json_integer(g_ctx->sessions_flapped));
+        json_object_set(jobj, "sessions-established", json_integer(counters.sessions_established_max));
+        json_object_set(jobj, "sessions-flapped", json_integer(counters.sessions_flapped));
         json_object_set(jobj, "setup-time-ms", json_integer(g_ctx->stats.setup_time));
         json_object_set(jobj, "setup-rate-cps", json_real(g_ctx->stats.cps));
         json_object_set(jobj, "setup-rate-cps-min", json_real(g_ctx->stats.cps_min));
         json_object_set(jobj, "setup-rate-cps-avg", json_real(g_ctx->stats.cps_avg));
         json_object_set(jobj, "setup-rate-cps-max", json_real(g_ctx->stats.cps_max));
-        json_object_set(jobj, "dhcp-sessions-established", json_integer(g_ctx->dhcp_established_max));
-        json_object_set(jobj, "dhcpv6-sessions-established", json_integer(g_ctx->dhcpv6_established_max));
+        json_object_set(jobj, "setup-rate-cps-target", json_real(g_ctx->stats.cps_target));
+        json_object_set(jobj, "setup-retries", json_integer(counters.session_retries));
+        jobj_sub = json_array();
+        for(i = 0; i < g_ctx->pacing.history_len; i++) {
+            json_array_append_new(jobj_sub, json_pack("{si si}",
+                "target-cps", g_ctx->pacing.history[i].target,
+                "achieved-cps", g_ctx->pacing.history[i].achieved));
+        }
+        json_object_set_new(jobj, "setup-rate-history", jobj_sub);
+        json_object_set_new(jobj, "setup-latency", bbl_session_setup_latency_json());
+        json_object_set(jobj, "dhcp-sessions-established", json_integer(counters.dhcp_established_max));
+        json_object_set(jobj, "dhcpv6-sessions-established", json_integer(counters.dhcpv6_established_max));
     }
     if(dict_count(g_ctx->li_flow_dict)) {
         jobj_sub = json_object();
@@ -1152,6 +1179,10 @@ bbl_stats_json(bbl_stats_s * stats)
         json_object_set(jobj_sub, "flow-rx-packet-loss-max", json_integer(stats->max_stream_loss));
         json_object_set(jobj_sub, "flow-rx-delay-us-min", json_integer(stats->min_stream_delay_us));
         json_object_set(jobj_sub, "flow-rx-delay-us-max", json_integer(stats->max_stream_delay_us));
+        json_object_set(jobj_sub, "flow-rx-delay-us-p50", json_integer(bbl_stream_delay_percentile(stats->stream_delay_hist, stats->max_stream_delay_us, 50.0)));
+        json_object_set(jobj_sub, "flow-rx-delay-us-p99", json_integer(bbl_stream_delay_percentile(stats->stream_delay_hist, stats->max_stream_delay_us, 99.0)));
+        json_object_set(jobj_sub, "flow-rx-delay-us-p999", json_integer(bbl_stream_delay_percentile(stats->stream_delay_hist, stats->max_stream_delay_us, 99.9)));
+        json_object_set(jobj_sub, "flow-rx-jitter-us-max", json_real(stats->max_stream_jitter_us));
         json_object_set(jobj, "traffic-streams", jobj_sub);
     }
 
@@ -127,6 +127,8 @@ typedef struct bbl_stats_
     uint64_t max_stream_rx_first_seq;
     uint64_t min_stream_delay_us;
     uint64_t max_stream_delay_us;
+    uint64_t stream_delay_hist[BBL_STREAM_DELAY_BUCKETS];
+    double max_stream_jitter_us;
 
     /* L2TP */
 
@@ -15,6 +15,8 @@ extern volatile bool g_teardown;
 extern bool g_init_phase;
 extern bool g_traffic;
 
+static atomic_uint_fast64_t g_stream_template = 0;
+
 const char g_multicast_traffic[] = "multicast";
 const char g_session_traffic_ipv4[] = "session-ipv4";
 const char g_session_traffic_ipv6[] = "session-ipv6";
@@ -24,13 +26,36 @@ endpoint_state_t g_endpoint = ENDPOINT_ACTIVE;
 static void
 bbl_stream_delay(bbl_stream_s *stream, struct timespec *rx_timestamp, struct timespec *bbl_timestamp)
 {
+    bbl_stream_delay_s *rx_delay = stream->rx_delay;
     struct timespec delay;
     uint64_t delay_us;
+    int64_t transit;
+    int64_t d;
+
     timespec_sub(&delay, rx_timestamp, bbl_timestamp);
     
     delay_us = (delay.tv_sec * 1000000) + (delay.tv_nsec / 1000);
     if(delay_us == 0) delay_us = 1;
 
+    if(!rx_delay) {
+        rx_delay = calloc(1, sizeof(bbl_stream_delay_s));
+        stream->rx_delay = rx_delay;
+    }
+    if(rx_delay) {
+        rx_delay->hist[hist_log_bucket(delay_us, BBL_STREAM_DELAY_BUCKETS)]++;
+
+        /* RFC 3550 interarrival jitter J += (|D(i-1,i)| - J) / 16
+         * with J stored scaled by 16 to keep the precision. */
+        transit = ((int64_t)rx_timestamp->tv_sec - bbl_timestamp->tv_sec) * 1000000000 + 
+                  (rx_timestamp->tv_nsec - bbl_timestamp->tv_nsec);
+        if(stream->rx_min_delay_us) {
+            d = transit - rx_delay->last_transit_ns;
+            if(d < 0) d = -d;
+            rx_delay->jitter += d - ((rx_delay->jitter + 8) >> 4);
+        }
+        rx_delay->last_transit_ns = transit;
+    }
+
     if(delay_us > stream->rx_max_delay_us) {
         stream->rx_max_delay_us = delay_us;
     }
@@ -1354,10 +1379,10 @@ bbl_stream_tx_qnode_remove(io_handle_s *io, bbl_stream_s *stream)
 }
 
 static void
-bbl_stream_update_tcp(bbl_stream_s *stream)
+bbl_stream_checksum_tcp(bbl_stream_s *stream, uint8_t *buf)
 {
     uint16_t  tcp_len = stream->tx_bbl_hdr_len + TCP_HDR_LEN_MIN;
-    uint8_t  *tcp_buf = (uint8_t*)(stream->tx_buf + (stream->tx_len - tcp_len));
+    uint8_t  *tcp_buf = (uint8_t*)(buf + (stream->tx_len - tcp_len));
     uint16_t *checksum = (uint16_t*)(tcp_buf+16);
 
     *checksum = 0;
@@ -1368,44 +1393,118 @@ bbl_stream_update_tcp(bbl_stream_s *stream)
     }
 }
 
-protocol_error_t
-bbl_stream_tx(io_handle_s *io, uint8_t *buf, uint16_t *len)
+/**
+ * Update the TCP checksum of a stream packet 
+ * after the BBL header fields have been updated.
+ *
+ * Only the last 16 bytes (sequence and timestamp) 
+ * differ from the stream template which contains 
+ * a valid checksum. This allows to update the 
+ * checksum incrementally (RFC 1624) instead of 
+ * summing up the whole TCP segment.
+ *
+ * @param stream stream
+ * @param buf stream packet
+ */
+static void
+bbl_stream_update_tcp(bbl_stream_s *stream, uint8_t *buf)
+{
+    uint16_t tcp_len = stream->tx_bbl_hdr_len + TCP_HDR_LEN_MIN;
+    uint16_t checksum = stream->tx_len - tcp_len + 16;
+    uint16_t update = stream->tx_len - 16;
+
+    if(stream->tx_bbl_hdr_len & 1) {
+        /* Incremental update requires even offset. */
+        bbl_stream_checksum_tcp(stream, buf);
+        return;
+    }
+    *(uint16_t*)(buf + checksum) = bbl_checksum_update(
+        *(uint16_t*)(stream->tx_buf + checksum), 
+        stream->tx_buf + update, buf + update, 16);
+}
+
+/**
+ * Write the next stream packet to buffer.
+ * 
+ * The optional template argument refers to the template
+ * id of the stream packet already stored in the buffer,
+ * which is typically a TX ring slot reused by the
+ * same stream. If this matches the template id of the
+ * stream, only the BBL header fields (and TCP checksum) 
+ * are updated instead of copying the whole packet.
+ * 
+ * @param io IO handle
+ * @param buf target buffer
+ * @param len target buffer length
+ * @param template template id of buffer (optional)
+ * @return PROTOCOL_SUCCESS or EMPTY if there is nothing to send
+ */
+static inline protocol_error_t
+bbl_stream_tx_buf(io_handle_s *io, uint8_t *buf, uint16_t *len, uint64_t *template)
 {
     bbl_stream_s *stream;
-    if(!CIRCLEQ_EMPTY(&io->stream_tx_qhead)) {
+
+    if(io->stream_tokens < 1.0) {
+        /* Rate limit of this TX handle reached. */
+        return EMPTY;
+    }
+    while(!CIRCLEQ_EMPTY(&io->stream_tx_qhead)) {
         stream = CIRCLEQ_FIRST(&io->stream_tx_qhead);
-        if(stream->token_bucket && stream->tx_buf) {
-            /* Update BBL header fields */
-            *(uint64_t*)(stream->tx_buf + (stream->tx_len - 16)) = stream->flow_seq;
-            *(uint32_t*)(stream->tx_buf + (stream->tx_len - 8)) = io->timestamp.tv_sec;
-            *(uint32_t*)(stream->tx_buf + (stream->tx_len - 4)) = io->timestamp.tv_nsec;
-            if(stream->tcp) {
-                bbl_stream_update_tcp(stream);
-            }
-            *len = stream->tx_len;
+        if(!(stream->token_bucket && stream->tx_buf)) {
+            bbl_stream_tx_qnode_remove(io, stream);
+            continue;
+        }
+        *len = stream->tx_len;
+        if(!(template && *template == stream->tx_template)) {
             memcpy(buf, stream->tx_buf, *len);
-            stream->token_bucket--;
-            stream->tx_packets++;
-
-            if(stream->flow_seq == 1) {
-                stream->tx_first_epoch = io->timestamp.tv_sec;
+            if(template) {
+                *template = stream->tx_template;
             }
-            stream->flow_seq++;
+        }
+        if(io->timestamping) {
+            /* Per packet TX timestamp */
+            clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        }
+        /* Update BBL header fields */
+        *(uint64_t*)(buf + (*len - 16)) = stream->flow_seq;
+        *(uint32_t*)(buf + (*len - 8)) = io->timestamp.tv_sec;
+        *(uint32_t*)(buf + (*len - 4)) = io->timestamp.tv_nsec;
+        if(stream->tcp) {
+            bbl_stream_update_tcp(stream, buf);
+        }
+        stream->token_bucket--;
+        stream->tx_packets++;
+        io->stream_tokens -= 1.0;
 
-            /* Remove only from TX queue if all tokens are consumed! */
-            bbl_stream_tx_qnode_remove(io, stream);
-            if(stream->token_bucket) {
-                /* Move to the end. */
-                bbl_stream_tx_qnode_insert(io, stream);
-            }
-        } else {
-            bbl_stream_tx_qnode_remove(io, stream);
+        if(stream->flow_seq == 1) {
+            stream->tx_first_epoch = io->timestamp.tv_sec;
+            stream->tx_timestamp_source = io->timestamping;
+        }
+        stream->flow_seq++;
+
+        /* Remove only from TX queue if all tokens are consumed! */
+        bbl_stream_tx_qnode_remove(io, stream);
+        if(stream->token_bucket) {
+            /* Move to the end. */
+            bbl_stream_tx_qnode_insert(io, stream);
         }
         return PROTOCOL_SUCCESS;
     }
     return EMPTY;
 }
 
+protocol_error_t
+bbl_stream_tx(io_handle_s *io, uint8_t *buf, uint16_t *len)
+{
+    return bbl_stream_tx_buf(io, buf, len, NULL);
+}
+
+protocol_error_t
+bbl_stream_tx_template(io_handle_s *io, uint8_t *buf, uint16_t *len, uint64_t *template)
+{
+    return bbl_stream_tx_buf(io, buf, len, template);
+}
+
 static bool
 bbl_stream_lag(bbl_stream_s *stream)
 {
@@ -1546,19 +1645,48 @@ bbl_stream_token_job(timer_s *timer)
             stream->token_bucket = 0;
             return;
         }
+        if(stream->tcp) {
+            bbl_stream_checksum_tcp(stream, stream->tx_buf);
+        }
+        /* Template id zero is reserved for empty buffers. */
+        stream->tx_template = atomic_fetch_add(&g_stream_template, 1) + 1;
     }
     bbl_stream_tx_qnode_insert(stream->io, stream);
 }
 
+static bbl_session_worker_s *
+bbl_stream_worker(bbl_stream_s *stream)
+{
+    if(stream->session) {
+        return stream->session->access_interface->shard->worker;
+    } else if(stream->access_interface) {
+        return stream->access_interface->shard->worker;
+    }
+    return NULL;
+}
+
 void
 bbl_stream_group_job(timer_s *timer)
 {
     bbl_stream_group_s *group = timer->data;
     bbl_stream_s *stream = group->head;
+    bbl_session_worker_s *worker = NULL;
+    bbl_session_worker_s *next;
+
+    /* Session streams update session state owned by
+     * session worker threads, where only the worker of
+     * the current stream is locked. */
     while(stream) {
+        next = bbl_stream_worker(stream);
+        if(next != worker) {
+            bbl_session_worker_unlock(worker);
+            bbl_session_worker_lock(next);
+            worker = next;
+        }
         bbl_stream_ctrl(stream);
         stream = stream->group_next;
     }
+    bbl_session_worker_unlock(worker);
 }
 
 bbl_stream_group_s *
@@ -1570,6 +1698,63 @@ bbl_stream_group_init()
     return group;
 }
 
+/**
+ * Add stream to the flow-id indexed stream table.
+ * 
+ * This is a two level table with lazily allocated blocks 
+ * of BBL_STREAM_FLOW_BLOCK_SIZE streams. Streams are added
+ * by the main thread only and never removed, which allows 
+ * RX threads to search streams without locks.
+ *
+ * @param stream stream
+ * @return true if successful
+ */
+static bool
+bbl_stream_index_add(bbl_stream_s *stream)
+{
+    bbl_stream_s **block;
+    uint64_t index = stream->flow_id >> BBL_STREAM_FLOW_BLOCK_BITS;
+
+    if(index >= BBL_STREAM_FLOW_INDEX_SIZE) {
+        return false;
+    }
+    block = g_ctx->stream_flow_index[index];
+    if(!block) {
+        block = calloc(BBL_STREAM_FLOW_BLOCK_SIZE, sizeof(bbl_stream_s*));
+        if(!block) {
+            return false;
+        }
+        __atomic_store_n(&g_ctx->stream_flow_index[index], block, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&block[stream->flow_id & (BBL_STREAM_FLOW_BLOCK_SIZE-1)], stream, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Get stream by flow-id. 
+ * 
+ * This function is thread safe and 
+ * can be called from RX threads.
+ *
+ * @param flow_id flow-id
+ * @return stream or NULL if not found
+ */
+bbl_stream_s *
+bbl_stream_index_get(uint64_t flow_id)
+{
+    bbl_stream_s **block;
+    uint64_t index = flow_id >> BBL_STREAM_FLOW_BLOCK_BITS;
+
+    if(index >= BBL_STREAM_FLOW_INDEX_SIZE) {
+        return NULL;
+    }
+    block = __atomic_load_n(&g_ctx->stream_flow_index[index], __ATOMIC_ACQUIRE);
+    if(!block) {
+        return NULL;
+    }
+    return __atomic_load_n(&block[flow_id & (BBL_STREAM_FLOW_BLOCK_SIZE-1)], __ATOMIC_ACQUIRE);
+}
+
 static void
 bbl_stream_add_group(bbl_stream_s *stream)
 {
@@ -1602,9 +1787,26 @@ bbl_stream_select_io_lag(bbl_stream_s *stream)
             stream->io = member->interface->io.tx;
         }
         member->interface->io.tx->stream_pps += stream->config->pps;
+        member->interface->io.tx->stream_bps += stream->config->pps * stream->config->length * 8;
     }
 }
 
+/**
+ * bbl_stream_io_load
+ *
+ * The load of a TX handle is the sum of bits per second
+ * with a fixed per packet cost added, so that streams are
+ * balanced by both packets and bytes.
+ *
+ * @param io TX handle
+ * @return load of the TX handle
+ */
+static double
+bbl_stream_io_load(io_handle_s *io)
+{
+    return io->stream_bps + (io->stream_pps * BBL_STREAM_TX_PACKET_COST);
+}
+
 static void
 bbl_stream_select_io(bbl_stream_s *stream)
 {
@@ -1612,12 +1814,13 @@ bbl_stream_select_io(bbl_stream_s *stream)
     io_handle_s *io_iter = io;
 
     while(io_iter) {
-        if(io_iter->stream_pps < io->stream_pps) {
+        if(bbl_stream_io_load(io_iter) < bbl_stream_io_load(io)) {
             io = io_iter;
         }
         io_iter = io_iter->next;
     }
     io->stream_pps += stream->config->pps;
+    io->stream_bps += stream->config->pps * stream->config->length * 8;
     stream->io = io;
     if(io->thread) {
         stream->threaded = true;
@@ -1645,6 +1848,9 @@ bbl_stream_add(bbl_stream_s *stream)
     if(stream->io && stream->io->thread) {
         timer_add_periodic(&stream->io->thread->timer.root, &stream->tx_timer, "Stream Tokens",
                             timer_sec, timer_nsec, stream, &bbl_stream_token_job);
+    } else if(stream->io && stream->io->interface->access) {
+        timer_add_periodic(stream->io->interface->access->shard->timer_root, &stream->tx_timer, "Stream Tokens",
+                            timer_sec, timer_nsec, stream, &bbl_stream_token_job);
     } else {
         timer_add_periodic(&g_ctx->timer_root, &stream->tx_timer, "Stream Tokens",
                             timer_sec, timer_nsec, stream, &bbl_stream_token_job);
@@ -1757,6 +1963,10 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
             return false;
         }
         *result.datum_ptr = stream_up;
+        if(!bbl_stream_index_add(stream_up)) {
+            LOG(ERROR, "Failed to insert stream %s (upstream)\n", config->name);
+            return false;
+        }
         stream_up->session_next = session->streams.head;
         session->streams.head = stream_up;
         bbl_stream_add(stream_up);
@@ -1807,6 +2017,10 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
             return false;
         }
         *result.datum_ptr = stream_down;
+        if(!bbl_stream_index_add(stream_down)) {
+            LOG(ERROR, "Failed to insert stream %s (downstream)\n", config->name);
+            return false;
+        }
         stream_down->session_next = session->streams.head;
         session->streams.head = stream_down;
         if(network_interface) {
@@ -1971,6 +2185,10 @@ bbl_stream_init() {
                     return false;
                 }
                 *result.datum_ptr = stream;
+                if(!bbl_stream_index_add(stream)) {
+                    LOG(ERROR, "Failed to insert RAW stream %s\n", config->name);
+                    return false;
+                }
                 bbl_stream_add(stream);
                 if(stream->type == BBL_TYPE_MULTICAST) {
                     LOG(DEBUG, "RAW multicast traffic stream %s added to %s with %0.2lf PPS\n", 
@@ -2037,6 +2255,10 @@ bbl_stream_init() {
                 return false;
             }
             *result.datum_ptr = stream;
+            if(!bbl_stream_index_add(stream)) {
+                LOG(ERROR, "Failed to insert multicast stream %s\n", config->name);
+                return false;
+            }
             bbl_stream_add(stream);
             LOG(DEBUG, "Autogenerated multicast traffic stream added to %s with %0.2lf PPS\n", 
                 network_interface->name, config->pps);
@@ -2140,6 +2362,56 @@ bbl_stream_init() {
     return true;
 }
 
+/**
+ * Add stream delay histogram to the given 
+ * histogram, which allows to aggregate the
+ * delay of multiple streams.
+ *
+ * @param stream traffic stream
+ * @param hist histogram with BBL_STREAM_DELAY_BUCKETS buckets
+ */
+void
+bbl_stream_delay_hist_add(bbl_stream_s *stream, uint64_t *hist)
+{
+    int i;
+
+    if(!stream->rx_delay) {
+        return;
+    }
+    for(i = 0; i < BBL_STREAM_DELAY_BUCKETS; i++) {
+        hist[i] += stream->rx_delay->hist[i];
+    }
+}
+
+/**
+ * Get delay percentile from histogram.
+ *
+ * The result is the highest delay of the bucket 
+ * containing the percentile, limited to max_us.
+ *
+ * @param hist histogram with BBL_STREAM_DELAY_BUCKETS buckets
+ * @param max_us maximum delay in microseconds
+ * @param percentile percentile (e.g. 99.9)
+ * @return delay in microseconds or zero if empty
+ */
+uint64_t
+bbl_stream_delay_percentile(uint64_t *hist, uint64_t max_us, double percentile)
+{
+    return hist_log_percentile(hist, BBL_STREAM_DELAY_BUCKETS, max_us, percentile);
+}
+
+/**
+ * Get RFC 3550 interarrival jitter in microseconds.
+ */
+double
+bbl_stream_jitter_us(bbl_stream_s *stream)
+{
+    if(!stream->rx_delay) {
+        return 0;
+    }
+    return (double)(stream->rx_delay->jitter >> 4) / 1000.0;
+}
+
 void __attribute__((optimize("O0")))
 bbl_stream_reset(bbl_stream_s *stream)
 {
@@ -2153,6 +2425,9 @@ bbl_stream_reset(bbl_stream_s *stream)
 
         stream->rx_min_delay_us = 0;
         stream->rx_max_delay_us = 0;
+        if(stream->rx_delay) {
+            memset(stream->rx_delay, 0x0, sizeof(bbl_stream_delay_s));
+        }
         stream->rx_len = 0;
         stream->rx_first_seq = 0;
         stream->rx_last_seq = 0;
@@ -2216,7 +2491,6 @@ bbl_stream_rx(bbl_ethernet_header_s *eth, bbl_session_s *session)
     bbl_bbl_s *bbl = eth->bbl;
     bbl_stream_s *stream;
     bbl_mpls_s *mpls;
-    void **search = NULL;
 
     uint64_t loss = 0;
 
@@ -2224,9 +2498,8 @@ bbl_stream_rx(bbl_ethernet_header_s *eth, bbl_session_s *session)
         return NULL;
     }
 
-    search = dict_search(g_ctx->stream_flow_dict, &bbl->flow_id);
-    if(search) {
-        stream = *search;
+    stream = bbl_stream_index_get(bbl->flow_id);
+    if(stream) {
         if(stream->rx_first_seq) {
             /* Stream already verified */
             if((stream->rx_last_seq +1) < bbl->flow_seq) {
@@ -2296,6 +2569,7 @@ bbl_stream_rx(bbl_ethernet_header_s *eth, bbl_session_s *session)
         stream->rx_packets++;
         stream->rx_last_seq = bbl->flow_seq;
         stream->rx_last_epoch = eth->timestamp.tv_sec;
+        stream->rx_timestamp_source = eth->timestamp_source;
         if(g_ctx->config.stream_delay_calc) {
             bbl_stream_delay(stream, &eth->timestamp, &bbl->timestamp);
         }
@@ -2355,6 +2629,7 @@ bbl_stream_json(bbl_stream_s *stream)
     char *dst_address = NULL;
     uint16_t src_port = 0;
     uint16_t dst_port = 0;
+    uint64_t delay_hist[BBL_STREAM_DELAY_BUCKETS] = {0};
 
     if(!stream) {
         return NULL;
@@ -2394,7 +2669,8 @@ bbl_stream_json(bbl_stream_s *stream)
     }
 
     if(stream->type == BBL_TYPE_UNICAST) {
-        root = json_pack("{ss* ss ss ss ss sI ss sI ss ss* ss* ss* sb sI sI sI si si si si si sI sI sI sI sI sI sI sI sI sI sI sI sI sf sf sf sI sI sI}",
+        bbl_stream_delay_hist_add(stream, delay_hist);
+        root = json_pack("{ss* ss ss ss ss sI ss sI ss ss* ss* ss* sb sI sI sI si si si si si sI sI sI sI sI sI sI sI sI sI sI sf sI sI sI sI sI sf sf sf sI sI sI}",
             "name", stream->config->name,
             "type", stream_type_string(stream),
             "sub-type", stream_sub_type_string(stream),
@@ -2424,6 +2700,10 @@ bbl_stream_json(bbl_stream_s *stream)
             "rx-wrong-session", stream->rx_wrong_session - stream->reset_wrong_session,
             "rx-delay-us-min", stream->rx_min_delay_us,
             "rx-delay-us-max", stream->rx_max_delay_us,
+            "rx-delay-us-p50", bbl_stream_delay_percentile(delay_hist, stream->rx_max_delay_us, 50.0),
+            "rx-delay-us-p99", bbl_stream_delay_percentile(delay_hist, stream->rx_max_delay_us, 99.0),
+            "rx-delay-us-p999", bbl_stream_delay_percentile(delay_hist, stream->rx_max_delay_us, 99.9),
+            "rx-jitter-us", bbl_stream_jitter_us(stream),
             "rx-pps", stream->rate_packets_rx.avg,
             "tx-pps", stream->rate_packets_tx.avg,
             "tx-bps-l2", stream->rate_packets_tx.avg * stream->tx_len * 8,
@@ -2463,6 +2743,12 @@ bbl_stream_json(bbl_stream_s *stream)
         if(stream->reverse) {
             json_object_set(root, "reverse-flow-id", json_integer(stream->reverse->flow_id));
         }
+        if(stream->tx_packets) {
+            json_object_set(root, "tx-timestamp", json_string(io_timestamp_string(stream->tx_timestamp_source)));
+        }
+        if(stream->rx_packets) {
+            json_object_set(root, "rx-timestamp", json_string(io_timestamp_string(stream->rx_timestamp_source)));
+        }
     } else {
         root = json_pack("{ss* ss ss ss ss* sI sI sI sI sI sf}",
             "name", stream->config->name,
@@ -2486,12 +2772,39 @@ int
 bbl_stream_ctrl_stats(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
 {
     int result = 0;
-    json_t *root = json_pack("{ss si s{si si}}",
-                             "status", "ok",
-                             "code", 200,
-                             "stream-stats",
-                             "total-flows", g_ctx->stats.stream_traffic_flows,
-                             "verified-flows", g_ctx->stats.stream_traffic_flows_verified);
+    json_t *root;
+
+    bbl_stream_s *stream;
+    struct dict_itor *itor;
+
+    uint64_t delay_hist[BBL_STREAM_DELAY_BUCKETS] = {0};
+    uint64_t delay_max = 0;
+    double jitter_max = 0;
+
+    /* Aggregate delay and jitter of all traffic streams */
+    itor = dict_itor_new(g_ctx->stream_flow_dict);
+    dict_itor_first(itor);
+    for (; dict_itor_valid(itor); dict_itor_next(itor)) {
+        stream = (bbl_stream_s*)*dict_itor_datum(itor);
+        if(stream && stream->rx_first_seq) {
+            bbl_stream_delay_hist_add(stream, delay_hist);
+            if(stream->rx_max_delay_us > delay_max) delay_max = stream->rx_max_delay_us;
+            if(bbl_stream_jitter_us(stream) > jitter_max) jitter_max = bbl_stream_jitter_us(stream);
+        }
+    }
+    dict_itor_free(itor);
+
+    root = json_pack("{ss si s{si si sI sI sI sI sf}}",
+                     "status", "ok",
+                     "code", 200,
+                     "stream-stats",
+                     "total-flows", g_ctx->stats.stream_traffic_flows,
+                     "verified-flows", g_ctx->stats.stream_traffic_flows_verified,
+                     "flow-rx-delay-us-max", delay_max,
+                     "flow-rx-delay-us-p50", bbl_stream_delay_percentile(delay_hist, delay_max, 50.0),
+                     "flow-rx-delay-us-p99", bbl_stream_delay_percentile(delay_hist, delay_max, 99.0),
+                     "flow-rx-delay-us-p999", bbl_stream_delay_percentile(delay_hist, delay_max, 99.9),
+                     "flow-rx-jitter-us-max", jitter_max);
     if(root) {
         result = json_dumpfd(root, fd, 0);
         json_decref(root);
@@ -2508,7 +2821,6 @@ bbl_stream_ctrl_info(int fd, uint32_t session_id __attribute__((unused)), json_t
     json_t *json_stream = NULL;
 
     bbl_stream_s *stream;
-    void **search = NULL;
 
     int number = 0;
     uint64_t flow_id;
@@ -2519,9 +2831,8 @@ bbl_stream_ctrl_info(int fd, uint32_t session_id __attribute__((unused)), json_t
     }
 
     flow_id = number;
-    search = dict_search(g_ctx->stream_flow_dict, &flow_id);
-    if(search) {
-        stream = *search;
+    stream = bbl_stream_index_get(flow_id);
+    if(stream) {
         json_stream = bbl_stream_json(stream);
         root = json_pack("{ss si so*}",
                          "status", "ok",
@@ -2732,12 +3043,10 @@ bbl_stream_ctrl_start_stop(int fd, uint32_t session_id, int session_group_id, ui
     bbl_session_s *session;
     bbl_stream_s *stream;
     struct dict_itor *itor;
-    void **search = NULL;
 
     if(flow_id) {
-        search = dict_search(g_ctx->stream_flow_dict, &flow_id);
-        if(search) {
-            stream = *search;
+        stream = bbl_stream_index_get(flow_id);
+        if(stream) {
             stream->stop = status;
         } else {
             return bbl_ctrl_status(fd, "warning", 404, "stream not found");
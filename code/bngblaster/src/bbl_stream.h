@@ -73,6 +73,15 @@ typedef struct bbl_stream_group_
     bbl_stream_group_s *next;
 } bbl_stream_group_s;
 
+/* Delay histogram and jitter, allocated
+ * with the first received packet. */
+typedef struct bbl_stream_delay_
+{
+    int64_t last_transit_ns; /* RFC 3550 relative transit time */
+    int64_t jitter; /* RFC 3550 interarrival jitter (nsec * 16) */
+    uint32_t hist[BBL_STREAM_DELAY_BUCKETS]; /* delay histogram */
+} bbl_stream_delay_s;
+
 typedef struct bbl_stream_
 {
     uint64_t flow_id;
@@ -104,8 +113,10 @@ typedef struct bbl_stream_
     uint8_t *tx_buf; /* TX buffer */
     uint16_t tx_len; /* TX length */
     uint16_t tx_bbl_hdr_len; /* TX BBL HDR length */
+    uint64_t tx_template; /* TX template id (changed with TX buffer) */
     uint64_t tx_interval; /* TX interval in nsec */
     __time_t tx_first_epoch;
+    uint8_t tx_timestamp_source; /* io_timestamp_t */
 
     uint32_t ipv4_src;
     uint32_t ipv4_dst;
@@ -148,6 +159,7 @@ typedef struct bbl_stream_
 
     uint64_t rx_min_delay_us;
     uint64_t rx_max_delay_us;
+    bbl_stream_delay_s *rx_delay;
 
     uint16_t rx_len;
     uint64_t rx_first_seq;
@@ -155,6 +167,7 @@ typedef struct bbl_stream_
 
     __time_t rx_first_epoch;
     __time_t rx_last_epoch;
+    uint8_t rx_timestamp_source; /* io_timestamp_t */
 
     uint8_t  rx_priority; /* IPv4 TOS or IPv6 TC */
     uint8_t  rx_outer_vlan_pbit;
@@ -206,12 +219,27 @@ bbl_stream_final();
 protocol_error_t
 bbl_stream_tx(io_handle_s *io, uint8_t *buf, uint16_t *len);
 
+protocol_error_t
+bbl_stream_tx_template(io_handle_s *io, uint8_t *buf, uint16_t *len, uint64_t *template);
+
+bbl_stream_s *
+bbl_stream_index_get(uint64_t flow_id);
+
 bbl_stream_s *
 bbl_stream_rx(bbl_ethernet_header_s *eth, bbl_session_s *session);
 
 void
 bbl_stream_reset(bbl_stream_s *stream);
 
+void
+bbl_stream_delay_hist_add(bbl_stream_s *stream, uint64_t *hist);
+
+uint64_t
+bbl_stream_delay_percentile(uint64_t *hist, uint64_t max_us, double percentile);
+
+double
+bbl_stream_jitter_us(bbl_stream_s *stream);
+
 json_t *
 bbl_stream_json(bbl_stream_s *stream);
 
@@ -139,7 +139,7 @@ bbl_tcp_ctx_new_session(bbl_session_s *session)
     }
 
     /* Bind local network interface */
-    tcp_bind_netif(tcpc->pcb, &session->netif);
+    tcp_bind_netif(tcpc->pcb, session->netif);
     
     /* Add BBL TCP context as argument */
     tcp_arg(tcpc->pcb, tcpc);
@@ -860,7 +860,7 @@ bbl_tcp_ipv4_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
     struct pbuf *pbuf;
     UNUSED(eth);
 
-    if(!(g_ctx->tcp && session->netif.state)) {
+    if(!(g_ctx->tcp && session->netif)) {
         /* TCP not enabled! */
         return;
     }
@@ -873,15 +873,15 @@ bbl_tcp_ipv4_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
         format_ipv4_address(&ipv4->src), tcp->src);
 #endif
 
-    ip_data.current_netif = &session->netif;
-    ip_data.current_input_netif = &session->netif;
+    ip_data.current_netif = session->netif;
+    ip_data.current_input_netif = session->netif;
     ip_data.current_iphdr_dest.type = IPADDR_TYPE_V4;
     ip_data.current_iphdr_dest.u_addr.ip4.addr = ipv4->dst;
     ip_data.current_iphdr_src.type = IPADDR_TYPE_V4;
     ip_data.current_iphdr_src.u_addr.ip4.addr = ipv4->src;
 
     pbuf = pbuf_alloc_reference(ipv4->payload, ipv4->payload_len, PBUF_ROM);
-    tcp_input(pbuf, &session->netif);
+    tcp_input(pbuf, session->netif);
 }
 
 /**
@@ -938,7 +938,7 @@ bbl_tcp_ipv6_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
     struct pbuf *pbuf;
     UNUSED(eth);
 
-    if(!(g_ctx->tcp && session->netif.state)) {
+    if(!(g_ctx->tcp && session->netif)) {
         /* TCP not enabled! */
         return;
     }
@@ -952,17 +952,17 @@ bbl_tcp_ipv6_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
 #endif
 
     pbuf = pbuf_alloc_reference(ipv6->hdr, ipv6->len, PBUF_ROM);
-    session->netif.input(pbuf, &session->netif);
+    session->netif->input(pbuf, session->netif);
 
-    ip_data.current_netif = &session->netif;
-    ip_data.current_input_netif = &session->netif;
+    ip_data.current_netif = session->netif;
+    ip_data.current_input_netif = session->netif;
     memcpy(&ip_data.current_iphdr_dest.u_addr.ip6.addr, ipv6->dst, sizeof(ip6_addr_t));
     ip_data.current_iphdr_dest.type = IPADDR_TYPE_V6;
     memcpy(&ip_data.current_iphdr_src.u_addr.ip6.addr, ipv6->src, sizeof(ip6_addr_t));
     ip_data.current_iphdr_src.type = IPADDR_TYPE_V6;
 
     pbuf = pbuf_alloc_reference(ipv6->payload, ipv6->payload_len, PBUF_ROM);
-    tcp_input(pbuf, &session->netif);
+    tcp_input(pbuf, session->netif);
 }
 
 /**
@@ -1193,12 +1193,14 @@ bbl_tcp_network_interface_init(bbl_network_interface_s *interface, bbl_network_c
 bool
 bbl_tcp_session_init(bbl_session_s *session)
 {
+    struct netif *netif;
+
     if(!(g_ctx->tcp && session->access_config->tcp)) {
         /* TCP not enabled! */
         return true;
     }
 
-    if(session->netif.state) {
+    if(session->netif) {
         /* Already initialised! */
         return true;
     }
@@ -1207,14 +1209,20 @@ bbl_tcp_session_init(bbl_session_s *session)
         LOG(ERROR, "Failed to init TCP for session %u (max 255 TCP interfaces supported)\n", session->session_id);
         return false;
     }
-    if(!netif_add(&session->netif, NULL, NULL, NULL, session, bbl_tcp_netif_init_session, ip_input))  {
+    netif = calloc(1, sizeof(struct netif));
+    if(!netif) {
+        return false;
+    }
+    if(!netif_add(netif, NULL, NULL, NULL, session, bbl_tcp_netif_init_session, ip_input))  {
+        free(netif);
         return false;
     }
     g_netif_count++;
 
-    session->netif.state = session;
-    session->netif.mtu = 1280;
-    session->netif.mtu6 = 1280;
+    netif->state = session;
+    netif->mtu = 1280;
+    netif->mtu6 = 1280;
+    session->netif = netif;
     return true;
 }
 
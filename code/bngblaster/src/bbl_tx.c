@@ -30,6 +30,9 @@ bbl_tx_igmp_timeout(timer_s *timer)
             return;
         }
     }
+    if(!session->igmp_groups) {
+        return;
+    }
 
     for(i=0; i < IGMP_MAX_GROUPS; i++) {
         group = &session->igmp_groups[i];
@@ -115,7 +118,7 @@ bbl_tx_encode_packet_igmp(bbl_session_s *session)
     ipv4.protocol = PROTOCOL_IPV4_IGMP;
     ipv4.router_alert_option = true;
     ipv4.next = &igmp;
-    for(i=0; i < IGMP_MAX_GROUPS; i++) {
+    for(i=0; session->igmp_groups && i < IGMP_MAX_GROUPS; i++) {
         if(session->igmp_groups[i].send && session->igmp_groups[i].state) {
             group = &session->igmp_groups[i];
             if(group->state == IGMP_GROUP_LEAVING) {
@@ -236,7 +239,7 @@ bbl_tx_encode_packet_igmp(bbl_session_s *session)
         return IGNORED;
     }
 
-    timer_add(&g_ctx->timer_root, &session->timer_igmp, "IGMP", 
+    timer_add(session->access_interface->shard->timer_root, &session->timer_igmp, "IGMP", 
               (g_ctx->config.igmp_robustness_interval / 1000), 
               (g_ctx->config.igmp_robustness_interval % 1000) * MSEC, 
               session, &bbl_tx_igmp_timeout);
@@ -282,12 +285,12 @@ bbl_tx_encode_packet_pap_request(bbl_session_s *session)
 
     pap.code = PAP_CODE_REQUEST;
     pap.identifier = 1;
-    pap.username = session->username;
-    pap.username_len = strlen(session->username);
-    pap.password = session->password;
-    pap.password_len = strlen(session->password);
+    pap.username = bbl_session_string(session, BBL_SESSION_USERNAME);
+    pap.username_len = strlen(pap.username);
+    pap.password = bbl_session_string(session, BBL_SESSION_PASSWORD);
+    pap.password_len = strlen(pap.password);
 
-    timer_add(&g_ctx->timer_root, &session->timer_auth, "Authentication Timeout",
+    timer_add(session->access_interface->shard->timer_root, &session->timer_auth, "Authentication Timeout",
               5, 0, session, &bbl_tx_pap_timeout);
 
     access_interface->stats.pap_tx++;
@@ -333,10 +336,10 @@ bbl_tx_encode_packet_chap_response(bbl_session_s *session)
     chap.identifier = session->chap_identifier;
     chap.challenge = session->chap_response;
     chap.challenge_len = CHALLENGE_LEN;
-    chap.name = session->username;
-    chap.name_len = strlen(session->username);
+    chap.name = bbl_session_string(session, BBL_SESSION_USERNAME);
+    chap.name_len = strlen(chap.name);
 
-    timer_add(&g_ctx->timer_root, &session->timer_auth, "Authentication Timeout", 
+    timer_add(session->access_interface->shard->timer_root, &session->timer_auth, "Authentication Timeout", 
               5, 0, session, &bbl_tx_chap_timeout);
 
     access_interface->stats.chap_tx++;
@@ -397,7 +400,7 @@ bbl_tx_encode_packet_icmpv6_rs(bbl_session_s *session)
     ipv6.next = &icmpv6;
     icmpv6.type = IPV6_ICMPV6_ROUTER_SOLICITATION;
 
-    timer_add(&g_ctx->timer_root, &session->timer_icmpv6, "ICMPv6", 
+    timer_add(session->access_interface->shard->timer_root, &session->timer_icmpv6, "ICMPv6", 
               5, 0, session, &bbl_icmpv6_timeout);
 
     session->stats.icmpv6_tx++;
@@ -428,6 +431,27 @@ bbl_tx_dhcpv6_timeout(timer_s *timer)
     }
 }
 
+/**
+ * bbl_tx_access_line
+ *
+ * Set access line strings rendered for the session.
+ *
+ * @param session session
+ * @param access_line access line
+ * @return false if neither ACI nor ARI is configured
+ */
+static bool
+bbl_tx_access_line(bbl_session_s *session, access_line_s *access_line)
+{
+    access_line->aci = bbl_session_string(session, BBL_SESSION_AGENT_CIRCUIT_ID);
+    access_line->ari = bbl_session_string(session, BBL_SESSION_AGENT_REMOTE_ID);
+    if(!(access_line->aci || access_line->ari)) {
+        return false;
+    }
+    access_line->aaci = bbl_session_string(session, BBL_SESSION_ACCESS_AGGREGATION_CIRCUIT_ID);
+    return true;
+}
+
 static protocol_error_t
 bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
 {
@@ -452,10 +476,7 @@ bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
         dhcpv6_relay.peer_address = (void*)session->link_local_ipv6_address;
         dhcpv6_relay.relay_message = &dhcpv6;
         if(g_ctx->config.dhcpv6_access_line && 
-           (session->agent_circuit_id || session->agent_remote_id)) {
-            access_line.aci = session->agent_circuit_id;
-            access_line.ari = session->agent_remote_id;
-            access_line.aaci = session->access_aggregation_circuit_id;
+           bbl_tx_access_line(session, &access_line)) {
             access_line.up = session->rate_up;
             access_line.down = session->rate_down;
             access_line.dsl_type = session->dsl_type;
@@ -548,10 +569,10 @@ bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
             return WRONG_PROTOCOL_STATE;
     }
 
-    timer_add(&g_ctx->timer_root, &session->timer_dhcpv6, "DHCPv6",
+    timer_add(session->access_interface->shard->timer_root, &session->timer_dhcpv6, "DHCPv6",
               g_ctx->config.dhcpv6_timeout, 0, session, &bbl_tx_dhcpv6_timeout);
 
-    session->dhcpv6_retry++;
+    if(session->dhcpv6_retry++) session->access_interface->shard->counters.session_retries++;
     session->stats.dhcpv6_tx++;
     access_interface->stats.dhcpv6_tx++;
     return encode_ethernet(session->write_buf, &session->write_idx, &eth);
@@ -610,7 +631,7 @@ bbl_tx_encode_packet_ip6cp_request(bbl_session_s *session)
     if(ip6cp.code == PPP_CODE_CONF_REQUEST) {
         ip6cp.ipv6_identifier = session->ip6cp_ipv6_identifier;
     }
-    timer_add(&g_ctx->timer_root, &session->timer_ip6cp, "IP6CP timeout",
+    timer_add(session->access_interface->shard->timer_root, &session->timer_ip6cp, "IP6CP timeout",
               g_ctx->config.ip6cp_conf_request_timeout, 0, session, &bbl_tx_ip6cp_timeout);
 
     access_interface->stats.ip6cp_tx++;
@@ -718,7 +739,7 @@ bbl_tx_encode_packet_ipcp_request(bbl_session_s *session)
         }
     }
 
-    timer_add(&g_ctx->timer_root, &session->timer_ipcp, "IPCP timeout",
+    timer_add(session->access_interface->shard->timer_root, &session->timer_ipcp, "IPCP timeout",
               g_ctx->config.ipcp_conf_request_timeout, 0, session, &bbl_ipcp_timeout);
 
     access_interface->stats.ipcp_tx++;
@@ -828,7 +849,7 @@ bbl_tx_encode_packet_lcp_request(bbl_session_s *session)
     }
 
     if(timeout) {
-        timer_add(&g_ctx->timer_root, &session->timer_lcp, "LCP timeout", 
+        timer_add(session->access_interface->shard->timer_root, &session->timer_lcp, "LCP timeout", 
                   timeout, 0, session, &bbl_lcp_timeout);
     }
 
@@ -932,10 +953,7 @@ bbl_encode_padi(bbl_session_s *session)
     if(g_ctx->config.pppoe_max_payload) {
         pppoe.max_payload = g_ctx->config.pppoe_max_payload;
     }
-    if(session->agent_circuit_id || session->agent_remote_id) {
-        access_line.aci = session->agent_circuit_id;
-        access_line.ari = session->agent_remote_id;
-        access_line.aaci = session->access_aggregation_circuit_id;
+    if(bbl_tx_access_line(session, &access_line)) {
         access_line.up = session->rate_up;
         access_line.down = session->rate_down;
         access_line.dsl_type = session->dsl_type;
@@ -976,10 +994,7 @@ bbl_encode_padr(bbl_session_s *session)
     if(g_ctx->config.pppoe_max_payload) {
         pppoe.max_payload = g_ctx->config.pppoe_max_payload;
     }
-    if(session->agent_circuit_id || session->agent_remote_id) {
-        access_line.aci = session->agent_circuit_id;
-        access_line.ari = session->agent_remote_id;
-        access_line.aaci = session->access_aggregation_circuit_id;
+    if(bbl_tx_access_line(session, &access_line)) {
         access_line.up = session->rate_up;
         access_line.down = session->rate_down;
         access_line.dsl_type = session->dsl_type;
@@ -1019,16 +1034,16 @@ bbl_tx_encode_packet_discovery(bbl_session_s *session) {
     switch(session->session_state) {
         case BBL_PPPOE_INIT:
             result = bbl_encode_padi(session);
-            timer_add(&g_ctx->timer_root, &session->timer_padi, "PADI timeout", 
+            timer_add(session->access_interface->shard->timer_root, &session->timer_padi, "PADI timeout", 
                       g_ctx->config.pppoe_discovery_timeout, 0, session, &bbl_padi_timeout);
             access_interface->stats.padi_tx++;
-            if(!g_ctx->stats.first_session_tx.tv_sec) {
-                clock_gettime(CLOCK_MONOTONIC, &g_ctx->stats.first_session_tx);
+            if(!session->access_interface->shard->counters.first_session_tx.tv_sec) {
+                clock_gettime(CLOCK_MONOTONIC, &session->access_interface->shard->counters.first_session_tx);
             }
             break;
         case BBL_PPPOE_REQUEST:
             result = bbl_encode_padr(session);
-            timer_add(&g_ctx->timer_root, &session->timer_padr, "PADR timeout", 
+            timer_add(session->access_interface->shard->timer_root, &session->timer_padr, "PADR timeout", 
                       g_ctx->config.pppoe_discovery_timeout, 0, session, &bbl_padr_timeout);
             access_interface->stats.padr_tx++;
             break;
@@ -1121,11 +1136,8 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
 
     /* Option 82 ... */
     if(g_ctx->config.dhcp_access_line && 
-       (session->agent_circuit_id || session->agent_remote_id) && 
-       session->dhcp_state != BBL_DHCP_RELEASE) {
-        access_line.aci = session->agent_circuit_id;
-        access_line.ari = session->agent_remote_id;
-        access_line.aaci = session->access_aggregation_circuit_id;
+       session->dhcp_state != BBL_DHCP_RELEASE &&
+       bbl_tx_access_line(session, &access_line)) {
         access_line.up = session->rate_up;
         access_line.down = session->rate_down;
         access_line.dsl_type = session->dsl_type;
@@ -1146,9 +1158,9 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
             dhcp.option_router = true;
             dhcp.option_host_name = true;
             dhcp.option_domain_name = true;
-            if(!g_ctx->stats.first_session_tx.tv_sec) {
-                g_ctx->stats.first_session_tx.tv_sec = now.tv_sec;
-                g_ctx->stats.first_session_tx.tv_nsec = now.tv_nsec;
+            if(!session->access_interface->shard->counters.first_session_tx.tv_sec) {
+                session->access_interface->shard->counters.first_session_tx.tv_sec = now.tv_sec;
+                session->access_interface->shard->counters.first_session_tx.tv_nsec = now.tv_nsec;
             }
             break;
         case BBL_DHCP_REQUESTING:
@@ -1191,10 +1203,10 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
             return IGNORED;
     }
 
-    session->dhcp_retry++;
+    if(session->dhcp_retry++) session->access_interface->shard->counters.session_retries++;
     if(dhcp.type == DHCP_MESSAGE_RELEASE) {
         if(session->dhcp_retry < g_ctx->config.dhcp_release_retry) {
-            timer_add(&g_ctx->timer_root, &session->timer_dhcp_retry, "DHCP timeout", 
+            timer_add(session->access_interface->shard->timer_root, &session->timer_dhcp_retry, "DHCP timeout", 
                       g_ctx->config.dhcp_release_interval, 0, session, &bbl_dhcp_timeout);
         } else {
             session->dhcp_state = BBL_DHCP_INIT;
@@ -1203,7 +1215,7 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
             }
         }
     } else {
-        timer_add(&g_ctx->timer_root, &session->timer_dhcp_retry, "DHCP timeout", 
+        timer_add(session->access_interface->shard->timer_root, &session->timer_dhcp_retry, "DHCP timeout", 
                   g_ctx->config.dhcp_timeout, 0, session, &bbl_dhcp_timeout);
     }
 
@@ -1242,15 +1254,15 @@ bbl_tx_encode_packet_arp_request(bbl_session_s *session)
 
     if(session->arp_resolved) {
         if(g_ctx->config.arp_interval) {
-            timer_add(&g_ctx->timer_root, &session->timer_arp, "ARP timeout", 
+            timer_add(session->access_interface->shard->timer_root, &session->timer_arp, "ARP timeout", 
                       g_ctx->config.arp_interval, 0, session, &bbl_arp_timeout);
         }
     } else {
-        timer_add(&g_ctx->timer_root, &session->timer_arp, "ARP timeout", 
+        timer_add(session->access_interface->shard->timer_root, &session->timer_arp, "ARP timeout", 
                   g_ctx->config.arp_timeout, 0, session, &bbl_arp_timeout);
     }
-    if(!g_ctx->stats.first_session_tx.tv_sec) {
-        clock_gettime(CLOCK_MONOTONIC, &g_ctx->stats.first_session_tx);
+    if(!session->access_interface->shard->counters.first_session_tx.tv_sec) {
+        clock_gettime(CLOCK_MONOTONIC, &session->access_interface->shard->counters.first_session_tx);
     }
 
     access_interface->stats.arp_tx++;
@@ -1302,9 +1314,9 @@ bbl_tx_encode_packet_cfm_cc(bbl_session_s *session)
     cfm.md_name_format = CMF_MD_NAME_FORMAT_NONE;
     cfm.ma_id = session->cfm_ma_id;
     cfm.ma_name_format = CMF_MA_NAME_FORMAT_STRING;
-    if(session->cfm_ma_name) {
-        cfm.ma_name_len = strlen(session->cfm_ma_name);
-        cfm.ma_name = (uint8_t*)session->cfm_ma_name;
+    cfm.ma_name = (uint8_t*)bbl_session_string(session, BBL_SESSION_CFM_MA_NAME);
+    if(cfm.ma_name) {
+        cfm.ma_name_len = strlen((char*)cfm.ma_name);
     }
 
     session->access_interface->stats.cfm_cc_tx++;
@@ -1323,33 +1335,35 @@ bbl_tx_encode_packet(bbl_session_s *session, uint8_t *buf, uint16_t *len)
     if(session->send_requests & BBL_SEND_DISCOVERY) {
         result = bbl_tx_encode_packet_discovery(session);
         session->send_requests &= ~BBL_SEND_DISCOVERY;
-        session->pppoe_retries++;
+        if(session->pppoe_retries++) session->access_interface->shard->counters.session_retries++;
     } else if(session->send_requests & BBL_SEND_LCP_REQUEST) {
         result = bbl_tx_encode_packet_lcp_request(session);
         session->send_requests &= ~BBL_SEND_LCP_REQUEST;
-        session->lcp_retries++;
+        if(session->lcp_retries++) session->access_interface->shard->counters.session_retries++;
     } else if(session->send_requests & BBL_SEND_LCP_RESPONSE) {
         result = bbl_tx_encode_packet_lcp_response(session);
         session->send_requests &= ~BBL_SEND_LCP_RESPONSE;
     } else if(session->send_requests & BBL_SEND_PAP_REQUEST) {
         result = bbl_tx_encode_packet_pap_request(session);
         session->send_requests &= ~BBL_SEND_PAP_REQUEST;
-        session->auth_retries++;
+        if(session->auth_retries++) session->access_interface->shard->counters.session_retries++;
     } else if(session->send_requests & BBL_SEND_CHAP_RESPONSE) {
         result = bbl_tx_encode_packet_chap_response(session);
         session->send_requests &= ~BBL_SEND_CHAP_RESPONSE;
-        session->auth_retries++;
+        if(session->auth_retries++) session->access_interface->shard->counters.session_retries++;
     } else if(session->send_requests & BBL_SEND_IPCP_REQUEST) {
         result = bbl_tx_encode_packet_ipcp_request(session);
+        bbl_session_setup_start(session, BBL_SETUP_IPCP);
         session->send_requests &= ~BBL_SEND_IPCP_REQUEST;
-        session->ipcp_retries++;
+        if(session->ipcp_retries++) session->access_interface->shard->counters.session_retries++;
     } else if(session->send_requests & BBL_SEND_IPCP_RESPONSE) {
         result = bbl_tx_encode_packet_ipcp_response(session);
         session->send_requests &= ~BBL_SEND_IPCP_RESPONSE;
     } else if(session->send_requests & BBL_SEND_IP6CP_REQUEST) {
         result = bbl_tx_encode_packet_ip6cp_request(session);
+        bbl_session_setup_start(session, BBL_SETUP_IP6CP);
         session->send_requests &= ~BBL_SEND_IP6CP_REQUEST;
-        session->ip6cp_retries++;
+        if(session->ip6cp_retries++) session->access_interface->shard->counters.session_retries++;
     } else if(session->send_requests & BBL_SEND_IP6CP_RESPONSE) {
         result = bbl_tx_encode_packet_ip6cp_response(session);
         session->send_requests &= ~BBL_SEND_IP6CP_RESPONSE;
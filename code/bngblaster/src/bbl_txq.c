@@ -10,25 +10,70 @@
 #include "bbl.h"
 #include "bbl_session.h"
 
+static inline uint32_t
+bbl_txq_slot_size(uint16_t packet_len)
+{
+    return (offsetof(bbl_txq_slot_t, packet) + packet_len + BBL_TXQ_SLOT_ALIGN - 1) & ~(BBL_TXQ_SLOT_ALIGN - 1);
+}
+
+/**
+ * Get next slot from consumer position, 
+ * skipping wrap marker at the end of the ring.
+ *
+ * @param txq TXQ
+ * @param cursor consumer position
+ * @return slot or NULL if empty
+ */
+static inline bbl_txq_slot_t *
+bbl_txq_cursor_slot(bbl_txq_s *txq, uint32_t *cursor)
+{
+    bbl_txq_slot_t *slot;
+
+    while(true) {
+        if(*cursor == txq->read_write) {
+            txq->read_write = __atomic_load_n(&txq->write, __ATOMIC_ACQUIRE);
+            if(*cursor == txq->read_write) {
+                return NULL;
+            }
+        }
+        slot = (bbl_txq_slot_t*)(txq->ring + (*cursor & txq->mask));
+        if(slot->packet_len != BBL_TXQ_SLOT_WRAP) {
+            return slot;
+        }
+        *cursor += txq->size - (*cursor & txq->mask);
+    }
+}
+
 bool
-bbl_txq_init(bbl_txq_s *txq, uint16_t size)
+bbl_txq_init(bbl_txq_s *txq, uint16_t slots)
 {
-    txq->ring = calloc(1, size * sizeof(bbl_txq_slot_t));
+    uint32_t size = BBL_TXQ_SLOT_ALIGN;
+    while(size < (uint32_t)slots * BBL_TXQ_SLOT_BYTES) {
+        size <<= 1;
+    }
+    txq->ring = aligned_alloc(BBL_TXQ_SLOT_ALIGN, size);
     if(!txq->ring) {
         return false;
     }
-    txq->size   = size;
-    txq->read   = 0;
-    txq->write  = 0;
-    txq->next   = 1;
+    txq->size = size;
+    txq->mask = size - 1;
+    txq->write = 0;
+    txq->write_cursor = 0;
+    txq->write_read = 0;
+    txq->read = 0;
+    txq->read_cursor = 0;
+    txq->read_write = 0;
     return true;
 }
 
 bool
 bbl_txq_is_empty(bbl_txq_s *txq)
 {
-    if(txq->read == txq->write) {
-        return true;
+    if(txq->read_cursor == txq->read_write) {
+        txq->read_write = __atomic_load_n(&txq->write, __ATOMIC_ACQUIRE);
+        if(txq->read_cursor == txq->read_write) {
+            return true;
+        }
     }
     return false;
 }
@@ -36,8 +81,16 @@ bbl_txq_is_empty(bbl_txq_s *txq)
 bool
 bbl_txq_is_full(bbl_txq_s *txq)
 {
-    if(txq->read == txq->next) {
-        return true;
+    /* Slots of maximum size might require to 
+     * skip the remaining space at the end of 
+     * the ring, which is twice the slot size 
+     * in the worst case. */
+    uint32_t need = bbl_txq_slot_size(BBL_TXQ_BUFFER_LEN) * 2;
+    if(txq->size - (txq->write_cursor - txq->write_read) < need) {
+        txq->write_read = __atomic_load_n(&txq->read, __ATOMIC_ACQUIRE);
+        if(txq->size - (txq->write_cursor - txq->write_read) < need) {
+            return true;
+        }
     }
     return false;
 }
@@ -53,21 +106,17 @@ bbl_txq_is_full(bbl_txq_s *txq)
 uint16_t
 bbl_txq_from_buffer(bbl_txq_s *txq, uint8_t *buf)
 {
-    bbl_txq_slot_t *slot;
+    bbl_txq_slot_t *slot = bbl_txq_read_slot(txq);
+    uint16_t len;
 
-    if(txq->read == txq->write) {
+    if(!slot) {
         /* Empty! */
         return 0;
     }
-
-    slot = txq->ring + txq->read;
-    memcpy(buf, slot->packet, slot->packet_len);
-
-    txq->read++;
-    if(txq->read == txq->size) {
-        txq->read = 0;
-    }
-    return slot->packet_len;
+    len = slot->packet_len;
+    memcpy(buf, slot->packet, len);
+    bbl_txq_read_next(txq);
+    return len;
 }
 
 /**
@@ -80,19 +129,14 @@ bbl_txq_from_buffer(bbl_txq_s *txq, uint8_t *buf)
 bbl_txq_result_t
 bbl_txq_to_buffer(bbl_txq_s *txq, bbl_ethernet_header_s *eth)
 {
-    bbl_txq_slot_t *slot;
+    bbl_txq_slot_t *slot = bbl_txq_write_slot(txq);
 
-    if(txq->read == txq->next) {
-        txq->stats.full++;
+    if(!slot) {
         return BBL_TXQ_FULL;
     }
-    slot = txq->ring + txq->write;
     slot->packet_len = 0;
     if(encode_ethernet(slot->packet, &slot->packet_len, eth) == PROTOCOL_SUCCESS) {
-        txq->write = txq->next++;
-        if(txq->next == txq->size) {
-            txq->next = 0;
-        }
+        bbl_txq_write_next(txq);
         return BBL_TXQ_OK;
     } else {
         txq->stats.encode_error++;
@@ -100,40 +144,147 @@ bbl_txq_to_buffer(bbl_txq_s *txq, bbl_ethernet_header_s *eth)
     }
 }
 
+/**
+ * @brief Reserve slot for a packet of up to 
+ * len bytes behind all slots reserved before.
+ * 
+ * The slot must be completed with 
+ * bbl_txq_reserve_next after setting the
+ * actual packet length. Completed slots are 
+ * not visible to the consumer before 
+ * bbl_txq_commit is called, which allows to 
+ * write multiple slots with a single update
+ * of the shared write position.
+ *
+ * @param txq TXQ
+ * @param len maximum packet length
+ * @return slot or NULL if full
+ */
 bbl_txq_slot_t *
-bbl_txq_read_slot(bbl_txq_s *txq)
+bbl_txq_reserve(bbl_txq_s *txq, uint16_t len)
 {
-    if(txq->read == txq->write) {
-        return NULL;
+    bbl_txq_slot_t *slot;
+
+    uint32_t offset = txq->write_cursor & txq->mask;
+    uint32_t need = bbl_txq_slot_size(len);
+    uint32_t skip = 0;
+
+    if(offset + need > txq->size) {
+        /* Skip remaining space at the end of the ring. */
+        skip = txq->size - offset;
     }
-    return txq->ring + txq->read;
+    if(txq->size - (txq->write_cursor - txq->write_read) < skip + need) {
+        txq->write_read = __atomic_load_n(&txq->read, __ATOMIC_ACQUIRE);
+        if(txq->size - (txq->write_cursor - txq->write_read) < skip + need) {
+            txq->stats.full++;
+            return NULL;
+        }
+    }
+    if(skip) {
+        slot = (bbl_txq_slot_t*)(txq->ring + offset);
+        slot->packet_len = BBL_TXQ_SLOT_WRAP;
+        txq->write_cursor += skip;
+        offset = 0;
+    }
+    return (bbl_txq_slot_t*)(txq->ring + offset);
 }
 
+/**
+ * @brief Complete the reserved slot.
+ *
+ * @param txq TXQ
+ */
 void
-bbl_txq_read_next(bbl_txq_s *txq) 
+bbl_txq_reserve_next(bbl_txq_s *txq)
 {
-    txq->read++;
-    if(txq->read == txq->size) {
-        txq->read = 0;
+    bbl_txq_slot_t *slot = (bbl_txq_slot_t*)(txq->ring + (txq->write_cursor & txq->mask));
+    txq->write_cursor += bbl_txq_slot_size(slot->packet_len);
+}
+
+/**
+ * @brief Make all completed slots 
+ * visible to the consumer. 
+ *
+ * @param txq TXQ
+ */
+void
+bbl_txq_commit(bbl_txq_s *txq)
+{
+    __atomic_store_n(&txq->write, txq->write_cursor, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Get up to count slots from TXQ 
+ * without removing them. 
+ *
+ * @param txq TXQ
+ * @param slots target slot array
+ * @param count maximum number of slots
+ * @return number of slots
+ */
+uint16_t
+bbl_txq_peek(bbl_txq_s *txq, bbl_txq_slot_t **slots, uint16_t count)
+{
+    bbl_txq_slot_t *slot;
+
+    uint32_t cursor = txq->read_cursor;
+    uint16_t peeked = 0;
+
+    while(peeked < count) {
+        slot = bbl_txq_cursor_slot(txq, &cursor);
+        if(!slot) {
+            break;
+        }
+        slots[peeked++] = slot;
+        cursor += bbl_txq_slot_size(slot->packet_len);
     }
+    return peeked;
 }
 
-bbl_txq_slot_t *
-bbl_txq_write_slot(bbl_txq_s *txq)
+/**
+ * @brief Remove count slots from TXQ 
+ * with a single update of the shared 
+ * read position.
+ *
+ * @param txq TXQ
+ * @param count number of slots
+ */
+void
+bbl_txq_release(bbl_txq_s *txq, uint16_t count)
 {
-    if(txq->read == txq->next) {
-        txq->stats.full++;
-        return NULL;
+    bbl_txq_slot_t *slot;
+
+    while(count--) {
+        slot = bbl_txq_cursor_slot(txq, &txq->read_cursor);
+        if(!slot) {
+            break;
+        }
+        txq->read_cursor += bbl_txq_slot_size(slot->packet_len);
     }
+    __atomic_store_n(&txq->read, txq->read_cursor, __ATOMIC_RELEASE);
+}
 
-    return txq->ring + txq->write;
+bbl_txq_slot_t *
+bbl_txq_read_slot(bbl_txq_s *txq)
+{
+    return bbl_txq_cursor_slot(txq, &txq->read_cursor);
+}
+
+void
+bbl_txq_read_next(bbl_txq_s *txq) 
+{
+    bbl_txq_release(txq, 1);
+}
+
+bbl_txq_slot_t *
+bbl_txq_write_slot(bbl_txq_s *txq)
+{
+    return bbl_txq_reserve(txq, BBL_TXQ_BUFFER_LEN);
 }
 
 void
 bbl_txq_write_next(bbl_txq_s *txq) 
 {
-    txq->write = txq->next++;
-    if(txq->next == txq->size) {
-        txq->next = 0;
-    }
-}
\ No newline at end of file
+    bbl_txq_reserve_next(txq);
+    bbl_txq_commit(txq);
+}
@@ -16,6 +16,15 @@
 #define BBL_TXQ_DEFAULT_SIZE 4096
 #define BBL_TXQ_BUFFER_LEN 4074
 
+/* The TXQ ring stores variable-length slots aligned 
+ * to cache lines. The ring size in bytes is derived
+ * from the number of slots multiplied with the average
+ * slot size (BBL_TXQ_SLOT_BYTES). */
+#define BBL_TXQ_SLOT_BYTES 1024
+#define BBL_TXQ_SLOT_ALIGN CACHE_LINE_SIZE
+#define BBL_TXQ_SLOT_WRAP 0xffff /* packet_len of wrap marker */
+#define BBL_TXQ_BATCH 64
+
 typedef enum bbl_ring_result_ {
     BBL_TXQ_OK = 0,
     BBL_TXQ_ENCODE_ERROR,
@@ -27,17 +36,27 @@ typedef struct bbl_txq_slot_ {
     uint16_t vlan_tci;
     uint16_t vlan_tpid;
     uint16_t packet_len;
-    uint8_t packet[BBL_TXQ_BUFFER_LEN];
+    uint8_t packet[];
 } bbl_txq_slot_t;
 
+/*
+ * Single producer single consumer ring buffer. 
+ *
+ * Producer and consumer work on private cursors and 
+ * cached copies of the other side's position. The 
+ * shared positions (write and read) are updated once
+ * per batch only (commit and release). 
+ */
 typedef struct bbl_txq_ {
-    bbl_txq_slot_t *ring; /* ring buffer */
-    uint16_t size; /* number of send slots */
+    uint8_t *ring; /* ring buffer */
+    uint32_t size; /* ring size in bytes (power of 2) */
+    uint32_t mask;
 
     char _pad0 __attribute__((__aligned__(CACHE_LINE_SIZE))); /* empty cache line */
 
-    atomic_uint_least16_t write; /* current write slot */
-    atomic_uint_least16_t next; /* next write slot */
+    uint32_t write; /* shared write position */
+    uint32_t write_cursor; /* producer write position */
+    uint32_t write_read; /* producer copy of read position */
     struct {
         uint32_t full; 
         uint32_t encode_error;
@@ -45,7 +64,9 @@ typedef struct bbl_txq_ {
 
     char _pad1 __attribute__((__aligned__(CACHE_LINE_SIZE))); /* empty cache line */
 
-    atomic_uint_least16_t read; /* current read slot */
+    uint32_t read; /* shared read position */
+    uint32_t read_cursor; /* consumer read position */
+    uint32_t read_write; /* consumer copy of write position */
 } bbl_txq_s;
 
 bool
@@ -63,6 +84,21 @@ bbl_txq_from_buffer(bbl_txq_s *txq, uint8_t *buf);
 bbl_txq_result_t
 bbl_txq_to_buffer(bbl_txq_s *txq, bbl_ethernet_header_s *eth);
 
+bbl_txq_slot_t *
+bbl_txq_reserve(bbl_txq_s *txq, uint16_t len);
+
+void
+bbl_txq_reserve_next(bbl_txq_s *txq);
+
+void
+bbl_txq_commit(bbl_txq_s *txq);
+
+uint16_t
+bbl_txq_peek(bbl_txq_s *txq, bbl_txq_slot_t **slots, uint16_t count);
+
+void
+bbl_txq_release(bbl_txq_s *txq, uint16_t count);
+
 bbl_txq_slot_t *
 bbl_txq_read_slot(bbl_txq_s *txq);
 
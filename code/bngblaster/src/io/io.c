@@ -9,34 +9,141 @@
 
 #include "io.h"
 
+const char *
+io_timestamp_string(io_timestamp_t timestamp)
+{
+    switch(timestamp) {
+        case IO_TIMESTAMP_TIMER: return "timer";
+        case IO_TIMESTAMP_USER: return "user";
+        case IO_TIMESTAMP_KERNEL: return "kernel";
+        case IO_TIMESTAMP_HARDWARE: return "hardware";
+        default: return "N/A";
+    }
+}
+
+/**
+ * Set timestamping mode of IO handle. Kernel and hardware 
+ * timestamps are supported for RX with PACKET_MMAP and RAW 
+ * only, falling back to per packet user space timestamps.
+ *
+ * @param io IO handle
+ * @param timestamping timestamping mode
+ */
+void
+io_timestamp_init(io_handle_s *io, io_timestamp_t timestamping)
+{
+    if(timestamping >= IO_TIMESTAMP_KERNEL) {
+        if(io->direction != IO_INGRESS || 
+           !(io->mode == IO_MODE_PACKET_MMAP || io->mode == IO_MODE_RAW)) {
+            timestamping = IO_TIMESTAMP_USER;
+        }
+    }
+    io->timestamping = timestamping;
+    io->timestamp_source = timestamping;
+}
+
+/**
+ * Update the offset between CLOCK_REALTIME and CLOCK_MONOTONIC,
+ * which is required to convert kernel and hardware timestamps 
+ * to the monotonic clock used for all internal timestamps.
+ *
+ * @param io IO handle
+ */
+void
+io_timestamp_offset(io_handle_s *io)
+{
+    struct timespec monotonic;
+    struct timespec realtime;
+
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    timespec_sub(&io->clock_offset, &realtime, &monotonic);
+}
+
+/**
+ * Set IO timestamp from kernel or hardware timestamp
+ * (CLOCK_REALTIME) with fallback to user space clock
+ * if the timestamp is missing.
+ *
+ * @param io IO handle
+ * @param sec seconds
+ * @param nsec nanoseconds
+ * @param hardware true if hardware timestamp
+ */
+void
+io_timestamp_set(io_handle_s *io, time_t sec, long nsec, bool hardware)
+{
+    struct timespec timestamp;
+
+    if(sec) {
+        timestamp.tv_sec = sec;
+        timestamp.tv_nsec = nsec;
+        timespec_sub(&io->timestamp, &timestamp, &io->clock_offset);
+        if(hardware) {
+            io->timestamp_source = IO_TIMESTAMP_HARDWARE;
+        } else {
+            io->timestamp_source = IO_TIMESTAMP_KERNEL;
+        }
+    } else {
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        io->timestamp_source = IO_TIMESTAMP_USER;
+    }
+}
+
 void
 io_update_stream_token_bucket(io_handle_s *io)
 {
-    io->stream_tokens += io->stream_rate;
+    struct timespec now;
+    struct timespec elapsed;
+
+    /* Refill tokens based on the time elapsed since the last
+     * update, so that delayed TX jobs do not reduce the rate. */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    timespec_sub(&elapsed, &now, &io->stream_token_timestamp);
+    io->stream_token_timestamp.tv_sec = now.tv_sec;
+    io->stream_token_timestamp.tv_nsec = now.tv_nsec;
+
+    if(elapsed.tv_sec) {
+        io->stream_tokens = io->stream_burst;
+        return;
+    }
+    io->stream_tokens += (io->stream_rate * elapsed.tv_nsec) / SEC;
     if(io->stream_tokens > io->stream_burst) {
         io->stream_tokens = io->stream_burst;
     }
 }
 
+/**
+ * io_init_stream_token_bucket
+ *
+ * Initialize the stream token bucket of all TX handles.
+ * Streams of an interface are sharded over all TX handles
+ * (TX threads) of this interface, where each handle is
+ * limited to the sum of its streams plus headroom. This
+ * way the sum of all shards never exceeds the rate of
+ * the interface, even if some TX threads are delayed.
+ */
 void
 io_init_stream_token_bucket()
 {
     bbl_interface_s *interface;
     io_handle_s *io;
-    double rate;
+    double burst;
 
     CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
         io = interface->io.tx;
         while(io) {
-            rate = (io->stream_pps / (io->interface->config->tx_interval / 1000)) * 1.3;
-            io->stream_rate = rate;
-            if(rate - (double)io->stream_rate) {
+            io->stream_rate = io->stream_pps * IO_STREAM_TOKEN_HEADROOM;
+            burst = (io->stream_rate * io->interface->config->tx_interval) / SEC;
+            burst *= IO_STREAM_TOKEN_BURST_INTERVALS;
+            io->stream_burst = burst;
+            if(burst - (double)io->stream_burst) {
                 /* Roundup. */
-                io->stream_rate++;
+                io->stream_burst++;
             }
             io->stream_tokens = 0;
-            io->stream_burst = io->stream_rate * 3;
+            clock_gettime(CLOCK_MONOTONIC, &io->stream_token_timestamp);
             io = io->next;
         }
     }
-}
\ No newline at end of file
+}
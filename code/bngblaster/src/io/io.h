@@ -10,6 +10,8 @@
 #define __BBL_IO_H__
 
 #include <assert.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 #include "../bbl.h"
 #include "../bbl_pcap.h"
@@ -26,10 +28,33 @@
 #include "io_raw.h"
 #include "io_packet_mmap.h"
 
+#ifdef BNGBLASTER_AF_XDP
+#include "io_af_xdp.h"
+#endif
+
 #ifdef BNGBLASTER_DPDK
 #include "io_dpdk.h"
 #endif
 
+/* Headroom of the per handle stream token bucket above the
+ * sum of all stream rates assigned to the handle. */
+#define IO_STREAM_TOKEN_HEADROOM 1.3
+
+/* Number of TX intervals covered by the token bucket burst. */
+#define IO_STREAM_TOKEN_BURST_INTERVALS 3
+
+const char *
+io_timestamp_string(io_timestamp_t timestamp);
+
+void
+io_timestamp_init(io_handle_s *io, io_timestamp_t timestamping);
+
+void
+io_timestamp_offset(io_handle_s *io);
+
+void
+io_timestamp_set(io_handle_s *io, time_t sec, long nsec, bool hardware);
+
 void
 io_update_stream_token_bucket(io_handle_s *io);
 
@@ -0,0 +1,811 @@
+/*
+ * BNG Blaster (BBL) - IO AF_XDP
+ *
+ * AF_XDP sockets receive packets redirected by a small XDP program
+ * directly into a user space memory area (UMEM) shared with the kernel.
+ * Packets are exchanged using four single producer/consumer rings
+ * per socket (RX, TX, FILL and COMPLETION). One socket is created
+ * per interface queue, which is shared by the RX and TX IO handles
+ * of this queue.
+ *
+ * The XDP program is loaded without any external library and attached
+ * in native (driver) mode with fallback to generic (SKB) mode. Zero-copy
+ * is used if supported by the driver, otherwise copy mode.
+ *
+ * https://www.kernel.org/doc/html/latest/networking/af_xdp.html
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "io.h"
+
+#ifdef BNGBLASTER_AF_XDP
+
+#include <stddef.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+
+#define IO_AF_XDP_FRAME_SIZE    4096
+#define IO_AF_XDP_HEADROOM      256 /* XDP_PACKET_HEADROOM */
+#define IO_AF_XDP_BATCH_SIZE    64
+
+static int
+sys_bpf(enum bpf_cmd cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static uint32_t
+roundup_pow2(uint32_t v)
+{
+    uint32_t r = 1;
+    while(r < v) r <<= 1;
+    return r;
+}
+
+/* Producer ring (FILL and TX) helper functions. */
+
+static inline uint32_t
+xsk_prod_free(io_xsk_ring_s *r, uint32_t nb)
+{
+    uint32_t entries = r->size - (r->cached_prod - r->cached_cons);
+    if(entries < nb) {
+        r->cached_cons = __atomic_load_n(r->consumer, __ATOMIC_ACQUIRE);
+        entries = r->size - (r->cached_prod - r->cached_cons);
+    }
+    return entries;
+}
+
+static inline void
+xsk_prod_submit(io_xsk_ring_s *r)
+{
+    __atomic_store_n(r->producer, r->cached_prod, __ATOMIC_RELEASE);
+}
+
+/* Consumer ring (RX and COMPLETION) helper functions. */
+
+static inline uint32_t
+xsk_cons_avail(io_xsk_ring_s *r, uint32_t nb)
+{
+    uint32_t entries = r->cached_prod - r->cached_cons;
+    if(entries == 0) {
+        r->cached_prod = __atomic_load_n(r->producer, __ATOMIC_ACQUIRE);
+        entries = r->cached_prod - r->cached_cons;
+    }
+    return (entries > nb) ? nb : entries;
+}
+
+static inline void
+xsk_cons_release(io_xsk_ring_s *r, uint32_t nb)
+{
+    r->cached_cons += nb;
+    __atomic_store_n(r->consumer, r->cached_cons, __ATOMIC_RELEASE);
+}
+
+static inline struct xdp_desc *
+xsk_desc(io_xsk_ring_s *r, uint32_t idx)
+{
+    return &((struct xdp_desc*)r->ring)[idx & r->mask];
+}
+
+static inline uint64_t *
+xsk_addr(io_xsk_ring_s *r, uint32_t idx)
+{
+    return &((uint64_t*)r->ring)[idx & r->mask];
+}
+
+static void
+poll_kernel(io_handle_s *io, short events)
+{
+    struct pollfd pollset;
+    pollset.fd = io->fd;
+    pollset.events = events;
+    pollset.revents = 0;
+    io->stats.polled++;
+    if(poll(&pollset, 1, 0) == -1) {
+        LOG(IO, "Failed to poll interface %s",
+            io->interface->name);
+    }
+}
+
+/**
+ * Return all frames from completion ring
+ * to the stack of free TX frames.
+ */
+static void
+io_af_xdp_tx_complete(io_xsk_s *xsk)
+{
+    uint32_t i, n;
+    n = xsk_cons_avail(&xsk->comp, xsk->comp.size);
+    if(n) {
+        for(i = 0; i < n; i++) {
+            xsk->tx_frames[xsk->tx_frames_free++] = *xsk_addr(&xsk->comp, xsk->comp.cached_cons + i);
+        }
+        xsk_cons_release(&xsk->comp, n);
+    }
+}
+
+/**
+ * Submit all queued TX descriptors and wakeup
+ * kernel if required. The kernel is also woken up
+ * if there are still frames in flight from previous
+ * intervals, which might not be sent because of
+ * a failed wakeup (e.g. EAGAIN).
+ */
+static void
+io_af_xdp_tx_kick(io_handle_s *io)
+{
+    io_xsk_s *xsk = io->xsk;
+
+    if(io->queued) {
+        xsk_prod_submit(&xsk->tx);
+        io->queued = 0;
+    } else if(xsk->tx_frames_free == xsk->tx.size) {
+        return;
+    }
+    if(*xsk->tx.flags & XDP_RING_NEED_WAKEUP) {
+        if(sendto(io->fd, NULL, 0, MSG_DONTWAIT, NULL, 0) < 0) {
+            if(!(errno == EAGAIN || errno == EBUSY || errno == ENOBUFS)) {
+                LOG(IO, "AF_XDP sendto on interface %s failed with error %s (%d)\n",
+                    io->interface->name, strerror(errno), errno);
+                io->stats.io_errors++;
+            }
+        }
+    }
+}
+
+/**
+ * Reserve next TX frame.
+ *
+ * @param io IO handle
+ * @return true if frame is reserved (io->buf)
+ */
+static inline bool
+io_af_xdp_tx_reserve(io_handle_s *io)
+{
+    io_xsk_s *xsk = io->xsk;
+    if(!xsk->tx_frames_free) {
+        io_af_xdp_tx_complete(xsk);
+        if(!xsk->tx_frames_free) {
+            return false;
+        }
+    }
+    if(xsk_prod_free(&xsk->tx, 1) == 0) {
+        return false;
+    }
+    io->buf = xsk->umem + xsk->tx_frames[xsk->tx_frames_free-1];
+    return true;
+}
+
+/**
+ * Enqueue the reserved TX frame (io->buf) with io->buf_len.
+ */
+static inline void
+io_af_xdp_tx_enqueue(io_handle_s *io)
+{
+    io_xsk_s *xsk = io->xsk;
+    struct xdp_desc *desc = xsk_desc(&xsk->tx, xsk->tx.cached_prod++);
+    desc->addr = xsk->tx_frames[--xsk->tx_frames_free];
+    desc->len = io->buf_len;
+    desc->options = 0;
+    io->queued++;
+}
+
+/**
+ * Recycle RX frames by returning them
+ * to the kernel via fill ring.
+ */
+static void
+io_af_xdp_rx_release(io_xsk_s *xsk, uint32_t n)
+{
+    uint32_t i;
+
+    /* The fill ring has always space for all frames
+     * hold by user space, because it is sized to
+     * the total number of RX frames. */
+    xsk_prod_free(&xsk->fill, n);
+    for(i = 0; i < n; i++) {
+        *xsk_addr(&xsk->fill, xsk->fill.cached_prod++) =
+            xsk_desc(&xsk->rx, xsk->rx.cached_cons + i)->addr & ~((uint64_t)IO_AF_XDP_FRAME_SIZE-1);
+    }
+    xsk_prod_submit(&xsk->fill);
+    xsk_cons_release(&xsk->rx, n);
+}
+
+/**
+ * This job is for AF_XDP RX in main thread!
+ */
+void
+io_af_xdp_rx_job(timer_s *timer)
+{
+    io_handle_s *io = timer->data;
+    io_xsk_s *xsk = io->xsk;
+    bbl_interface_s *interface = io->interface;
+
+    struct xdp_desc *desc;
+    uint32_t i, n;
+
+    bbl_ethernet_header_s *eth;
+
+    protocol_error_t decode_result;
+    bool pcap = false;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread == NULL);
+
+    n = xsk_cons_avail(&xsk->rx, IO_AF_XDP_BATCH_SIZE);
+    if(!n) {
+        /* If no buffer is available poll kernel */
+        if(*xsk->fill.flags & XDP_RING_NEED_WAKEUP) {
+            poll_kernel(io, POLLIN);
+        }
+        return;
+    }
+
+    /* Get RX timestamp */
+    if(io->timestamping) {
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+    } else {
+        io->timestamp.tv_sec = timer->timestamp->tv_sec;
+        io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    }
+    while(n) {
+        for(i = 0; i < n; i++) {
+            desc = xsk_desc(&xsk->rx, xsk->rx.cached_cons + i);
+            io->buf = xsk->umem + desc->addr;
+            io->buf_len = desc->len;
+            io->stats.packets++;
+            io->stats.bytes += io->buf_len;
+            decode_result = decode_ethernet_fast(io->buf, io->buf_len, interface->io.sp, SCRATCHPAD_LEN, &eth);
+            if(decode_result == PROTOCOL_SUCCESS) {
+                /* Copy RX timestamp */
+                eth->timestamp.tv_sec = io->timestamp.tv_sec;
+                eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+                eth->timestamp_source = io->timestamp_source;
+                bbl_rx_handler(interface, eth);
+            } else if(decode_result == UNKNOWN_PROTOCOL) {
+                io->stats.unknown++;
+            } else {
+                io->stats.protocol_errors++;
+            }
+            /* Dump the packet into pcap file */
+            if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
+                pcap = true;
+                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+            }
+        }
+        io_af_xdp_rx_release(xsk, n);
+        n = xsk_cons_avail(&xsk->rx, IO_AF_XDP_BATCH_SIZE);
+    }
+    if(pcap) {
+        pcapng_fflush();
+    }
+}
+
+/**
+ * This job is for AF_XDP TX in main thread!
+ */
+void
+io_af_xdp_tx_job(timer_s *timer)
+{
+    io_handle_s *io = timer->data;
+    bbl_interface_s *interface = io->interface;
+
+    uint32_t stream_packets = 0;
+    bool ctrl = true;
+    bool pcap = false;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_EGRESS);
+    assert(io->thread == NULL);
+
+    io_update_stream_token_bucket(io);
+    io_af_xdp_tx_complete(io->xsk);
+
+    /* Get TX timestamp */
+    //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+    io->timestamp.tv_sec = timer->timestamp->tv_sec;
+    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    while(true) {
+        /* Check if TX frame and slot are available for writing. */
+        if(!io_af_xdp_tx_reserve(io)) {
+            io->stats.no_buffer++;
+            break;
+        }
+        if(ctrl) {
+            /* First send all control traffic which has higher priority. */
+            if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+                ctrl = false;
+                continue;
+            }
+        } else {
+            /* Send traffic streams up to allowed burst. */
+            if(++stream_packets > io->stream_burst) {
+                break;
+            }
+            if(bbl_stream_tx(io, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+                break;
+            }
+        }
+        io_af_xdp_tx_enqueue(io);
+        io->stats.packets++;
+        io->stats.bytes += io->buf_len;
+
+        /* Dump the packet into pcap file. */
+        if(g_ctx->pcap.write_buf && (ctrl || g_ctx->pcap.include_streams)) {
+            pcap = true;
+            pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                      interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
+        }
+    }
+    if(pcap) {
+        pcapng_fflush();
+    }
+    io_af_xdp_tx_kick(io);
+}
+
+void
+io_af_xdp_thread_rx_run_fn(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+    io_xsk_s *xsk = io->xsk;
+
+    struct xdp_desc *desc;
+    uint32_t i, n;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread);
+
+    struct timespec sleep, rem;
+
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = 0;
+
+    /* VLAN tags are not stripped by XDP. */
+    io->vlan_tci = 0;
+    io->vlan_tpid = 0;
+
+    while(thread->active) {
+        n = xsk_cons_avail(&xsk->rx, IO_AF_XDP_BATCH_SIZE);
+        if(!n) {
+            /* If no buffer is available poll kernel */
+            poll_kernel(io, POLLIN);
+            sleep.tv_nsec = 100000; /* 0.1ms */
+            nanosleep(&sleep, &rem);
+            continue;
+        }
+
+        /* Get RX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        while(n) {
+            for(i = 0; i < n; i++) {
+                desc = xsk_desc(&xsk->rx, xsk->rx.cached_cons + i);
+                io->buf = xsk->umem + desc->addr;
+                io->buf_len = desc->len;
+                /* Process packet */
+                io_thread_rx_handler(thread, io);
+            }
+            io_af_xdp_rx_release(xsk, n);
+            n = xsk_cons_avail(&xsk->rx, IO_AF_XDP_BATCH_SIZE);
+        }
+    }
+}
+
+/**
+ * This job is for AF_XDP TX in worker thread!
+ */
+void
+io_af_xdp_thread_tx_job(timer_s *timer)
+{
+    io_thread_s *thread = timer->data;
+    io_handle_s *io = thread->io;
+
+    bbl_txq_s *txq = thread->txq;
+    bbl_txq_slot_t *slot;
+
+    uint32_t stream_packets = 0;
+    bool ctrl = true;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_EGRESS);
+    assert(io->thread);
+
+    io_update_stream_token_bucket(io);
+    io_af_xdp_tx_complete(io->xsk);
+
+    /* Get TX timestamp */
+    //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+    io->timestamp.tv_sec = timer->timestamp->tv_sec;
+    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    while(true) {
+        /* Check if TX frame and slot are available for writing. */
+        if(!io_af_xdp_tx_reserve(io)) {
+            io->stats.no_buffer++;
+            break;
+        }
+        if(ctrl) {
+            /* First send all control traffic which has higher priority. */
+            slot = bbl_txq_read_slot(txq);
+            if(slot) {
+                io->buf_len = slot->packet_len;
+                memcpy(io->buf, slot->packet, slot->packet_len);
+                bbl_txq_read_next(txq);
+            } else {
+                ctrl = false;
+                continue;
+            }
+        } else {
+            /* Send traffic streams up to allowed burst. */
+            if(++stream_packets > io->stream_burst) {
+                break;
+            }
+            if(bbl_stream_tx(io, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+                break;
+            }
+        }
+        io_af_xdp_tx_enqueue(io);
+        io->stats.packets++;
+        io->stats.bytes += io->buf_len;
+    }
+    io_af_xdp_tx_kick(io);
+}
+
+static bool
+io_af_xdp_ring_mmap(io_xsk_s *xsk, io_xsk_ring_s *r, struct xdp_ring_offset *off,
+                    uint32_t size, size_t desc_size, off_t pgoff)
+{
+    r->map_len = off->desc + size * desc_size;
+    r->map = mmap(NULL, r->map_len, PROT_READ|PROT_WRITE,
+                  MAP_SHARED|MAP_POPULATE, xsk->fd, pgoff);
+    if(r->map == MAP_FAILED) {
+        r->map = NULL;
+        return false;
+    }
+    r->producer = (uint32_t*)((uint8_t*)r->map + off->producer);
+    r->consumer = (uint32_t*)((uint8_t*)r->map + off->consumer);
+    r->flags = (uint32_t*)((uint8_t*)r->map + off->flags);
+    r->ring = (uint8_t*)r->map + off->desc;
+    r->size = size;
+    r->mask = size - 1;
+    r->cached_prod = *r->producer;
+    r->cached_cons = *r->consumer;
+    return true;
+}
+
+static void
+io_af_xdp_ring_munmap(io_xsk_ring_s *r)
+{
+    if(r->map) {
+        munmap(r->map, r->map_len);
+        r->map = NULL;
+    }
+}
+
+/**
+ * Close AF_XDP socket and release rings and UMEM.
+ */
+static void
+io_af_xdp_socket_close(io_xsk_s *xsk)
+{
+    io_af_xdp_ring_munmap(&xsk->rx);
+    io_af_xdp_ring_munmap(&xsk->tx);
+    io_af_xdp_ring_munmap(&xsk->fill);
+    io_af_xdp_ring_munmap(&xsk->comp);
+    if(xsk->umem) {
+        munmap(xsk->umem, xsk->umem_len);
+    }
+    if(xsk->fd >= 0) {
+        close(xsk->fd);
+    }
+    if(xsk->tx_frames) {
+        free(xsk->tx_frames);
+    }
+    free(xsk);
+}
+
+/**
+ * Create AF_XDP socket with UMEM for given queue.
+ *
+ * The UMEM is split into RX frames (fill ring size)
+ * followed by TX frames (TX ring size).
+ */
+static io_xsk_s *
+io_af_xdp_socket_open(bbl_interface_s *interface, uint32_t queue)
+{
+    bbl_link_config_s *config = interface->config;
+    io_xdp_s *xdp = interface->io.xdp;
+    io_xsk_s *xsk;
+
+    struct xdp_umem_reg umem_reg = {0};
+    struct xdp_mmap_offsets off = {0};
+    struct sockaddr_xdp sxdp = {0};
+    socklen_t optlen = sizeof(off);
+
+    uint32_t rx_size = roundup_pow2(config->io_slots_rx);
+    uint32_t tx_size = roundup_pow2(config->io_slots_tx);
+    uint32_t i;
+
+    xsk = calloc(1, sizeof(io_xsk_s));
+    if(!xsk) return NULL;
+    xsk->queue = queue;
+    xsk->fd = socket(AF_XDP, SOCK_RAW, 0);
+    if(xsk->fd == -1) {
+        LOG(ERROR, "AF_XDP: failed to open socket for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        goto ERROR;
+    }
+
+    xsk->umem_len = (uint64_t)(rx_size + tx_size) * IO_AF_XDP_FRAME_SIZE;
+    xsk->umem = mmap(NULL, xsk->umem_len, PROT_READ|PROT_WRITE,
+                     MAP_PRIVATE|MAP_ANONYMOUS|MAP_POPULATE, -1, 0);
+    if(xsk->umem == MAP_FAILED) {
+        xsk->umem = NULL;
+        LOG(ERROR, "AF_XDP: failed to allocate %lu byte UMEM for interface %s queue %u\n",
+            xsk->umem_len, interface->name, queue);
+        goto ERROR;
+    }
+    LOG(DEBUG, "AF_XDP: setup %lu byte UMEM (%u RX and %u TX frames) for interface %s queue %u\n",
+        xsk->umem_len, rx_size, tx_size, interface->name, queue);
+
+    umem_reg.addr = (uintptr_t)xsk->umem;
+    umem_reg.len = xsk->umem_len;
+    umem_reg.chunk_size = IO_AF_XDP_FRAME_SIZE;
+    umem_reg.headroom = 0;
+    if(setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_REG, &umem_reg, sizeof(umem_reg)) == -1 ||
+       setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_FILL_RING, &rx_size, sizeof(rx_size)) == -1 ||
+       setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &tx_size, sizeof(tx_size)) == -1 ||
+       setsockopt(xsk->fd, SOL_XDP, XDP_RX_RING, &rx_size, sizeof(rx_size)) == -1 ||
+       setsockopt(xsk->fd, SOL_XDP, XDP_TX_RING, &tx_size, sizeof(tx_size)) == -1) {
+        LOG(ERROR, "AF_XDP: failed to setup UMEM and rings for interface %s queue %u - %s (%d)\n",
+            interface->name, queue, strerror(errno), errno);
+        goto ERROR;
+    }
+    if(getsockopt(xsk->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) == -1) {
+        LOG(ERROR, "AF_XDP: failed to get ring offsets for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        goto ERROR;
+    }
+    if(!(io_af_xdp_ring_mmap(xsk, &xsk->rx, &off.rx, rx_size, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) &&
+         io_af_xdp_ring_mmap(xsk, &xsk->tx, &off.tx, tx_size, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING) &&
+         io_af_xdp_ring_mmap(xsk, &xsk->fill, &off.fr, rx_size, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) &&
+         io_af_xdp_ring_mmap(xsk, &xsk->comp, &off.cr, tx_size, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING))) {
+        LOG(ERROR, "AF_XDP: failed to map rings for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        goto ERROR;
+    }
+
+    /* Pass all RX frames to the kernel. */
+    for(i = 0; i < rx_size; i++) {
+        *xsk_addr(&xsk->fill, xsk->fill.cached_prod++) = (uint64_t)i * IO_AF_XDP_FRAME_SIZE;
+    }
+    xsk_prod_submit(&xsk->fill);
+
+    /* All TX frames are initially free. */
+    xsk->tx_frames = malloc(tx_size * sizeof(uint64_t));
+    if(!xsk->tx_frames) goto ERROR;
+    for(i = 0; i < tx_size; i++) {
+        xsk->tx_frames[xsk->tx_frames_free++] = (uint64_t)(rx_size + i) * IO_AF_XDP_FRAME_SIZE;
+    }
+
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = interface->kernel_index;
+    sxdp.sxdp_queue_id = queue;
+    sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP;
+    if(xdp->mode == XDP_FLAGS_DRV_MODE) {
+        sxdp.sxdp_flags |= XDP_ZEROCOPY;
+        if(bind(xsk->fd, (struct sockaddr*)&sxdp, sizeof(sxdp)) == 0) {
+            xdp->zero_copy = true;
+            return xsk;
+        }
+        sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP;
+    }
+    sxdp.sxdp_flags |= XDP_COPY;
+    if(bind(xsk->fd, (struct sockaddr*)&sxdp, sizeof(sxdp)) == -1) {
+        LOG(ERROR, "AF_XDP: failed to bind socket for interface %s queue %u - %s (%d)\n",
+            interface->name, queue, strerror(errno), errno);
+        goto ERROR;
+    }
+    return xsk;
+
+ERROR:
+    io_af_xdp_socket_close(xsk);
+    return NULL;
+}
+
+/**
+ * Load and attach the XDP program which redirects all packets
+ * to the AF_XDP socket of the receiving queue. Packets received
+ * on queues without socket are passed to the kernel.
+ */
+static bool
+io_af_xdp_program_attach(bbl_interface_s *interface)
+{
+    io_xdp_s *xdp = interface->io.xdp;
+    union bpf_attr attr;
+    char log[1024] = {0};
+
+    struct bpf_insn prog[] = {
+        /* r2 = ((struct xdp_md *)ctx)->rx_queue_index */
+        { .code = BPF_LDX|BPF_MEM|BPF_W, .dst_reg = BPF_REG_2, .src_reg = BPF_REG_1,
+          .off = offsetof(struct xdp_md, rx_queue_index) },
+        /* r1 = xsks_map (64 bit immediate load) */
+        { .code = BPF_LD|BPF_DW|BPF_IMM, .dst_reg = BPF_REG_1, .src_reg = BPF_PSEUDO_MAP_FD,
+          .imm = xdp->map_fd },
+        { .code = 0 },
+        /* r3 = XDP_PASS (action if there is no socket for this queue) */
+        { .code = BPF_ALU64|BPF_MOV|BPF_K, .dst_reg = BPF_REG_3, .imm = XDP_PASS },
+        /* r0 = bpf_redirect_map(r1, r2, r3) */
+        { .code = BPF_JMP|BPF_CALL, .imm = BPF_FUNC_redirect_map },
+        /* return r0 */
+        { .code = BPF_JMP|BPF_EXIT },
+    };
+
+    memset(&attr, 0x0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uintptr_t)prog;
+    attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+    attr.license = (uintptr_t)"Dual BSD/GPL";
+    attr.log_buf = (uintptr_t)log;
+    attr.log_size = sizeof(log);
+    attr.log_level = 1;
+    xdp->prog_fd = sys_bpf(BPF_PROG_LOAD, &attr);
+    if(xdp->prog_fd < 0) {
+        LOG(ERROR, "AF_XDP: failed to load XDP program for interface %s - %s (%d) %s\n",
+            interface->name, strerror(errno), errno, log);
+        return false;
+    }
+
+    /* The program remains attached as long as the link
+     * file descriptor is open (process is running). */
+    memset(&attr, 0x0, sizeof(attr));
+    attr.link_create.prog_fd = xdp->prog_fd;
+    attr.link_create.target_ifindex = interface->kernel_index;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = XDP_FLAGS_DRV_MODE;
+    xdp->link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+    if(xdp->link_fd < 0) {
+        LOG(DEBUG, "AF_XDP: native mode not supported on interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+        xdp->link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+        if(xdp->link_fd < 0) {
+            LOG(ERROR, "AF_XDP: failed to attach XDP program to interface %s - %s (%d)\n",
+                interface->name, strerror(errno), errno);
+            return false;
+        }
+    }
+    xdp->mode = attr.link_create.flags;
+    return true;
+}
+
+/**
+ * io_af_xdp_interface_init
+ *
+ * Init XDP program and AF_XDP sockets (per queue)
+ * for interface. This function must be called before
+ * the IO handles are initialized via io_af_xdp_init.
+ *
+ * @param interface interface
+ * @return true if successful
+ */
+bool
+io_af_xdp_interface_init(bbl_interface_s *interface)
+{
+    bbl_link_config_s *config = interface->config;
+    io_xdp_s *xdp;
+    union bpf_attr attr;
+    uint32_t queue;
+    uint32_t fd;
+
+    uint32_t rx_queues = config->rx_threads ? config->rx_threads : 1;
+    uint32_t tx_queues = config->tx_threads ? config->tx_threads : 1;
+
+    xdp = calloc(1, sizeof(io_xdp_s));
+    if(!xdp) return false;
+    interface->io.xdp = xdp;
+    xdp->queues = rx_queues > tx_queues ? rx_queues : tx_queues;
+    xdp->xsk = calloc(xdp->queues, sizeof(io_xsk_s*));
+    if(!xdp->xsk) return false;
+
+    memset(&attr, 0x0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = xdp->queues;
+    xdp->map_fd = sys_bpf(BPF_MAP_CREATE, &attr);
+    if(xdp->map_fd < 0) {
+        LOG(ERROR, "AF_XDP: failed to create XSK map for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        return false;
+    }
+    if(!io_af_xdp_program_attach(interface)) {
+        return false;
+    }
+
+    for(queue = 0; queue < xdp->queues; queue++) {
+        xdp->xsk[queue] = io_af_xdp_socket_open(interface, queue);
+        if(!xdp->xsk[queue]) {
+            return false;
+        }
+        if(queue < rx_queues) {
+            /* Redirect packets received on this queue to the socket. */
+            fd = xdp->xsk[queue]->fd;
+            memset(&attr, 0x0, sizeof(attr));
+            attr.map_fd = xdp->map_fd;
+            attr.key = (uintptr_t)&queue;
+            attr.value = (uintptr_t)&fd;
+            if(sys_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+                LOG(ERROR, "AF_XDP: failed to add socket to XSK map for interface %s queue %u - %s (%d)\n",
+                    interface->name, queue, strerror(errno), errno);
+                return false;
+            }
+        }
+    }
+    LOG(DEBUG, "AF_XDP: interface %s uses %u queues in %s mode (%s)\n",
+        interface->name, xdp->queues,
+        xdp->mode == XDP_FLAGS_DRV_MODE ? "native" : "generic",
+        xdp->zero_copy ? "zero-copy" : "copy");
+    return true;
+}
+
+bool
+io_af_xdp_init(io_handle_s *io)
+{
+    bbl_interface_s *interface = io->interface;
+    bbl_link_config_s *config = interface->config;
+    io_xdp_s *xdp = interface->io.xdp;
+
+    io_thread_s *thread = io->thread;
+
+    if(!xdp || (uint32_t)io->id >= xdp->queues) {
+        return false;
+    }
+    io->xsk = xdp->xsk[io->id];
+    io->fd = io->xsk->fd;
+
+    if(thread) {
+        if(io->direction == IO_INGRESS) {
+            thread->run_fn = io_af_xdp_thread_rx_run_fn;
+        } else {
+            timer_add_periodic(&thread->timer.root, &thread->timer.io, "TX (threaded)", 0,
+                config->tx_interval, thread, &io_af_xdp_thread_tx_job);
+            thread->timer.io->reset = false;
+        }
+    } else {
+        if(io->direction == IO_INGRESS) {
+            timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0,
+                config->rx_interval, io, &io_af_xdp_rx_job);
+        } else {
+            timer_add_periodic(&g_ctx->timer_root, &interface->io.tx_job, "TX", 0,
+                config->tx_interval, io, &io_af_xdp_tx_job);
+            interface->io.tx_job->reset = false;
+        }
+    }
+    return true;
+}
+
+void
+io_af_xdp_set_max_stream_len()
+{
+    uint16_t len = IO_AF_XDP_FRAME_SIZE - BBL_MAX_STREAM_OVERHEAD - IO_AF_XDP_HEADROOM;
+
+    if(len < g_ctx->config.io_max_stream_len) {
+        LOG(DEBUG, "Set max allowed stream length to %u because of AF_XDP limitations\n", len);
+        g_ctx->config.io_max_stream_len = len;
+    }
+}
+
+#endif
@@ -38,6 +38,53 @@ typedef enum {
     IO_MODE_AF_XDP              /* AF_XDP */
 } __attribute__ ((__packed__)) io_mode_t;
 
+typedef enum {
+    IO_TIMESTAMP_TIMER = 0,     /* IO job timer (per burst) */
+    IO_TIMESTAMP_USER,          /* user space clock (per packet) */
+    IO_TIMESTAMP_KERNEL,        /* kernel software timestamps (RX) */
+    IO_TIMESTAMP_HARDWARE       /* NIC hardware timestamps (RX) */
+} __attribute__ ((__packed__)) io_timestamp_t;
+
+#ifdef BNGBLASTER_AF_XDP
+typedef struct io_xsk_ring_ {
+    uint32_t cached_prod;
+    uint32_t cached_cons;
+    uint32_t mask;
+    uint32_t size;
+    uint32_t *producer;
+    uint32_t *consumer;
+    uint32_t *flags;
+    void *ring; /* descriptors */
+    void *map;
+    size_t map_len;
+} io_xsk_ring_s;
+
+/* AF_XDP socket (per queue) */
+typedef struct io_xsk_ {
+    int fd;
+    uint32_t queue;
+    uint8_t *umem;
+    uint64_t umem_len;
+    io_xsk_ring_s rx;
+    io_xsk_ring_s tx;
+    io_xsk_ring_s fill;
+    io_xsk_ring_s comp;
+    uint64_t *tx_frames; /* stack of free TX frames */
+    uint32_t tx_frames_free;
+} io_xsk_s;
+
+/* AF_XDP interface */
+typedef struct io_xdp_ {
+    int map_fd;
+    int prog_fd;
+    int link_fd;
+    uint32_t mode; /* XDP_FLAGS_DRV_MODE or XDP_FLAGS_SKB_MODE */
+    bool zero_copy;
+    uint32_t queues;
+    io_xsk_s **xsk; /* sockets per queue */
+} io_xdp_s;
+#endif
+
 typedef struct io_handle_ {
     io_mode_t mode;
     io_direction_t direction;
@@ -46,7 +93,7 @@ typedef struct io_handle_ {
     int fd;
     int fanout_id;
     int fanout_type;
-    struct tpacket_req req;
+    struct tpacket_req3 req; /* TPACKET_V2 uses only the tpacket_req part */
     struct sockaddr_ll addr;
 
 #ifdef BNGBLASTER_DPDK
@@ -56,7 +103,20 @@ typedef struct io_handle_ {
     uint16_t queue;
 #endif
 
+#ifdef BNGBLASTER_AF_XDP
+    io_xsk_s *xsk;
+#endif
+
+    struct {
+        struct mmsghdr *msg;
+        struct iovec *iov;
+        bool *ctrl; /* control traffic (TX) */
+        uint8_t *cmsg; /* control messages (RX timestamps) */
+        uint16_t count; /* packets in batch */
+    } mmsg; /* RAW sendmmsg/recvmmsg batch */
+
     uint8_t *ring; /* ring buffer */
+    uint64_t *ring_template; /* stream template id per TX ring slot */
     unsigned int cursor; /* ring buffer cursor */
     unsigned int queued;
 
@@ -69,13 +129,18 @@ typedef struct io_handle_ {
     uint16_t vlan_tci;
     uint16_t vlan_tpid;
 
-    double stream_pps;
-    uint32_t stream_tokens;
-    uint32_t stream_rate;
+    double stream_pps; /* sum of stream PPS assigned to this handle */
+    double stream_bps; /* sum of stream bits per second assigned to this handle */
+    double stream_tokens;
+    double stream_rate; /* tokens per second */
     uint32_t stream_burst;
+    struct timespec stream_token_timestamp; /* last token bucket update */
     CIRCLEQ_HEAD(stream_tx_, bbl_stream_) stream_tx_qhead;
 
     struct timespec timestamp; /* user space timestamps */
+    struct timespec clock_offset; /* CLOCK_REALTIME - CLOCK_MONOTONIC */
+    io_timestamp_t timestamping; /* configured timestamping mode */
+    io_timestamp_t timestamp_source; /* source of current timestamp */
 
     struct {
         uint64_t packets;
@@ -120,6 +185,15 @@ typedef struct io_thread_ {
         struct timer_ *io;
     } timer;
 
+    struct {
+        bool enabled;
+        bool busy; /* packets received since last wait */
+        int epoll_fd;
+        int timer_fd;
+        uint64_t busy_poll; /* busy poll time in nsec */
+        struct timespec idle; /* start of idle period */
+    } event;
+
     struct io_thread_ *next;
 } io_thread_s;
 
@@ -174,9 +174,12 @@ io_dpdk_rx_job(timer_s *timer)
     assert(io->thread == NULL);
 
     /* Get RX timestamp */
-    //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
-    io->timestamp.tv_sec = timer->timestamp->tv_sec;
-    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    if(io->timestamping) {
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+    } else {
+        io->timestamp.tv_sec = timer->timestamp->tv_sec;
+        io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    }
     while(true) {
         nb_rx = rte_eth_rx_burst(interface->port_id, io->queue, packet_burst, BURST_SIZE_RX);
         if(nb_rx == 0) {
@@ -189,11 +192,12 @@ io_dpdk_rx_job(timer_s *timer)
             io->buf_len = packet->pkt_len;
             io->stats.packets++;
             io->stats.bytes += io->buf_len;
-            decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
+            decode_result = decode_ethernet_fast(io->buf, io->buf_len, interface->io.sp, SCRATCHPAD_LEN, &eth);
             if(decode_result == PROTOCOL_SUCCESS) {
                 /* Copy RX timestamp */
                 eth->timestamp.tv_sec = io->timestamp.tv_sec;
                 eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+                eth->timestamp_source = io->timestamp_source;
                 bbl_rx_handler(interface, eth);
             } else if(decode_result == UNKNOWN_PROTOCOL) {
                 io->stats.unknown++;
@@ -214,6 +218,20 @@ io_dpdk_rx_job(timer_s *timer)
     }
 }
 
+/**
+ * The mbuf private area stores the template id of 
+ * the stream packet in the mbuf data, which remains 
+ * untouched if the mbuf is returned to the TX pool. 
+ * This allows to update just the BBL header of 
+ * stream packets if the mbuf is reused by the same 
+ * stream.
+ */
+static inline uint64_t *
+io_dpdk_mbuf_template(struct rte_mbuf *mbuf)
+{
+    return (uint64_t*)rte_mbuf_to_priv(mbuf);
+}
+
 static bool
 io_dpdk_mbuf_alloc(io_handle_s *io)
 {
@@ -281,12 +299,14 @@ io_dpdk_tx_job(timer_s *timer)
                     ctrl = false;
                     continue;
                 }
+                *io_dpdk_mbuf_template(io->mbuf) = 0;
             } else {
                 /* Send traffic streams up to allowed burst. */
                 if(++stream_packets > io->stream_burst) {
                     break;
                 }
-                if(bbl_stream_tx(io, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+                if(bbl_stream_tx_template(io, io->buf, &io->buf_len, 
+                                          io_dpdk_mbuf_template(io->mbuf)) != PROTOCOL_SUCCESS) {
                     break;
                 }
             }
@@ -409,6 +429,7 @@ io_dpdk_thread_tx_job(timer_s *timer)
                     io->buf_len = slot->packet_len;
                     memcpy(io->buf, slot->packet, slot->packet_len);
                     bbl_txq_read_next(txq);
+                    *io_dpdk_mbuf_template(io->mbuf) = 0;
                 } else {
                     ctrl = false;
                     continue;
@@ -418,7 +439,8 @@ io_dpdk_thread_tx_job(timer_s *timer)
                 if(++stream_packets > io->stream_burst) {
                     break;
                 }
-                if(bbl_stream_tx(io, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+                if(bbl_stream_tx_template(io, io->buf, &io->buf_len, 
+                                          io_dpdk_mbuf_template(io->mbuf)) != PROTOCOL_SUCCESS) {
                     break;
                 }
             }
@@ -450,10 +472,24 @@ io_dpdk_add_mbuf_pool(io_handle_s *io)
     name = strdup(buf);
     if(!name) return false; /* very unlikely... */
 
-    mbuf_pool = rte_pktmbuf_pool_create(name,
-            NUM_MBUFS, MBUF_CACHE_SIZE, 0,
+    /* Each queue has its own mbuf pool which is used by one 
+     * thread only. The IO threads are no EAL lcores without
+     * per lcore mempool cache, therefore a single producer
+     * and single consumer ring is used to avoid atomic 
+     * operations for each mbuf allocated or freed. */
+    mbuf_pool = rte_pktmbuf_pool_create_by_ops(name,
+            NUM_MBUFS, MBUF_CACHE_SIZE, 
+            RTE_ALIGN(sizeof(uint64_t), RTE_MBUF_PRIV_ALIGN),
             RTE_MBUF_DEFAULT_BUF_SIZE, 
-            rte_eth_dev_socket_id(io->interface->port_id));
+            rte_eth_dev_socket_id(io->interface->port_id),
+            "ring_sp_sc");
+    if(!mbuf_pool) {
+        mbuf_pool = rte_pktmbuf_pool_create(name,
+                NUM_MBUFS, MBUF_CACHE_SIZE, 
+                RTE_ALIGN(sizeof(uint64_t), RTE_MBUF_PRIV_ALIGN),
+                RTE_MBUF_DEFAULT_BUF_SIZE, 
+                rte_eth_dev_socket_id(io->interface->port_id));
+    }
     if(!mbuf_pool) {
         free(name);
         return false;
@@ -521,10 +557,27 @@ io_dpdk_interface_init(bbl_interface_s *interface)
         local_port_conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE;
     }
 
-    local_port_conf.rxmode.mq_mode = RTE_ETH_MQ_RX_RSS;
-    local_port_conf.rx_adv_conf.rss_conf.rss_hf =
-        (RTE_ETH_RSS_IP | RTE_ETH_RSS_TCP | RTE_ETH_RSS_UDP) &
-        dev_info.flow_type_rss_offloads;
+    if(nb_rx_queue > 1) {
+        /* Distribute received packets over all RX queues and 
+         * threads using RSS on the L3/L4 5-tuple. PPPoE sessions 
+         * and VLAN tags are added to the hash if supported by 
+         * the NIC, so that access traffic is distributed too. */
+        local_port_conf.rxmode.mq_mode = RTE_ETH_MQ_RX_RSS;
+        local_port_conf.rx_adv_conf.rss_conf.rss_key = NULL;
+        local_port_conf.rx_adv_conf.rss_conf.rss_hf =
+            (RTE_ETH_RSS_IP | RTE_ETH_RSS_TCP | RTE_ETH_RSS_UDP | 
+             RTE_ETH_RSS_PPPOE | RTE_ETH_RSS_C_VLAN | RTE_ETH_RSS_S_VLAN) &
+            dev_info.flow_type_rss_offloads;
+        if(local_port_conf.rx_adv_conf.rss_conf.rss_hf) {
+            LOG(DPDK, "DPDK: interface %s (%u) RSS over %u RX queues (hash functions 0x%lx)\n",
+                interface->name, port_id, nb_rx_queue, 
+                local_port_conf.rx_adv_conf.rss_conf.rss_hf);
+        } else {
+            LOG(ERROR, "DPDK: interface %s (%u) does not support RSS, all packets are received on RX queue 0\n",
+                interface->name, port_id);
+            local_port_conf.rxmode.mq_mode = RTE_ETH_MQ_RX_NONE;
+        }
+    }
 
     ret = rte_eth_dev_configure(port_id, nb_rx_queue, nb_tx_queue, &local_port_conf);
     if(ret < 0) {
@@ -554,6 +607,7 @@ io_dpdk_interface_init(bbl_interface_s *interface)
         io->id = --id;
         io->mode = config->io_mode;
         io->direction = IO_INGRESS;
+        io_timestamp_init(io, config->io_timestamping);
         io->next = interface->io.rx;
         interface->io.rx = io;
         io->interface = interface;
@@ -593,6 +647,7 @@ io_dpdk_interface_init(bbl_interface_s *interface)
         io->id = --id;
         io->mode = config->io_mode;
         io->direction = IO_EGRESS;
+        io_timestamp_init(io, config->io_timestamping);
         io->next = interface->io.tx;
         interface->io.tx = io;
         io->interface = interface;
@@ -605,7 +660,6 @@ io_dpdk_interface_init(bbl_interface_s *interface)
             timer_add_periodic(&io->thread->timer.root, &io->thread->timer.io, "TX (threaded)", 0, 
                 config->tx_interval, io->thread, &io_dpdk_thread_tx_job);
             io->thread->timer.io->reset = false;
-            io->thread->set_cpu_affinity = true;
         } else {
             timer_add_periodic(&g_ctx->timer_root, &interface->io.tx_job, "TX", 0, 
                 config->tx_interval, io, &io_dpdk_tx_job);
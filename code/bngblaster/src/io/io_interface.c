@@ -86,6 +86,7 @@ io_interface_init_rx(bbl_interface_s *interface)
             io->mode = IO_MODE_PACKET_MMAP;
         }
         io->direction = IO_INGRESS;
+        io_timestamp_init(io, config->io_timestamping);
         io->next = interface->io.rx;
         interface->io.rx = io;
         io->interface = interface;
@@ -106,6 +107,13 @@ io_interface_init_rx(bbl_interface_s *interface)
                     return false;
                 }
                 break;
+#ifdef BNGBLASTER_AF_XDP
+            case IO_MODE_AF_XDP:
+                if(!io_af_xdp_init(io)) {
+                    return false;
+                }
+                break;
+#endif
             default:
                 return false;
         }
@@ -133,6 +141,7 @@ io_interface_init_tx(bbl_interface_s *interface)
             io->mode = IO_MODE_RAW;
         }
         io->direction = IO_EGRESS;
+        io_timestamp_init(io, config->io_timestamping);
         io->next = interface->io.tx;
         interface->io.tx = io;
         io->interface = interface;
@@ -153,6 +162,13 @@ io_interface_init_tx(bbl_interface_s *interface)
                     return false;
                 }
                 break;
+#ifdef BNGBLASTER_AF_XDP
+            case IO_MODE_AF_XDP:
+                if(!io_af_xdp_init(io)) {
+                    return false;
+                }
+                break;
+#endif
             default:
                 return false;
         }
@@ -208,6 +224,9 @@ io_interface_init(bbl_interface_s *interface)
 {
     bbl_link_config_s *config = interface->config;
 
+    /* RX jobs are executed in main loop per default. */
+    interface->io.sp = g_ctx->sp;
+
 #ifdef BNGBLASTER_DPDK
     if(config->io_mode == IO_MODE_DPDK) {
         if(!io_dpdk_interface_init(interface)) {
@@ -227,6 +246,13 @@ io_interface_init(bbl_interface_s *interface)
         if(*(uint32_t*)config->mac) {
             memcpy(interface->mac, config->mac, ETH_ADDR_LEN);
         }
+#ifdef BNGBLASTER_AF_XDP
+        if(config->io_mode == IO_MODE_AF_XDP) {
+            if(!io_af_xdp_interface_init(interface)) {
+                return false;
+            }
+        }
+#endif
         if(!io_interface_init_rx(interface)) {
             return false;
         }
@@ -31,6 +31,18 @@ poll_kernel(io_handle_s *io, short events)
     }
 }
 
+/* Get per packet RX timestamp if enabled. Kernel and hardware 
+ * timestamps are taken from the ring frame header. */
+static void
+rx_timestamp(io_handle_s *io, uint32_t status, uint32_t sec, uint32_t nsec)
+{
+    if(io->timestamping >= IO_TIMESTAMP_KERNEL) {
+        io_timestamp_set(io, sec, nsec, status & TP_STATUS_TS_RAW_HARDWARE);
+    } else if(io->timestamping == IO_TIMESTAMP_USER) {
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+    }
+}
+
 /**
  * This job is for PACKET_MMAP RX in main thread!
  */
@@ -65,12 +77,16 @@ io_packet_mmap_rx_job(timer_s *timer)
     //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    if(io->timestamping >= IO_TIMESTAMP_KERNEL) {
+        io_timestamp_offset(io);
+    }
     while(tphdr->tp_status & TP_STATUS_USER) {
         io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
         io->buf_len = tphdr->tp_len;
+        rx_timestamp(io, tphdr->tp_status, tphdr->tp_sec, tphdr->tp_nsec);
         io->stats.packets++;
         io->stats.bytes += io->buf_len;
-        decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
+        decode_result = decode_ethernet_fast(io->buf, io->buf_len, interface->io.sp, SCRATCHPAD_LEN, &eth);
         if(decode_result == PROTOCOL_SUCCESS) {
             vlan = tphdr->tp_vlan_tci & BBL_ETH_VLAN_ID_MAX;
             if(vlan && eth->vlan_outer != vlan) {
@@ -84,10 +100,9 @@ io_packet_mmap_rx_job(timer_s *timer)
                 }
             }
             /* Copy RX timestamp */
-            //eth->timestamp.tv_sec = tphdr->tp_sec; /* ktime/hw timestamp */
-            //eth->timestamp.tv_nsec = tphdr->tp_nsec; /* ktime/hw timestamp */
             eth->timestamp.tv_sec = io->timestamp.tv_sec;
             eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+            eth->timestamp_source = io->timestamp_source;
             bbl_rx_handler(interface, eth);
         } else if(decode_result == UNKNOWN_PROTOCOL) {
             io->stats.unknown++;
@@ -112,6 +127,94 @@ io_packet_mmap_rx_job(timer_s *timer)
     }
 }
 
+/**
+ * This job is for PACKET_MMAP TPACKET_V3 RX in main thread!
+ */
+void
+io_packet_mmap_rx_v3_job(timer_s *timer)
+{
+    io_handle_s *io = timer->data;
+    bbl_interface_s *interface = io->interface;
+
+    struct tpacket_block_desc *pbd;
+    struct tpacket3_hdr *tphdr;
+    uint32_t packets;
+
+    bbl_ethernet_header_s *eth;
+    uint16_t vlan;
+
+    protocol_error_t decode_result;
+    bool pcap = false;
+
+    assert(io->mode == IO_MODE_PACKET_MMAP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread == NULL);
+
+    pbd = (struct tpacket_block_desc*)(io->ring + (io->cursor * io->req.tp_block_size));
+    if(!(pbd->hdr.bh1.block_status & TP_STATUS_USER)) {
+        /* If no block is available poll kernel */
+        poll_kernel(io, POLLIN);
+        return;
+    }
+
+    /* Get RX timestamp */
+    io->timestamp.tv_sec = timer->timestamp->tv_sec;
+    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    if(io->timestamping >= IO_TIMESTAMP_KERNEL) {
+        io_timestamp_offset(io);
+    }
+    while(pbd->hdr.bh1.block_status & TP_STATUS_USER) {
+        /* Process all packets of the block */
+        packets = pbd->hdr.bh1.num_pkts;
+        tphdr = (struct tpacket3_hdr*)((uint8_t*)pbd + pbd->hdr.bh1.offset_to_first_pkt);
+        while(packets--) {
+            io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
+            io->buf_len = tphdr->tp_snaplen;
+            rx_timestamp(io, tphdr->tp_status, tphdr->tp_sec, tphdr->tp_nsec);
+            io->stats.packets++;
+            io->stats.bytes += io->buf_len;
+            decode_result = decode_ethernet_fast(io->buf, io->buf_len, interface->io.sp, SCRATCHPAD_LEN, &eth);
+            if(decode_result == PROTOCOL_SUCCESS) {
+                vlan = tphdr->hv1.tp_vlan_tci & BBL_ETH_VLAN_ID_MAX;
+                if(vlan && eth->vlan_outer != vlan) {
+                    /* The outer VLAN is stripped from header */
+                    eth->vlan_inner = eth->vlan_outer;
+                    eth->vlan_inner_priority = eth->vlan_outer_priority;
+                    eth->vlan_outer = vlan;
+                    eth->vlan_outer_priority = tphdr->hv1.tp_vlan_tci >> 13;
+                    if(tphdr->hv1.tp_vlan_tpid == ETH_TYPE_QINQ) {
+                        eth->qinq = true;
+                    }
+                }
+                /* Copy RX timestamp */
+                eth->timestamp.tv_sec = io->timestamp.tv_sec;
+                eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+                eth->timestamp_source = io->timestamp_source;
+                bbl_rx_handler(interface, eth);
+            } else if(decode_result == UNKNOWN_PROTOCOL) {
+                io->stats.unknown++;
+            } else {
+                io->stats.protocol_errors++;
+            }
+            /* Dump the packet into pcap file */
+            if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
+                pcap = true;
+                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+            }
+            tphdr = (struct tpacket3_hdr*)((uint8_t*)tphdr + tphdr->tp_next_offset);
+        }
+        /* Return ownership of the whole block back to kernel */
+        pbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        /* Get next block */
+        io->cursor = (io->cursor + 1) % io->req.tp_block_nr;
+        pbd = (struct tpacket_block_desc*)(io->ring + (io->cursor * io->req.tp_block_size));
+    }
+    if(pcap) {
+        pcapng_fflush();
+    }
+}
+
 /**
  * This job is for PACKET_MMAP TX in main thread!
  */
@@ -159,12 +262,16 @@ io_packet_mmap_tx_job(timer_s *timer)
                     ctrl = false;
                     continue;
                 }
+                io->ring_template[io->cursor] = 0;
             } else {
                 /* Send traffic streams up to allowed burst. */
                 if(++stream_packets > io->stream_burst) {
                     break;
                 }
-                if(bbl_stream_tx(io, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+                /* Stream packets are written only once to each ring slot, 
+                 * updating just the BBL header if the slot is reused. */
+                if(bbl_stream_tx_template(io, io->buf, &io->buf_len, 
+                                          &io->ring_template[io->cursor]) != PROTOCOL_SUCCESS) {
                     break;
                 }
             }
@@ -231,18 +338,23 @@ io_packet_mmap_thread_rx_run_fn(io_thread_s *thread)
         frame_ptr = ring + (cursor * frame_size);
         tphdr = (struct tpacket2_hdr*)frame_ptr;
         if(!(tphdr->tp_status & TP_STATUS_USER)) {
-            /* If no buffer is available poll kernel */
-            poll_kernel(io, POLLIN);
-            sleep.tv_nsec = 100000; /* 0.1ms */
-            nanosleep(&sleep, &rem);
+            if(!thread->event.enabled) {
+                /* If no buffer is available poll kernel */
+                poll_kernel(io, POLLIN);
+            }
+            io_thread_rx_wait(thread, 100000); /* 0.1ms */
             continue;
         }
 
         /* Get RX timestamp */
         clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        if(io->timestamping >= IO_TIMESTAMP_KERNEL) {
+            io_timestamp_offset(io);
+        }
         while(tphdr->tp_status & TP_STATUS_USER) {
             io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
             io->buf_len = tphdr->tp_len;
+            rx_timestamp(io, tphdr->tp_status, tphdr->tp_sec, tphdr->tp_nsec);
             io->vlan_tci = tphdr->tp_vlan_tci;
             io->vlan_tpid = tphdr->tp_vlan_tpid;
             /* Process packet */
@@ -254,8 +366,73 @@ io_packet_mmap_thread_rx_run_fn(io_thread_s *thread)
             frame_ptr = ring + (cursor * frame_size);
             tphdr = (struct tpacket2_hdr*)frame_ptr;
         }
-        sleep.tv_nsec = 1000; /* 0.001ms */
-        nanosleep(&sleep, &rem);
+        if(!thread->event.enabled) {
+            sleep.tv_nsec = 1000; /* 0.001ms */
+            nanosleep(&sleep, &rem);
+        }
+    }
+}
+
+/**
+ * TPACKET_V3 RX thread run function processing 
+ * whole blocks and waiting for the next block 
+ * with a blocking poll, which returns if a block 
+ * is full or the block retire timeout expired. 
+ */
+void
+io_packet_mmap_thread_rx_v3_run_fn(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+
+    uint32_t cursor = io->cursor;
+    uint32_t block_size = io->req.tp_block_size;
+    uint32_t block_nr = io->req.tp_block_nr;
+    uint8_t *ring = io->ring;
+
+    struct tpacket_block_desc *pbd;
+    struct tpacket3_hdr *tphdr;
+    uint32_t packets;
+
+    struct pollfd pollset;
+
+    assert(io->mode == IO_MODE_PACKET_MMAP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread);
+
+    pollset.fd = io->fd;
+    pollset.events = POLLIN|POLLERR;
+    pollset.revents = 0;
+
+    while(thread->active) {
+        pbd = (struct tpacket_block_desc*)(ring + (cursor * block_size));
+        if(!(pbd->hdr.bh1.block_status & TP_STATUS_USER)) {
+            /* Wait for next block */
+            io->stats.polled++;
+            poll(&pollset, 1, IO_PACKET_MMAP_V3_POLL_TIMEOUT);
+            continue;
+        }
+
+        /* Get RX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        if(io->timestamping >= IO_TIMESTAMP_KERNEL) {
+            io_timestamp_offset(io);
+        }
+        packets = pbd->hdr.bh1.num_pkts;
+        tphdr = (struct tpacket3_hdr*)((uint8_t*)pbd + pbd->hdr.bh1.offset_to_first_pkt);
+        while(packets--) {
+            io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
+            io->buf_len = tphdr->tp_snaplen;
+            rx_timestamp(io, tphdr->tp_status, tphdr->tp_sec, tphdr->tp_nsec);
+            io->vlan_tci = tphdr->hv1.tp_vlan_tci;
+            io->vlan_tpid = tphdr->hv1.tp_vlan_tpid;
+            /* Process packet */
+            io_thread_rx_handler(thread, io);
+            tphdr = (struct tpacket3_hdr*)((uint8_t*)tphdr + tphdr->tp_next_offset);
+        }
+        /* Return ownership of the whole block back to kernel */
+        pbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        /* Get next block */
+        cursor = (cursor + 1) % block_nr;
     }
 }
 
@@ -270,7 +447,10 @@ io_packet_mmap_thread_tx_job(timer_s *timer)
     bbl_interface_s *interface = io->interface;
 
     bbl_txq_s *txq = thread->txq;
+    bbl_txq_slot_t *slots[BBL_TXQ_BATCH];
     bbl_txq_slot_t *slot;
+    uint16_t count = 0;
+    uint16_t index = 0;
 
     struct tpacket2_hdr* tphdr;
     uint8_t *frame_ptr;
@@ -295,6 +475,7 @@ io_packet_mmap_thread_tx_job(timer_s *timer)
         //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
         io->timestamp.tv_sec = timer->timestamp->tv_sec;
         io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+        count = bbl_txq_peek(txq, slots, BBL_TXQ_BATCH);
         while(true) {
             /* Check if this slot available for writing. */
             if(tphdr->tp_status != TP_STATUS_AVAILABLE) {
@@ -305,11 +486,16 @@ io_packet_mmap_thread_tx_job(timer_s *timer)
 
             if(ctrl) {
                 /* First send all control traffic which has higher priority. */
-                slot = bbl_txq_read_slot(txq);
-                if(slot) {
+                if(index == count && count == BBL_TXQ_BATCH) {
+                    bbl_txq_release(txq, count);
+                    count = bbl_txq_peek(txq, slots, BBL_TXQ_BATCH);
+                    index = 0;
+                }
+                if(index < count) {
+                    slot = slots[index++];
                     io->buf_len = slot->packet_len;
                     memcpy(io->buf, slot->packet, slot->packet_len);
-                    bbl_txq_read_next(txq);
+                    io->ring_template[io->cursor] = 0;
                 } else {
                     ctrl = false;
                     continue;
@@ -319,7 +505,10 @@ io_packet_mmap_thread_tx_job(timer_s *timer)
                 if(++stream_packets > io->stream_burst) {
                     break;
                 }
-                if(bbl_stream_tx(io, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+                /* Stream packets are written only once to each ring slot, 
+                 * updating just the BBL header if the slot is reused. */
+                if(bbl_stream_tx_template(io, io->buf, &io->buf_len, 
+                                          &io->ring_template[io->cursor]) != PROTOCOL_SUCCESS) {
                     break;
                 }
             }
@@ -336,6 +525,9 @@ io_packet_mmap_thread_tx_job(timer_s *timer)
             frame_ptr = io->ring + (io->cursor * io->req.tp_frame_size);
             tphdr = (struct tpacket2_hdr *)frame_ptr;
         }
+        if(index) {
+            bbl_txq_release(txq, index);
+        }
     }
 
     if(io->queued) {
@@ -361,10 +553,20 @@ io_packet_mmap_init(io_handle_s *io)
     if(!io_socket_open(io)) {
         return false;
     }
+    if(io->direction == IO_EGRESS) {
+        io->ring_template = calloc(io->req.tp_frame_nr, sizeof(uint64_t));
+        if(!io->ring_template) {
+            return false;
+        }
+    }
 
     if(thread) {
         if(io->direction == IO_INGRESS) {
-            thread->run_fn = io_packet_mmap_thread_rx_run_fn;
+            if(config->io_rx_tpacket_v3) {
+                thread->run_fn = io_packet_mmap_thread_rx_v3_run_fn;
+            } else {
+                thread->run_fn = io_packet_mmap_thread_rx_run_fn;
+            }
         } else {
             timer_add_periodic(&thread->timer.root, &thread->timer.io, "TX (threaded)", 0, 
                 config->tx_interval, thread, &io_packet_mmap_thread_tx_job);
@@ -372,8 +574,13 @@ io_packet_mmap_init(io_handle_s *io)
         }
     } else {
         if(io->direction == IO_INGRESS) {
-            timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0, 
-                config->rx_interval, io, &io_packet_mmap_rx_job);
+            if(config->io_rx_tpacket_v3) {
+                timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0, 
+                    config->rx_interval, io, &io_packet_mmap_rx_v3_job);
+            } else {
+                timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0, 
+                    config->rx_interval, io, &io_packet_mmap_rx_job);
+            }
         } else {
             timer_add_periodic(&g_ctx->timer_root, &interface->io.tx_job, "TX", 0, 
                 config->tx_interval, io, &io_packet_mmap_tx_job);
@@ -9,6 +9,10 @@
 #ifndef __BBL_IO_PACKET_MMAP_H__
 #define __BBL_IO_PACKET_MMAP_H__
 
+#define IO_PACKET_MMAP_V3_BLOCK_FRAMES  32 /* block size in pages */
+#define IO_PACKET_MMAP_V3_BLOCK_NR_MIN  4
+#define IO_PACKET_MMAP_V3_POLL_TIMEOUT  100 /* msec */
+
 bool
 io_packet_mmap_init(io_handle_s *io);
 
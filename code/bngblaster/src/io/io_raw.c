@@ -8,6 +8,52 @@
  */
 #include "io.h"
 
+/**
+ * Get per packet RX timestamp if enabled. Kernel and 
+ * hardware timestamps are received as control message.
+ */
+static void
+io_raw_rx_timestamp(io_handle_s *io, struct msghdr *msg)
+{
+    struct cmsghdr *cmsg;
+    struct scm_timestamping *ts = NULL;
+
+    if(io->timestamping >= IO_TIMESTAMP_KERNEL) {
+        for(cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+            if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                ts = (struct scm_timestamping*)CMSG_DATA(cmsg);
+                break;
+            }
+        }
+        if(ts && ts->ts[2].tv_sec) {
+            /* Raw hardware timestamp */
+            io_timestamp_set(io, ts->ts[2].tv_sec, ts->ts[2].tv_nsec, true);
+        } else if(ts) {
+            /* Software timestamp */
+            io_timestamp_set(io, ts->ts[0].tv_sec, ts->ts[0].tv_nsec, false);
+        } else {
+            io_timestamp_set(io, 0, 0, false);
+        }
+    } else if(io->timestamping == IO_TIMESTAMP_USER) {
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+    }
+}
+
+/**
+ * Reset control buffer length of all received messages, 
+ * which is updated by the kernel with each receive. This
+ * must be done also for skipped messages.
+ */
+static void
+io_raw_rx_cmsg_reset(io_handle_s *io, int count)
+{
+    if(io->mmsg.cmsg) {
+        for(int i = 0; i < count; i++) {
+            io->mmsg.msg[i].msg_hdr.msg_controllen = IO_RAW_CMSG_LEN;
+        }
+    }
+}
+
 /**
  * This job is for RAW RX in main thread!
  */
@@ -17,13 +63,11 @@ io_raw_rx_job(timer_s *timer)
     io_handle_s *io = timer->data;
     bbl_interface_s *interface = io->interface;
 
-    struct sockaddr saddr;
-    int saddr_size = sizeof(saddr);
-
     bbl_ethernet_header_s *eth;
 
     protocol_error_t decode_result;
     bool pcap = false;
+    int count, i;
 
     assert(io->mode == IO_MODE_RAW);
     assert(io->direction == IO_INGRESS);
@@ -33,29 +77,45 @@ io_raw_rx_job(timer_s *timer)
     //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    if(io->timestamping >= IO_TIMESTAMP_KERNEL) {
+        io_timestamp_offset(io);
+    }
     while(true) {
-        io->buf_len = recvfrom(io->fd, io->buf, IO_BUFFER_LEN, 0, &saddr , (socklen_t*)&saddr_size);
-        if(io->buf_len < 14 || io->buf_len > IO_BUFFER_LEN) {
+        count = recvmmsg(io->fd, io->mmsg.msg, IO_RAW_BATCH_LEN, MSG_DONTWAIT, NULL);
+        if(count <= 0) {
             break;
         }
-        io->stats.packets++;
-        io->stats.bytes += io->buf_len;
-        decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
-        if(decode_result == PROTOCOL_SUCCESS) {
-            /* Copy RX timestamp */
-            eth->timestamp.tv_sec = io->timestamp.tv_sec;
-            eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
-            bbl_rx_handler(interface, eth);
-        } else if(decode_result == UNKNOWN_PROTOCOL) {
-            io->stats.unknown++;
-        } else {
-            io->stats.protocol_errors++;
+        for(i = 0; i < count; i++) {
+            io->buf = io->mmsg.iov[i].iov_base;
+            io->buf_len = io->mmsg.msg[i].msg_len;
+            if(io->buf_len < 14 || io->buf_len > IO_BUFFER_LEN) {
+                continue;
+            }
+            io_raw_rx_timestamp(io, &io->mmsg.msg[i].msg_hdr);
+            io->stats.packets++;
+            io->stats.bytes += io->buf_len;
+            decode_result = decode_ethernet_fast(io->buf, io->buf_len, interface->io.sp, SCRATCHPAD_LEN, &eth);
+            if(decode_result == PROTOCOL_SUCCESS) {
+                /* Copy RX timestamp */
+                eth->timestamp.tv_sec = io->timestamp.tv_sec;
+                eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+                eth->timestamp_source = io->timestamp_source;
+                bbl_rx_handler(interface, eth);
+            } else if(decode_result == UNKNOWN_PROTOCOL) {
+                io->stats.unknown++;
+            } else {
+                io->stats.protocol_errors++;
+            }
+            /* Dump the packet into pcap file */
+            if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
+                pcap = true;
+                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+            }
         }
-        /* Dump the packet into pcap file */
-        if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
-            pcap = true;
-            pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                      interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+        io_raw_rx_cmsg_reset(io, count);
+        if(count < IO_RAW_BATCH_LEN) {
+            break;
         }
     }
     if(pcap) {
@@ -68,18 +128,109 @@ io_raw_rx_job(timer_s *timer)
  * the error EMSGSIZE is returned, and the message is not transmitted. In this 
  * case we must not retry the packet, because it will always fail. 
  */
-void
-io_raw_tx_lo_long(io_handle_s *io)
+static void
+io_raw_tx_lo_long(io_handle_s *io, size_t len)
 {
     bbl_interface_s *interface = io->interface;
     if(io->stats.to_long == 0) {
         /* Log error for first oversized packet only! */
-        LOG(ERROR, "RAW sendto on interface %s failed because of to long packet (%u byte), please check MTU settings!\n", 
-            interface->name, io->buf_len);
+        LOG(ERROR, "RAW sendto on interface %s failed because of to long packet (%zu byte), please check MTU settings!\n", 
+            interface->name, len);
     }
     io->stats.to_long++;
 }
 
+/**
+ * Update the timestamps of BBL traffic 
+ * remaining in the TX batch to be retried.
+ */
+static void
+io_raw_tx_retry(io_handle_s *io)
+{
+    struct iovec *iov;
+    uint8_t *buf;
+    uint16_t i;
+
+    for(i = 0; i < io->mmsg.count; i++) {
+        iov = &io->mmsg.iov[i];
+        buf = iov->iov_base;
+        if(packet_is_bbl(buf, iov->iov_len)) {
+            *(uint32_t*)(buf + (iov->iov_len - 8)) = io->timestamp.tv_sec;
+            *(uint32_t*)(buf + (iov->iov_len - 4)) = io->timestamp.tv_nsec;
+        }
+    }
+}
+
+/**
+ * Send all packets in the TX batch with sendmmsg.
+ * 
+ * If sending fails, the failed and all following packets
+ * remain in the TX batch to be retried in the next interval.
+ * 
+ * @param io IO handle
+ * @return false if packets remain in the TX batch
+ */
+static bool
+io_raw_tx_flush(io_handle_s *io)
+{
+    bbl_interface_s *interface = io->interface;
+
+    struct iovec *iov = io->mmsg.iov;
+    struct iovec iov_swap;
+    bool *ctrl = io->mmsg.ctrl;
+    bool ctrl_swap;
+    bool pcap = false;
+
+    uint16_t sent = 0;
+    uint16_t i;
+    int count;
+
+    while(sent < io->mmsg.count) {
+        count = sendmmsg(io->fd, io->mmsg.msg + sent, io->mmsg.count - sent, 0);
+        if(count < 0) {
+            if(errno == EMSGSIZE) {
+                /* Drop the packet because it will always fail. */
+                io_raw_tx_lo_long(io, iov[sent].iov_len);
+                sent++;
+                continue;
+            }
+            LOG(IO, "RAW sendmmsg on interface %s failed with error %s (%d)\n", 
+                interface->name, strerror(errno), errno);
+            io->stats.io_errors++;
+            break;
+        }
+        for(i = sent; i < sent + count; i++) {
+            io->stats.packets++;
+            io->stats.bytes += iov[i].iov_len;
+            /* Dump the packet into pcap file. */
+            if(g_ctx->pcap.write_buf && !io->thread && (ctrl[i] || g_ctx->pcap.include_streams)) {
+                pcap = true;
+                pcapng_push_packet_header(&io->timestamp, iov[i].iov_base, iov[i].iov_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
+            }
+        }
+        sent += count;
+    }
+    if(pcap) {
+        pcapng_fflush();
+    }
+
+    /* Move packets to be retried to the begin of the batch
+     * by swapping buffers, which keeps all buffers unique. */
+    io->mmsg.count -= sent;
+    if(sent) {
+        for(i = 0; i < io->mmsg.count; i++) {
+            iov_swap = iov[i];
+            iov[i] = iov[sent+i];
+            iov[sent+i] = iov_swap;
+            ctrl_swap = ctrl[i];
+            ctrl[i] = ctrl[sent+i];
+            ctrl[sent+i] = ctrl_swap;
+        }
+    }
+    return io->mmsg.count == 0;
+}
+
 /**
  * This job is for RAW TX in main thread!
  */
@@ -89,9 +240,9 @@ io_raw_tx_job(timer_s *timer)
     io_handle_s *io = timer->data;
     bbl_interface_s *interface = io->interface;
 
+    struct iovec *iov;
     uint32_t stream_packets = 0;
-    bool ctrl = true;
-    bool pcap = false;
+    uint16_t len;
 
     assert(io->mode == IO_MODE_RAW);
     assert(io->direction == IO_EGRESS);
@@ -103,59 +254,42 @@ io_raw_tx_job(timer_s *timer)
     //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
-    while(true) {
-        /* If sendto fails, the failed packet remains in TX buffer to be retried
-         * in the next interval. */
-        if(io->buf_len) {
-            if(packet_is_bbl(io->buf, io->buf_len)) {
-                /* Update timestamp if BBL traffic is retried. */
-                *(uint32_t*)(io->buf + (io->buf_len - 8)) = io->timestamp.tv_sec;
-                *(uint32_t*)(io->buf + (io->buf_len - 4)) = io->timestamp.tv_nsec;
-            }
-        } else if(ctrl) {
-            /* First send all control traffic which has higher priority. */
-            if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
-                io->buf_len = 0;
-                ctrl = false;
-                continue;
-            }
-        } else {
-            /* Send traffic streams up to allowed burst. */
-            if(++stream_packets > io->stream_burst) {
-                break;
-            }
-            if(bbl_stream_tx(io, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
-                break;
-            }
-        }
 
-        if(sendto(io->fd, io->buf, io->buf_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) <0 ) {
-            if(errno == EMSGSIZE) {
-                io_raw_tx_lo_long(io);
-            } else {
-                /* This packet will be retried next interval 
-                 * because io->buf_len is not reset to zero. */
-                LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                    interface->name, strerror(errno), errno);
-                io->stats.io_errors++;
-                break;
-            }
-        } else {
-            /* Dump the packet into pcap file. */
-            if(g_ctx->pcap.write_buf && (ctrl || g_ctx->pcap.include_streams)) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
-            }
-            io->stats.packets++;
-            io->stats.bytes += io->buf_len;
+    /* If sendmmsg fails, the failed packets remain in TX batch 
+     * to be retried in the next interval. */
+    if(io->mmsg.count) {
+        io_raw_tx_retry(io);
+        if(!io_raw_tx_flush(io)) {
+            return;
+        }
+    }
 
+    /* First send all control traffic which has higher priority. */
+    while(true) {
+        if(io->mmsg.count == IO_RAW_BATCH_LEN && !io_raw_tx_flush(io)) {
+            return;
+        }
+        iov = &io->mmsg.iov[io->mmsg.count];
+        if(bbl_tx(interface, iov->iov_base, &len) != PROTOCOL_SUCCESS) {
+            break;
         }
-        io->buf_len = 0;
+        iov->iov_len = len;
+        io->mmsg.ctrl[io->mmsg.count++] = true;
     }
-    if(pcap) {
-        pcapng_fflush();
+
+    /* Send traffic streams up to allowed burst. */
+    while(stream_packets++ < io->stream_burst) {
+        if(io->mmsg.count == IO_RAW_BATCH_LEN && !io_raw_tx_flush(io)) {
+            return;
+        }
+        iov = &io->mmsg.iov[io->mmsg.count];
+        if(bbl_stream_tx(io, iov->iov_base, &len) != PROTOCOL_SUCCESS) {
+            break;
+        }
+        iov->iov_len = len;
+        io->mmsg.ctrl[io->mmsg.count++] = false;
     }
+    io_raw_tx_flush(io);
 }
 
 void
@@ -163,28 +297,33 @@ io_raw_thread_rx_run_fn(io_thread_s *thread)
 {
     io_handle_s *io = thread->io;
 
-    struct sockaddr saddr;
-    int saddr_size = sizeof(saddr);
-
-    struct timespec sleep, rem;
+    int count, i;
 
     assert(io->direction == IO_INGRESS);
 
-    sleep.tv_sec = 0;
-    sleep.tv_nsec = 0;
-
     while(thread->active) {
-        /* Get RX timestamp */
-        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
         /* Receive from socket */
-        io->buf_len = recvfrom(io->fd, io->buf, IO_BUFFER_LEN, 0, &saddr , (socklen_t*)&saddr_size);
-        if(io->buf_len < 14 || io->buf_len > IO_BUFFER_LEN) {
-            sleep.tv_nsec = 1000; /* 0.001ms */
-            nanosleep(&sleep, &rem);
+        count = recvmmsg(io->fd, io->mmsg.msg, IO_RAW_BATCH_LEN, MSG_DONTWAIT, NULL);
+        if(count <= 0) {
+            io_thread_rx_wait(thread, 1000); /* 0.001ms */
             continue;
         }
-        /* Process packet */
-        io_thread_rx_handler(thread, io);
+        /* Get RX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        if(io->timestamping >= IO_TIMESTAMP_KERNEL) {
+            io_timestamp_offset(io);
+        }
+        for(i = 0; i < count; i++) {
+            io->buf = io->mmsg.iov[i].iov_base;
+            io->buf_len = io->mmsg.msg[i].msg_len;
+            if(io->buf_len < 14 || io->buf_len > IO_BUFFER_LEN) {
+                continue;
+            }
+            io_raw_rx_timestamp(io, &io->mmsg.msg[i].msg_hdr);
+            /* Process packet */
+            io_thread_rx_handler(thread, io);
+        }
+        io_raw_rx_cmsg_reset(io, count);
     }
 }
 
@@ -198,9 +337,14 @@ io_raw_thread_tx_job(timer_s *timer)
     io_handle_s *io = thread->io;
 
     bbl_txq_s *txq = thread->txq;
+    bbl_txq_slot_t *slots[BBL_TXQ_BATCH];
     bbl_txq_slot_t *slot;
+    uint16_t count;
+    uint16_t i;
 
+    struct iovec *iov;
     uint32_t stream_packets = 0;
+    uint16_t len;
 
     assert(io->mode == IO_MODE_RAW);
     assert(io->direction == IO_EGRESS);
@@ -208,58 +352,90 @@ io_raw_thread_tx_job(timer_s *timer)
 
     io_update_stream_token_bucket(io);
 
-    /* First send all control traffic which has higher priority. */
-    while((slot = bbl_txq_read_slot(txq))) {
-        /* This packet will be retried next interval 
-         * because slot is not marked as read. */
-        if(sendto(io->fd, slot->packet, slot->packet_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) <0 ) {
-            LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                io->interface->name, strerror(errno), errno);
-            io->stats.io_errors++;
-            return;
-        }
-        io->stats.packets++;
-        io->stats.bytes += slot->packet_len;
-        bbl_txq_read_next(txq);
-    }
-
     /* Get TX timestamp */
     //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
 
+    /* If sendmmsg fails, the failed packets remain in TX batch 
+     * to be retried in the next interval. */
+    if(io->mmsg.count) {
+        io_raw_tx_retry(io);
+        if(!io_raw_tx_flush(io)) {
+            return;
+        }
+    }
+
+    /* First send all control traffic which has higher priority. */
+    while((count = bbl_txq_peek(txq, slots, BBL_TXQ_BATCH))) {
+        for(i = 0; i < count; i++) {
+            if(io->mmsg.count == IO_RAW_BATCH_LEN && !io_raw_tx_flush(io)) {
+                bbl_txq_release(txq, i);
+                return;
+            }
+            slot = slots[i];
+            iov = &io->mmsg.iov[io->mmsg.count];
+            memcpy(iov->iov_base, slot->packet, slot->packet_len);
+            iov->iov_len = slot->packet_len;
+            io->mmsg.ctrl[io->mmsg.count++] = true;
+        }
+        bbl_txq_release(txq, count);
+    }
+
     /* Send traffic streams up to allowed burst. */
     while(stream_packets++ < io->stream_burst) {
-        /* If sendto fails, the failed packet remains in TX buffer 
-         * to be retried in the next interval. */
-        if(io->buf_len) {
-            if(packet_is_bbl(io->buf, io->buf_len)) {
-                /* Update timestamp if BBL traffic is retried. */
-                *(uint32_t*)(io->buf + (io->buf_len - 8)) = io->timestamp.tv_sec;
-                *(uint32_t*)(io->buf + (io->buf_len - 4)) = io->timestamp.tv_nsec;
-            }
-        } else {
-            if(bbl_stream_tx(io, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
-                break;
-            }
+        if(io->mmsg.count == IO_RAW_BATCH_LEN && !io_raw_tx_flush(io)) {
+            return;
         }
-        if(sendto(io->fd, io->buf, io->buf_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) <0 ) {
-            if(errno == EMSGSIZE) {
-                io_raw_tx_lo_long(io);
-            } else {
-                /* This packet will be retried next interval 
-                 * because io->buf_len is not reset to zero. */
-                LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                    io->interface->name, strerror(errno), errno);
-                io->stats.io_errors++;
-                break;
-            }
-        } else {
-            io->stats.packets++;
-            io->stats.bytes += io->buf_len;
+        iov = &io->mmsg.iov[io->mmsg.count];
+        if(bbl_stream_tx(io, iov->iov_base, &len) != PROTOCOL_SUCCESS) {
+            break;
+        }
+        iov->iov_len = len;
+        io->mmsg.ctrl[io->mmsg.count++] = false;
+    }
+    io_raw_tx_flush(io);
+}
+
+/**
+ * Allocate sendmmsg/recvmmsg batch with 
+ * one buffer of IO_BUFFER_LEN per packet.
+ */
+static bool
+io_raw_batch_init(io_handle_s *io)
+{
+    struct mmsghdr *msg;
+    uint16_t i;
+
+    io->buf = malloc(IO_RAW_BATCH_LEN * IO_BUFFER_LEN);
+    io->mmsg.msg = calloc(IO_RAW_BATCH_LEN, sizeof(struct mmsghdr));
+    io->mmsg.iov = calloc(IO_RAW_BATCH_LEN, sizeof(struct iovec));
+    io->mmsg.ctrl = calloc(IO_RAW_BATCH_LEN, sizeof(bool));
+    if(!(io->buf && io->mmsg.msg && io->mmsg.iov && io->mmsg.ctrl)) {
+        return false;
+    }
+    if(io->direction == IO_INGRESS && io->timestamping >= IO_TIMESTAMP_KERNEL) {
+        io->mmsg.cmsg = calloc(IO_RAW_BATCH_LEN, IO_RAW_CMSG_LEN);
+        if(!io->mmsg.cmsg) {
+            return false;
+        }
+    }
+    for(i = 0; i < IO_RAW_BATCH_LEN; i++) {
+        io->mmsg.iov[i].iov_base = io->buf + (i * IO_BUFFER_LEN);
+        io->mmsg.iov[i].iov_len = IO_BUFFER_LEN;
+        msg = &io->mmsg.msg[i];
+        msg->msg_hdr.msg_iov = &io->mmsg.iov[i];
+        msg->msg_hdr.msg_iovlen = 1;
+        if(io->direction == IO_EGRESS) {
+            msg->msg_hdr.msg_name = &io->addr;
+            msg->msg_hdr.msg_namelen = sizeof(struct sockaddr_ll);
+        } else if(io->mmsg.cmsg) {
+            msg->msg_hdr.msg_control = io->mmsg.cmsg + (i * IO_RAW_CMSG_LEN);
+            msg->msg_hdr.msg_controllen = IO_RAW_CMSG_LEN;
         }
-        io->buf_len = 0;
     }
+    io->mmsg.count = 0;
+    return true;
 }
 
 bool
@@ -270,8 +446,10 @@ io_raw_init(io_handle_s *io)
     
     io_thread_s *thread = io->thread;
     
-    io->buf = malloc(IO_BUFFER_LEN);
-
+    if(!io_raw_batch_init(io)) {
+        LOG(ERROR, "Failed to allocate RAW batch for interface %s\n", interface->name);
+        return false;
+    }
     if(!io_socket_open(io)) {
         return false;
     }
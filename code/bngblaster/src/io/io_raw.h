@@ -9,6 +9,9 @@
 #ifndef __BBL_IO_RAW_H__
 #define __BBL_IO_RAW_H__
 
+#define IO_RAW_BATCH_LEN 64 /* packets per sendmmsg/recvmmsg */
+#define IO_RAW_CMSG_LEN CMSG_SPACE(sizeof(struct scm_timestamping))
+
 bool
 io_raw_init(io_handle_s *io);
 
@@ -48,6 +48,58 @@ set_fanout(io_handle_s *io)
     return true;
 }
 
+/* Enable hardware timestamping for all received packets 
+ * in the network interface driver. */
+static bool
+set_hwtstamp(io_handle_s *io)
+{
+    struct hwtstamp_config config = {0};
+    struct ifreq ifr = {0};
+
+    config.tx_type = HWTSTAMP_TX_OFF;
+    config.rx_filter = HWTSTAMP_FILTER_ALL;
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", io->interface->name);
+    ifr.ifr_data = (void*)&config;
+    if(ioctl(io->fd, SIOCSHWTSTAMP, &ifr) == -1) {
+        LOG(ERROR, "Failed to enable hardware timestamping for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    return true;
+}
+
+/* Enable kernel or hardware RX timestamps, falling back 
+ * from hardware to kernel timestamps if not supported. */
+static void
+set_timestamping(io_handle_s *io)
+{
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE|SOF_TIMESTAMPING_SOFTWARE;
+    int req = 0;
+
+    if(io->timestamping == IO_TIMESTAMP_HARDWARE) {
+        if(set_hwtstamp(io)) {
+            flags |= SOF_TIMESTAMPING_RX_HARDWARE|SOF_TIMESTAMPING_RAW_HARDWARE;
+            req = SOF_TIMESTAMPING_RAW_HARDWARE;
+        } else {
+            LOG(INFO, "Fallback to kernel timestamps for interface %s\n", 
+                io->interface->name);
+            io->timestamping = IO_TIMESTAMP_KERNEL;
+        }
+    }
+    if(setsockopt(io->fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == -1) {
+        LOG(ERROR, "Failed to set timestamping for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+    }
+    if(req && io->mode == IO_MODE_PACKET_MMAP) {
+        /* Report hardware timestamps in the ring (tp_sec/tp_nsec). */
+        if(setsockopt(io->fd, SOL_PACKET, PACKET_TIMESTAMP, &req, sizeof(req)) == -1) {
+            LOG(ERROR, "Failed to set packet timestamp for interface %s - %s (%d)\n",
+                io->interface->name, strerror(errno), errno);
+        }
+    }
+    io_timestamp_offset(io);
+}
+
 /* Set packet version (TPACKET_V1, TPACKET_V2 or TPACKET_V3). */
 static bool
 set_packet_version(io_handle_s *io, int version)
@@ -62,7 +114,7 @@ set_packet_version(io_handle_s *io, int version)
 
 /* Setup ringbuffer. */
 static bool
-set_ring(io_handle_s *io, int slots)
+set_ring(io_handle_s *io, int slots, int version)
 {
     /* The following are conditions that are checked in packet_set_ring:
      * - tp_block_size must be a multiple of PAGE_SIZE (1)
@@ -72,22 +124,41 @@ set_ring(io_handle_s *io, int slots)
      * Note that tp_block_size should be chosen to be a power of two 
      * or there will be a waste of memory. */
     unsigned int ring_size = 0;
+    socklen_t req_len = sizeof(struct tpacket_req);
     int flag = 0;
     if(io->direction == IO_INGRESS) {
         flag = PACKET_RX_RING;
     } else {
         flag = PACKET_TX_RING;
     }
-    io->req.tp_block_size = getpagesize(); /* 4096 */
-    io->req.tp_frame_size = io->req.tp_block_size;
-    io->req.tp_block_nr = slots;
-    io->req.tp_frame_nr = slots;
+    if(version == TPACKET_V3) {
+        /* TPACKET_V3 stores packets with variable length back 
+         * to back in blocks, which are passed to user space
+         * if full or if the block retire timeout expires. 
+         * The ring size in bytes is equal to TPACKET_V2. */
+        io->req.tp_block_size = getpagesize() * IO_PACKET_MMAP_V3_BLOCK_FRAMES;
+        io->req.tp_block_nr = slots / IO_PACKET_MMAP_V3_BLOCK_FRAMES;
+        if(io->req.tp_block_nr < IO_PACKET_MMAP_V3_BLOCK_NR_MIN) {
+            io->req.tp_block_nr = IO_PACKET_MMAP_V3_BLOCK_NR_MIN;
+        }
+        io->req.tp_frame_size = getpagesize();
+        io->req.tp_frame_nr = io->req.tp_block_nr * IO_PACKET_MMAP_V3_BLOCK_FRAMES;
+        io->req.tp_retire_blk_tov = io->interface->config->io_rx_block_timeout;
+        io->req.tp_sizeof_priv = 0;
+        io->req.tp_feature_req_word = 0;
+        req_len = sizeof(struct tpacket_req3);
+    } else {
+        io->req.tp_block_size = getpagesize(); /* 4096 */
+        io->req.tp_frame_size = io->req.tp_block_size;
+        io->req.tp_block_nr = slots;
+        io->req.tp_frame_nr = slots;
+    }
 
     ring_size = io->req.tp_block_nr * io->req.tp_block_size;
 
-    LOG(DEBUG, "Setup %u byte packet_mmap ringbuffer (%d slots) for interface %s\n", 
-        ring_size, slots, io->interface->name);
-    if(setsockopt(io->fd, SOL_PACKET, flag, &io->req, sizeof(struct tpacket_req)) == -1) {
+    LOG(DEBUG, "Setup %u byte packet_mmap ringbuffer (%u blocks) for interface %s\n", 
+        ring_size, io->req.tp_block_nr, io->interface->name);
+    if(setsockopt(io->fd, SOL_PACKET, flag, &io->req, req_len) == -1) {
         LOG(ERROR, "Allocating ringbuffer error for interface %s - %s (%d)\n",
             io->interface->name, strerror(errno), errno);
         return false;
@@ -109,6 +180,7 @@ io_socket_open(io_handle_s *io) {
 
     int protocol = 0;
     int slots = config->io_slots_tx;
+    int version = TPACKET_V2;
 
     if(io->direction == IO_INGRESS) {
         protocol = htobe16(ETH_P_ALL);
@@ -137,11 +209,17 @@ io_socket_open(io_handle_s *io) {
             return false;
         }
     }
+    if(io->direction == IO_INGRESS && io->timestamping >= IO_TIMESTAMP_KERNEL) {
+        set_timestamping(io);
+    }
     if(io->mode == IO_MODE_PACKET_MMAP) {
-        if(!set_packet_version(io, TPACKET_V2)) {
+        if(io->direction == IO_INGRESS && config->io_rx_tpacket_v3) {
+            version = TPACKET_V3;
+        }
+        if(!set_packet_version(io, version)) {
             return false;
         }
-        if(!set_ring(io, slots)) {
+        if(!set_ring(io, slots, version)) {
             return false;
         }
     }
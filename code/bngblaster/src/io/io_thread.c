@@ -28,7 +28,7 @@ redirect(io_thread_s *thread, io_handle_s *io)
         return IO_ERROR;
     }
 
-    if((slot = bbl_txq_write_slot(thread->txq))) {
+    if((slot = bbl_txq_reserve(thread->txq, io->buf_len))) {
         slot->timestamp.tv_sec = io->timestamp.tv_sec;
         slot->timestamp.tv_nsec = io->timestamp.tv_nsec;
         slot->vlan_tci = io->vlan_tci;
@@ -62,15 +62,17 @@ io_thread_rx_handler(io_thread_s *thread, io_handle_s *io)
 
     io->stats.packets++;
     io->stats.bytes += io->buf_len;
+    thread->event.busy = true;
     if(likely(packet_is_bbl(io->buf, io->buf_len))) {
         /** Process */
-        decode_result = decode_ethernet(io->buf, io->buf_len, thread->sp, SCRATCHPAD_LEN, &eth);
+        decode_result = decode_ethernet_fast(io->buf, io->buf_len, thread->sp, SCRATCHPAD_LEN, &eth);
         if(decode_result == PROTOCOL_SUCCESS) {
             eth->timestamp.tv_sec = io->timestamp.tv_sec;
             eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+            eth->timestamp_source = io->timestamp_source;
 
             vlan = io->vlan_tci & BBL_ETH_VLAN_ID_MAX;
-            if(eth->vlan_outer != vlan) {
+            if(vlan && eth->vlan_outer != vlan) {
                 /* The outer VLAN is stripped from header */
                 eth->vlan_inner = eth->vlan_outer;
                 eth->vlan_inner_priority = eth->vlan_outer_priority;
@@ -106,17 +108,21 @@ io_thread_main_rx_job(timer_s *timer)
     io_handle_s *io = interface->io.rx;
     io_thread_s *thread;
 
+    bbl_txq_slot_t *slots[BBL_TXQ_BATCH];
     bbl_txq_slot_t *slot;
     bbl_ethernet_header_s *eth;
     uint16_t vlan;
+    uint16_t count;
+    uint16_t i;
 
     protocol_error_t decode_result;
     bool pcap = false;
     while(io) {
         thread = io->thread;
-        if(thread) {
-            while((slot = bbl_txq_read_slot(thread->txq))) {
-                decode_result = decode_ethernet(slot->packet, slot->packet_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
+        while(thread && (count = bbl_txq_peek(thread->txq, slots, BBL_TXQ_BATCH))) {
+            for(i = 0; i < count; i++) {
+                slot = slots[i];
+                decode_result = decode_ethernet(slot->packet, slot->packet_len, interface->io.sp, SCRATCHPAD_LEN, &eth);
                 if(decode_result == PROTOCOL_SUCCESS) {
                     vlan = slot->vlan_tci & BBL_ETH_VLAN_ID_MAX;
                     if(vlan && eth->vlan_outer != vlan) {
@@ -144,8 +150,8 @@ io_thread_main_rx_job(timer_s *timer)
                     pcapng_push_packet_header(&slot->timestamp, slot->packet, slot->packet_len,
                                               interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
                 }
-                bbl_txq_read_next(thread->txq);
             }
+            bbl_txq_release(thread->txq, count);
         }
         io = io->next;
     }
@@ -166,6 +172,7 @@ io_thread_main_tx_job(timer_s *timer)
     io_thread_s *thread = io->thread;
     bbl_txq_s *txq = thread->txq;
     bbl_txq_slot_t *slot;
+    uint16_t count = 0;
 
     protocol_error_t tx_result = IGNORED;
 
@@ -183,16 +190,166 @@ io_thread_main_tx_job(timer_s *timer)
                 pcapng_push_packet_header(&timestamp, slot->packet, slot->packet_len,
                                           interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
             }
-            bbl_txq_write_next(txq);
+            bbl_txq_reserve_next(txq);
+            /* Pass packets in batches to the TX thread. */
+            if(++count == BBL_TXQ_BATCH) {
+                bbl_txq_commit(txq);
+                count = 0;
+            }
         } else if(tx_result == EMPTY) {
             break;
         }
     }
+    if(count) {
+        bbl_txq_commit(txq);
+    }
     if(pcap) {
         pcapng_fflush();
     }
 }
 
+/**
+ * Init thread event loop with epoll instance and
+ * timerfd. The packet socket of RX threads is added
+ * to the epoll instance for PACKET_MMAP and RAW only.
+ *
+ * @param thread thread handle
+ * @return true if successful
+ */
+static bool
+io_thread_event_init(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+    struct epoll_event event = {0};
+
+    thread->event.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(thread->event.epoll_fd < 0) {
+        return false;
+    }
+    thread->event.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC);
+    if(thread->event.timer_fd < 0) {
+        close(thread->event.epoll_fd);
+        return false;
+    }
+    event.events = EPOLLIN;
+    event.data.fd = thread->event.timer_fd;
+    if(epoll_ctl(thread->event.epoll_fd, EPOLL_CTL_ADD, thread->event.timer_fd, &event) < 0) {
+        goto ERROR;
+    }
+    if(io->direction == IO_INGRESS && 
+       (io->mode == IO_MODE_PACKET_MMAP || io->mode == IO_MODE_RAW)) {
+        event.events = EPOLLIN;
+        event.data.fd = io->fd;
+        if(epoll_ctl(thread->event.epoll_fd, EPOLL_CTL_ADD, io->fd, &event) < 0) {
+            goto ERROR;
+        }
+    }
+    return true;
+ERROR:
+    close(thread->event.timer_fd);
+    close(thread->event.epoll_fd);
+    return false;
+}
+
+/**
+ * Wait for the next event (packet socket or timerfd)
+ * or until the event timeout expired.
+ *
+ * @param thread thread handle
+ */
+static void
+io_thread_event_wait(io_thread_s *thread)
+{
+    struct epoll_event events[IO_THREAD_EVENTS];
+    uint64_t expirations;
+    int i, n;
+
+    thread->io->stats.polled++;
+    n = epoll_wait(thread->event.epoll_fd, events, IO_THREAD_EVENTS, IO_THREAD_EVENT_TIMEOUT);
+    for(i = 0; i < n; i++) {
+        if(events[i].data.fd == thread->event.timer_fd) {
+            if(read(thread->event.timer_fd, &expirations, sizeof(expirations)) < 0) {
+                continue;
+            }
+        }
+    }
+}
+
+/**
+ * RX threads call this function if there are no 
+ * packets to be received. 
+ * 
+ * With event loop enabled, the thread keeps polling 
+ * for up to busy poll time after the last received
+ * packet and then waits for the packet socket to 
+ * become readable. Otherwise the thread sleeps 
+ * for the given time. 
+ *
+ * @param thread thread handle
+ * @param nsec sleep time without event loop
+ */
+void
+io_thread_rx_wait(io_thread_s *thread, long nsec)
+{
+    struct timespec sleep, rem, now, idle;
+
+    if(!thread->event.enabled) {
+        sleep.tv_sec = 0;
+        sleep.tv_nsec = nsec;
+        nanosleep(&sleep, &rem);
+        return;
+    }
+    if(thread->event.busy_poll) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if(thread->event.busy) {
+            thread->event.busy = false;
+            thread->event.idle.tv_sec = now.tv_sec;
+            thread->event.idle.tv_nsec = now.tv_nsec;
+        }
+        timespec_sub(&idle, &now, &thread->event.idle);
+        if(idle.tv_sec == 0 && (uint64_t)idle.tv_nsec < thread->event.busy_poll) {
+            return;
+        }
+    }
+    thread->event.busy = false;
+    io_thread_event_wait(thread);
+}
+
+/**
+ * Event loop for timer based threads (TX), waiting
+ * for the next timer to expire using timerfd. The 
+ * thread keeps polling if the next timer expires 
+ * within the busy poll time. 
+ *
+ * @param thread thread handle
+ */
+static void
+io_thread_event_loop(io_thread_s *thread)
+{
+    struct itimerspec timer = {0};
+    struct timespec now, next, wait;
+
+    while(thread->active) {
+        timer_process(&thread->timer.root, &next);
+        if(next.tv_sec == 0 && next.tv_nsec == 0) {
+            io_thread_event_wait(thread);
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timespec_sub(&wait, &next, &now);
+        /* Next timer expired or expires within busy poll time. */
+        if(wait.tv_sec == 0 && (uint64_t)wait.tv_nsec <= thread->event.busy_poll) {
+            continue;
+        }
+        timer.it_value.tv_sec = next.tv_sec;
+        timer.it_value.tv_nsec = next.tv_nsec;
+        if(timerfd_settime(thread->event.timer_fd, TFD_TIMER_ABSTIME, &timer, NULL) < 0) {
+            continue;
+        }
+        io_thread_event_wait(thread);
+    }
+}
+
 void *
 io_thread_main(void *thread_data)
 {
@@ -200,12 +357,21 @@ io_thread_main(void *thread_data)
     if(thread->setup_fn) {
         (*thread->setup_fn)(thread);
     }
+    if(thread->event.enabled && !io_thread_event_init(thread)) {
+        LOG(ERROR, "Failed to init event loop for interface %s (%s)\n", 
+            thread->io->interface->name, strerror(errno));
+        thread->event.enabled = false;
+    }
     if(thread->run_fn) {
         (*thread->run_fn)(thread);
     }
     if(thread->teardown_fn) {
         (*thread->teardown_fn)(thread);
     }
+    if(thread->event.enabled) {
+        close(thread->event.timer_fd);
+        close(thread->event.epoll_fd);
+    }
     thread->active = false;
     thread->stopped = true;
     return NULL;
@@ -217,6 +383,10 @@ io_thread_timer_loop(io_thread_s *thread)
     pthread_mutex_lock(&thread->mutex);
     timer_smear_all_buckets(&thread->timer.root);
     pthread_mutex_unlock(&thread->mutex);
+    if(thread->event.enabled) {
+        io_thread_event_loop(thread);
+        return;
+    }
     while(thread->active) {
         timer_walk(&thread->timer.root);
     }
@@ -268,6 +438,10 @@ io_thread_init(io_handle_s *io)
     /* Default run function which might be overwritten */
     thread->run_fn = io_thread_timer_loop;
 
+    /* Event loop with optional busy poll */
+    thread->event.enabled = config->io_event_loop;
+    thread->event.busy_poll = config->io_busy_poll * 1000;
+
     /* Add thread main loop timers/jobs */
     if(io->direction == IO_INGRESS && !interface->io.rx_job) {
         /** Start job reading from RX thread TXQ */
@@ -9,6 +9,9 @@
 #ifndef __BBL_IO_THREAD_H__
 #define __BBL_IO_THREAD_H__
 
+#define IO_THREAD_EVENTS            8
+#define IO_THREAD_EVENT_TIMEOUT     100 /* msec */
+
 bool
 io_thread_init(io_handle_s *io);
 
@@ -21,4 +24,7 @@ io_thread_stop_all();
 io_result_t
 io_thread_rx_handler(io_thread_s *thread, io_handle_s *io);
 
+void
+io_thread_rx_wait(io_thread_s *thread, long nsec);
+
 #endif
\ No newline at end of file
@@ -12,6 +12,9 @@ uint8_t g_isis_mac_p2p_hello[] = {0x09, 0x00, 0x2b, 0x00, 0x00, 0x05};
 uint8_t g_isis_mac_all_l1[] = {0x01, 0x80, 0xc2, 0x00, 0x00, 0x14};
 uint8_t g_isis_mac_all_l2[] = {0x01, 0x80, 0xc2, 0x00, 0x00, 0x15};
 
+/* LSP PDU storage */
+slab_s g_isis_pdu_slab = {0};
+
 int
 isis_lsp_id_compare(void *id1, void *id2)
 {
@@ -53,6 +56,10 @@ isis_init() {
     isis_instance_s *instance = NULL;
     uint8_t level;
 
+    if(config && !slab_init(&g_isis_pdu_slab, ISIS_MAX_PDU_LEN)) {
+        return false;
+    }
+
     while(config) {
         LOG(ISIS, "Init IS-IS instance %u\n", config->id);
         if(instance) {
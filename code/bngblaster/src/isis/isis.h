@@ -24,6 +24,7 @@
 extern uint8_t g_isis_mac_p2p_hello[];
 extern uint8_t g_isis_mac_all_l1[];
 extern uint8_t g_isis_mac_all_l2[];
+extern slab_s g_isis_pdu_slab;
 
 int
 isis_lsp_id_compare(void *id1, void *id2);
@@ -70,6 +70,8 @@ isis_adjacency_init(bbl_network_interface_s *interface,
 
         adjacency->flood_tree = hb_tree_new((dict_compare_func)isis_lsp_id_compare);
         adjacency->psnp_tree = hb_tree_new((dict_compare_func)isis_lsp_id_compare);
+        CIRCLEQ_INIT(&adjacency->flood_tx_qhead);
+        CIRCLEQ_INIT(&adjacency->flood_retry_qhead);
         adjacency->level = level;
         adjacency->window_size = config->lsp_tx_window_size;
         if(level == ISIS_LEVEL_1) {
@@ -106,7 +108,7 @@ isis_adjacency_up(isis_adjacency_s *adjacency)
         "ISIS TX", 0, config->lsp_tx_interval * MSEC, adjacency, &isis_lsp_tx_job);
 
     timer_add_periodic(&g_ctx->timer_root, &adjacency->timer_retry, 
-        "ISIS RETRY", config->lsp_retry_interval, 0, adjacency, &isis_lsp_retry_job);
+        "ISIS RETRY", 1, 0, adjacency, &isis_lsp_retry_job);
 
     timer_add_periodic(&g_ctx->timer_root, &adjacency->timer_csnp, 
         "ISIS CSNP", config->csnp_interval, 0, adjacency, &isis_csnp_job);
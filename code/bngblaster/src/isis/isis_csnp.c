@@ -30,6 +30,7 @@ isis_csnp_job(timer_s *timer)
     int entries = 0;
 
     isis_pdu_s pdu = {0};
+    uint8_t pdu_buf[ISIS_MAX_PDU_LEN];
     uint8_t level = adjacency->level;
     uint16_t remaining_lifetime;
 
@@ -45,13 +46,13 @@ isis_csnp_job(timer_s *timer)
 
     /* Build PDU */
     if(level == ISIS_LEVEL_1) {
-        isis_pdu_init(&pdu, ISIS_PDU_L1_CSNP);
+        isis_pdu_init(&pdu, ISIS_PDU_L1_CSNP, pdu_buf, sizeof(pdu_buf));
         if(config->level1_auth_csnp) {
             auth = config->level1_auth;
             key = config->level1_key;
         }
     } else {
-        isis_pdu_init(&pdu, ISIS_PDU_L2_CSNP);
+        isis_pdu_init(&pdu, ISIS_PDU_L2_CSNP, pdu_buf, sizeof(pdu_buf));
         if(config->level2_auth_csnp) {
             auth = config->level2_auth;
             key = config->level2_key;
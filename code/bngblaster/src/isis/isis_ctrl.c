@@ -57,6 +57,11 @@ isis_ctrl_adjacency(isis_adjacency_s *adjacency)
         json_object_set(stats, "l1-psnp-tx", json_integer(adjacency->stats.psnp_tx));
         json_object_set(stats, "l1-lsp-rx", json_integer(adjacency->stats.lsp_rx));
         json_object_set(stats, "l1-lsp-tx", json_integer(adjacency->stats.lsp_tx));
+        json_object_set(stats, "l1-lsp-tx-retry", json_integer(adjacency->stats.lsp_tx_retry));
+        json_object_set(stats, "l1-lsp-tx-rate", json_integer(adjacency->stats.lsp_tx_rate));
+        json_object_set(stats, "l1-flood-pending", json_integer(adjacency->flood_tx_count));
+        json_object_set(stats, "l1-flood-wait-ack", json_integer(adjacency->flood_retry_count));
+        json_object_set(stats, "l1-flood-convergence-ms", json_integer(adjacency->stats.flood_convergence_ms));
     } else {
         json_object_set(stats, "l2-hello-rx", json_integer(adjacency->stats.hello_rx));
         json_object_set(stats, "l2-hello-tx", json_integer(adjacency->stats.hello_tx));
@@ -66,6 +71,11 @@ isis_ctrl_adjacency(isis_adjacency_s *adjacency)
         json_object_set(stats, "l2-psnp-tx", json_integer(adjacency->stats.psnp_tx));
         json_object_set(stats, "l2-lsp-rx", json_integer(adjacency->stats.lsp_rx));
         json_object_set(stats, "l2-lsp-tx", json_integer(adjacency->stats.lsp_tx));
+        json_object_set(stats, "l2-lsp-tx-retry", json_integer(adjacency->stats.lsp_tx_retry));
+        json_object_set(stats, "l2-lsp-tx-rate", json_integer(adjacency->stats.lsp_tx_rate));
+        json_object_set(stats, "l2-flood-pending", json_integer(adjacency->flood_tx_count));
+        json_object_set(stats, "l2-flood-wait-ack", json_integer(adjacency->flood_retry_count));
+        json_object_set(stats, "l2-flood-convergence-ms", json_integer(adjacency->stats.flood_convergence_ms));
     }
 
     peer = json_pack("{ss si}",
@@ -113,6 +123,11 @@ isis_ctrl_adjacency_p2p(bbl_network_interface_s *network_interface)
         json_object_set(stats, "l1-psnp-tx", json_integer(adjacency->stats.psnp_tx));
         json_object_set(stats, "l1-lsp-rx", json_integer(adjacency->stats.lsp_rx));
         json_object_set(stats, "l1-lsp-tx", json_integer(adjacency->stats.lsp_tx));
+        json_object_set(stats, "l1-lsp-tx-retry", json_integer(adjacency->stats.lsp_tx_retry));
+        json_object_set(stats, "l1-lsp-tx-rate", json_integer(adjacency->stats.lsp_tx_rate));
+        json_object_set(stats, "l1-flood-pending", json_integer(adjacency->flood_tx_count));
+        json_object_set(stats, "l1-flood-wait-ack", json_integer(adjacency->flood_retry_count));
+        json_object_set(stats, "l1-flood-convergence-ms", json_integer(adjacency->stats.flood_convergence_ms));
     } 
     if(p2p_adjacency->level & ISIS_LEVEL_2) {
         adjacency = network_interface->isis_adjacency[ISIS_LEVEL_2_IDX];
@@ -122,6 +137,11 @@ isis_ctrl_adjacency_p2p(bbl_network_interface_s *network_interface)
         json_object_set(stats, "l2-psnp-tx", json_integer(adjacency->stats.psnp_tx));
         json_object_set(stats, "l2-lsp-rx", json_integer(adjacency->stats.lsp_rx));
         json_object_set(stats, "l2-lsp-tx", json_integer(adjacency->stats.lsp_tx));
+        json_object_set(stats, "l2-lsp-tx-retry", json_integer(adjacency->stats.lsp_tx_retry));
+        json_object_set(stats, "l2-lsp-tx-rate", json_integer(adjacency->stats.lsp_tx_rate));
+        json_object_set(stats, "l2-flood-pending", json_integer(adjacency->flood_tx_count));
+        json_object_set(stats, "l2-flood-wait-ack", json_integer(adjacency->flood_retry_count));
+        json_object_set(stats, "l2-flood-convergence-ms", json_integer(adjacency->stats.flood_convergence_ms));
     }
 
     peer = json_pack("{ss si}",
@@ -306,17 +326,41 @@ isis_ctrl_load_mrt(int fd, uint32_t session_id __attribute__((unused)), json_t *
     return bbl_ctrl_status(fd, "ok", 200, NULL);
 }
 
+/**
+ * isis_ctrl_lsp_load
+ *
+ * Decode a single raw ISIS PDU and
+ * update the corresponding external LSP.
+ *
+ * @param instance ISIS instance
+ * @param buf raw PDU
+ * @param len PDU length
+ * @return NULL on success or error message
+ */
+static const char *
+isis_ctrl_lsp_load(isis_instance_s *instance, uint8_t *buf, uint16_t len)
+{
+    isis_pdu_s pdu = {0};
+
+    if(len > ISIS_MAX_PDU_LEN ||
+       isis_pdu_load(&pdu, buf, len) != PROTOCOL_SUCCESS) {
+        return "failed to decode ISIS PDU";
+    }
+    /* Update external LSP */
+    if(!isis_lsp_update_external(instance, &pdu, false)) {
+        return "failed to update ISIS LSP";
+    }
+    return NULL;
+}
+
 int
 isis_ctrl_lsp_update(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
 {
-    protocol_error_t result;
-
     json_t *value;
     size_t pdu_count;
 
-
-    isis_pdu_s pdu = {0};
     const char *pdu_string;
+    const char *error;
     uint16_t pdu_string_len;
 
     uint8_t buf[ISIS_MAX_PDU_LEN];
@@ -338,17 +382,16 @@ isis_ctrl_lsp_update(int fd, uint32_t session_id __attribute__((unused)), json_t
                 return bbl_ctrl_status(fd, "error", 500, "failed to read ISIS PDU");
             }
             pdu_string_len = strlen(pdu_string);
+            if(pdu_string_len/2 > ISIS_MAX_PDU_LEN) {
+                return bbl_ctrl_status(fd, "error", 500, "failed to decode ISIS PDU");
+            }
             /* Load PDU from hexstring */
             for (len = 0; len < (pdu_string_len/2); len++) {
                 sscanf(pdu_string + len*2, "%02hhx", &buf[len]);
             }
-            result = isis_pdu_load(&pdu, (uint8_t*)buf, len);
-            if(result != PROTOCOL_SUCCESS) {
-                return bbl_ctrl_status(fd, "error", 500, "failed to decode ISIS PDU");
-            }
-            /* Update external LSP */
-            if(!isis_lsp_update_external(instance, &pdu, false)) {
-                return bbl_ctrl_status(fd, "error", 500, "failed to update ISIS LSP");
+            error = isis_ctrl_lsp_load(instance, buf, len);
+            if(error) {
+                return bbl_ctrl_status(fd, "error", 500, error);
             }
         }
     } else {
@@ -357,6 +400,30 @@ isis_ctrl_lsp_update(int fd, uint32_t session_id __attribute__((unused)), json_t
     return bbl_ctrl_status(fd, "ok", 200, NULL);
 }
 
+/**
+ * isis_ctrl_lsp_stream
+ *
+ * Update a single external LSP received
+ * via binary PDU stream (isis-lsp-stream).
+ *
+ * @param instance_id ISIS instance identifier
+ * @param buf raw PDU
+ * @param len PDU length
+ * @return true if LSP was updated successfully
+ */
+bool
+isis_ctrl_lsp_stream(int instance_id, uint8_t *buf, uint16_t len)
+{
+    isis_instance_s *instance = g_ctx->isis_instances;
+    while(instance) {
+        if(instance->config->id == instance_id) {
+            return isis_ctrl_lsp_load(instance, buf, len) == NULL;
+        }
+        instance = instance->next;
+    }
+    return false;
+}
+
 int
 isis_ctrl_lsp_purge(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
 {
@@ -21,6 +21,9 @@ isis_ctrl_load_mrt(int fd, uint32_t session_id __attribute__((unused)), json_t *
 int
 isis_ctrl_lsp_update(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
 
+bool
+isis_ctrl_lsp_stream(int instance_id, uint8_t *buf, uint16_t len);
+
 int
 isis_ctrl_lsp_purge(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
 
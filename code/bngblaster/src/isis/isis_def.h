@@ -268,6 +268,15 @@ typedef struct isis_adjacency_ {
     hb_tree         *flood_tree;
     hb_tree         *psnp_tree;
 
+    /* Flood tree entries are either queued for
+     * transmission (FIFO) or waiting for ack,
+     * ordered by transmission time. */
+    CIRCLEQ_HEAD(flood_tx_, isis_flood_entry_) flood_tx_qhead;
+    CIRCLEQ_HEAD(flood_retry_, isis_flood_entry_) flood_retry_qhead;
+    uint32_t flood_tx_count;
+    uint32_t flood_retry_count;
+    struct timespec flood_start;
+
     struct timer_   *timer_tx;
     struct timer_   *timer_retry;
     struct timer_   *timer_csnp;
@@ -293,6 +302,10 @@ typedef struct isis_adjacency_ {
         uint32_t psnp_tx;
         uint32_t lsp_rx;
         uint32_t lsp_tx;
+        uint32_t lsp_tx_retry;
+        uint32_t lsp_tx_rate; /* LSP per second */
+        uint32_t lsp_tx_last;
+        uint32_t flood_convergence_ms; /* Last flooding convergence time */
     } stats;
 
 } isis_adjacency_s;
@@ -320,6 +333,8 @@ typedef struct isis_instance_ {
     struct timer_  *timer_teardown;
     struct timer_  *timer_lsp_gc;
 
+    uint16_t        mrt_refresh_interval;
+
     struct {
         hb_tree *lsdb;
         isis_adjacency_s *adjacency;
@@ -341,8 +356,9 @@ typedef struct isis_pdu_ {
 
     uint16_t cur; /* current position */
 
-    uint8_t  pdu[ISIS_MAX_PDU_LEN];
+    uint8_t *pdu;
     uint16_t pdu_len;
+    uint16_t pdu_buf_len;
 } isis_pdu_s;
 
 typedef struct isis_lsp_ {
@@ -383,6 +399,7 @@ typedef struct isis_flood_entry_ {
     bool            wait_ack;
     uint32_t        tx_count;
     struct timespec tx_timestamp;
+    CIRCLEQ_ENTRY(isis_flood_entry_) flood_qnode; /* TX or retry queue */
 } isis_flood_entry_s;
 
 typedef struct isis_lsp_flap_ {
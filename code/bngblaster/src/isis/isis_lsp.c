@@ -8,6 +8,103 @@
  */
 #include "isis.h"
 
+/**
+ * isis_lsp_pdu_free
+ * 
+ * @param pdu PDU stored in slab
+ */
+static void
+isis_lsp_pdu_free(isis_pdu_s *pdu)
+{
+    if(pdu->pdu) {
+        slab_free(&g_isis_pdu_slab, pdu->pdu, pdu->pdu_buf_len);
+        pdu->pdu = NULL;
+        pdu->pdu_buf_len = 0;
+    }
+}
+
+/**
+ * isis_lsp_pdu_alloc
+ * 
+ * This function ensures that the PDU buffer 
+ * has the size class required for the given 
+ * length. PDU's are stored in a slab allocator 
+ * at their real length rounded up to the next 
+ * size class. 
+ * 
+ * @param pdu PDU
+ * @param len required length
+ * @return true (success) / false (error)
+ */
+static bool
+isis_lsp_pdu_alloc(isis_pdu_s *pdu, uint16_t len)
+{
+    uint32_t size = slab_size(&g_isis_pdu_slab, len);
+    uint8_t *buf;
+
+    if(pdu->pdu && slab_size(&g_isis_pdu_slab, pdu->pdu_buf_len) == size) {
+        return true;
+    }
+    buf = slab_alloc(&g_isis_pdu_slab, size);
+    if(!buf) {
+        LOG_NOARG(ERROR, "Failed to allocate ISIS PDU\n");
+        return false;
+    }
+    isis_lsp_pdu_free(pdu);
+    pdu->pdu = buf;
+    pdu->pdu_buf_len = size;
+    return true;
+}
+
+/**
+ * isis_lsp_pdu_copy
+ * 
+ * @param dst PDU stored in slab
+ * @param src PDU
+ * @return true (success) / false (error)
+ */
+static bool
+isis_lsp_pdu_copy(isis_pdu_s *dst, isis_pdu_s *src)
+{
+    uint8_t *buf;
+    uint16_t buf_len;
+
+    if(!isis_lsp_pdu_alloc(dst, src->pdu_len)) {
+        return false;
+    }
+    buf = dst->pdu;
+    buf_len = dst->pdu_buf_len;
+    memcpy(dst, src, sizeof(isis_pdu_s));
+    memcpy(buf, src->pdu, src->pdu_len);
+    dst->pdu = buf;
+    dst->pdu_buf_len = buf_len;
+    ISIS_PDU_CURSOR_RST(dst);
+    return true;
+}
+
+/**
+ * isis_lsp_pdu_store
+ * 
+ * This function stores a copy of the 
+ * given PDU at its real length in the LSP.
+ * 
+ * @param lsp LSP
+ * @param pdu PDU
+ * @return true (success) / false (error)
+ */
+bool
+isis_lsp_pdu_store(isis_lsp_s *lsp, isis_pdu_s *pdu)
+{
+    return isis_lsp_pdu_copy(&lsp->pdu, pdu);
+}
+
+void
+isis_lsp_free(isis_lsp_s *lsp)
+{
+    isis_lsp_pdu_free(&lsp->pdu);
+    free(lsp);
+}
+
 /**
  * isis_lsp_gc_job 
  * 
@@ -56,13 +153,51 @@ isis_lsp_gc_job(timer_s *timer)
             for(size_t i=0; i < delete_list_len; i++) {
                 removed = hb_tree_remove(lsdb, &delete_list[i]);
                 if(removed.removed) {
-                    free(removed.datum);
+                    isis_lsp_free(removed.datum);
                 }
             }
         }
     }
 }
 
+/**
+ * isis_lsp_flood_dequeue
+ *
+ * This function removes a flood entry
+ * from the TX or retry queue.
+ *
+ * @param adjacency ISIS adjacency
+ * @param entry flood entry
+ */
+static void
+isis_lsp_flood_dequeue(isis_adjacency_s *adjacency, isis_flood_entry_s *entry)
+{
+    if(entry->wait_ack) {
+        CIRCLEQ_REMOVE(&adjacency->flood_retry_qhead, entry, flood_qnode);
+        adjacency->flood_retry_count--;
+    } else {
+        CIRCLEQ_REMOVE(&adjacency->flood_tx_qhead, entry, flood_qnode);
+        adjacency->flood_tx_count--;
+    }
+}
+
+/**
+ * isis_lsp_flood_enqueue
+ *
+ * This function adds a flood entry
+ * to the end of the TX queue.
+ *
+ * @param adjacency ISIS adjacency
+ * @param entry flood entry
+ */
+static void
+isis_lsp_flood_enqueue(isis_adjacency_s *adjacency, isis_flood_entry_s *entry)
+{
+    entry->wait_ack = false;
+    CIRCLEQ_INSERT_TAIL(&adjacency->flood_tx_qhead, entry, flood_qnode);
+    adjacency->flood_tx_count++;
+}
+
 /**
  * isis_lsp_flood_adjacency 
  * 
@@ -83,7 +218,11 @@ isis_lsp_flood_adjacency(isis_lsp_s *lsp, isis_adjacency_s *adjacency)
     search = hb_tree_search(adjacency->flood_tree, &lsp->id);
     if(search) {
         flood = *search;
-        flood->wait_ack = false;
+        if(flood->wait_ack) {
+            /* Move from retry to TX queue. */
+            isis_lsp_flood_dequeue(adjacency, flood);
+            isis_lsp_flood_enqueue(adjacency, flood);
+        }
         flood->tx_count = 0;
     } else {
         result = hb_tree_insert(adjacency->flood_tree,  &lsp->id);
@@ -92,12 +231,47 @@ isis_lsp_flood_adjacency(isis_lsp_s *lsp, isis_adjacency_s *adjacency)
             flood->lsp = lsp;
             *result.datum_ptr = flood;
             lsp->refcount++;
+            if(!(adjacency->flood_tx_count || adjacency->flood_retry_count)) {
+                clock_gettime(CLOCK_MONOTONIC, &adjacency->flood_start);
+            }
+            isis_lsp_flood_enqueue(adjacency, flood);
         } else {
             LOG_NOARG(ISIS, "Failed to add LSP to flood-tree\n");
         }
     }
 }
 
+/**
+ * isis_lsp_flood_ack
+ *
+ * This function removes an acknowledged flood 
+ * entry from the TX or retry queue and updates 
+ * the flooding convergence time if this was 
+ * the last entry.
+ *
+ * @param adjacency ISIS adjacency
+ * @param entry flood entry
+ */
+static void
+isis_lsp_flood_ack(isis_adjacency_s *adjacency, isis_flood_entry_s *entry)
+{
+    struct timespec now;
+    struct timespec time_diff;
+
+    isis_lsp_flood_dequeue(adjacency, entry);
+    if(adjacency->flood_tx_count || adjacency->flood_retry_count) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    timespec_sub(&time_diff, &now, &adjacency->flood_start);
+    adjacency->stats.flood_convergence_ms = time_diff.tv_sec * 1000 + time_diff.tv_nsec / 1000000;
+
+    LOG(ISIS, "ISIS %s flooding on interface %s converged in %ums\n", 
+        isis_level_string(adjacency->level), 
+        adjacency->interface->name,
+        adjacency->stats.flood_convergence_ms);
+}
+
 /**
  * isis_lsp_flood 
  * 
@@ -188,6 +362,7 @@ isis_lsp_process_entries(isis_adjacency_s *adjacency, hb_tree *lsdb, isis_pdu_s
                         /* Ack LSP by removing them from flood tree. */
                         removed = hb_tree_remove(adjacency->flood_tree, &lsp->id);
                         if(removed.removed) {
+                            isis_lsp_flood_ack(adjacency, removed.datum);
                             assert(lsp->refcount);
                             if(lsp->refcount) lsp->refcount--;
                             free(removed.datum);
@@ -201,14 +376,22 @@ isis_lsp_process_entries(isis_adjacency_s *adjacency, hb_tree *lsdb, isis_pdu_s
 }
 
 
+/**
+ * isis_lsp_retry_job 
+ * 
+ * This job is executed every second to move 
+ * all LSP not acknowledged within the retry 
+ * interval back to the TX queue. The retry 
+ * queue is ordered by transmission time, so 
+ * only expired entries are visited. 
+ * 
+ * @param timer time
+ */
 void
 isis_lsp_retry_job(timer_s *timer)
 {
     isis_adjacency_s *adjacency = timer->data;
-
     isis_flood_entry_s *entry;
-    hb_itor *itor;
-    bool next;
 
     uint16_t lsp_retry_interval = adjacency->instance->config->lsp_retry_interval;
 
@@ -216,20 +399,19 @@ isis_lsp_retry_job(timer_s *timer)
     struct timespec ago;
     clock_gettime(CLOCK_MONOTONIC, &now);
 
-    itor = hb_itor_new(adjacency->flood_tree);
-    next = hb_itor_first(itor);
-    while(next) {
-        entry = *hb_itor_datum(itor);
-        if(entry->wait_ack) {
-            timespec_sub(&ago, &now, &entry->tx_timestamp);
-            if(ago.tv_sec > lsp_retry_interval) {
-                entry->wait_ack = false;
-            }
-        } else {
+    while(!CIRCLEQ_EMPTY(&adjacency->flood_retry_qhead)) {
+        entry = CIRCLEQ_FIRST(&adjacency->flood_retry_qhead);
+        timespec_sub(&ago, &now, &entry->tx_timestamp);
+        if(ago.tv_sec < lsp_retry_interval) {
             break;
         }
-        next = hb_itor_next(itor);
+        isis_lsp_flood_dequeue(adjacency, entry);
+        isis_lsp_flood_enqueue(adjacency, entry);
     }
+
+    /* Flooding rate (LSP per second) */
+    adjacency->stats.lsp_tx_rate = adjacency->stats.lsp_tx - adjacency->stats.lsp_tx_last;
+    adjacency->stats.lsp_tx_last = adjacency->stats.lsp_tx;
 }
 
 void
@@ -308,8 +490,6 @@ isis_lsp_tx_job(timer_s *timer)
     isis_adjacency_s *adjacency = timer->data;
     isis_flood_entry_s *entry;
     isis_lsp_s *lsp;
-    hb_itor *itor;
-    bool next;
     uint16_t window = adjacency->window_size;
 
     bbl_ethernet_header_s eth = {0};
@@ -333,43 +513,45 @@ isis_lsp_tx_job(timer_s *timer)
         isis.type = ISIS_PDU_L2_LSP;
     }
     
-    itor = hb_itor_new(adjacency->flood_tree);
-    next = hb_itor_first(itor);
-    while(next) {
-        entry = *hb_itor_datum(itor);
-        if(!entry->wait_ack) {
-            lsp = entry->lsp;
-
-            LOG(PACKET, "ISIS TX %s-LSP %s (seq %u) on interface %s\n", 
-                isis_level_string(adjacency->level), 
-                isis_lsp_id_to_str(&lsp->id), 
-                lsp->seq,
-                adjacency->interface->name);
-
-            /* Update lifetime */
-            timespec_sub(&ago, &now, &lsp->timestamp);
-            if(ago.tv_sec < lsp->lifetime) {
-                remaining_lifetime = lsp->lifetime - ago.tv_sec;
-            }
-            isis_pdu_update_lifetime(&lsp->pdu, remaining_lifetime);
+    /* Send LSP from the head of the TX queue
+     * and move them to the end of the retry queue. */
+    while(!CIRCLEQ_EMPTY(&adjacency->flood_tx_qhead)) {
+        entry = CIRCLEQ_FIRST(&adjacency->flood_tx_qhead);
+        lsp = entry->lsp;
+
+        LOG(PACKET, "ISIS TX %s-LSP %s (seq %u) on interface %s\n", 
+            isis_level_string(adjacency->level), 
+            isis_lsp_id_to_str(&lsp->id), 
+            lsp->seq,
+            adjacency->interface->name);
+
+        /* Update lifetime */
+        timespec_sub(&ago, &now, &lsp->timestamp);
+        if(ago.tv_sec < lsp->lifetime) {
+            remaining_lifetime = lsp->lifetime - ago.tv_sec;
+        }
+        isis_pdu_update_lifetime(&lsp->pdu, remaining_lifetime);
 
-            isis.pdu = lsp->pdu.pdu;
-            isis.pdu_len = lsp->pdu.pdu_len;
-            if(bbl_txq_to_buffer(adjacency->interface->txq, &eth) != BBL_TXQ_OK) {
-                break;
-            }
-            entry->wait_ack = true;
-            entry->tx_count++;
-            entry->tx_timestamp.tv_sec = now.tv_sec;
-            entry->tx_timestamp.tv_nsec = now.tv_nsec;
-            adjacency->stats.lsp_tx++;
-            adjacency->interface->stats.isis_tx++;
-            if(window) window--;
-            if(window == 0) break;
+        isis.pdu = lsp->pdu.pdu;
+        isis.pdu_len = lsp->pdu.pdu_len;
+        if(bbl_txq_to_buffer(adjacency->interface->txq, &eth) != BBL_TXQ_OK) {
+            break;
         }
-        next = hb_itor_next(itor);
+        isis_lsp_flood_dequeue(adjacency, entry);
+        entry->wait_ack = true;
+        CIRCLEQ_INSERT_TAIL(&adjacency->flood_retry_qhead, entry, flood_qnode);
+        adjacency->flood_retry_count++;
+        if(entry->tx_count) {
+            adjacency->stats.lsp_tx_retry++;
+        }
+        entry->tx_count++;
+        entry->tx_timestamp.tv_sec = now.tv_sec;
+        entry->tx_timestamp.tv_nsec = now.tv_nsec;
+        adjacency->stats.lsp_tx++;
+        adjacency->interface->stats.isis_tx++;
+        if(window) window--;
+        if(window == 0) break;
     }
-    hb_itor_free(itor);
 }
 
 isis_lsp_s *
@@ -424,11 +606,16 @@ isis_lsp_fragment(isis_instance_s *instance, uint8_t level, uint8_t fragment, bo
     } else {
         /* Create new LSP. */
         lsp = isis_lsp_new(lsp_id, level, instance);
+        if(!isis_lsp_pdu_alloc(&lsp->pdu, ISIS_MAX_PDU_LEN)) {
+            isis_lsp_free(lsp);
+            return NULL;
+        }
         result = hb_tree_insert(lsdb,  &lsp->id);
         if(result.inserted) {
             *result.datum_ptr = lsp;
         } else {
             LOG_NOARG(ISIS, "Failed to add LSP to LSDB\n");
+            isis_lsp_free(lsp);
             return NULL;
         }
     }
@@ -456,12 +643,15 @@ isis_lsp_fragment(isis_instance_s *instance, uint8_t level, uint8_t fragment, bo
 
     /* Build PDU */
     pdu = &lsp->pdu;
+    if(!isis_lsp_pdu_alloc(pdu, ISIS_MAX_PDU_LEN)) {
+        return NULL;
+    }
     if(level == ISIS_LEVEL_1) {
-        isis_pdu_init(pdu, ISIS_PDU_L1_LSP);
+        isis_pdu_init(pdu, ISIS_PDU_L1_LSP, pdu->pdu, ISIS_MAX_PDU_LEN);
         auth_type = config->level1_auth;
         lsp->auth_key = config->level1_key;
     } else {
-        isis_pdu_init(pdu, ISIS_PDU_L2_LSP);
+        isis_pdu_init(pdu, ISIS_PDU_L2_LSP, pdu->pdu, ISIS_MAX_PDU_LEN);
         auth_type = config->level2_auth;
         lsp->auth_key = config->level2_key;
     }
@@ -696,11 +886,22 @@ isis_lsp_handler_rx(bbl_network_interface_s *interface, isis_pdu_s *pdu, uint8_t
     } else {
         /* Create new LSP. */
         lsp = isis_lsp_new(lsp_id, level, adjacency->instance);
+    }
+
+    /* The PDU is stored before a new LSP is added 
+     * to the LSDB, which ensures that all LSP in the
+     * LSDB have a valid PDU. */
+    if(!isis_lsp_pdu_store(lsp, pdu)) {
+        if(!search) isis_lsp_free(lsp);
+        return;
+    }
+    if(!search) {
         result = hb_tree_insert(lsdb,  &lsp->id);
         if(result.inserted) {
             *result.datum_ptr = lsp;
         } else {
             LOG_NOARG(ISIS, "Failed to add LSP to LSDB\n");
+            isis_lsp_free(lsp);
             return;
         }
     }
@@ -715,9 +916,6 @@ isis_lsp_handler_rx(bbl_network_interface_s *interface, isis_pdu_s *pdu, uint8_t
     lsp->instance = adjacency->instance;
     clock_gettime(CLOCK_MONOTONIC, &lsp->timestamp);
 
-    ISIS_PDU_CURSOR_RST(pdu);
-    memcpy(&lsp->pdu, pdu, sizeof(isis_pdu_s));
-
     isis_lsp_lifetime(lsp);
     isis_lsp_flood(lsp);
 
@@ -745,6 +943,8 @@ void
 isis_lsp_purge(isis_lsp_s *lsp)
 {
     isis_pdu_s *pdu;
+    isis_pdu_s purge_pdu = {0};
+    uint8_t purge_pdu_buf[ISIS_MAX_PDU_LEN];
     isis_auth_type auth_type = ISIS_AUTH_NONE;
 
     isis_config_s *config = lsp->instance->config;
@@ -759,13 +959,13 @@ isis_lsp_purge(isis_lsp_s *lsp)
     isis_lsp_lifetime(lsp);
 
     /* Build PDU */
-    pdu = &lsp->pdu;
+    pdu = &purge_pdu;
     if(lsp->level == ISIS_LEVEL_1) {
-        isis_pdu_init(pdu, ISIS_PDU_L1_LSP);
+        isis_pdu_init(pdu, ISIS_PDU_L1_LSP, purge_pdu_buf, sizeof(purge_pdu_buf));
         auth_type = config->level1_auth;
         lsp->auth_key = config->level1_key;
     } else {
-        isis_pdu_init(pdu, ISIS_PDU_L2_LSP);
+        isis_pdu_init(pdu, ISIS_PDU_L2_LSP, purge_pdu_buf, sizeof(purge_pdu_buf));
         auth_type = config->level2_auth;
         lsp->auth_key = config->level2_key;
     }
@@ -789,6 +989,10 @@ isis_lsp_purge(isis_lsp_s *lsp)
     *(uint16_t*)ISIS_PDU_OFFSET(pdu, ISIS_OFFSET_LSP_LIFETIME) = 0;
     *(uint16_t*)ISIS_PDU_OFFSET(pdu, ISIS_OFFSET_LSP_CHECKSUM) = 0;
 
+    /* Store PDU at its real length. */
+    if(!isis_lsp_pdu_store(lsp, pdu)) {
+        return;
+    }
     isis_lsp_flood(lsp);
 }
 
@@ -872,11 +1076,19 @@ isis_lsp_update_external(isis_instance_s *instance, isis_pdu_s *pdu, bool refres
     } else {
         /* Create new LSP. */
         lsp = isis_lsp_new(lsp_id, level, instance);
+    }
+
+    if(!isis_lsp_pdu_store(lsp, pdu)) {
+        if(!search) isis_lsp_free(lsp);
+        return false;
+    }
+    if(!search) {
         result = hb_tree_insert(lsdb,  &lsp->id);
         if(result.inserted) {
             *result.datum_ptr = lsp;
         } else {
             LOG_NOARG(ERROR, "Failed to add ISIS LSP to LSDB\n");
+            isis_lsp_free(lsp);
             return false;
         }
     }
@@ -891,9 +1103,6 @@ isis_lsp_update_external(isis_instance_s *instance, isis_pdu_s *pdu, bool refres
     lsp->instance = instance;
     clock_gettime(CLOCK_MONOTONIC, &lsp->timestamp);
 
-    ISIS_PDU_CURSOR_RST(pdu);
-    memcpy(&lsp->pdu, pdu, sizeof(isis_pdu_s));
-
     if(lsp->lifetime > 0 && instance->config->external_auto_refresh) {
         if(level == ISIS_LEVEL_1) {
             lsp->auth_key = instance->config->level1_key;
@@ -936,6 +1145,7 @@ isis_lsp_flap_job(timer_s *timer)
         if(!isis_lsp_update_external(flap->instance, &flap->pdu, true)) {
             LOG(ISIS, "Failed to flap ISIS LSP %s\n", isis_lsp_id_to_str(&flap->id));
         }
+        isis_lsp_pdu_free(&flap->pdu);
         flap->free = true;
     }
 }
@@ -975,15 +1185,22 @@ isis_lsp_flap(isis_lsp_s *lsp, time_t timer)
     }
     if(!flap) {
         flap = calloc(1, sizeof(isis_lsp_flap_s));
+        if(!flap) {
+            return false;
+        }
+        /* Remains free for reuse if the copy below fails. */
+        flap->free = true;
         flap->next = isis_lsp_flap;
         isis_lsp_flap = flap;
     }
 
+    if(!isis_lsp_pdu_copy(&flap->pdu, &lsp->pdu)) {
+        return false;
+    }
     flap->free = false;
     flap->timer = NULL;
     flap->id = lsp->id;
     flap->instance = lsp->instance;
-    memcpy(&flap->pdu, &lsp->pdu, sizeof(isis_pdu_s));
 
     timer_add(&g_ctx->timer_root, &flap->timer, "ISIS FLAP", timer, 0, flap, &isis_lsp_flap_job);
     isis_lsp_purge(lsp);
@@ -39,6 +39,12 @@ isis_lsp_tx_job(timer_s *timer);
 isis_lsp_s *
 isis_lsp_new(uint64_t id, uint8_t level, isis_instance_s *instance);
 
+bool
+isis_lsp_pdu_store(isis_lsp_s *lsp, isis_pdu_s *pdu);
+
+void
+isis_lsp_free(isis_lsp_s *lsp);
+
 bool
 isis_lsp_self_update(isis_instance_s *instance, uint8_t level);
 
@@ -8,15 +8,43 @@
  */
 #include "isis.h"
 
-bool
-isis_mrt_load(isis_instance_s *instance, char *file_path, bool startup)
+/**
+ * isis_mrt_validate
+ *
+ * Validate a single MRT record
+ * (executed in MRT worker threads).
+ */
+static bool
+isis_mrt_validate(void *instance __attribute__((unused)), 
+                  uint16_t type, uint16_t subtype, 
+                  uint8_t *buf, uint32_t len)
 {
-    FILE *mrt_file;
+    isis_pdu_s pdu;
+
+    if(!(type == ISIS_MRT_TYPE && 
+         subtype == 0 &&
+         len >= ISIS_HDR_LEN_COMMON &&
+         len <= ISIS_MAX_PDU_LEN)) {
+        return false;
+    }
+    return isis_pdu_load(&pdu, buf, len) == PROTOCOL_SUCCESS;
+}
 
-    isis_mrt_hdr_t mrt = {0};
+/**
+ * isis_mrt_commit
+ *
+ * Add or update a single LSP from 
+ * MRT record (executed in main thread).
+ */
+static bool
+isis_mrt_commit(void *instance_ptr, 
+                uint16_t type __attribute__((unused)), 
+                uint16_t subtype __attribute__((unused)), 
+                uint8_t *buf, uint32_t len)
+{
+    isis_instance_s *instance = instance_ptr;
     isis_pdu_s pdu = {0};
     uint8_t level;
-    uint8_t pdu_buf[ISIS_MAX_PDU_LEN];
 
     isis_lsp_s *lsp = NULL;
     uint64_t lsp_id;
@@ -27,123 +55,119 @@ isis_mrt_load(isis_instance_s *instance, char *file_path, bool startup)
     void **search = NULL;
     dict_insert_result result;
 
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
-
-    LOG(ISIS, "Load ISIS MRT file %s\n", file_path);
-
-    mrt_file = fopen(file_path, "r");
-    if(!mrt_file) {
-        LOG(ERROR, "Failed to open MRT file %s\n", file_path);
+    if(isis_pdu_load(&pdu, buf, len) != PROTOCOL_SUCCESS) {
         return false;
     }
+    switch(pdu.pdu_type) {
+        case ISIS_PDU_L1_LSP:
+            level = ISIS_LEVEL_1;
+            break;
+        case ISIS_PDU_L2_LSP:
+            level = ISIS_LEVEL_2;
+            break;
+        default:
+            LOG_NOARG(ERROR, "Skip record from ISIS MRT file\n");
+            return true;
+    }
 
-    while(fread(&mrt, sizeof(isis_mrt_hdr_t), 1, mrt_file) == 1) {
-        mrt.type = be16toh(mrt.type);
-        mrt.subtype = be16toh(mrt.subtype);
-        mrt.length = be32toh(mrt.length);
-        //LOG(DEBUG, "MRT type: %u subtype: %u length: %u\n", mrt.type, mrt.subtype, mrt.length);
-        if(!(mrt.type == ISIS_MRT_TYPE && 
-             mrt.subtype == 0 &&
-             mrt.length >= ISIS_HDR_LEN_COMMON &&
-             mrt.length <= ISIS_MAX_PDU_LEN)) {
-            LOG(ERROR, "Invalid MRT file %s\n", file_path);
-            fclose(mrt_file);
-            return false;
-        }
-        if(fread(pdu_buf, mrt.length, 1, mrt_file) != 1) {
-            LOG(ERROR, "Invalid MRT file %s\n", file_path);
-            fclose(mrt_file);
-            return false;
-        }
-        if(isis_pdu_load(&pdu, pdu_buf, mrt.length) != PROTOCOL_SUCCESS) {
-            LOG(ERROR, "Failed to load PDU from MRT file %s\n", file_path);
-            fclose(mrt_file);
+    lsp_id = be64toh(*(uint64_t*)ISIS_PDU_OFFSET(&pdu, ISIS_OFFSET_LSP_ID));
+    seq = be32toh(*(uint32_t*)ISIS_PDU_OFFSET(&pdu, ISIS_OFFSET_LSP_SEQ));
+
+    LOG(DEBUG, "ISIS ADD %s-LSP %s (seq %u) from MRT file to instance %u\n", 
+        isis_level_string(level), 
+        isis_lsp_id_to_str(&lsp_id), 
+        seq, instance->config->id);
+
+    /* Get LSDB */
+    lsdb = instance->level[level-1].lsdb;
+    search = hb_tree_search(lsdb, &lsp_id);
+    if(search) {
+        /* Update existing LSP. */
+        lsp = *search;
+        if(lsp->source.type == ISIS_SOURCE_SELF) {
+            LOG_NOARG(ISIS, "Failed to add LSP to LSDB (overwriting self LSP not permitted)\n");
             return false;
         }
-        switch(pdu.pdu_type) {
-            case ISIS_PDU_L1_LSP:
-                level = ISIS_LEVEL_1;
-                break;
-            case ISIS_PDU_L2_LSP:
-                level = ISIS_LEVEL_2;
-                break;
-            default:
-                LOG(ERROR, "Skip record from MRT file %s\n", file_path);
-                continue;
-        }
-
-        lsp_id = be64toh(*(uint64_t*)ISIS_PDU_OFFSET(&pdu, ISIS_OFFSET_LSP_ID));
-        seq = be32toh(*(uint32_t*)ISIS_PDU_OFFSET(&pdu, ISIS_OFFSET_LSP_SEQ));
-
-        LOG(DEBUG, "ISIS ADD %s-LSP %s (seq %u) from MRT file to instance %u\n", 
-            isis_level_string(level), 
-            isis_lsp_id_to_str(&lsp_id), 
-            seq, instance->config->id);
+    } else {
+        /* Create new LSP. */
+        lsp = isis_lsp_new(lsp_id, level, instance);
+    }
 
-        /* Get LSDB */
-        lsdb = instance->level[level-1].lsdb;
-        search = hb_tree_search(lsdb, &lsp_id);
-        if(search) {
-            /* Update existing LSP. */
-            lsp = *search;
-            if(lsp->source.type == ISIS_SOURCE_SELF) {
-                LOG_NOARG(ISIS, "Failed to add LSP to LSDB (overwriting self LSP not permitted)\n");
-                fclose(mrt_file);
-                return false;
-            }
+    if(!isis_lsp_pdu_store(lsp, &pdu)) {
+        if(!search) isis_lsp_free(lsp);
+        return false;
+    }
+    if(!search) {
+        result = hb_tree_insert(lsdb,  &lsp->id);
+        if(result.inserted) {
+            *result.datum_ptr = lsp;
         } else {
-            /* Create new LSP. */
-            lsp = isis_lsp_new(lsp_id, level, instance);
-            result = hb_tree_insert(lsdb,  &lsp->id);
-            if(result.inserted) {
-                *result.datum_ptr = lsp;
-            } else {
-                LOG_NOARG(ISIS, "Failed to add LSP to LSDB\n");
-                fclose(mrt_file);
-                return false;
-            }
+            LOG_NOARG(ISIS, "Failed to add LSP to LSDB\n");
+            isis_lsp_free(lsp);
+            return false;
         }
+    }
 
-        lsp->level = level;
-        lsp->source.type = ISIS_SOURCE_EXTERNAL;
-        lsp->source.adjacency = NULL;
-        lsp->seq = seq;
-        lsp->lifetime = be16toh(*(uint16_t*)ISIS_PDU_OFFSET(&pdu, ISIS_OFFSET_LSP_LIFETIME));
-        lsp->expired = false;
-        lsp->deleted = false;
-        lsp->instance = instance;
-        lsp->timestamp.tv_sec = now.tv_sec;
-        lsp->timestamp.tv_nsec = now.tv_nsec;
-
-        ISIS_PDU_CURSOR_RST(&pdu);
-        memcpy(&lsp->pdu, &pdu, sizeof(isis_pdu_s));
-
-        if(lsp->lifetime > 0 && instance->config->external_auto_refresh) {
-            if(level == ISIS_LEVEL_1) {
-                lsp->auth_key = instance->config->level1_key;
-            } else {
-                lsp->auth_key = instance->config->level2_key;
-            }
-            if(lsp->lifetime < ISIS_DEFAULT_LSP_LIFETIME_MIN) {
-                /* Increase ISIS lifetime. */
-                lsp->lifetime = ISIS_DEFAULT_LSP_LIFETIME_MIN;
-                isis_lsp_refresh(lsp); 
-            }
-            refresh_interval = lsp->lifetime - 300;
-            timer_add_periodic(&g_ctx->timer_root, &lsp->timer_refresh, 
-                               "ISIS LSP REFRESH", refresh_interval, 3, lsp, 
-                               &isis_lsp_refresh_job);
+    lsp->level = level;
+    lsp->source.type = ISIS_SOURCE_EXTERNAL;
+    lsp->source.adjacency = NULL;
+    lsp->seq = seq;
+    lsp->lifetime = be16toh(*(uint16_t*)ISIS_PDU_OFFSET(&pdu, ISIS_OFFSET_LSP_LIFETIME));
+    lsp->expired = false;
+    lsp->deleted = false;
+    lsp->instance = instance;
+    clock_gettime(CLOCK_MONOTONIC, &lsp->timestamp);
+
+    if(lsp->lifetime > 0 && instance->config->external_auto_refresh) {
+        if(level == ISIS_LEVEL_1) {
+            lsp->auth_key = instance->config->level1_key;
         } else {
-            isis_lsp_lifetime(lsp);
+            lsp->auth_key = instance->config->level2_key;
         }
+        if(lsp->lifetime < ISIS_DEFAULT_LSP_LIFETIME_MIN) {
+            /* Increase ISIS lifetime. */
+            lsp->lifetime = ISIS_DEFAULT_LSP_LIFETIME_MIN;
+            isis_lsp_refresh(lsp); 
+        }
+        refresh_interval = lsp->lifetime - 300;
+        timer_add_periodic(&g_ctx->timer_root, &lsp->timer_refresh, 
+                           "ISIS LSP REFRESH", refresh_interval, 3, lsp, 
+                           &isis_lsp_refresh_job);
+        instance->mrt_refresh_interval = refresh_interval;
+    } else {
+        isis_lsp_lifetime(lsp);
     }
+    return true;
+}
 
-    if(startup && refresh_interval) {
+static void
+isis_mrt_done(void *instance_ptr, bool startup)
+{
+    isis_instance_s *instance = instance_ptr;
+
+    if(startup && instance->mrt_refresh_interval) {
         /* Adding 3 nanoseconds to enforce a dedicated timer bucket. */
-        timer_smear_bucket(&g_ctx->timer_root, refresh_interval, 3);
+        timer_smear_bucket(&g_ctx->timer_root, instance->mrt_refresh_interval, 3);
     }
+}
 
-    fclose(mrt_file);
-    return true;
-}
\ No newline at end of file
+/**
+ * isis_mrt_load
+ *
+ * Start loading LSPs from MRT file. The file is
+ * memory mapped and validated in background threads
+ * while LSPs are added in batches from the main loop.
+ * The progress is reported by control command mrt-info.
+ *
+ * @param instance ISIS instance
+ * @param file_path MRT file
+ * @param startup true if loaded during startup
+ * @return true if loading has started (startup: loaded)
+ */
+bool
+isis_mrt_load(isis_instance_s *instance, char *file_path, bool startup)
+{
+    LOG(ISIS, "Load ISIS MRT file %s\n", file_path);
+    return bbl_mrt_load("isis", instance->config->id, instance, file_path, startup,
+                        isis_mrt_validate, isis_mrt_commit, isis_mrt_done);
+}
@@ -66,6 +66,7 @@ isis_p2p_hello_encode(bbl_network_interface_s *interface,
 {
     protocol_error_t result;
     isis_pdu_s pdu = {0};
+    uint8_t pdu_buf[ISIS_MAX_PDU_LEN];
     bbl_isis_s isis = {0};
 
     isis_adjacency_p2p_s *adjacency = interface->isis_adjacency_p2p;
@@ -89,7 +90,7 @@ isis_p2p_hello_encode(bbl_network_interface_s *interface,
     }
 
     /* Build PDU */
-    isis_pdu_init(&pdu, ISIS_PDU_P2P_HELLO);
+    isis_pdu_init(&pdu, ISIS_PDU_P2P_HELLO, pdu_buf, sizeof(pdu_buf));
     /* PDU header */
     isis_pdu_add_u8(&pdu, adjacency->level);
     isis_pdu_add_bytes(&pdu, config->system_id, ISIS_SYSTEM_ID_LEN);
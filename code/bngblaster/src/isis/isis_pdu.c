@@ -22,8 +22,9 @@ isis_pdu_load(isis_pdu_s *pdu, uint8_t *buf, uint16_t len)
         return DECODE_ERROR;
     }
     memset(pdu, 0x0, sizeof(isis_pdu_s));
-    memcpy(pdu->pdu, buf, len);
+    pdu->pdu = buf;
     pdu->pdu_len = len;
+    pdu->pdu_buf_len = len;
     
     /* Decode IS-IS common header (8 byte) */    
     hdr_len = *ISIS_PDU_OFFSET(pdu, ISIS_OFFSET_HDR_LEN);
@@ -300,9 +301,12 @@ isis_pdu_validate_auth(isis_pdu_s *pdu, isis_auth_type auth, char *key)
 }
 
 void
-isis_pdu_init(isis_pdu_s *pdu, uint8_t pdu_type)
+isis_pdu_init(isis_pdu_s *pdu, uint8_t pdu_type, uint8_t *buf, uint16_t buf_len)
 {
     memset(pdu, 0x0, sizeof(isis_pdu_s));
+    memset(buf, 0x0, buf_len);
+    pdu->pdu = buf;
+    pdu->pdu_buf_len = buf_len;
     pdu->pdu_type = pdu_type;
     *pdu->pdu = ISIS_PROTOCOL_IDENTIFIER;
     *(pdu->pdu+2) = 0x01;
@@ -563,7 +567,7 @@ isis_pdu_add_tlv_router_cap(isis_pdu_s *pdu, ipv4addr_t router_id,
 void
 isis_pdu_padding(isis_pdu_s *pdu)
 {
-    uint16_t remaining = ISIS_MAX_PDU_LEN - pdu->pdu_len;
+    uint16_t remaining = pdu->pdu_buf_len - pdu->pdu_len;
     memset(ISIS_PDU_CURSOR(pdu), 0x0, remaining);
     while(remaining >= sizeof(isis_tlv_s)) {
         isis_tlv_s *tlv = (isis_tlv_s *)ISIS_PDU_CURSOR(pdu);
@@ -16,7 +16,7 @@
 #define ISIS_PDU_CURSOR_SET(_pdu, _off)  ((_pdu)->cur=_off)
 #define ISIS_PDU_CURSOR_INC(_pdu, _off)  ((_pdu)->cur+=_off)
 #define ISIS_PDU_OFFSET(_pdu, _off)      ((_pdu)->pdu+_off)
-#define ISIS_PDU_REMAINING(_pdu)         (ISIS_MAX_PDU_LEN-(_pdu)->cur)
+#define ISIS_PDU_REMAINING(_pdu)         ((_pdu)->pdu_buf_len-(_pdu)->cur)
 
 #define ISIS_PDU_BUMP_WRITE_BUFFER(_pdu, _off) \
     (_pdu)->cur+=(_off); \
@@ -50,7 +50,7 @@ bool
 isis_pdu_validate_auth(isis_pdu_s *pdu, isis_auth_type auth, char *key);
 
 void
-isis_pdu_init(isis_pdu_s *pdu, uint8_t pdu_type);
+isis_pdu_init(isis_pdu_s *pdu, uint8_t pdu_type, uint8_t *buf, uint16_t buf_len);
 
 void
 isis_pdu_add_u8(isis_pdu_s *pdu, uint8_t value);
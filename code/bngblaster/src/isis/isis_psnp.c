@@ -25,6 +25,7 @@ isis_psnp_job (timer_s *timer)
     int entries = 0;
 
     isis_pdu_s pdu = {0};
+    uint8_t pdu_buf[ISIS_MAX_PDU_LEN];
     uint8_t level = adjacency->level;
     uint16_t remaining_lifetime;
 
@@ -42,13 +43,13 @@ isis_psnp_job (timer_s *timer)
 
     /* Build PDU */
     if(level == ISIS_LEVEL_1) {
-        isis_pdu_init(&pdu, ISIS_PDU_L1_PSNP);
+        isis_pdu_init(&pdu, ISIS_PDU_L1_PSNP, pdu_buf, sizeof(pdu_buf));
         if(config->level1_auth_psnp) {
             auth = config->level1_auth;
             key = config->level1_key;
         }
     } else {
-        isis_pdu_init(&pdu, ISIS_PDU_L2_PSNP);
+        isis_pdu_init(&pdu, ISIS_PDU_L2_PSNP, pdu_buf, sizeof(pdu_buf));
         if(config->level2_auth_psnp) {
             auth = config->level2_auth;
             key = config->level2_key;
@@ -246,7 +246,7 @@ ospf_ctrl_load_mrt(int fd, uint32_t session_id __attribute__((unused)), json_t *
     if(json_unpack(arguments, "{s:s}", "file", &file_path) != 0) {
         return bbl_ctrl_status(fd, "error", 400, "missing MRT file");
     }
-    if(!ospf_mrt_load(ospf_instance, file_path)) {
+    if(!ospf_mrt_load(ospf_instance, file_path, false)) {
         return bbl_ctrl_status(fd, "error", 500, "failed to load OSPF MRT file");
     }
     return bbl_ctrl_status(fd, "ok", 200, NULL);
@@ -293,15 +293,59 @@ ospf_ctrl_lsa_update(int fd, uint32_t session_id __attribute__((unused)), json_t
     return bbl_ctrl_status(fd, "ok", 200, NULL);
 }
 
+/**
+ * ospf_ctrl_pdu_load
+ *
+ * Decode a single raw OSPF LS update PDU
+ * and load all contained external LSA.
+ *
+ * @param ospf_instance OSPF instance
+ * @param buf raw PDU
+ * @param len PDU length
+ * @return NULL on success or error message
+ */
+static const char *
+ospf_ctrl_pdu_load(ospf_instance_s *ospf_instance, uint8_t *buf, uint16_t len)
+{
+    ospf_pdu_s pdu = {0};
+    size_t lsa_count;
+
+    if(ospf_pdu_load(&pdu, buf, len) != PROTOCOL_SUCCESS) {
+        return "failed to load OSPF PDU";
+    }
+    if(pdu.pdu_type != OSPF_PDU_LS_UPDATE) {
+        return "failed to load OSPF PDU (wrong PDU type)";
+    }
+    if(pdu.pdu_version != ospf_instance->config->version) {
+        return "failed to load OSPF PDU (wrong version)";
+    }
+    if(pdu.pdu_version == OSPF_VERSION_2) {
+        if(pdu.pdu_len < OSPFV2_LS_UPDATE_LEN_MIN) {
+            return "failed to load OSPF PDU (wrong PDU len)";
+        }
+        lsa_count = be32toh(*(uint32_t*)OSPF_PDU_OFFSET(&pdu, OSPFV2_OFFSET_LS_UPDATE_COUNT));
+        OSPF_PDU_CURSOR_SET(&pdu, OSPFV2_OFFSET_LS_UPDATE_LSA);
+    } else {
+        if(pdu.pdu_len < OSPFV3_LS_UPDATE_LEN_MIN) {
+            return "failed to load OSPF PDU (wrong PDU len)";
+        }
+        lsa_count = be32toh(*(uint32_t*)OSPF_PDU_OFFSET(&pdu, OSPFV3_OFFSET_LS_UPDATE_COUNT));
+        OSPF_PDU_CURSOR_SET(&pdu, OSPFV3_OFFSET_LS_UPDATE_LSA);
+    }
+    if(!ospf_lsa_load_external(ospf_instance, lsa_count, OSPF_PDU_CURSOR(&pdu), OSPF_PDU_CURSOR_LEN(&pdu))) {
+        return "failed to load OSPF PDU (LSA load error)";
+    }
+    return NULL;
+}
+
 int
 ospf_ctrl_pdu_update(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
 {
     json_t *value;
     size_t pdu_count;
-    size_t lsa_count;
 
-    ospf_pdu_s pdu = {0};
     const char *lsa_string;
+    const char *error;
     uint16_t lsa_string_len;
 
     uint16_t len;
@@ -326,31 +370,9 @@ ospf_ctrl_pdu_update(int fd, uint32_t session_id __attribute__((unused)), json_t
             for (len = 0; len < (lsa_string_len/2); len++) {
                 sscanf(lsa_string + len*2, "%02hhx", &g_pdu_buf[len]);
             }
-
-            if(ospf_pdu_load(&pdu, g_pdu_buf, len) != PROTOCOL_SUCCESS) {
-                return bbl_ctrl_status(fd, "error", 500, "failed to load OSPF PDU");
-            }
-            if(pdu.pdu_type != OSPF_PDU_LS_UPDATE) {
-                return bbl_ctrl_status(fd, "error", 500, "failed to load OSPF PDU (wrong PDU type)");
-            }
-            if(pdu.pdu_version != ospf_instance->config->version) {
-                return bbl_ctrl_status(fd, "error", 500, "failed to load OSPF PDU (wrong version)");
-            }
-            if(pdu.pdu_version == OSPF_VERSION_2) {
-                if(pdu.pdu_len < OSPFV2_LS_UPDATE_LEN_MIN) {
-                    return bbl_ctrl_status(fd, "error", 500, "failed to load OSPF PDU (wrong PDU len)");
-                }
-                lsa_count = be32toh(*(uint32_t*)OSPF_PDU_OFFSET(&pdu, OSPFV2_OFFSET_LS_UPDATE_COUNT));
-                OSPF_PDU_CURSOR_SET(&pdu, OSPFV2_OFFSET_LS_UPDATE_LSA);
-            } else {
-                if(pdu.pdu_len < OSPFV3_LS_UPDATE_LEN_MIN) {
-                    return bbl_ctrl_status(fd, "error", 500, "failed to load OSPF PDU (wrong PDU len)");
-                }
-                lsa_count = be32toh(*(uint32_t*)OSPF_PDU_OFFSET(&pdu, OSPFV3_OFFSET_LS_UPDATE_COUNT));
-                OSPF_PDU_CURSOR_SET(&pdu, OSPFV3_OFFSET_LS_UPDATE_LSA);
-            }
-            if(!ospf_lsa_load_external(ospf_instance, lsa_count, OSPF_PDU_CURSOR(&pdu), OSPF_PDU_CURSOR_LEN(&pdu))) {
-                return bbl_ctrl_status(fd, "error", 500, "failed to load OSPF PDU (LSA load error)");
+            error = ospf_ctrl_pdu_load(ospf_instance, g_pdu_buf, len);
+            if(error) {
+                return bbl_ctrl_status(fd, "error", 500, error);
             }
         }
     } else {
@@ -359,6 +381,30 @@ ospf_ctrl_pdu_update(int fd, uint32_t session_id __attribute__((unused)), json_t
     return bbl_ctrl_status(fd, "ok", 200, NULL);
 }
 
+/**
+ * ospf_ctrl_pdu_stream
+ *
+ * Load a single LS update PDU received
+ * via binary PDU stream (ospf-pdu-stream).
+ *
+ * @param instance_id OSPF instance identifier
+ * @param buf raw PDU
+ * @param len PDU length
+ * @return true if PDU was loaded successfully
+ */
+bool
+ospf_ctrl_pdu_stream(int instance_id, uint8_t *buf, uint16_t len)
+{
+    ospf_instance_s *ospf_instance = g_ctx->ospf_instances;
+    while(ospf_instance) {
+        if(ospf_instance->config->id == instance_id) {
+            return ospf_ctrl_pdu_load(ospf_instance, buf, len) == NULL;
+        }
+        ospf_instance = ospf_instance->next;
+    }
+    return false;
+}
+
 int
 ospf_ctrl_teardown(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused))) 
 {
@@ -27,6 +27,9 @@ ospf_ctrl_lsa_update(int fd, uint32_t session_id __attribute__((unused)), json_t
 int
 ospf_ctrl_pdu_update(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
 
+bool
+ospf_ctrl_pdu_stream(int instance_id, uint8_t *buf, uint16_t len);
+
 int
 ospf_ctrl_teardown(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)));
 
@@ -8,100 +8,112 @@
  */
 #include "ospf.h"
 
-extern uint8_t g_pdu_buf[];
-
-bool
-ospf_mrt_load(ospf_instance_s *instance, char *file_path)
+/**
+ * ospf_mrt_pdu_load
+ *
+ * Decode LS update PDU from MRT record and 
+ * set cursor to first LSA.
+ */
+static const char *
+ospf_mrt_pdu_load(ospf_instance_s *instance, ospf_pdu_s *pdu, uint32_t *lsa_count,
+                  uint16_t type, uint16_t subtype, uint8_t *buf, uint32_t len)
 {
-    FILE *mrt_file = NULL;
-    ospf_mrt_hdr_t mrt = {0};
-
-    ospf_pdu_s pdu = {0};
-    uint32_t lsa_count = 0;
-
-    LOG(OSPF, "Load OSPF MRT file %s\n", file_path);
-
-    mrt_file = fopen(file_path, "r");
-    if(!mrt_file) {
-        LOG(ERROR, "Failed to open MRT file %s\n", file_path);
-        return false;
+    if(!(subtype == 0 && len <= OSPF_PDU_LEN_MAX)) {
+        return "invalid MRT record";
     }
-
-    while(fread(&mrt, sizeof(ospf_mrt_hdr_t), 1, mrt_file) == 1) {
-        mrt.type = be16toh(mrt.type);
-        mrt.subtype = be16toh(mrt.subtype);
-        mrt.length = be32toh(mrt.length);
-        //LOG(DEBUG, "MRT type: %u subtype: %u length: %u\n", mrt.type, mrt.subtype, mrt.length);
-
-        if(!(mrt.subtype == 0 && mrt.length <= OSPF_PDU_LEN_MAX)) {
-            LOG(ERROR, "Invalid MRT file %s\n", file_path);
-            fclose(mrt_file);
-            return false;
+    if(type == OSPFv2_MRT_TYPE && len >= (OSPFv2_MRT_PDU_OFFSET+OSPF_PDU_LEN_MIN)) {
+        if(ospf_pdu_load(pdu, buf+OSPFv2_MRT_PDU_OFFSET, len-OSPFv2_MRT_PDU_OFFSET) != PROTOCOL_SUCCESS) {
+            return "PDU load error";
         }
-        if(fread(g_pdu_buf, mrt.length, 1, mrt_file) != 1) {
-            LOG(ERROR, "Invalid MRT file %s\n", file_path);
-            fclose(mrt_file);
-            return false;
+        if(pdu->pdu_version != OSPF_VERSION_2) {
+            return "wrong PDU version";
         }
-
-        if(mrt.type == OSPFv2_MRT_TYPE && mrt.length >= (OSPFv2_MRT_PDU_OFFSET+OSPF_PDU_LEN_MIN)) {
-            if(ospf_pdu_load(&pdu, g_pdu_buf+OSPFv2_MRT_PDU_OFFSET, mrt.length-OSPFv2_MRT_PDU_OFFSET) != PROTOCOL_SUCCESS) {
-                LOG(ERROR, "Invalid OSPFv2 MRT file %s (PDU load error)\n", file_path);
-                fclose(mrt_file);
-                return false;
-            }
-            if(pdu.pdu_version != OSPF_VERSION_2) {
-                LOG(ERROR, "Invalid OSPFv2 MRT file %s (wrong PDU version)\n", file_path);
-                fclose(mrt_file);
-                return false;
-            }
-            if(pdu.pdu_len < OSPFV2_LS_UPDATE_LEN_MIN) {
-                LOG(ERROR, "Invalid OSPFv2 MRT file %s (wrong PDU len)\n", file_path);
-                fclose(mrt_file);
-                return false;
-            }
-            lsa_count = be32toh(*(uint32_t*)OSPF_PDU_OFFSET(&pdu, OSPFV2_OFFSET_LS_UPDATE_COUNT));
-            OSPF_PDU_CURSOR_SET(&pdu, OSPFV2_OFFSET_LS_UPDATE_LSA);
-        } else if(mrt.type == OSPFv3_MRT_TYPE && mrt.length >= (OSPFv3_MRT_PDU_OFFSET+OSPF_PDU_LEN_MIN)) {
-            if(ospf_pdu_load(&pdu, g_pdu_buf+OSPFv3_MRT_PDU_OFFSET, mrt.length-OSPFv3_MRT_PDU_OFFSET) != PROTOCOL_SUCCESS) {
-                LOG(ERROR, "Invalid OSPFv3 MRT file %s (PDU load error)\n", file_path);
-                fclose(mrt_file);
-                return false;
-            }
-            if(pdu.pdu_version != OSPF_VERSION_3) {
-                LOG(ERROR, "Invalid OSPFv3 MRT file %s (wrong PDU version)\n", file_path);
-                fclose(mrt_file);
-                return false;
-            }
-            if(pdu.pdu_len < OSPFV3_LS_UPDATE_LEN_MIN) {
-                LOG(ERROR, "Invalid OSPFv3 MRT file %s (wrong PDU len)\n", file_path);
-                fclose(mrt_file);
-                return false;
-            }
-            lsa_count = be32toh(*(uint32_t*)OSPF_PDU_OFFSET(&pdu, OSPFV3_OFFSET_LS_UPDATE_COUNT));
-            OSPF_PDU_CURSOR_SET(&pdu, OSPFV3_OFFSET_LS_UPDATE_LSA);
-        } else {
-            LOG(ERROR, "Invalid MRT file %s (wrong MRT type)\n", file_path);
-            fclose(mrt_file);
-            return false;
+        if(pdu->pdu_len < OSPFV2_LS_UPDATE_LEN_MIN) {
+            return "wrong PDU len";
         }
-        if(pdu.pdu_type != OSPF_PDU_LS_UPDATE) {
-            LOG(ERROR, "Invalid MRT file %s (wrong PDU type)\n", file_path);
-            fclose(mrt_file);
-            return false;
+        *lsa_count = be32toh(*(uint32_t*)OSPF_PDU_OFFSET(pdu, OSPFV2_OFFSET_LS_UPDATE_COUNT));
+        OSPF_PDU_CURSOR_SET(pdu, OSPFV2_OFFSET_LS_UPDATE_LSA);
+    } else if(type == OSPFv3_MRT_TYPE && len >= (OSPFv3_MRT_PDU_OFFSET+OSPF_PDU_LEN_MIN)) {
+        if(ospf_pdu_load(pdu, buf+OSPFv3_MRT_PDU_OFFSET, len-OSPFv3_MRT_PDU_OFFSET) != PROTOCOL_SUCCESS) {
+            return "PDU load error";
         }
-        if(pdu.pdu_version != instance->config->version) {
-            LOG(ERROR, "Invalid MRT file %s (wrong version)\n", file_path);
-            fclose(mrt_file);
-            return false;
+        if(pdu->pdu_version != OSPF_VERSION_3) {
+            return "wrong PDU version";
         }
-        if(!ospf_lsa_load_external(instance, lsa_count, OSPF_PDU_CURSOR(&pdu), OSPF_PDU_CURSOR_LEN(&pdu))) {
-            LOG(ERROR, "Invalid MRT file %s (LSA load error)\n", file_path);
-            fclose(mrt_file);
-            return false;
+        if(pdu->pdu_len < OSPFV3_LS_UPDATE_LEN_MIN) {
+            return "wrong PDU len";
         }
+        *lsa_count = be32toh(*(uint32_t*)OSPF_PDU_OFFSET(pdu, OSPFV3_OFFSET_LS_UPDATE_COUNT));
+        OSPF_PDU_CURSOR_SET(pdu, OSPFV3_OFFSET_LS_UPDATE_LSA);
+    } else {
+        return "wrong MRT type";
+    }
+    if(pdu->pdu_type != OSPF_PDU_LS_UPDATE) {
+        return "wrong PDU type";
     }
+    if(pdu->pdu_version != instance->config->version) {
+        return "wrong version";
+    }
+    return NULL;
+}
+
+/**
+ * ospf_mrt_validate
+ *
+ * Validate a single MRT record
+ * (executed in MRT worker threads).
+ */
+static bool
+ospf_mrt_validate(void *instance, uint16_t type, uint16_t subtype, uint8_t *buf, uint32_t len)
+{
+    ospf_pdu_s pdu = {0};
+    uint32_t lsa_count = 0;
+
+    return ospf_mrt_pdu_load(instance, &pdu, &lsa_count, type, subtype, buf, len) == NULL;
+}
+
+/**
+ * ospf_mrt_commit
+ *
+ * Add or update all LSAs from
+ * MRT record (executed in main thread).
+ */
+static bool
+ospf_mrt_commit(void *instance, uint16_t type, uint16_t subtype, uint8_t *buf, uint32_t len)
+{
+    ospf_pdu_s pdu = {0};
+    uint32_t lsa_count = 0;
+    const char *error;
 
-    fclose(mrt_file);
+    error = ospf_mrt_pdu_load(instance, &pdu, &lsa_count, type, subtype, buf, len);
+    if(error) {
+        LOG(ERROR, "Invalid OSPF MRT record (%s)\n", error);
+        return false;
+    }
+    if(!ospf_lsa_load_external(instance, lsa_count, OSPF_PDU_CURSOR(&pdu), OSPF_PDU_CURSOR_LEN(&pdu))) {
+        LOG_NOARG(ERROR, "Invalid OSPF MRT record (LSA load error)\n");
+        return false;
+    }
     return true;
-}
\ No newline at end of file
+}
+
+/**
+ * ospf_mrt_load
+ *
+ * Start loading LSAs from MRT file. The file is
+ * memory mapped and validated in background threads
+ * while LSAs are added in batches from the main loop.
+ * The progress is reported by control command mrt-info.
+ *
+ * @param instance OSPF instance
+ * @param file_path MRT file
+ * @param startup true if loaded during startup
+ * @return true if loading has started (startup: loaded)
+ */
+bool
+ospf_mrt_load(ospf_instance_s *instance, char *file_path, bool startup)
+{
+    LOG(OSPF, "Load OSPF MRT file %s\n", file_path);
+    return bbl_mrt_load("ospf", instance->config->id, instance, file_path, startup,
+                        ospf_mrt_validate, ospf_mrt_commit, NULL);
+}
@@ -46,9 +46,303 @@ test_protocols_decode_pppoe_ipcp_conf_request(void **unused) {
 
 }
 
+static uint16_t
+test_checksum_reference(uint8_t *buf, uint16_t len) {
+    uint32_t sum = 0;
+    uint16_t i;
+    for(i = 0; i + 1 < len; i += 2) {
+        sum += *(uint16_t*)(buf+i);
+    }
+    if(len & 1) {
+        sum += buf[len-1];
+    }
+    while(sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return ~sum;
+}
+
+static void
+test_protocols_checksum(void **unused) {
+    (void) unused;
+
+    uint8_t buf[2048];
+    uint16_t len;
+    uint16_t offset;
+    int kernel, i;
+
+    srand(1);
+    for(i = 0; i < (int)sizeof(buf); i++) {
+        buf[i] = rand();
+    }
+    /* Test generic kernel first and then 
+     * the kernel selected by CPUID. */
+    for(kernel = 0; kernel < 2; kernel++) {
+        if(kernel) {
+            assert_non_null(bbl_checksum_init());
+        }
+        for(offset = 0; offset < 4; offset++) {
+            for(len = 0; len < 1600; len++) {
+                assert_int_equal(bbl_checksum(buf+offset, len), test_checksum_reference(buf+offset, len));
+            }
+        }
+    }
+    /* Test all ones (overflow). */
+    memset(buf, 0xff, sizeof(buf));
+    assert_int_equal(bbl_checksum(buf, sizeof(buf)), test_checksum_reference(buf, sizeof(buf)));
+}
+
+static void
+test_protocols_checksum_update(void **unused) {
+    (void) unused;
+
+    uint8_t buf[256];
+    uint8_t old[16];
+    uint16_t checksum;
+    int i, n;
+
+    srand(2);
+    for(i = 0; i < (int)sizeof(buf); i++) {
+        buf[i] = rand();
+    }
+    checksum = bbl_checksum(buf, sizeof(buf));
+    for(n = 0; n < 1000; n++) {
+        memcpy(old, buf+128, sizeof(old));
+        for(i = 0; i < (int)sizeof(old); i++) {
+            buf[128+i] = n & 1 ? rand() : 0;
+        }
+        checksum = bbl_checksum_update(checksum, old, buf+128, sizeof(old));
+        assert_int_equal(checksum, bbl_checksum(buf, sizeof(buf)));
+    }
+}
+
+static uint16_t
+test_decode_fast_packet(uint8_t *buf, uint16_t vlan_outer, uint16_t vlan_inner, uint16_t vlan_three,
+                        bool pppoe_session, bool ipv6_packet, uint16_t udp_port) {
+    uint8_t mac_dst[ETH_ADDR_LEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    uint8_t mac_src[ETH_ADDR_LEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+    uint8_t ipv6_src[IPV6_ADDR_LEN] = {0xfc, 0x66, 0x10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    uint8_t ipv6_dst[IPV6_ADDR_LEN] = {0xfc, 0x66, 0x10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2};
+
+    bbl_ethernet_header_s eth = {0};
+    bbl_pppoe_session_s pppoe = {0};
+    bbl_ipv4_s ipv4 = {0};
+    bbl_ipv6_s ipv6 = {0};
+    bbl_udp_s udp = {0};
+    bbl_bbl_s bbl = {0};
+    uint16_t len = 0;
+
+    eth.dst = mac_dst;
+    eth.src = mac_src;
+    eth.vlan_outer = vlan_outer;
+    eth.vlan_outer_priority = 5;
+    eth.vlan_inner = vlan_inner;
+    eth.vlan_inner_priority = 3;
+    eth.vlan_three = vlan_three;
+    udp.src = udp_port;
+    udp.dst = udp_port;
+    udp.protocol = UDP_PROTOCOL_BBL;
+    udp.next = &bbl;
+    bbl.type = BBL_TYPE_UNICAST;
+    bbl.sub_type = ipv6_packet ? BBL_SUB_TYPE_IPV6 : BBL_SUB_TYPE_IPV4;
+    bbl.direction = BBL_DIRECTION_DOWN;
+    bbl.session_id = 1;
+    bbl.flow_id = 2;
+    bbl.flow_seq = 1000;
+    bbl.tos = 0xa0;
+    if(ipv6_packet) {
+        ipv6.src = ipv6_src;
+        ipv6.dst = ipv6_dst;
+        ipv6.ttl = 64;
+        ipv6.tos = 0xa0;
+        ipv6.protocol = IPV6_NEXT_HEADER_UDP;
+        ipv6.next = &udp;
+    } else {
+        ipv4.src = htobe32(0x0a000001);
+        ipv4.dst = htobe32(0x0a000002);
+        ipv4.ttl = 64;
+        ipv4.tos = 0xa0;
+        ipv4.offset = IPV4_DF;
+        ipv4.protocol = PROTOCOL_IPV4_UDP;
+        ipv4.next = &udp;
+    }
+    if(pppoe_session) {
+        eth.type = ETH_TYPE_PPPOE_SESSION;
+        eth.next = &pppoe;
+        pppoe.session_id = 1;
+        pppoe.protocol = ipv6_packet ? PROTOCOL_IPV6 : PROTOCOL_IPV4;
+        pppoe.next = ipv6_packet ? (void*)&ipv6 : (void*)&ipv4;
+    } else {
+        eth.type = ipv6_packet ? ETH_TYPE_IPV6 : ETH_TYPE_IPV4;
+        eth.next = ipv6_packet ? (void*)&ipv6 : (void*)&ipv4;
+    }
+    assert_int_equal(encode_ethernet(buf, &len, &eth), PROTOCOL_SUCCESS);
+    return len;
+}
+
+static void
+test_decode_fast_compare(uint8_t *buf, uint16_t len) {
+    static uint8_t sp_full[SCRATCHPAD_LEN];
+    static uint8_t sp_fast[SCRATCHPAD_LEN];
+    bbl_ethernet_header_s *a = NULL;
+    bbl_ethernet_header_s *b = NULL;
+    bbl_pppoe_session_s *pppoe_a, *pppoe_b;
+    bbl_ipv4_s *ipv4_a, *ipv4_b;
+    bbl_ipv6_s *ipv6_a, *ipv6_b;
+    bbl_udp_s *udp_a = NULL, *udp_b = NULL;
+    void *next_a, *next_b;
+    uint16_t type;
+
+    protocol_error_t result = decode_ethernet(buf, len, sp_full, SCRATCHPAD_LEN, &a);
+    assert_int_equal(decode_ethernet_fast(buf, len, sp_fast, SCRATCHPAD_LEN, &b), result);
+    if(result != PROTOCOL_SUCCESS) {
+        return;
+    }
+
+    assert_int_equal(a->length, b->length);
+    assert_int_equal(a->type, b->type);
+    assert_int_equal(a->vlan_outer, b->vlan_outer);
+    assert_int_equal(a->vlan_inner, b->vlan_inner);
+    assert_int_equal(a->vlan_three, b->vlan_three);
+    assert_int_equal(a->vlan_outer_priority, b->vlan_outer_priority);
+    assert_int_equal(a->vlan_inner_priority, b->vlan_inner_priority);
+    assert_int_equal(a->qinq, b->qinq);
+    assert_int_equal(a->tos, b->tos);
+    assert_ptr_equal(a->dst, b->dst);
+    assert_ptr_equal(a->src, b->src);
+    assert_true((a->bbl == NULL) == (b->bbl == NULL));
+    if(a->bbl) {
+        assert_memory_equal(a->bbl, b->bbl, sizeof(bbl_bbl_s));
+    }
+
+    next_a = a->next; next_b = b->next;
+    type = a->type;
+    if(type == ETH_TYPE_PPPOE_SESSION) {
+        pppoe_a = next_a; pppoe_b = next_b;
+        assert_int_equal(pppoe_a->session_id, pppoe_b->session_id);
+        assert_int_equal(pppoe_a->protocol, pppoe_b->protocol);
+        type = pppoe_a->protocol == PROTOCOL_IPV4 ? ETH_TYPE_IPV4 : ETH_TYPE_IPV6;
+        next_a = pppoe_a->next; next_b = pppoe_b->next;
+    }
+    if(type == ETH_TYPE_IPV4) {
+        ipv4_a = next_a; ipv4_b = next_b;
+        assert_int_equal(ipv4_a->src, ipv4_b->src);
+        assert_int_equal(ipv4_a->dst, ipv4_b->dst);
+        assert_int_equal(ipv4_a->tos, ipv4_b->tos);
+        assert_int_equal(ipv4_a->ttl, ipv4_b->ttl);
+        assert_int_equal(ipv4_a->protocol, ipv4_b->protocol);
+        assert_int_equal(ipv4_a->id, ipv4_b->id);
+        assert_int_equal(ipv4_a->offset, ipv4_b->offset);
+        assert_int_equal(ipv4_a->len, ipv4_b->len);
+        assert_ptr_equal(ipv4_a->hdr, ipv4_b->hdr);
+        assert_ptr_equal(ipv4_a->payload, ipv4_b->payload);
+        assert_int_equal(ipv4_a->payload_len, ipv4_b->payload_len);
+        if(ipv4_a->protocol == PROTOCOL_IPV4_UDP) {
+            udp_a = ipv4_a->next; udp_b = ipv4_b->next;
+        }
+    } else if(type == ETH_TYPE_IPV6) {
+        ipv6_a = next_a; ipv6_b = next_b;
+        assert_ptr_equal(ipv6_a->src, ipv6_b->src);
+        assert_ptr_equal(ipv6_a->dst, ipv6_b->dst);
+        assert_int_equal(ipv6_a->tos, ipv6_b->tos);
+        assert_int_equal(ipv6_a->ttl, ipv6_b->ttl);
+        assert_int_equal(ipv6_a->protocol, ipv6_b->protocol);
+        assert_int_equal(ipv6_a->len, ipv6_b->len);
+        assert_ptr_equal(ipv6_a->hdr, ipv6_b->hdr);
+        assert_ptr_equal(ipv6_a->payload, ipv6_b->payload);
+        assert_int_equal(ipv6_a->payload_len, ipv6_b->payload_len);
+        if(ipv6_a->protocol == IPV6_NEXT_HEADER_UDP) {
+            udp_a = ipv6_a->next; udp_b = ipv6_b->next;
+        }
+    }
+    if(udp_a) {
+        assert_non_null(udp_b);
+        assert_int_equal(udp_a->src, udp_b->src);
+        assert_int_equal(udp_a->dst, udp_b->dst);
+        assert_int_equal(udp_a->protocol, udp_b->protocol);
+        assert_int_equal(udp_a->payload_len, udp_b->payload_len);
+    }
+}
+
+static void
+test_protocols_decode_fast(void **unused) {
+    (void) unused;
+
+    uint8_t buf[512];
+    uint16_t len;
+    uint8_t *l3;
+
+    /* Stream traffic decoded by the fast path. */
+    len = test_decode_fast_packet(buf, 0, 0, 0, false, false, BBL_UDP_PORT);
+    test_decode_fast_compare(buf, len);
+    len = test_decode_fast_packet(buf, 0, 0, 0, false, true, BBL_UDP_PORT);
+    test_decode_fast_compare(buf, len);
+    len = test_decode_fast_packet(buf, 100, 0, 0, false, false, BBL_UDP_PORT);
+    test_decode_fast_compare(buf, len);
+    len = test_decode_fast_packet(buf, 100, 200, 0, false, true, BBL_UDP_PORT);
+    test_decode_fast_compare(buf, len);
+    len = test_decode_fast_packet(buf, 100, 200, 0, true, false, BBL_UDP_PORT);
+    test_decode_fast_compare(buf, len);
+    len = test_decode_fast_packet(buf, 100, 200, 0, true, true, BBL_UDP_PORT);
+    test_decode_fast_compare(buf, len);
+
+    /* Three VLAN tags. */
+    len = test_decode_fast_packet(buf, 100, 200, 300, false, false, BBL_UDP_PORT);
+    test_decode_fast_compare(buf, len);
+
+    /* Non-BBL UDP port. */
+    len = test_decode_fast_packet(buf, 100, 0, 0, false, false, 1234);
+    test_decode_fast_compare(buf, len);
+    len = test_decode_fast_packet(buf, 0, 0, 0, false, true, 1234);
+    test_decode_fast_compare(buf, len);
+
+    /* IPv4 options (4 byte NOP). */
+    len = test_decode_fast_packet(buf, 0, 0, 0, false, false, BBL_UDP_PORT);
+    l3 = buf + 14;
+    memmove(l3 + 24, l3 + 20, len - 34);
+    memset(l3 + 20, 0x01, 4);
+    l3[0] = 0x46;
+    *(uint16_t*)(l3+2) = htobe16(be16toh(*(uint16_t*)(l3+2)) + 4);
+    len += 4;
+    test_decode_fast_compare(buf, len);
+
+    /* IPv4 fragments. */
+    len = test_decode_fast_packet(buf, 0, 0, 0, false, false, BBL_UDP_PORT);
+    l3 = buf + 14;
+    *(uint16_t*)(l3+6) = htobe16(IPV4_MF);
+    test_decode_fast_compare(buf, len);
+    *(uint16_t*)(l3+6) = htobe16(100);
+    test_decode_fast_compare(buf, len);
+
+    /* Bad PPPoE length. */
+    len = test_decode_fast_packet(buf, 100, 0, 0, true, false, BBL_UDP_PORT);
+    *(uint16_t*)(buf+18+4) = htobe16(len);
+    test_decode_fast_compare(buf, len);
+
+    /* Bad IP length. */
+    len = test_decode_fast_packet(buf, 0, 0, 0, false, false, BBL_UDP_PORT);
+    l3 = buf + 14;
+    *(uint16_t*)(l3+2) = htobe16(len);
+    test_decode_fast_compare(buf, len);
+    len = test_decode_fast_packet(buf, 0, 0, 0, false, true, BBL_UDP_PORT);
+    l3 = buf + 14;
+    *(uint16_t*)(l3+4) = htobe16(len);
+    test_decode_fast_compare(buf, len);
+    len = test_decode_fast_packet(buf, 100, 0, 0, true, false, BBL_UDP_PORT);
+    l3 = buf + 18 + 8;
+    *(uint16_t*)(l3+2) = htobe16(10);
+    test_decode_fast_compare(buf, len);
+
+    /* Non-stream packet. */
+    test_decode_fast_compare(pppoe_ipcp_conf_request, sizeof(pppoe_ipcp_conf_request));
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_protocols_decode_pppoe_ipcp_conf_request),
+        cmocka_unit_test(test_protocols_checksum),
+        cmocka_unit_test(test_protocols_checksum_update),
+        cmocka_unit_test(test_protocols_decode_fast),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
\ No newline at end of file
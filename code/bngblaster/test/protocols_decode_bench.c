@@ -0,0 +1,232 @@
+/*
+ * BNG Blaster (BBL) - Decode Benchmark
+ *
+ * This simple application is build to messure
+ * the decode performance of BNG Blaster stream
+ * traffic using the full decoder (decode_ethernet)
+ * and the stream fast path (decode_ethernet_fast)
+ * and to verify that both return the same result.
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <bbl_def.h>
+#include <bbl_protocols.h>
+
+#include "ethernet_packets.h"
+
+#define PACKETS     7
+#define ITERATIONS  1000000
+
+typedef protocol_error_t (*decode_fn)(uint8_t *buf, uint16_t len,
+                                      uint8_t *sp, uint16_t sp_len,
+                                      bbl_ethernet_header_s **ethernet);
+
+uint8_t g_packet[PACKETS][256];
+uint16_t g_packet_len[PACKETS];
+
+uint8_t g_mac_dst[ETH_ADDR_LEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+uint8_t g_mac_src[ETH_ADDR_LEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+uint8_t g_ipv6_src[IPV6_ADDR_LEN] = {0xfc, 0x66, 0x10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+uint8_t g_ipv6_dst[IPV6_ADDR_LEN] = {0xfc, 0x66, 0x10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2};
+
+static void
+build_packet(int index, uint16_t vlan_outer, uint16_t vlan_inner, bool pppoe_session, bool ipv6_packet)
+{
+    bbl_ethernet_header_s eth = {0};
+    bbl_pppoe_session_s pppoe = {0};
+    bbl_ipv4_s ipv4 = {0};
+    bbl_ipv6_s ipv6 = {0};
+    bbl_udp_s udp = {0};
+    bbl_bbl_s bbl = {0};
+
+    eth.dst = g_mac_dst;
+    eth.src = g_mac_src;
+    eth.vlan_outer = vlan_outer;
+    eth.vlan_outer_priority = 5;
+    eth.vlan_inner = vlan_inner;
+    eth.vlan_inner_priority = 3;
+    udp.src = BBL_UDP_PORT;
+    udp.dst = BBL_UDP_PORT;
+    udp.protocol = UDP_PROTOCOL_BBL;
+    udp.next = &bbl;
+    bbl.type = BBL_TYPE_UNICAST;
+    bbl.sub_type = ipv6_packet ? BBL_SUB_TYPE_IPV6 : BBL_SUB_TYPE_IPV4;
+    bbl.direction = BBL_DIRECTION_DOWN;
+    bbl.session_id = index + 1;
+    bbl.flow_id = index + 1;
+    bbl.flow_seq = 1000;
+    bbl.tos = 0xa0;
+    if(ipv6_packet) {
+        ipv6.src = g_ipv6_src;
+        ipv6.dst = g_ipv6_dst;
+        ipv6.ttl = 64;
+        ipv6.tos = 0xa0;
+        ipv6.protocol = IPV6_NEXT_HEADER_UDP;
+        ipv6.next = &udp;
+    } else {
+        ipv4.src = htobe32(0x0a000001);
+        ipv4.dst = htobe32(0x0a000002);
+        ipv4.ttl = 64;
+        ipv4.tos = 0xa0;
+        ipv4.offset = IPV4_DF;
+        ipv4.protocol = PROTOCOL_IPV4_UDP;
+        ipv4.next = &udp;
+    }
+    if(pppoe_session) {
+        eth.type = ETH_TYPE_PPPOE_SESSION;
+        eth.next = &pppoe;
+        pppoe.session_id = index + 1;
+        if(ipv6_packet) {
+            pppoe.protocol = PROTOCOL_IPV6;
+            pppoe.next = &ipv6;
+        } else {
+            pppoe.protocol = PROTOCOL_IPV4;
+            pppoe.next = &ipv4;
+        }
+    } else if(ipv6_packet) {
+        eth.type = ETH_TYPE_IPV6;
+        eth.next = &ipv6;
+    } else {
+        eth.type = ETH_TYPE_IPV4;
+        eth.next = &ipv4;
+    }
+    g_packet_len[index] = 0;
+    if(encode_ethernet(g_packet[index], &g_packet_len[index], &eth) != PROTOCOL_SUCCESS) {
+        fprintf(stderr, "Failed to encode packet %d\n", index);
+        exit(1);
+    }
+}
+
+static bool
+compare_result(bbl_ethernet_header_s *a, bbl_ethernet_header_s *b)
+{
+    bbl_pppoe_session_s *pppoe_a, *pppoe_b;
+    bbl_ipv4_s *ipv4_a, *ipv4_b;
+    bbl_ipv6_s *ipv6_a, *ipv6_b;
+    bbl_udp_s *udp_a, *udp_b;
+    void *next_a = a->next;
+    void *next_b = b->next;
+    uint16_t type;
+
+    if(a->length != b->length || a->type != b->type ||
+       a->vlan_outer != b->vlan_outer || a->vlan_inner != b->vlan_inner ||
+       a->vlan_outer_priority != b->vlan_outer_priority ||
+       a->vlan_inner_priority != b->vlan_inner_priority ||
+       a->vlan_three != b->vlan_three || a->qinq != b->qinq ||
+       a->tos != b->tos || a->dst != b->dst || a->src != b->src ||
+       a->mpls != b->mpls || !a->bbl || !b->bbl) {
+        return false;
+    }
+    if(memcmp(a->bbl, b->bbl, sizeof(bbl_bbl_s)) != 0) {
+        return false;
+    }
+    type = a->type;
+    if(type == ETH_TYPE_PPPOE_SESSION) {
+        pppoe_a = next_a; pppoe_b = next_b;
+        if(pppoe_a->session_id != pppoe_b->session_id ||
+           pppoe_a->protocol != pppoe_b->protocol) {
+            return false;
+        }
+        type = pppoe_a->protocol == PROTOCOL_IPV4 ? ETH_TYPE_IPV4 : ETH_TYPE_IPV6;
+        next_a = pppoe_a->next; next_b = pppoe_b->next;
+    }
+    if(type == ETH_TYPE_IPV4) {
+        ipv4_a = next_a; ipv4_b = next_b;
+        if(ipv4_a->src != ipv4_b->src || ipv4_a->dst != ipv4_b->dst ||
+           ipv4_a->tos != ipv4_b->tos || ipv4_a->ttl != ipv4_b->ttl ||
+           ipv4_a->protocol != ipv4_b->protocol || ipv4_a->id != ipv4_b->id ||
+           ipv4_a->offset != ipv4_b->offset || ipv4_a->len != ipv4_b->len ||
+           ipv4_a->hdr != ipv4_b->hdr || ipv4_a->payload != ipv4_b->payload ||
+           ipv4_a->payload_len != ipv4_b->payload_len) {
+            return false;
+        }
+        next_a = ipv4_a->next; next_b = ipv4_b->next;
+    } else {
+        ipv6_a = next_a; ipv6_b = next_b;
+        if(ipv6_a->src != ipv6_b->src || ipv6_a->dst != ipv6_b->dst ||
+           ipv6_a->tos != ipv6_b->tos || ipv6_a->ttl != ipv6_b->ttl ||
+           ipv6_a->protocol != ipv6_b->protocol || ipv6_a->len != ipv6_b->len ||
+           ipv6_a->hdr != ipv6_b->hdr || ipv6_a->payload != ipv6_b->payload ||
+           ipv6_a->payload_len != ipv6_b->payload_len) {
+            return false;
+        }
+        next_a = ipv6_a->next; next_b = ipv6_b->next;
+    }
+    udp_a = next_a; udp_b = next_b;
+    if(udp_a->src != udp_b->src || udp_a->dst != udp_b->dst ||
+       udp_a->protocol != udp_b->protocol ||
+       udp_a->payload_len != udp_b->payload_len) {
+        return false;
+    }
+    return true;
+}
+
+static double
+run(const char *name, decode_fn fn, uint8_t *sp)
+{
+    struct timespec tstart={0,0}, tend={0,0};
+    bbl_ethernet_header_s *eth;
+    uint32_t errors = 0;
+    double result;
+    int i, p;
+
+    clock_gettime(CLOCK_MONOTONIC, &tstart);
+    for(i = 0; i < ITERATIONS; i++) {
+        for(p = 0; p < PACKETS; p++) {
+            if(fn(g_packet[p], g_packet_len[p], sp, SCRATCHPAD_LEN, &eth) != PROTOCOL_SUCCESS) {
+                errors++;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &tend);
+    result = ((double)tend.tv_sec + 1.0e-9*tend.tv_nsec) -
+             ((double)tstart.tv_sec + 1.0e-9*tstart.tv_nsec);
+    printf("%-22s %u packets in %.6f seconds (%.2f ns/packet, %u errors)\n",
+           name, ITERATIONS * PACKETS, result,
+           result * 1e9 / (ITERATIONS * PACKETS), errors);
+    return result;
+}
+
+int
+main() {
+    uint8_t *sp_full = calloc(1, SCRATCHPAD_LEN);
+    uint8_t *sp_fast = calloc(1, SCRATCHPAD_LEN);
+    bbl_ethernet_header_s *eth_full;
+    bbl_ethernet_header_s *eth_fast;
+    double full, fast;
+    int p;
+
+    build_packet(0, 0, 0, false, false);
+    build_packet(1, 0, 0, false, true);
+    build_packet(2, 100, 0, false, false);
+    build_packet(3, 100, 200, false, true);
+    build_packet(4, 100, 200, true, false);
+    build_packet(5, 100, 200, true, true);
+    build_packet(6, 100, 0, true, false);
+
+    /* Verify that both decoders return the same result. */
+    for(p = 0; p < PACKETS; p++) {
+        if(decode_ethernet(g_packet[p], g_packet_len[p], sp_full, SCRATCHPAD_LEN, &eth_full) != PROTOCOL_SUCCESS ||
+           decode_ethernet_fast(g_packet[p], g_packet_len[p], sp_fast, SCRATCHPAD_LEN, &eth_fast) != PROTOCOL_SUCCESS ||
+           !compare_result(eth_full, eth_fast)) {
+            fprintf(stderr, "Decode result of packet %d differs\n", p);
+            return 1;
+        }
+    }
+    /* Non-stream packets must be passed to the full decoder. */
+    if(decode_ethernet_fast(pppoe_ipcp_conf_request, sizeof(pppoe_ipcp_conf_request), sp_fast, SCRATCHPAD_LEN, &eth_fast) != PROTOCOL_SUCCESS) {
+        fprintf(stderr, "Decode of non-stream packet failed\n");
+        return 1;
+    }
+
+    full = run("decode_ethernet", decode_ethernet, sp_full);
+    fast = run("decode_ethernet_fast", decode_ethernet_fast, sp_fast);
+    printf("Speedup: %.2fx\n", full / fast);
+    return 0;
+}
@@ -0,0 +1,201 @@
+/*
+ * BNG Blaster (BBL) - TXQ Benchmark
+ *
+ * This simple application is build to messure
+ * the TXQ throughput between a producer and a
+ * consumer thread pinned to different CPU cores
+ * using the single slot API (write_slot/read_slot)
+ * and the batch API (reserve/commit and peek/release)
+ * and to verify that all packets are received in
+ * order and unmodified.
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <bbl_def.h>
+#include <bbl_protocols.h>
+#include <bbl_txq.h>
+
+#define PACKETS     10000000
+#define SLOTS       4096
+
+typedef struct bench_ {
+    bbl_txq_s txq;
+    uint16_t packet_len;
+    bool batch;
+    bool random;
+    uint32_t errors;
+} bench_s;
+
+static uint16_t
+packet_len(bench_s *bench, uint32_t seq)
+{
+    if(bench->random) {
+        return 64 + ((seq * 2654435761U) >> 16) % 1437;
+    }
+    return bench->packet_len;
+}
+
+static void
+pin(int core)
+{
+    cpu_set_t cpuset;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    CPU_ZERO(&cpuset);
+    CPU_SET(core % (cores > 0 ? cores : 1), &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+}
+
+static void *
+producer(void *arg)
+{
+    bench_s *bench = arg;
+    bbl_txq_s *txq = &bench->txq;
+    bbl_txq_slot_t *slot;
+    uint32_t seq = 0;
+    uint16_t count = 0;
+    uint16_t len;
+
+    pin(0);
+    while(seq < PACKETS) {
+        len = packet_len(bench, seq);
+        if(bench->batch) {
+            slot = bbl_txq_reserve(txq, len);
+            if(!slot) {
+                if(count) {
+                    bbl_txq_commit(txq);
+                    count = 0;
+                }
+                sched_yield();
+                continue;
+            }
+            slot->packet_len = len;
+            *(uint32_t*)slot->packet = seq;
+            slot->packet[len-1] = (uint8_t)seq;
+            bbl_txq_reserve_next(txq);
+            if(++count == BBL_TXQ_BATCH) {
+                bbl_txq_commit(txq);
+                count = 0;
+            }
+        } else {
+            slot = bbl_txq_write_slot(txq);
+            if(!slot) {
+                sched_yield();
+                continue;
+            }
+            slot->packet_len = len;
+            *(uint32_t*)slot->packet = seq;
+            slot->packet[len-1] = (uint8_t)seq;
+            bbl_txq_write_next(txq);
+        }
+        seq++;
+    }
+    bbl_txq_commit(txq);
+    return NULL;
+}
+
+static void *
+consumer(void *arg)
+{
+    bench_s *bench = arg;
+    bbl_txq_s *txq = &bench->txq;
+    bbl_txq_slot_t *slots[BBL_TXQ_BATCH];
+    bbl_txq_slot_t *slot;
+    uint32_t seq = 0;
+    uint16_t count;
+    uint16_t i;
+
+    pin(1);
+    while(seq < PACKETS) {
+        if(bench->batch) {
+            count = bbl_txq_peek(txq, slots, BBL_TXQ_BATCH);
+            if(!count) {
+                sched_yield();
+                continue;
+            }
+            for(i = 0; i < count; i++) {
+                slot = slots[i];
+                if(slot->packet_len != packet_len(bench, seq) ||
+                   *(uint32_t*)slot->packet != seq ||
+                   slot->packet[slot->packet_len-1] != (uint8_t)seq) {
+                    bench->errors++;
+                }
+                seq++;
+            }
+            bbl_txq_release(txq, count);
+        } else {
+            slot = bbl_txq_read_slot(txq);
+            if(!slot) {
+                sched_yield();
+                continue;
+            }
+            if(slot->packet_len != packet_len(bench, seq) ||
+               *(uint32_t*)slot->packet != seq ||
+               slot->packet[slot->packet_len-1] != (uint8_t)seq) {
+                bench->errors++;
+            }
+            bbl_txq_read_next(txq);
+            seq++;
+        }
+    }
+    return NULL;
+}
+
+static uint32_t
+run(uint16_t len, bool batch)
+{
+    struct timespec tstart={0,0}, tend={0,0};
+    pthread_t thread_producer, thread_consumer;
+    bench_s bench = {0};
+    double result;
+
+    bench.packet_len = len;
+    bench.random = len == 0;
+    bench.batch = batch;
+    if(!bbl_txq_init(&bench.txq, SLOTS)) {
+        fprintf(stderr, "Failed to init TXQ\n");
+        exit(1);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &tstart);
+    pthread_create(&thread_consumer, NULL, consumer, &bench);
+    pthread_create(&thread_producer, NULL, producer, &bench);
+    pthread_join(thread_producer, NULL);
+    pthread_join(thread_consumer, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &tend);
+    result = ((double)tend.tv_sec + 1.0e-9*tend.tv_nsec) -
+             ((double)tstart.tv_sec + 1.0e-9*tstart.tv_nsec);
+
+    if(bench.random) {
+        printf("%-6s random %u packets in %.6f seconds (%.2f Mpps, %u errors)\n",
+               batch ? "batch" : "single", PACKETS, result,
+               PACKETS / result / 1e6, bench.errors);
+    } else {
+        printf("%-6s %6u %u packets in %.6f seconds (%.2f Mpps, %u errors)\n",
+               batch ? "batch" : "single", len, PACKETS, result,
+               PACKETS / result / 1e6, bench.errors);
+    }
+    free(bench.txq.ring);
+    return bench.errors;
+}
+
+int
+main() {
+    uint16_t sizes[] = {64, 256, 1500, 0};
+    uint32_t errors = 0;
+    size_t i;
+
+    for(i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+        errors += run(sizes[i], false);
+        errors += run(sizes[i], true);
+    }
+    return errors ? 1 : 0;
+}
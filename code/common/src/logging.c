@@ -17,12 +17,12 @@ FILE *g_log_fp = NULL;
 char *g_log_file = NULL;
 
 /*
- * Format the logging timestamp.
+ * Format the logging timestamp in a per thread buffer.
  */
 char *
 log_format_timestamp(void)
 {
-    static char ts_str[sizeof("Jun 19 08:07:13.711541")];
+    static __thread char ts_str[sizeof("Jun 19 08:07:13.711541")];
     struct timespec now;
     struct tm tm;
     int len;
@@ -0,0 +1,138 @@
+/*
+ * Slab Allocator
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "slab.h"
+
+static inline uint32_t
+slab_class(uint32_t size)
+{
+    uint32_t class = (size + SLAB_CLASS_SIZE - 1) / SLAB_CLASS_SIZE;
+    return class ? class : 1;
+}
+
+/*
+ * Initialize slab allocator for objects up to max_size
+ * bytes, rounded up to the next size class.
+ */
+bool
+slab_init(slab_s *slab, uint32_t max_size)
+{
+    memset(slab, 0x0, sizeof(slab_s));
+    slab->classes = slab_class(max_size) + 1;
+    slab->max_size = (slab->classes - 1) * SLAB_CLASS_SIZE;
+    slab->free_list = calloc(slab->classes, sizeof(void*));
+    return slab->free_list != NULL;
+}
+
+/*
+ * Free all chunks of the slab allocator. Objects
+ * larger than max_size must be freed before.
+ */
+void
+slab_destroy(slab_s *slab)
+{
+    void *chunk = slab->chunk;
+    void *next;
+
+    while(chunk) {
+        next = *(void**)chunk;
+        free(chunk);
+        chunk = next;
+    }
+    if(slab->free_list) {
+        free(slab->free_list);
+    }
+    memset(slab, 0x0, sizeof(slab_s));
+}
+
+/*
+ * Return the real size of an object allocated with given size.
+ */
+uint32_t
+slab_size(slab_s *slab, uint32_t size)
+{
+    if(size > slab->max_size) {
+        return size;
+    }
+    return slab_class(size) * SLAB_CLASS_SIZE;
+}
+
+void *
+slab_alloc(slab_s *slab, uint32_t size)
+{
+    uint32_t class;
+    uint32_t obj_size;
+    uint8_t *chunk;
+    void *ptr;
+
+    if(size > slab->max_size) {
+        ptr = malloc(size);
+        if(ptr) {
+            slab->stats.objects++;
+            slab->stats.bytes += size;
+        }
+        return ptr;
+    }
+
+    class = slab_class(size);
+    obj_size = class * SLAB_CLASS_SIZE;
+    if(slab->free_list[class]) {
+        ptr = slab->free_list[class];
+        slab->free_list[class] = *(void**)ptr;
+    } else {
+        if(slab->left < obj_size) {
+            chunk = malloc(SLAB_CHUNK_SIZE);
+            if(!chunk) {
+                return NULL;
+            }
+            /* Move the remaining tail of the 
+             * current chunk to the free list. */
+            class = slab->left / SLAB_CLASS_SIZE;
+            if(class) {
+                *(void**)slab->cur = slab->free_list[class];
+                slab->free_list[class] = slab->cur;
+            }
+            /* The first bytes of each chunk are used 
+             * to link all chunks together. */
+            *(void**)chunk = slab->chunk;
+            slab->chunk = chunk;
+            slab->cur = chunk + SLAB_CLASS_SIZE;
+            slab->left = SLAB_CHUNK_SIZE - SLAB_CLASS_SIZE;
+            slab->stats.chunks++;
+        }
+        ptr = slab->cur;
+        slab->cur += obj_size;
+        slab->left -= obj_size;
+    }
+    slab->stats.objects++;
+    slab->stats.bytes += obj_size;
+    return ptr;
+}
+
+/*
+ * Free object, where size must be equal to the
+ * size used to allocate (or of the same size class).
+ */
+void
+slab_free(slab_s *slab, void *ptr, uint32_t size)
+{
+    uint32_t class;
+
+    if(!ptr) {
+        return;
+    }
+    if(size > slab->max_size) {
+        free(ptr);
+        slab->stats.objects--;
+        slab->stats.bytes -= size;
+        return;
+    }
+    class = slab_class(size);
+    *(void**)ptr = slab->free_list[class];
+    slab->free_list[class] = ptr;
+    slab->stats.objects--;
+    slab->stats.bytes -= class * SLAB_CLASS_SIZE;
+}
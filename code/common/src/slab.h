@@ -0,0 +1,43 @@
+/*
+ * Slab Allocator
+ *
+ * Objects are allocated in size classes of SLAB_CLASS_SIZE
+ * bytes from large chunks of memory. Freed objects are kept
+ * in a free list per size class for reuse. This allows to
+ * store millions of small variable length objects (e.g. PDUs)
+ * at their real size without per allocation overhead.
+ *
+ * The allocator is not thread-safe.
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __COMMON_SLAB_H__
+#define __COMMON_SLAB_H__
+#include "common.h"
+
+#define SLAB_CLASS_SIZE     64
+#define SLAB_CHUNK_SIZE     (1024*1024)
+
+typedef struct slab_ {
+    uint32_t max_size; /* objects larger than max size are allocated via malloc */
+    uint32_t classes;
+    void **free_list; /* free objects per size class */
+    void *chunk; /* list of chunks */
+    uint8_t *cur; /* next free byte of current chunk */
+    size_t left; /* bytes left in current chunk */
+
+    struct {
+        uint64_t objects;
+        uint64_t bytes; /* bytes allocated for objects */
+        uint64_t chunks;
+    } stats;
+} slab_s;
+
+bool slab_init(slab_s *slab, uint32_t max_size);
+void slab_destroy(slab_s *slab);
+uint32_t slab_size(slab_s *slab, uint32_t size);
+void *slab_alloc(slab_s *slab, uint32_t size);
+void slab_free(slab_s *slab, void *ptr, uint32_t size);
+
+#endif
@@ -107,14 +107,14 @@ timespec_sub(struct timespec *result, struct timespec *x, struct timespec *y)
 }
 
 /**
- * Format a timestamp in one of four buffers.
+ * Format a timestamp in one of four per thread buffers.
  * This way we can format upto 4 timespecs in one printf() call.
  */
 char *
 timespec_format(struct timespec *x)
 {
-    static char buffer[4][32];
-    static int idx = 0;
+    static __thread char buffer[4][32];
+    static __thread int idx = 0;
     char *ret;
 
     ret = buffer[idx];
@@ -143,6 +143,129 @@ timer_change(timer_s *timer)
     timer->on_change_list = true;
 }
 
+#ifdef BNGBLASTER_TIMER_HEAP
+/**
+ * Expiration of the first (earliest) timer of a bucket.
+ */
+static inline struct timespec *
+timer_bucket_expire(timer_bucket_s *timer_bucket)
+{
+    return &CIRCLEQ_FIRST(&timer_bucket->timer_qhead)->expire;
+}
+
+static inline void
+timer_heap_set(timer_root_s *root, uint32_t index, timer_bucket_s *timer_bucket)
+{
+    root->heap[index] = timer_bucket;
+    timer_bucket->heap_index = index + 1;
+}
+
+static void
+timer_heap_up(timer_root_s *root, uint32_t index)
+{
+    timer_bucket_s *timer_bucket = root->heap[index];
+    uint32_t parent;
+
+    while(index) {
+        parent = (index - 1) / 2;
+        if(timespec_compare(timer_bucket_expire(root->heap[parent]), 
+                            timer_bucket_expire(timer_bucket)) <= 0) {
+            break;
+        }
+        timer_heap_set(root, index, root->heap[parent]);
+        index = parent;
+    }
+    timer_heap_set(root, index, timer_bucket);
+}
+
+static void
+timer_heap_down(timer_root_s *root, uint32_t index)
+{
+    timer_bucket_s *timer_bucket = root->heap[index];
+    uint32_t child;
+
+    while(true) {
+        child = index * 2 + 1;
+        if(child >= root->heap_len) {
+            break;
+        }
+        if(child + 1 < root->heap_len &&
+           timespec_compare(timer_bucket_expire(root->heap[child+1]), 
+                            timer_bucket_expire(root->heap[child])) < 0) {
+            child++;
+        }
+        if(timespec_compare(timer_bucket_expire(timer_bucket), 
+                            timer_bucket_expire(root->heap[child])) <= 0) {
+            break;
+        }
+        timer_heap_set(root, index, root->heap[child]);
+        index = child;
+    }
+    timer_heap_set(root, index, timer_bucket);
+}
+
+static bool
+timer_heap_push(timer_root_s *root, timer_bucket_s *timer_bucket)
+{
+    timer_bucket_s **heap;
+    uint32_t size;
+
+    if(root->heap_len == root->heap_size) {
+        size = root->heap_size ? root->heap_size * 2 : 64;
+        heap = realloc(root->heap, size * sizeof(timer_bucket_s*));
+        if(!heap) {
+            return false;
+        }
+        root->heap = heap;
+        root->heap_size = size;
+    }
+    timer_heap_set(root, root->heap_len++, timer_bucket);
+    timer_heap_up(root, root->heap_len - 1);
+    return true;
+}
+
+static void
+timer_heap_remove(timer_root_s *root, timer_bucket_s *timer_bucket)
+{
+    uint32_t index = timer_bucket->heap_index - 1;
+
+    timer_bucket->heap_index = 0;
+    if(--root->heap_len == index) {
+        return;
+    }
+    timer_heap_set(root, index, root->heap[root->heap_len]);
+    timer_heap_up(root, index);
+    timer_heap_down(root, root->heap[index]->heap_index - 1);
+}
+
+/**
+ * Next bucket in walk list or NULL.
+ */
+static timer_bucket_s *
+timer_walk_next(timer_root_s *root, timer_bucket_s *timer_bucket)
+{
+    if(timer_bucket == CIRCLEQ_LAST(&root->timer_walk_qhead)) {
+        return NULL;
+    }
+    return CIRCLEQ_NEXT(timer_bucket, timer_walk_qnode);
+}
+
+/**
+ * Restore heap order after the first timer 
+ * of a bucket has changed.
+ */
+static void
+timer_heap_update(timer_bucket_s *timer_bucket)
+{
+    timer_root_s *root = timer_bucket->timer_root;
+
+    if(timer_bucket->heap_index) {
+        timer_heap_up(root, timer_bucket->heap_index - 1);
+        timer_heap_down(root, timer_bucket->heap_index - 1);
+    }
+}
+#endif
+
 static void
 timer_enqueue_bucket(timer_root_s *root, timer_s *timer, time_t sec, long nsec)
 {
@@ -180,6 +303,15 @@ timer_enqueue_bucket(timer_root_s *root, timer_s *timer, time_t sec, long nsec)
     timer->timer_bucket = timer_bucket;
     CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
     timer_bucket->timers++;
+#ifdef BNGBLASTER_TIMER_HEAP
+    if(timer_bucket->timers == 1) {
+        /* New buckets are added to the heap with 
+         * their first timer as sort key. */
+        if(!timer_heap_push(root, timer_bucket)) {
+            CIRCLEQ_INSERT_TAIL(&root->timer_walk_qhead, timer_bucket, timer_walk_qnode);
+        }
+    }
+#endif
 }
 
 /**
@@ -191,9 +323,16 @@ timer_dequeue_bucket(timer_s *timer)
     timer_root_s *timer_root;
     timer_bucket_s *timer_bucket;
 
+#ifdef BNGBLASTER_TIMER_HEAP
+    bool first;
+#endif
+
     timer_bucket = timer->timer_bucket;
     timer_root = timer_bucket->timer_root;
 
+#ifdef BNGBLASTER_TIMER_HEAP
+    first = (CIRCLEQ_FIRST(&timer_bucket->timer_qhead) == timer);
+#endif
     CIRCLEQ_REMOVE(&timer_bucket->timer_qhead, timer, timer_qnode);
     timer_bucket->timers--;
     timer->timer_bucket = NULL;
@@ -202,6 +341,16 @@ timer_dequeue_bucket(timer_s *timer)
      * remove the bucket as well. */
     if(!timer_bucket->timers) {
         CIRCLEQ_REMOVE(&timer_root->timer_bucket_qhead, timer_bucket, timer_bucket_qnode);
+#ifdef BNGBLASTER_TIMER_HEAP
+        if(timer_bucket->heap_index) {
+            timer_heap_remove(timer_root, timer_bucket);
+        } else {
+            if(timer_root->walk_next == timer_bucket) {
+                timer_root->walk_next = timer_walk_next(timer_root, timer_bucket);
+            }
+            CIRCLEQ_REMOVE(&timer_root->timer_walk_qhead, timer_bucket, timer_walk_qnode);
+        }
+#endif
 
 #ifdef BNGBLASTER_TIMER_LOGGING
         LOG(TIMER_DETAIL, "  Delete timer bucket %lu.%06lus\n",
@@ -210,6 +359,10 @@ timer_dequeue_bucket(timer_s *timer)
 
         free(timer_bucket);
         timer_root->buckets--;
+#ifdef BNGBLASTER_TIMER_HEAP
+    } else if(first) {
+        timer_heap_update(timer_bucket);
+#endif
     }
 }
 
@@ -229,8 +382,19 @@ timer_requeue(timer_s *timer, time_t sec, long nsec)
      * If there is no match, do a slightly more expensive
      * bucket dequeue and enqueue. */
     if(timer_bucket->sec == sec && timer_bucket->nsec == nsec) {
+#ifdef BNGBLASTER_TIMER_HEAP
+        if(CIRCLEQ_FIRST(&timer_bucket->timer_qhead) == timer) {
+            CIRCLEQ_REMOVE(&timer_bucket->timer_qhead, timer, timer_qnode);
+            CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
+            timer_heap_update(timer_bucket);
+        } else {
+            CIRCLEQ_REMOVE(&timer_bucket->timer_qhead, timer, timer_qnode);
+            CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
+        }
+#else
         CIRCLEQ_REMOVE(&timer_bucket->timer_qhead, timer, timer_qnode);
         CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
+#endif
     } else {
         timer_dequeue_bucket(timer);
         timer_enqueue_bucket(timer_root, timer, sec, nsec);
@@ -288,6 +452,9 @@ timer_smear_bucket(timer_root_s *root, time_t sec, long nsec)
                     timer->expire.tv_sec, timer->expire.tv_nsec / 1000);
 #endif
             }
+#ifdef BNGBLASTER_TIMER_HEAP
+            timer_heap_update(timer_bucket);
+#endif
         }
         return;
     }
@@ -332,6 +499,9 @@ timer_smear_all_buckets(timer_root_s *root)
                     last_timer->expire.tv_sec, last_timer->expire.tv_nsec / 1000);
 #endif
             }
+#ifdef BNGBLASTER_TIMER_HEAP
+            timer_heap_update(timer_bucket);
+#endif
         }
     }
 }
@@ -490,73 +660,157 @@ timer_add_periodic(timer_root_s *root, timer_s **ptimer, char *name,
 }
 
 /**
- * Process the timer queue.
- *
- * @param root timer root
+ * Move a timer to another timer root, keeping
+ * name, interval, callback and data. The old timer
+ * is deleted with the next change processing of its
+ * root, which must not run concurrently.
  */
 void
-timer_walk(timer_root_s *root)
+timer_move(timer_root_s *root, timer_s **ptimer)
 {
-    timer_s *timer;
+    timer_s *timer = *ptimer;
     timer_bucket_s *timer_bucket;
-    struct timespec now, min, sleep, rem;
-    int res;
+    char name[sizeof(timer->name)];
+    bool periodic;
+    bool reset;
 
-    /* No buckets filled and we're done. */
-    if(CIRCLEQ_EMPTY(&root->timer_bucket_qhead)) {
+    if(!(timer && timer->timer_bucket)) {
         return;
     }
+    timer_bucket = timer->timer_bucket;
+    if(timer_bucket->timer_root == root) {
+        return;
+    }
+    memcpy(name, timer->name, sizeof(name));
+    periodic = timer->periodic;
+    reset = timer->reset;
+
+    /* Detach the old timer from the pointer
+     * before it gets deleted. */
+    timer->ptimer = NULL;
+    *ptimer = NULL;
+    timer_del(timer);
+
+    timer_add(root, ptimer, name, timer_bucket->sec, timer_bucket->nsec, timer->data, timer->cb);
+    /* The old timer may still expire before it
+     * gets deleted, which must not call into the
+     * callback on the old root anymore. */
+    timer->cb = NULL;
+    if(*ptimer) {
+        (*ptimer)->periodic = periodic;
+        (*ptimer)->reset = reset;
+    }
+}
 
-    clock_gettime(CLOCK_MONOTONIC, &now);
+/**
+ * Call into all expired timers of a bucket.
+ */
+static void
+timer_bucket_walk(timer_bucket_s *timer_bucket, struct timespec *now)
+{
+    timer_s *timer;
 
 #ifdef BNGBLASTER_TIMER_LOGGING
-    LOG(TIMER_DETAIL, "Walk timer queue, now %lu.%06lus\n",
-        now.tv_sec, now.tv_nsec / 1000);
+    LOG(TIMER_DETAIL, "  Checking timer bucket %lu.%06lus\n",
+        timer_bucket->sec, timer_bucket->nsec/1000);
 #endif
 
-    min.tv_sec = 0;
-    min.tv_nsec = 0;
+    CIRCLEQ_FOREACH(timer, &timer_bucket->timer_qhead, timer_qnode) {
 
-    /* Walk all buckets. */
-    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
+        /* Hitting the first non-expired timer means
+         * we're done processing this buckets queue. */
+        if(timespec_compare(&timer->expire, now) == 1) {
+            break;
+        }
+
+        /* Everything from here one is expired. */
+        timer->expired = true;
 
+        /* Execute callback. */
+        if(timer->cb) {
+            timer->timestamp = now;
+            (*timer->cb)(timer);
 #ifdef BNGBLASTER_TIMER_LOGGING
-        LOG(TIMER_DETAIL, "  Checking timer bucket %lu.%06lus\n",
-            timer_bucket->sec, timer_bucket->nsec/1000);
+            LOG(TIMER_DETAIL, "  Firing %s timer\n", timer->name);
 #endif
+        }
+        if(timer->periodic) {
+            /* Periodic timers are simple de-queued and
+             * re-inserted at the tail of this buckets queue. */
+            timer_change(timer);
+        } else if(timer->expired) {
+            /* Timers restarted in callback will not be expired anymore.
+             * Those timer gets deleted. */
+            timer_del(timer);
+        }
+    }
+}
 
-        /* First pass. Call into expired nodes. */
-        CIRCLEQ_FOREACH(timer, &timer_bucket->timer_qhead, timer_qnode) {
+#ifdef BNGBLASTER_TIMER_HEAP
+/**
+ * Call into all expired timers and return the 
+ * next expiration (min) using the bucket heap.
+ */
+static void
+timer_walk_heap(timer_root_s *root, struct timespec *now, struct timespec *min)
+{
+    timer_bucket_s *timer_bucket;
 
-            /* Hitting the first non-expired timer means
-             * we're done processing this buckets queue. */
-            if(timespec_compare(&timer->expire, &now) == 1) {
-                break;
-            }
+    /* Move all expired buckets from heap to walk list. */
+    while(root->heap_len) {
+        timer_bucket = root->heap[0];
+        if(timespec_compare(timer_bucket_expire(timer_bucket), now) == 1) {
+            break;
+        }
+        timer_heap_remove(root, timer_bucket);
+        CIRCLEQ_INSERT_TAIL(&root->timer_walk_qhead, timer_bucket, timer_walk_qnode);
+    }
 
-            /* Everything from here one is expired. */
-            timer->expired = true;
+    /* First pass. Call into expired nodes. Buckets removed 
+     * by callbacks are also removed from walk list. */
+    if(!CIRCLEQ_EMPTY(&root->timer_walk_qhead)) {
+        root->walk_next = CIRCLEQ_FIRST(&root->timer_walk_qhead);
+        while((timer_bucket = root->walk_next)) {
+            root->walk_next = timer_walk_next(root, timer_bucket);
+            timer_bucket_walk(timer_bucket, now);
+        }
+    }
 
-            /* Execute callback. */
-            if(timer->cb) {
-                timer->timestamp = &now;
-                (*timer->cb)(timer);
-#ifdef BNGBLASTER_TIMER_LOGGING
-                LOG(TIMER_DETAIL, "  Firing %s timer\n", timer->name);
-#endif
-            }
-            if(timer->periodic) {
-                /* Periodic timers are simple de-queued and
-                 * re-inserted at the tail of this buckets queue. */
-                timer_change(timer);
-            } else if(timer->expired) {
-                /* Timers restarted in callback will not be expired anymore.
-                 * Those timer gets deleted. */
-                timer_del(timer);
-            }
+    /* Process all changes from the last timer run. */
+    timer_process_changes(root);
+
+    /* Move walked buckets back to heap. */
+    while(!CIRCLEQ_EMPTY(&root->timer_walk_qhead)) {
+        timer_bucket = CIRCLEQ_FIRST(&root->timer_walk_qhead);
+        CIRCLEQ_REMOVE(&root->timer_walk_qhead, timer_bucket, timer_walk_qnode);
+        if(!timer_heap_push(root, timer_bucket)) {
+            CIRCLEQ_INSERT_TAIL(&root->timer_walk_qhead, timer_bucket, timer_walk_qnode);
+            break;
         }
     }
 
+    /* The first bucket in the heap has the min sleep time. */
+    if(root->heap_len) {
+        min->tv_sec = timer_bucket_expire(root->heap[0])->tv_sec;
+        min->tv_nsec = timer_bucket_expire(root->heap[0])->tv_nsec;
+    }
+}
+#else
+/**
+ * Call into all expired timers and return the 
+ * next expiration (min) walking all buckets.
+ */
+static void
+timer_walk_buckets(timer_root_s *root, struct timespec *now, struct timespec *min)
+{
+    timer_s *timer;
+    timer_bucket_s *timer_bucket;
+
+    /* First pass. Walk all buckets and call into expired nodes. */
+    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
+        timer_bucket_walk(timer_bucket, now);
+    }
+
     /* Process all changes from the last timer run. */
     timer_process_changes(root);
 
@@ -570,34 +824,87 @@ timer_walk(timer_root_s *root)
             }
 
             /* First timer in the queue becomes the actual minimum. */
-            if(min.tv_sec == 0 && min.tv_nsec == 0) {
-                min.tv_sec = timer->expire.tv_sec;
-                min.tv_nsec = timer->expire.tv_nsec;
+            if(min->tv_sec == 0 && min->tv_nsec == 0) {
+                min->tv_sec = timer->expire.tv_sec;
+                min->tv_nsec = timer->expire.tv_nsec;
             }
 
             /* Find the min timer. */
-            if(timespec_compare(&timer->expire, &min) == -1) {
-                min.tv_sec = timer->expire.tv_sec;
-                min.tv_nsec = timer->expire.tv_nsec;
+            if(timespec_compare(&timer->expire, min) == -1) {
+                min->tv_sec = timer->expire.tv_sec;
+                min->tv_nsec = timer->expire.tv_nsec;
 #ifdef BNGBLASTER_TIMER_LOGGING
                 LOG(TIMER_DETAIL, "New minimum sleep (%s) timer, found %lu.%06lus\n",
-                    timer->name, min.tv_sec, min.tv_nsec / 1000);
+                    timer->name, min->tv_sec, min->tv_nsec / 1000);
 #endif
             }
             /* Hitting the first non-expired timer means
              * we're done processing this buckets queue. */
-            if(timespec_compare(&timer->expire, &now) == 1) {
+            if(timespec_compare(&timer->expire, now) == 1) {
                 break;
             }
         }
     }
+}
+#endif
+
+/**
+ * Call into all expired timers without sleeping.
+ *
+ * @param root timer root
+ * @param next returns the expiration of the next
+ *        timer or zero if there is no timer
+ */
+void
+timer_process(timer_root_s *root, struct timespec *next)
+{
+    struct timespec now;
+
+    next->tv_sec = 0;
+    next->tv_nsec = 0;
+
+    /* No buckets filled and we're done. */
+    if(CIRCLEQ_EMPTY(&root->timer_bucket_qhead)) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+#ifdef BNGBLASTER_TIMER_LOGGING
+    LOG(TIMER_DETAIL, "Walk timer queue, now %lu.%06lus\n",
+        now.tv_sec, now.tv_nsec / 1000);
+#endif
+
+#ifdef BNGBLASTER_TIMER_HEAP
+    timer_walk_heap(root, &now, next);
+#else
+    timer_walk_buckets(root, &now, next);
+#endif
+}
+
+/**
+ * Process the timer queue and sleep 
+ * until the next timer expires.
+ *
+ * @param root timer root
+ */
+void
+timer_walk(timer_root_s *root)
+{
+    struct timespec now, min, sleep, rem;
+    int res;
+
+    timer_process(root, &min);
+    if(min.tv_sec == 0 && min.tv_nsec == 0) {
+        return;
+    }
 
     /* Calculate the sleep timer. */
+    clock_gettime(CLOCK_MONOTONIC, &now);
 #ifdef BNGBLASTER_TIMER_LOGGING
     LOG(TIMER_DETAIL, "  Now %lu.%06lus\n", now.tv_sec, now.tv_nsec / 1000);
     LOG(TIMER_DETAIL, "  Min %lu.%06lus\n", min.tv_sec, min.tv_nsec / 1000);
 #endif
-    clock_gettime(CLOCK_MONOTONIC, &now);
     if(timespec_compare(&now, &min) == -1) {
         timespec_sub(&sleep, &min, &now);
 #ifdef BNGBLASTER_TIMER_LOGGING
@@ -627,6 +934,9 @@ timer_init_root(timer_root_s *timer_root)
     CIRCLEQ_INIT(&timer_root->timer_bucket_qhead);
     CIRCLEQ_INIT(&timer_root->timer_gc_qhead);
     CIRCLEQ_INIT(&timer_root->timer_change_qhead);
+#ifdef BNGBLASTER_TIMER_HEAP
+    CIRCLEQ_INIT(&timer_root->timer_walk_qhead);
+#endif
 }
 
 /**
@@ -655,4 +965,10 @@ timer_flush_root(timer_root_s *timer_root)
         timer_root->gc--;
         free(timer);
     }
+#ifdef BNGBLASTER_TIMER_HEAP
+    free(timer_root->heap);
+    timer_root->heap = NULL;
+    timer_root->heap_len = 0;
+    timer_root->heap_size = 0;
+#endif
 }
@@ -24,6 +24,18 @@ typedef struct timer_root_
     uint32_t buckets; /* # of buckets hanging off */
     uint32_t gc; /* # of timers waiting for GC */
 
+#ifdef BNGBLASTER_TIMER_HEAP
+    /* Buckets are kept in a min-heap ordered by the expiration of their
+     * first timer, which is the earliest one as all timers of a bucket
+     * share the same interval. Expired buckets are moved from the heap
+     * to the walk list while their timers are processed. */
+    CIRCLEQ_HEAD(timer_walk_root_, timer_bucket_ ) timer_walk_qhead; /* Walk list */
+    struct timer_bucket_ *walk_next; /* Next bucket to walk */
+    struct timer_bucket_ **heap;
+    uint32_t heap_len;
+    uint32_t heap_size;
+#endif
+
 } timer_root_s;
 
 /* Group each like timers (e.g. all 100ms, 1s, 5s timers) into a timer bucket.
@@ -41,6 +53,11 @@ typedef struct timer_bucket_
     long nsec;
 
     uint32_t timers; /* # of timers hanging off this bucket */
+
+#ifdef BNGBLASTER_TIMER_HEAP
+    CIRCLEQ_ENTRY(timer_bucket_) timer_walk_qnode; /* node in walk list */
+    uint32_t heap_index; /* heap position + 1, zero if on walk list */
+#endif
 } timer_bucket_s;
 
 /* Timer which hangs off the bucket list. */
@@ -92,6 +109,12 @@ timer_add_periodic(timer_root_s *root, timer_s **ptimer, char *name,
                    time_t sec, long nsec, 
                    void *data, void (*cb)(timer_s *));
 
+void
+timer_move(timer_root_s *root, timer_s **ptimer);
+
+void
+timer_process(timer_root_s *root, struct timespec *next);
+
 void
 timer_walk(timer_root_s *root);
 
@@ -197,7 +197,7 @@ keyval_get_key (struct keyval_ *keyval, uint32_t val)
 /**
  * format_mac_address
  *
- * Format an MAC address as string in one of 16 static buffers.
+ * Format an MAC address as string in one of 16 per thread static buffers.
  *
  * @param mac MAC address bytes
  * @return MAC address string
@@ -205,8 +205,8 @@ keyval_get_key (struct keyval_ *keyval, uint32_t val)
 char *
 format_mac_address(uint8_t *mac) 
 {
-    static char buffer[16][MAC_STR_LEN];
-    static int idx = 0;
+    static __thread char buffer[16][MAC_STR_LEN];
+    static __thread int idx = 0;
     char *ret;
     ret = buffer[idx];
     idx = (idx+1) & 15;
@@ -217,7 +217,7 @@ format_mac_address(uint8_t *mac)
 /**
  * format_ipv4_address
  *
- * Format an IPv4 address as string in one of 32 static buffers.
+ * Format an IPv4 address as string in one of 32 per thread static buffers.
  *
  * @param addr4 IPv4 address bytes
  * @return IPv4 address string
@@ -225,8 +225,8 @@ format_mac_address(uint8_t *mac)
 char *
 format_ipv4_address(uint32_t *addr4)
 {
-    static char buffer[32][IPV4_DOTTED_STR_LEN];
-    static int idx = 0;
+    static __thread char buffer[32][IPV4_DOTTED_STR_LEN];
+    static __thread int idx = 0;
     char *ret;
     ret = buffer[idx];
     *ret = '\0';
@@ -238,7 +238,7 @@ format_ipv4_address(uint32_t *addr4)
 /**
  * format_ipv4_prefix
  *
- * Format an IPv4 prefix as string in one of 16 static buffers.
+ * Format an IPv4 prefix as string in one of 16 per thread static buffers.
  *
  * @param addr4 IPv4 prefix bytes
  * @return IPv4 prefix string
@@ -246,8 +246,8 @@ format_ipv4_address(uint32_t *addr4)
 char *
 format_ipv4_prefix(ipv4_prefix *addr4)
 {
-    static char buffer[16][IPV4_DOTTED_PREFIX_STR_LEN];
-    static int idx = 0;
+    static __thread char buffer[16][IPV4_DOTTED_PREFIX_STR_LEN];
+    static __thread int idx = 0;
     char *ret;
     ret = buffer[idx];
     *ret = '\0';
@@ -260,7 +260,7 @@ format_ipv4_prefix(ipv4_prefix *addr4)
 /**
  * format_ipv6_address
  *
- * Format an IPv6 address as string in one of 16 static buffers.
+ * Format an IPv6 address as string in one of 16 per thread static buffers.
  *
  * @param addr6 IPv6 address bytes
  * @return IPv6 address string
@@ -268,8 +268,8 @@ format_ipv4_prefix(ipv4_prefix *addr4)
 char *
 format_ipv6_address(ipv6addr_t *addr6)
 {
-    static char buffer[16][IPV6_STR_LEN];
-    static int idx = 0;
+    static __thread char buffer[16][IPV6_STR_LEN];
+    static __thread int idx = 0;
     char *ret;
     ret = buffer[idx];
     *ret = '\0';
@@ -281,7 +281,7 @@ format_ipv6_address(ipv6addr_t *addr6)
 /**
  * format_ipv6_prefix
  *
- * Format an IPv6 prefix as string in one of 16 static buffers.
+ * Format an IPv6 prefix as string in one of 16 per thread static buffers.
  *
  * @param addr6 IPv6 prefix bytes
  * @return IPv6 prefix string
@@ -289,8 +289,8 @@ format_ipv6_address(ipv6addr_t *addr6)
 char *
 format_ipv6_prefix(ipv6_prefix *addr6)
 {
-    static char buffer[16][IPV6_PREFIX_STR_LEN];
-    static int idx = 0;
+    static __thread char buffer[16][IPV6_PREFIX_STR_LEN];
+    static __thread int idx = 0;
     char *ret;
     ret = buffer[idx];
     *ret = '\0';
@@ -303,7 +303,7 @@ format_ipv6_prefix(ipv6_prefix *addr6)
 /**
  * format_iso_prefix
  *
- * Format an ISO prefix as string in one of 16 static buffers.
+ * Format an ISO prefix as string in one of 16 per thread static buffers.
  *
  * @param iso ISO prefix structure
  * @return ISO prefix string
@@ -315,8 +315,8 @@ format_iso_prefix(iso_prefix *iso)
     uint8_t hi_byte, lo_byte;
     uint16_t i, buf_idx, prefix_len;
 
-    static char buffer[16][ISO_STR_LEN];
-    static int idx = 0;
+    static __thread char buffer[16][ISO_STR_LEN];
+    static __thread int idx = 0;
     char *ret;
 
     ret = buffer[idx];
@@ -589,7 +589,7 @@ ipv6_prefix_not_zero(ipv6_prefix *prefix)
 /**
  * replace_substring
  *
- * Replace subscrtring in one of 4 static buffers.
+ * Replace subscrtring in one of 4 per thread static buffers.
  *
  * @param source source string
  * @param old subsctring to search for
@@ -605,8 +605,8 @@ replace_substring(const char* source,
         return NULL;
     }
 
-    static char buffer[4][SUB_STR_LEN];
-    static int idx = 0;
+    static __thread char buffer[4][SUB_STR_LEN];
+    static __thread int idx = 0;
     char  *result = buffer[idx];
     char  *result_pos = result;
     size_t result_len = 0;
@@ -675,3 +675,96 @@ ipv4_len_to_mask(uint8_t len)
     if(len == 0) return 0;
     return htobe32(~((1 << (32 - len)) - 1));
 }
+
+/**
+ * Get log-linear histogram bucket with four
+ * sub-buckets per power of two, which limits the
+ * relative error to 25%. Values exceeding the
+ * histogram are counted in the last bucket.
+ *
+ * @param value value (e.g. delay in microseconds)
+ * @param buckets number of histogram buckets
+ * @return bucket index
+ */
+uint8_t
+hist_log_bucket(uint64_t value, uint8_t buckets)
+{
+    uint64_t bucket;
+    int exp;
+
+    if(value < 4) {
+        bucket = value;
+    } else {
+        exp = 63 - __builtin_clzll(value);
+        bucket = ((exp - 1) << 2) | ((value >> (exp - 2)) & 3);
+    }
+    if(bucket >= buckets) {
+        bucket = buckets - 1;
+    }
+    return bucket;
+}
+
+/**
+ * Get highest value counted in the given
+ * log-linear histogram bucket.
+ *
+ * @param bucket bucket index
+ * @param buckets number of histogram buckets
+ * @return highest value or UINT64_MAX for last bucket
+ */
+uint64_t
+hist_log_bucket_max(uint8_t bucket, uint8_t buckets)
+{
+    int exp;
+
+    if(bucket >= buckets - 1) {
+        return UINT64_MAX;
+    }
+    if(bucket < 4) {
+        return bucket;
+    }
+    exp = (bucket >> 2) + 1;
+    return (((4 | (bucket & 3)) + 1) << (exp - 2)) - 1;
+}
+
+/**
+ * Get percentile from log-linear histogram.
+ *
+ * The result is the highest value of the bucket
+ * containing the percentile, limited to max.
+ *
+ * @param hist histogram
+ * @param buckets number of histogram buckets
+ * @param max maximum value
+ * @param percentile percentile (e.g. 99.9)
+ * @return value or zero if histogram is empty
+ */
+uint64_t
+hist_log_percentile(uint64_t *hist, uint8_t buckets, uint64_t max, double percentile)
+{
+    uint64_t total = 0;
+    uint64_t count = 0;
+    uint64_t value;
+    double rank;
+    int i;
+
+    for(i = 0; i < buckets; i++) {
+        total += hist[i];
+    }
+    if(!total) {
+        return 0;
+    }
+    rank = (total * percentile) / 100.0;
+    if(rank < 1.0) rank = 1.0;
+    for(i = 0; i < buckets - 1; i++) {
+        count += hist[i];
+        if(count >= rank) {
+            break;
+        }
+    }
+    value = hist_log_bucket_max(i, buckets);
+    if(value > max) {
+        value = max;
+    }
+    return value;
+}
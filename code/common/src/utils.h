@@ -49,4 +49,8 @@ char *string_or_na(char *string);
 
 uint8_t ipv4_mask_to_len(uint32_t mask);
 uint32_t ipv4_len_to_mask(uint8_t len);
+
+uint8_t  hist_log_bucket(uint64_t value, uint8_t buckets);
+uint64_t hist_log_bucket_max(uint8_t bucket, uint8_t buckets);
+uint64_t hist_log_percentile(uint64_t *hist, uint8_t buckets, uint64_t max, double percentile);
 #endif
@@ -0,0 +1,92 @@
+/*
+ * Slab Allocator Tests
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <slab.h>
+
+#define TEST_OBJECTS 50000
+
+static void
+test_slab_size(void **unused) {
+    (void) unused;
+
+    slab_s slab;
+    assert_true(slab_init(&slab, 1500));
+    assert_int_equal(slab_size(&slab, 0), SLAB_CLASS_SIZE);
+    assert_int_equal(slab_size(&slab, 1), SLAB_CLASS_SIZE);
+    assert_int_equal(slab_size(&slab, SLAB_CLASS_SIZE), SLAB_CLASS_SIZE);
+    assert_int_equal(slab_size(&slab, SLAB_CLASS_SIZE+1), SLAB_CLASS_SIZE*2);
+    assert_int_equal(slab_size(&slab, 1500), 1536);
+    assert_int_equal(slab_size(&slab, 1536), 1536);
+    assert_int_equal(slab_size(&slab, 1537), 1537);
+    slab_destroy(&slab);
+}
+
+static void
+test_slab_alloc(void **unused) {
+    (void) unused;
+
+    slab_s slab;
+    static uint8_t *ptr[TEST_OBJECTS];
+    uint32_t size;
+    int i;
+
+    assert_true(slab_init(&slab, 1500));
+
+    /* Allocate objects of different sizes 
+     * and fill them with a pattern. */
+    for(i = 0; i < TEST_OBJECTS; i++) {
+        size = 1 + (i * 37) % 2000;
+        ptr[i] = slab_alloc(&slab, size);
+        assert_non_null(ptr[i]);
+        memset(ptr[i], i & 0xff, size);
+    }
+    assert_int_equal(slab.stats.objects, TEST_OBJECTS);
+
+    /* Verify that objects do not overlap. */
+    for(i = 0; i < TEST_OBJECTS; i++) {
+        size = 1 + (i * 37) % 2000;
+        assert_int_equal(ptr[i][0], i & 0xff);
+        assert_int_equal(ptr[i][size-1], i & 0xff);
+    }
+
+    /* Free every second object and allocate 
+     * them again, which should not require 
+     * any new chunk. */
+    for(i = 0; i < TEST_OBJECTS; i += 2) {
+        size = 1 + (i * 37) % 2000;
+        slab_free(&slab, ptr[i], size);
+    }
+    assert_int_equal(slab.stats.objects, TEST_OBJECTS/2);
+    size = slab.stats.chunks;
+    for(i = 0; i < TEST_OBJECTS; i += 2) {
+        ptr[i] = slab_alloc(&slab, 1 + (i * 37) % 2000);
+        assert_non_null(ptr[i]);
+    }
+    assert_int_equal(slab.stats.chunks, size);
+    assert_int_equal(slab.stats.objects, TEST_OBJECTS);
+
+    /* Free large objects allocated via malloc. */
+    for(i = 0; i < TEST_OBJECTS; i++) {
+        size = 1 + (i * 37) % 2000;
+        if(size > 1500) {
+            slab_free(&slab, ptr[i], size);
+        }
+    }
+    slab_destroy(&slab);
+    assert_null(slab.chunk);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_slab_size),
+        cmocka_unit_test(test_slab_alloc),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,187 @@
+/*
+ * Timer Library Tests
+ *
+ * Copyright (C) 2020-2023, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <timer.h>
+
+#define TEST_TIMERS 64
+
+keyval_t log_names[] = {
+    { 0, NULL}
+};
+
+static int g_fired[TEST_TIMERS];
+static int g_order[TEST_TIMERS*4];
+static int g_order_idx;
+
+static void
+test_timer_cb(timer_s *timer)
+{
+    int id = *(int*)timer->data;
+    g_fired[id]++;
+    if(g_order_idx < TEST_TIMERS*4) {
+        g_order[g_order_idx++] = id;
+    }
+}
+
+static void
+test_timer_reset(void)
+{
+    memset(g_fired, 0x0, sizeof(g_fired));
+    memset(g_order, 0x0, sizeof(g_order));
+    g_order_idx = 0;
+}
+
+static void
+test_timer_expire_order(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    timer_s *timer[TEST_TIMERS] = {0};
+    int id[TEST_TIMERS];
+    int i;
+
+    test_timer_reset();
+    timer_init_root(&root);
+
+    /* Timers with different intervals (buckets) 
+     * added in reverse order of expiration. */
+    for(i = 0; i < 8; i++) {
+        id[i] = i;
+        timer_add(&root, &timer[i], "test", 0, (8-i) * 2 * MSEC, &id[i], &test_timer_cb);
+    }
+    assert_int_equal(root.buckets, 8);
+    while(g_order_idx < 8) {
+        timer_walk(&root);
+    }
+    for(i = 0; i < 8; i++) {
+        assert_int_equal(g_order[i], 7-i);
+        assert_int_equal(g_fired[i], 1);
+        /* Non-periodic timers are deleted after expiry. */
+        assert_null(timer[i]);
+    }
+    assert_int_equal(root.buckets, 0);
+    timer_flush_root(&root);
+}
+
+static void
+test_timer_periodic(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    timer_s *timer[TEST_TIMERS] = {0};
+    int id[TEST_TIMERS];
+    int i;
+
+    test_timer_reset();
+    timer_init_root(&root);
+
+    for(i = 0; i < 3; i++) {
+        id[i] = i;
+    }
+    timer_add_periodic(&root, &timer[0], "fast", 0, 1 * MSEC, &id[0], &test_timer_cb);
+    timer_add_periodic(&root, &timer[1], "slow", 0, 5 * MSEC, &id[1], &test_timer_cb);
+    timer_add(&root, &timer[2], "once", 0, 2 * MSEC, &id[2], &test_timer_cb);
+    while(g_fired[1] < 3) {
+        timer_walk(&root);
+    }
+    assert_true(g_fired[0] >= 10);
+    assert_int_equal(g_fired[2], 1);
+    assert_non_null(timer[0]);
+    assert_non_null(timer[1]);
+    assert_null(timer[2]);
+
+    /* Deleted periodic timers will not fire anymore. */
+    timer_del(timer[1]);
+    i = g_fired[1];
+    while(g_fired[0] < 30) {
+        timer_walk(&root);
+    }
+    assert_int_equal(g_fired[1], i);
+    assert_null(timer[1]);
+    assert_int_equal(root.buckets, 1);
+    timer_flush_root(&root);
+    assert_int_equal(root.gc, 0);
+}
+
+static void
+test_timer_restart(void **unused) {
+    (void) unused;
+
+    timer_root_s root = {0};
+    timer_s *timer[TEST_TIMERS] = {0};
+    int id[TEST_TIMERS];
+    int i;
+
+    test_timer_reset();
+    timer_init_root(&root);
+
+    /* Restarting a timer moves it to the new bucket, 
+     * which must be considered for the next expiration. */
+    for(i = 0; i < TEST_TIMERS; i++) {
+        id[i] = i;
+        timer_add(&root, &timer[i], "test", 0, (10+i) * MSEC, &id[i], &test_timer_cb);
+    }
+    assert_int_equal(root.buckets, TEST_TIMERS);
+    timer_add(&root, &timer[TEST_TIMERS-1], "test", 0, 1 * MSEC, &id[TEST_TIMERS-1], &test_timer_cb);
+    timer_add(&root, &timer[TEST_TIMERS-2], "test", 0, 2 * MSEC, &id[TEST_TIMERS-2], &test_timer_cb);
+    timer_del(timer[0]);
+    assert_int_equal(root.buckets, TEST_TIMERS);
+    while(g_order_idx < 2) {
+        timer_walk(&root);
+    }
+    assert_int_equal(g_order[0], TEST_TIMERS-1);
+    assert_int_equal(g_order[1], TEST_TIMERS-2);
+    assert_int_equal(g_fired[0], 0);
+    assert_int_equal(root.buckets, TEST_TIMERS-3);
+    timer_flush_root(&root);
+    assert_int_equal(root.buckets, 0);
+}
+
+static void
+test_timer_move(void **unused) {
+    (void) unused;
+
+    timer_root_s root1 = {0};
+    timer_root_s root2 = {0};
+    timer_s *timer = NULL;
+    timer_s *moved;
+    int id = 0;
+
+    test_timer_reset();
+    timer_init_root(&root1);
+    timer_init_root(&root2);
+
+    /* Moved periodic timers fire on the new root only. */
+    timer_add_periodic(&root1, &timer, "move", 0, 1 * MSEC, &id, &test_timer_cb);
+    timer_move(&root2, &timer);
+    assert_non_null(timer);
+    moved = timer;
+    while(g_fired[0] < 3) {
+        timer_walk(&root2);
+    }
+    timer_process(&root1, &(struct timespec){0});
+    assert_int_equal(g_fired[0], 3);
+    assert_ptr_equal(timer, moved);
+    assert_int_equal(root1.buckets, 0);
+    assert_int_equal(root2.buckets, 1);
+    timer_flush_root(&root1);
+    timer_flush_root(&root2);
+    assert_null(timer);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_timer_expire_order),
+        cmocka_unit_test(test_timer_periodic),
+        cmocka_unit_test(test_timer_restart),
+        cmocka_unit_test(test_timer_move),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -234,6 +234,35 @@ test_ipv6_multicast_mac(void **unused) {
     assert_memory_equal(mac_expected, mac, ETH_ADDR_LEN);
 }
 
+static void
+test_hist_log(void **unused) {
+    (void) unused;
+
+    uint64_t hist[64] = {0};
+    uint64_t value;
+
+    assert_int_equal(hist_log_bucket(0, 64), 0);
+    assert_int_equal(hist_log_bucket(3, 64), 3);
+    assert_int_equal(hist_log_bucket(4, 64), 4);
+    assert_int_equal(hist_log_bucket(1000, 64), 35);
+    assert_int_equal(hist_log_bucket(UINT64_MAX, 64), 63);
+
+    /* Each value must be within the range of its bucket. */
+    for(value = 0; value < 100000; value++) {
+        assert_true(value <= hist_log_bucket_max(hist_log_bucket(value, 64), 64));
+        if(value > 4) {
+            assert_true(value > hist_log_bucket_max(hist_log_bucket(value, 64) - 1, 64));
+        }
+    }
+
+    assert_int_equal(hist_log_percentile(hist, 64, 1000, 50.0), 0);
+    hist[hist_log_bucket(10, 64)] = 98;
+    hist[hist_log_bucket(1000, 64)] = 2;
+    assert_int_equal(hist_log_percentile(hist, 64, 2000, 50.0), 11);
+    assert_int_equal(hist_log_percentile(hist, 64, 2000, 99.0), 1023);
+    assert_int_equal(hist_log_percentile(hist, 64, 1000, 99.0), 1000);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_val2key),
@@ -254,6 +283,7 @@ int main() {
         cmocka_unit_test(test_string_or_na),
         cmocka_unit_test(test_ipv4_multicast_mac),
         cmocka_unit_test(test_ipv6_multicast_mac),
+        cmocka_unit_test(test_hist_log),
 
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
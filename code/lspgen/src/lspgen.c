@@ -63,6 +63,7 @@ static struct option long_options[] = {
     {"help", no_argument, NULL, 'h'},
     {"mrt-file", required_argument, NULL, 'm'},
     {"node-count", required_argument, NULL, 'c'},
+    {"topology", required_argument, NULL, 'o'},
     {"pcap-file", required_argument, NULL, 'p'},
     {"purge", no_argument, NULL, 'G'},
     {"stream-file", required_argument, NULL, 'f'},
@@ -92,6 +93,17 @@ struct keyval_ log_names[] = {
     { 0, NULL}
 };
 
+/*
+ * Topology / name translation table.
+ */
+struct keyval_ topology_names[] = {
+    { TOPOLOGY_RANDOM, "random" },
+    { TOPOLOGY_CLOS, "clos" },
+    { TOPOLOGY_RING, "ring" },
+    { TOPOLOGY_POWER_LAW, "power-law" },
+    { 0, NULL}
+};
+
 /*
  * Protocol / name translation table.
  */
@@ -154,6 +166,11 @@ lspgen_print_usage_arg(struct option *option)
 	    return lspgen_print_arg_options(proto_names);
         }
 
+	/* topology */
+	if (strcmp(option->name, "topology") == 0) {
+	    return lspgen_print_arg_options(topology_names);
+        }
+
 	/* logging */
 	if (strcmp(option->name, "log") == 0) {
 	    return lspgen_print_arg_options(log_names);
@@ -944,6 +961,7 @@ lspgen_init_ctx(struct lsdb_ctx_ *ctx)
     ctx->protocol_id = PROTO_ISIS;
 
     ctx->num_nodes = 10; /* Number of nodes */
+    ctx->topology = TOPOLOGY_RANDOM;
 
     /* IS-IS area */
     ctx->area[0].address[0] = 0x49;
@@ -1040,6 +1058,8 @@ lspgen_log_ctx(struct lsdb_ctx_ *ctx)
 
     LOG_NOARG(NORMAL, "LSP generation parameters\n");
     LOG(NORMAL, " Protocol %s\n", lsdb_format_proto(ctx));
+    LOG(NORMAL, " Topology %s, %u nodes, seed 0x%x\n",
+        val2key(topology_names, ctx->topology), ctx->num_nodes, ctx->seed);
 
     /*
      * No Area specified ? Show at least the default.
@@ -1270,7 +1290,7 @@ main(int argc, char *argv[])
      * Parse options.
      */
     idx = 0;
-    while ((opt = getopt_long(argc, argv, "vha:c:C:e:f:g:Gl:L:m:M:n:K:N:p:P:q:Qr:s:S:t:T:u:V:w:x:X:yzZ",
+    while ((opt = getopt_long(argc, argv, "vha:c:C:e:f:g:Gl:L:m:M:n:K:N:o:p:P:q:Qr:s:S:t:T:u:V:w:x:X:yzZ",
                               long_options, &idx)) != -1) {
         switch (opt) {
             case 'v':
@@ -1361,6 +1381,13 @@ main(int argc, char *argv[])
                 }
                 lspgen_compute_srgb_range(ctx);
                 break;
+            case 'o':
+                ctx->topology = key2val(topology_names, optarg);
+                if (!ctx->topology) {
+                    LOG(ERROR, "Unknown topology %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
             case 'C':
                 /* connector */
                 lspgen_add_connector(ctx, optarg);
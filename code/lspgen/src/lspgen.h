@@ -21,6 +21,7 @@
 #include <sys/stat.h>
 #include <sys/queue.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <sys/un.h>
 #include <arpa/inet.h>
 
@@ -31,6 +32,9 @@
 #include "lspgen_lsdb.h"
 
 #define CTRL_SOCKET_BUFSIZE 1024*4096
+#define CTRL_STREAM_BATCH_SIZE 256*1024 /* must not exceed the BNG Blaster max request size */
+#define CTRL_STREAM_WINDOW 4 /* max unacknowledged batches */
+#define CTRL_STREAM_ACK_LEN 8
 #define PAD4(X) ((X+3)&(~3)) /* 32-Bit padding */
 #define CONNECTOR_MARKER 1 /* Marker for connector link */
 
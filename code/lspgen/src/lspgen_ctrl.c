@@ -80,6 +80,25 @@ lspgen_enqueue_all_packets(lsdb_ctx_t *ctx)
     dict_itor_free(itor);
 }
 
+/*
+ * Remote has closed the connection.
+ * Requeue all packets to the change list and reconnect.
+ */
+static void
+lspgen_ctrl_restart(lsdb_ctx_t *ctx)
+{
+    timer_del(ctx->ctrl_socket_write_timer);
+    if (ctx->ctrl_socket_sockfd > 0) {
+	close(ctx->ctrl_socket_sockfd);
+	ctx->ctrl_socket_sockfd = 0;
+    }
+    timer_add_periodic(&ctx->timer_root, &ctx->ctrl_socket_connect_timer,
+		       "connect", 1, 0, ctx, &lspgen_ctrl_connect_cb);
+
+    lspgen_enqueue_all_packets(ctx);
+    LOG(ERROR, "Requeued %u packets to %s\n", ctx->ctrl_stats.packets_queued, ctx->ctrl_socket_path);
+}
+
 static void
 lspgen_write_ctrl_buffer(lsdb_ctx_t *ctx)
 {
@@ -107,16 +126,7 @@ lspgen_write_ctrl_buffer(lsdb_ctx_t *ctx)
                 /*
                  * Remote has closed the connection. Restart.
                  */
-                timer_del(ctx->ctrl_socket_write_timer);
-                timer_add_periodic(&ctx->timer_root, &ctx->ctrl_socket_connect_timer,
-                                   "connect", 1, 0, ctx, &lspgen_ctrl_connect_cb);
-
-		/*
-		 * Requeue all packets to the change list.
-		 */
-		lspgen_enqueue_all_packets(ctx);
-		LOG(ERROR, "Requeued %u packets to %s\n", ctx->ctrl_stats.packets_queued, ctx->ctrl_socket_path);
-
+		lspgen_ctrl_restart(ctx);
 		return;
             default:
                 LOG(ERROR, "write(): error %s (%d)\n", strerror(errno), errno);
@@ -155,6 +165,22 @@ lspgen_write_ctrl_buffer(lsdb_ctx_t *ctx)
     }
 }
 
+/*
+ * Offset of the PDU in the generated packet.
+ */
+static uint32_t
+lspgen_ctrl_packet_offset(lsdb_ctx_t *ctx)
+{
+    if (ctx->protocol_id == PROTO_OSPF2) {
+        /* Omit the IPv4 header (the first 20 bytes). */
+        return 20;
+    } else if (ctx->protocol_id == PROTO_OSPF3) {
+        /* Omit the IPv6 header (the first 40 bytes). */
+        return 40;
+    }
+    return 0;
+}
+
 /*
  * Encode a packet as a hexdump.
  */
@@ -176,16 +202,8 @@ lspgen_ctrl_encode_packet(lsdb_ctx_t *ctx, lsdb_packet_t *packet)
     }
     push_be_uint(buf, 1, '"');
 
-    idx = 0;
-    if (ctx->protocol_id == PROTO_OSPF2) {
-        /* Omit the IPv4 header (the first 20 bytes). */
-        idx = 20;
-    } else if (ctx->protocol_id == PROTO_OSPF3) {
-        /* Omit the IPv6 header (the first 40 bytes). */
-        idx = 40;
-    }
-
     src_buf = &packet->buf[0];
+    idx = lspgen_ctrl_packet_offset(ctx);
     for (; idx < src_buf->idx; idx++) {
         hi_byte = src_buf->data[idx] >> 4;
         lo_byte = src_buf->data[idx] & 0xf;
@@ -245,6 +263,200 @@ lspgen_buffer_is_empty (lsdb_ctx_t *ctx) {
     }
 }
 
+/*
+ * Encode a packet as length prefixed binary frame.
+ */
+static void
+lspgen_ctrl_stream_encode_packet(lsdb_ctx_t *ctx, lsdb_packet_t *packet)
+{
+    struct io_buffer_ *src_buf;
+    uint32_t idx;
+
+    src_buf = &packet->buf[0];
+    idx = lspgen_ctrl_packet_offset(ctx);
+
+    push_be_uint(&ctx->ctrl_io_buf, 2, src_buf->idx - idx);
+    push_data(&ctx->ctrl_io_buf, src_buf->data + idx, src_buf->idx - idx);
+
+    ctx->ctrl_stats.packets_sent++;
+}
+
+/*
+ * Remote does not support the binary PDU stream.
+ * Reconnect and continue using JSON.
+ */
+static void
+lspgen_ctrl_stream_fallback(lsdb_ctx_t *ctx)
+{
+    LOG(NORMAL, "PDU stream not supported by %s, fallback to JSON\n", ctx->ctrl_socket_path);
+    ctx->ctrl_stream_state = CTRL_STREAM_DISABLED;
+
+    timer_del(ctx->ctrl_socket_write_timer);
+    close(ctx->ctrl_socket_sockfd);
+    ctx->ctrl_socket_sockfd = 0;
+    timer_add_periodic(&ctx->timer_root, &ctx->ctrl_socket_connect_timer,
+		       "connect", 1, 0, ctx, &lspgen_ctrl_connect_cb);
+}
+
+/*
+ * Read the response to the stream command and the batch acknowledgements.
+ * Returns false if the connection has been closed.
+ */
+static bool
+lspgen_ctrl_stream_read(lsdb_ctx_t *ctx)
+{
+    uint32_t pdus, errors, consumed;
+    char *eol;
+    int res;
+
+    while (1) {
+	res = recv(ctx->ctrl_socket_sockfd, ctx->ctrl_rx_buf + ctx->ctrl_rx_len,
+		   sizeof(ctx->ctrl_rx_buf) - ctx->ctrl_rx_len - 1, MSG_DONTWAIT);
+	if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+	    return true;
+	}
+	if (res <= 0) {
+	    if (ctx->ctrl_stream_state == CTRL_STREAM_PENDING) {
+		lspgen_ctrl_stream_fallback(ctx);
+	    } else {
+		lspgen_ctrl_restart(ctx);
+	    }
+	    return false;
+	}
+	ctx->ctrl_rx_len += res;
+
+	if (ctx->ctrl_stream_state == CTRL_STREAM_PENDING) {
+	    /*
+	     * The JSON response to the stream command is terminated by a newline.
+	     */
+	    ctx->ctrl_rx_buf[ctx->ctrl_rx_len] = 0;
+	    eol = strchr(ctx->ctrl_rx_buf, '\n');
+	    if (!eol) {
+		if (ctx->ctrl_rx_len >= sizeof(ctx->ctrl_rx_buf) - 1) {
+		    lspgen_ctrl_stream_fallback(ctx);
+		    return false;
+		}
+		continue;
+	    }
+	    *eol = 0;
+	    if (!strstr(ctx->ctrl_rx_buf, "\"ok\"")) {
+		lspgen_ctrl_stream_fallback(ctx);
+		return false;
+	    }
+	    LOG(NORMAL, "PDU stream to %s enabled\n", ctx->ctrl_socket_path);
+	    ctx->ctrl_stream_state = CTRL_STREAM_ENABLED;
+	    consumed = eol - ctx->ctrl_rx_buf + 1;
+	    ctx->ctrl_rx_len -= consumed;
+	    memmove(ctx->ctrl_rx_buf, eol + 1, ctx->ctrl_rx_len);
+	}
+
+	/*
+	 * Batch acknowledgements.
+	 */
+	consumed = 0;
+	while (ctx->ctrl_rx_len - consumed >= CTRL_STREAM_ACK_LEN) {
+	    pdus = read_be_uint((uint8_t *)ctx->ctrl_rx_buf + consumed, 4);
+	    errors = read_be_uint((uint8_t *)ctx->ctrl_rx_buf + consumed + 4, 4);
+	    consumed += CTRL_STREAM_ACK_LEN;
+
+	    if (ctx->ctrl_stream_batches) {
+		ctx->ctrl_stream_batches--;
+	    }
+	    ctx->ctrl_stats.packets_acked += pdus;
+	    ctx->ctrl_stats.packets_error += errors;
+	    if (errors) {
+		LOG(ERROR, "%u of %u packets rejected by %s\n", errors, pdus, ctx->ctrl_socket_path);
+	    }
+	    LOG(CTRL, "Batch of %u packets acknowledged by %s\n", pdus, ctx->ctrl_socket_path);
+	}
+	if (consumed) {
+	    ctx->ctrl_rx_len -= consumed;
+	    memmove(ctx->ctrl_rx_buf, ctx->ctrl_rx_buf + consumed, ctx->ctrl_rx_len);
+	}
+    }
+}
+
+/*
+ * Drain the change queue using the binary PDU stream.
+ *
+ * Packets are sent in batches of length prefixed frames, terminated
+ * by a zero length frame. Each batch is acknowledged by the
+ * BNG Blaster, where the number of unacknowledged batches is
+ * limited to CTRL_STREAM_WINDOW (flow control).
+ */
+static void
+lspgen_ctrl_stream_write(lsdb_ctx_t *ctx)
+{
+    struct lsdb_packet_ *packet;
+    uint32_t batch_start;
+
+    /*
+     * First flush the ctrl socket buffer.
+     */
+    lspgen_write_ctrl_buffer(ctx);
+    if (!ctx->ctrl_socket_sockfd) {
+	return;
+    }
+
+    if (!lspgen_ctrl_stream_read(ctx)) {
+	return;
+    }
+    if (ctx->ctrl_stream_state != CTRL_STREAM_ENABLED) {
+	/* wait for response */
+	return;
+    }
+
+    while (!CIRCLEQ_EMPTY(&ctx->packet_change_qhead) &&
+	   ctx->ctrl_stream_batches < CTRL_STREAM_WINDOW) {
+
+	if (ctx->ctrl_io_buf.size - ctx->ctrl_io_buf.idx < CTRL_STREAM_BATCH_SIZE) {
+	    break;
+	}
+
+	batch_start = ctx->ctrl_io_buf.idx;
+	while (!CIRCLEQ_EMPTY(&ctx->packet_change_qhead)) {
+	    packet = CIRCLEQ_FIRST(&ctx->packet_change_qhead);
+
+	    /* Reserve space for the frame and the end of batch marker. */
+	    if (ctx->ctrl_io_buf.idx - batch_start + packet->buf[0].idx + 4 > CTRL_STREAM_BATCH_SIZE) {
+		break;
+	    }
+	    lspgen_ctrl_stream_encode_packet(ctx, packet);
+
+	    CIRCLEQ_REMOVE(&ctx->packet_change_qhead, packet, packet_change_qnode);
+	    packet->on_change_list = false;
+	    ctx->ctrl_stats.packets_queued--;
+	}
+	push_be_uint(&ctx->ctrl_io_buf, 2, 0); /* end of batch */
+	ctx->ctrl_stream_batches++;
+    }
+
+    lspgen_write_ctrl_buffer(ctx);
+    if (!ctx->ctrl_socket_sockfd) {
+	return;
+    }
+
+    if (!CIRCLEQ_EMPTY(&ctx->packet_change_qhead) ||
+	ctx->ctrl_stream_batches ||
+	!lspgen_buffer_is_empty(ctx)) {
+	return;
+    }
+
+    /*
+     * Everything has been acknowledged.
+     */
+    timer_del(ctx->ctrl_socket_write_timer);
+
+    LOG(NORMAL, "Sent %u packets, %u bytes, %u errors to %s\n",
+	ctx->ctrl_stats.packets_sent,
+	ctx->ctrl_stats.octets_sent,
+	ctx->ctrl_stats.packets_error,
+	ctx->ctrl_socket_path);
+
+    timer_add(&ctx->timer_root, &ctx->ctrl_socket_close_timer, "close",
+	      1, 0, ctx, &lspgen_ctrl_close_cb);
+}
+
 void
 lspgen_ctrl_write_cb(timer_s *timer)
 {
@@ -255,6 +467,11 @@ lspgen_ctrl_write_cb(timer_s *timer)
 
     ctx = timer->data;
 
+    if (ctx->ctrl_stream_state != CTRL_STREAM_DISABLED) {
+	lspgen_ctrl_stream_write(ctx);
+	return;
+    }
+
     /*
      * First flush the ctrl socket buffer.
      */
@@ -348,6 +565,26 @@ lspgen_ctrl_wakeup_cb(__attribute__((unused))timer_s *timer)
 {
 }
 
+/*
+ * Request the binary PDU stream.
+ */
+static void
+lspgen_ctrl_stream_start(lsdb_ctx_t *ctx)
+{
+    char *command;
+
+    if (ctx->protocol_id == PROTO_ISIS) {
+	command = "{\"command\": \"isis-lsp-stream\", \"arguments\": {\"instance\": 1}}";
+    } else if (ctx->protocol_id == PROTO_OSPF2 || ctx->protocol_id == PROTO_OSPF3) {
+	command = "{\"command\": \"ospf-pdu-stream\", \"arguments\": {\"instance\": 1}}";
+    } else {
+	ctx->ctrl_stream_state = CTRL_STREAM_DISABLED;
+	return;
+    }
+    push_data(&ctx->ctrl_io_buf, (uint8_t *)command, strlen(command));
+    ctx->ctrl_stream_state = CTRL_STREAM_PENDING;
+}
+
 void
 lspgen_ctrl_connect_cb(timer_s *timer)
 {
@@ -399,6 +636,17 @@ lspgen_ctrl_connect_cb(timer_s *timer)
 	 */
 	ctx->ctrl_stats.octets_sent = 0;
 	ctx->ctrl_stats.packets_sent = 0;
+	ctx->ctrl_stats.packets_acked = 0;
+	ctx->ctrl_stats.packets_error = 0;
+
+	/*
+	 * Try the binary PDU stream first.
+	 */
+	ctx->ctrl_rx_len = 0;
+	ctx->ctrl_stream_batches = 0;
+	if (ctx->ctrl_stream_state != CTRL_STREAM_DISABLED) {
+	    lspgen_ctrl_stream_start(ctx);
+	}
 
         /*
          * Write header before the first packet.
@@ -71,99 +71,237 @@ init_array(int *a, int end)
     }
 }
 
-void
-print_graph(lsdb_ctx_t *ctx, int v, int e, int *adj_matrix)
+/*
+ * Sparse graph as list of edges with hashed
+ * duplicate detection, such that memory and
+ * run time are linear in nodes and edges.
+ */
+struct lsdb_graph_edge_ {
+    uint32_t a; /* local node number (1..v) */
+    uint32_t b; /* remote node number (1..v) */
+    uint32_t metric;
+};
+
+struct lsdb_graph_ {
+    struct lsdb_graph_edge_ *edge;
+    uint32_t edges;
+    uint32_t edges_max;
+
+    uint64_t *hash; /* open addressing, zero is empty */
+    uint32_t hash_size; /* power of 2 */
+};
+
+static inline uint64_t
+lsdb_graph_key(uint32_t a, uint32_t b)
 {
-    struct lsdb_node_ node_template;
-    struct lsdb_link_ link_template;
-    struct lsdb_node_ *local_node, *remote_node;
-    char node_name[32];
-    int i, j, index;
-    uint32_t link_index;
-    unsigned int root = 0;
-    __uint128_t addr;
+    if (a > b) {
+        return ((uint64_t)b << 32 | a);
+    }
+    return ((uint64_t)a << 32 | b);
+}
 
-    UNUSED(e);
+static inline uint32_t
+lsdb_graph_slot(uint64_t key, uint32_t hash_size)
+{
+    key *= 0x9e3779b97f4a7c15ULL;
+    return (uint32_t)(key >> 32) & (hash_size - 1);
+}
 
-    memset(&node_template, 0, sizeof(node_template));
-    memset(&link_template, 0, sizeof(link_template));
+static bool
+lsdb_graph_init(struct lsdb_graph_ *graph, uint32_t edges)
+{
+    memset(graph, 0, sizeof(*graph));
+    graph->edges_max = edges ? edges : 1;
+    graph->edge = calloc(graph->edges_max, sizeof(struct lsdb_graph_edge_));
+    graph->hash_size = 64;
+    while (graph->hash_size < graph->edges_max * 2) {
+        graph->hash_size <<= 1;
+    }
+    graph->hash = calloc(graph->hash_size, sizeof(uint64_t));
+    if (!graph->edge || !graph->hash) {
+        free(graph->edge);
+        free(graph->hash);
+        return false;
+    }
+    return true;
+}
 
-    for (i = 1; i < v; i++) {
-        for (j = i + 1; j <= v; j++) {
-            index = (i - 1) * v + j - 1;
-            if (adj_matrix[index]) {
+static void
+lsdb_graph_free(struct lsdb_graph_ *graph)
+{
+    free(graph->edge);
+    free(graph->hash);
+}
 
-            if (!root) {
-                root = i;
-            }
+static bool
+lsdb_graph_has_edge(struct lsdb_graph_ *graph, uint32_t a, uint32_t b)
+{
+    uint64_t key = lsdb_graph_key(a, b);
+    uint32_t slot = lsdb_graph_slot(key, graph->hash_size);
 
-            /*
-             * Add local node.
-             */
-            addr = lspgen_load_addr((uint8_t*)&ctx->ipv4_node_prefix.address, sizeof(ipv4addr_t)) + i - 1;
-	    if (ctx->protocol_id == PROTO_ISIS) {
-		lspgen_store_bcd_addr(addr, node_template.key.node_id, 4);
-	    } else if (ctx->protocol_id == PROTO_OSPF2 || ctx->protocol_id == PROTO_OSPF3) {
-		lspgen_store_addr(addr, node_template.key.node_id, 4);
-	    }
-	    snprintf(node_name, sizeof(node_name), "node%u", i);
-            node_template.node_name = node_name;
-            local_node = lsdb_add_node(ctx, &node_template);
+    while (graph->hash[slot]) {
+        if (graph->hash[slot] == key) {
+            return true;
+        }
+        slot = (slot + 1) & (graph->hash_size - 1);
+    }
+    return false;
+}
 
-            /*
-             * Add remote node.
-             */
-            addr = lspgen_load_addr((uint8_t*)&ctx->ipv4_node_prefix.address, sizeof(ipv4addr_t)) + j - 1;
-	    if (ctx->protocol_id == PROTO_ISIS) {
-		lspgen_store_bcd_addr(addr, node_template.key.node_id, 4);
-	    } else if (ctx->protocol_id == PROTO_OSPF2 || ctx->protocol_id == PROTO_OSPF3) {
-		lspgen_store_addr(addr, node_template.key.node_id, 4);
-	    }
-	    snprintf(node_name, sizeof(node_name), "node%u", j);
-            node_template.node_name = node_name;
-            remote_node = lsdb_add_node(ctx, &node_template);
-
-	    for (link_index = 0; link_index < ctx->link_multiplier; link_index++) {
-
-		/*
-		 * Add outgoing link.
-		 */
-		link_template.link_metric = weights[adj_matrix[index]];
-		addr = lspgen_load_addr((uint8_t*)&ctx->ipv4_node_prefix.address, sizeof(ipv4addr_t)) + i - 1;
-		if (ctx->protocol_id == PROTO_ISIS) {
-		    lspgen_store_bcd_addr(addr, link_template.key.local_node_id, 4);
-		} else if (ctx->protocol_id == PROTO_OSPF2 || ctx->protocol_id == PROTO_OSPF3) {
-		    lspgen_store_addr(addr, link_template.key.local_node_id, 4);
-		}
-		addr = lspgen_load_addr((uint8_t*)&ctx->ipv4_node_prefix.address, sizeof(ipv4addr_t)) + j - 1;
-		if (ctx->protocol_id == PROTO_ISIS) {
-		    lspgen_store_bcd_addr(addr, link_template.key.remote_node_id, 4);
-		} else if (ctx->protocol_id == PROTO_OSPF2 || ctx->protocol_id == PROTO_OSPF3) {
-		    lspgen_store_addr(addr, link_template.key.remote_node_id, 4);
-		}
-		lspgen_store_addr(link_index, link_template.key.local_link_id, 4);
-		lsdb_add_link(ctx, local_node, &link_template);
-
-		/*
-		 * Add incoming link.
-		 */
-		addr = lspgen_load_addr((uint8_t*)&ctx->ipv4_node_prefix.address, sizeof(ipv4addr_t)) + j - 1;
-		if (ctx->protocol_id == PROTO_ISIS) {
-		    lspgen_store_bcd_addr(addr, link_template.key.local_node_id, 4);
-		} else if (ctx->protocol_id == PROTO_OSPF2 || ctx->protocol_id == PROTO_OSPF3) {
-		    lspgen_store_addr(addr, link_template.key.local_node_id, 4);
-		}
-		addr = lspgen_load_addr((uint8_t*)&ctx->ipv4_node_prefix.address, sizeof(ipv4addr_t)) + i - 1;
-		if (ctx->protocol_id == PROTO_ISIS) {
-		    lspgen_store_bcd_addr(addr, link_template.key.remote_node_id, 4);
-		} else if (ctx->protocol_id == PROTO_OSPF2 || ctx->protocol_id == PROTO_OSPF3) {
-		    lspgen_store_addr(addr, link_template.key.remote_node_id, 4);
-		}
-		lspgen_store_addr(link_index, link_template.key.local_link_id, 4);
-		lsdb_add_link(ctx, remote_node, &link_template);
+/*
+ * Add an edge between node a and b unless a == b or the edge exists.
+ * Returns true if the edge was added.
+ */
+static bool
+lsdb_graph_add_edge(struct lsdb_graph_ *graph, uint32_t a, uint32_t b, uint32_t metric)
+{
+    struct lsdb_graph_edge_ *edge;
+    uint64_t key, *hash;
+    uint32_t slot, idx, hash_size;
+
+    if (a == b || lsdb_graph_has_edge(graph, a, b)) {
+        return false;
+    }
+
+    if (graph->edges == graph->edges_max) {
+        edge = realloc(graph->edge, graph->edges_max * 2 * sizeof(struct lsdb_graph_edge_));
+        if (!edge) {
+            return false;
+        }
+        graph->edge = edge;
+        graph->edges_max *= 2;
+    }
+
+    /*
+     * Keep the hash table at most half full.
+     */
+    if (graph->edges + 1 > graph->hash_size / 2) {
+        hash_size = graph->hash_size * 2;
+        hash = calloc(hash_size, sizeof(uint64_t));
+        if (!hash) {
+            return false;
+        }
+        for (idx = 0; idx < graph->hash_size; idx++) {
+            if (!graph->hash[idx]) {
+                continue;
+            }
+            slot = lsdb_graph_slot(graph->hash[idx], hash_size);
+            while (hash[slot]) {
+                slot = (slot + 1) & (hash_size - 1);
             }
-	    }
+            hash[slot] = graph->hash[idx];
         }
+        free(graph->hash);
+        graph->hash = hash;
+        graph->hash_size = hash_size;
+    }
+
+    key = lsdb_graph_key(a, b);
+    slot = lsdb_graph_slot(key, graph->hash_size);
+    while (graph->hash[slot]) {
+        slot = (slot + 1) & (graph->hash_size - 1);
+    }
+    graph->hash[slot] = key;
+
+    edge = &graph->edge[graph->edges++];
+    edge->a = a < b ? a : b;
+    edge->b = a < b ? b : a;
+    edge->metric = metric;
+    return true;
+}
+
+static int
+lsdb_graph_compare_edge(const void *p1, const void *p2)
+{
+    const struct lsdb_graph_edge_ *e1 = p1;
+    const struct lsdb_graph_edge_ *e2 = p2;
+
+    if (e1->a != e2->a) {
+        return e1->a < e2->a ? -1 : 1;
+    }
+    if (e1->b != e2->b) {
+        return e1->b < e2->b ? -1 : 1;
+    }
+    return 0;
+}
+
+static void
+lsdb_graph_store_node_id(lsdb_ctx_t *ctx, uint32_t node, uint8_t *node_id)
+{
+    __uint128_t addr;
+
+    addr = lspgen_load_addr((uint8_t*)&ctx->ipv4_node_prefix.address, sizeof(ipv4addr_t)) + node - 1;
+    if (ctx->protocol_id == PROTO_ISIS) {
+	lspgen_store_bcd_addr(addr, node_id, 4);
+    } else if (ctx->protocol_id == PROTO_OSPF2 || ctx->protocol_id == PROTO_OSPF3) {
+	lspgen_store_addr(addr, node_id, 4);
+    }
+}
+
+static struct lsdb_node_ *
+lsdb_graph_add_node(lsdb_ctx_t *ctx, uint32_t node)
+{
+    struct lsdb_node_ node_template;
+    char node_name[32];
+
+    memset(&node_template, 0, sizeof(node_template));
+    lsdb_graph_store_node_id(ctx, node, node_template.key.node_id);
+    snprintf(node_name, sizeof(node_name), "node%u", node);
+    node_template.node_name = node_name;
+    return lsdb_add_node(ctx, &node_template);
+}
+
+/*
+ * Add all nodes and links of the graph to the LSDB. Edges are added
+ * in ascending order of node numbers, such that node and link indexes
+ * do not depend on the order in which the edges have been generated.
+ */
+static void
+print_graph(lsdb_ctx_t *ctx, struct lsdb_graph_ *graph)
+{
+    struct lsdb_link_ link_template;
+    struct lsdb_node_ *local_node, *remote_node;
+    struct lsdb_graph_edge_ *edge;
+    uint32_t idx, link_index;
+    unsigned int root = 0;
+    __uint128_t addr;
+
+    memset(&link_template, 0, sizeof(link_template));
+
+    qsort(graph->edge, graph->edges, sizeof(struct lsdb_graph_edge_), lsdb_graph_compare_edge);
+
+    for (idx = 0; idx < graph->edges; idx++) {
+	edge = &graph->edge[idx];
+
+	if (!root) {
+	    root = edge->a;
+	}
+
+	/*
+	 * Add local and remote node.
+	 */
+	local_node = lsdb_graph_add_node(ctx, edge->a);
+	remote_node = lsdb_graph_add_node(ctx, edge->b);
+
+	for (link_index = 0; link_index < ctx->link_multiplier; link_index++) {
+
+	    /*
+	     * Add outgoing link.
+	     */
+	    link_template.link_metric = edge->metric;
+	    lsdb_graph_store_node_id(ctx, edge->a, link_template.key.local_node_id);
+	    lsdb_graph_store_node_id(ctx, edge->b, link_template.key.remote_node_id);
+	    lspgen_store_addr(link_index, link_template.key.local_link_id, 4);
+	    lsdb_add_link(ctx, local_node, &link_template);
+
+	    /*
+	     * Add incoming link.
+	     */
+	    lsdb_graph_store_node_id(ctx, edge->b, link_template.key.local_node_id);
+	    lsdb_graph_store_node_id(ctx, edge->a, link_template.key.remote_node_id);
+	    lspgen_store_addr(link_index, link_template.key.local_link_id, 4);
+	    lsdb_add_link(ctx, remote_node, &link_template);
+	}
     }
 
     /*
@@ -185,8 +323,7 @@ print_graph(lsdb_ctx_t *ctx, int v, int e, int *adj_matrix)
 /*
  * This function generates a random connected simple graph with v vertices and max(v-1,e) edges.  The graph can be
  * weighted (weight_flag == 1) or unweighted (weight_flag != 1). If it is weighted, the weights are in the range 1 to
- * max_wgt. It is assumed that e <= v(v-1)/2. (In this program, this assured because of the call to
- * fix_imbalanced_graph.)
+ * max_wgt. It is assumed that e <= v(v-1)/2.
  *
  * To generate a random connected graph, we begin by generating a random spanning tree.  To generate a random spanning
  * tree, we first generate a random permutation tree[0],...,tree[v-1]. (v = number of vertices.) We then iteratively
@@ -194,22 +331,30 @@ print_graph(lsdb_ctx_t *ctx, int v, int e, int *adj_matrix)
  * we assume that tree[0],tree[1],...,tree[i-1] are in the tree.  We then add vertex tree[i] to the tree by adding the
  * edge (tree[i],tree[rand(i)]). (This construction is similar to that of Prim's algorithm.) Finally, we add random
  * edges to produce the desired number of edges.
+ *
+ * Edges are stored in a sparse edge list instead of an adjacency matrix, which results in the same graph for the
+ * same seed using O(v+e) instead of O(v*v) memory.
  */
 static void
 lsdb_random_connected_graph(lsdb_ctx_t *ctx, int v, int e, int max_wgt, int weight_flag)
 {
-    int i, j, count, index, *adj_matrix, *tree;
+    struct lsdb_graph_ graph;
+    int i, j, count, *tree;
+
+    if ((long)e > (long)v * (v - 1) / 2) {
+        e = (long)v * (v - 1) / 2;
+    }
 
     LOG(NORMAL, "Generating a graph of %d nodes and %d links\n", v, e);
 
-    if ((adj_matrix = (int *) calloc(v * v, sizeof(int))) == NULL) {
-        LOG(ERROR, "Not enough room for %d nodes %d links  graph\n", v, e);
+    if (!lsdb_graph_init(&graph, e)) {
+        LOG(ERROR, "Not enough room for %d nodes %d links graph\n", v, e);
         return;
     }
 
     if ((tree = (int *) calloc(v, sizeof(int))) == NULL) {
         LOG(ERROR, "Not enough room for %d nodes %d links graph\n", v, e);
-        free(adj_matrix);
+        lsdb_graph_free(&graph);
         return;
     }
 
@@ -227,7 +372,7 @@ lsdb_random_connected_graph(lsdb_ctx_t *ctx, int v, int e, int max_wgt, int weig
      */
     for (i = 1; i < v; i++) {
         j = ran(i);
-        adj_matrix[tree[i] * v + tree[j]] = adj_matrix[tree[j] * v + tree[i]] = weight_flag ? 1 + ran(max_wgt) : 1;
+        lsdb_graph_add_edge(&graph, tree[i] + 1, tree[j] + 1, weights[weight_flag ? 1 + ran(max_wgt) : 1]);
     }
 
     /*
@@ -240,20 +385,209 @@ lsdb_random_connected_graph(lsdb_ctx_t *ctx, int v, int e, int max_wgt, int weig
         if (i == j)
             continue;
 
-        if (i > j)
-            swap(&i, &j);
-
-        index = i * v + j;
-        if (!adj_matrix[index]) {
-            adj_matrix[index] = weight_flag ? 1 + ran(max_wgt) : 1;
+        if (!lsdb_graph_has_edge(&graph, i + 1, j + 1)) {
+            lsdb_graph_add_edge(&graph, i + 1, j + 1, weights[weight_flag ? 1 + ran(max_wgt) : 1]);
             count++;
         }
     }
 
-    print_graph(ctx, v, count, adj_matrix);
+    print_graph(ctx, &graph);
 
     free(tree);
-    free(adj_matrix);
+    lsdb_graph_free(&graph);
+}
+
+/*
+ * Generate a folded three stage Clos (fat-tree) topology. The nodes are split into
+ * super-spine planes and pods, where each pod consists of one spine per plane and
+ * leaves connected to all spines of the pod. The spine of plane p in each pod
+ * connects to all super-spines of plane p.
+ */
+static void
+lsdb_clos_graph(lsdb_ctx_t *ctx, uint32_t v)
+{
+    struct lsdb_graph_ graph;
+    uint32_t planes, super_per_plane, leaves_per_pod, pod_size, spines;
+    uint32_t node, pod_base, spine, leaf, plane, idx;
+
+    /*
+     * Scale the fabric width with the number of nodes.
+     */
+    if (v < 100) {
+        planes = 2;
+    } else if (v < 10000) {
+        planes = 4;
+    } else {
+        planes = 8;
+    }
+    super_per_plane = planes / 2;
+    leaves_per_pod = planes * 4;
+    pod_size = planes + leaves_per_pod;
+
+    if (v <= planes * super_per_plane) {
+        LOG(ERROR, "Clos graph requires more than %u nodes\n", planes * super_per_plane);
+        return;
+    }
+
+    LOG(NORMAL, "Generating a clos graph of %u nodes, %u planes, %u super-spines per plane, "
+        "%u leaves per pod\n", v, planes, super_per_plane, leaves_per_pod);
+
+    if (!lsdb_graph_init(&graph, v * planes)) {
+        LOG(ERROR, "Not enough room for %u nodes clos graph\n", v);
+        return;
+    }
+
+    /*
+     * Super-spines are numbered 1 .. planes * super_per_plane,
+     * followed by the pods with spines first and leaves last.
+     */
+    node = planes * super_per_plane + 1;
+    while (node <= v) {
+        pod_base = node;
+        if (v - pod_base + 1 <= planes && node > planes * super_per_plane + 1) {
+            /*
+             * Not enough nodes left for another pod,
+             * attach the remaining nodes as leaves to the last pod.
+             */
+            pod_base -= pod_size;
+            for (leaf = node; leaf <= v; leaf++) {
+                for (plane = 0; plane < planes; plane++) {
+                    lsdb_graph_add_edge(&graph, pod_base + plane, leaf, weights[3]);
+                }
+            }
+            break;
+        }
+
+        /*
+         * The first pod may be partial with less spines than planes,
+         * where the super-spines of planes without spine are connected
+         * to the spine of another plane.
+         */
+        spines = v - pod_base + 1;
+        if (spines > planes) {
+            spines = planes;
+        }
+        for (plane = 0; plane < planes; plane++) {
+            spine = pod_base + (plane % spines);
+            for (idx = 0; idx < super_per_plane; idx++) {
+                lsdb_graph_add_edge(&graph, plane * super_per_plane + idx + 1, spine, weights[3]);
+            }
+        }
+        for (leaf = pod_base + planes; leaf < pod_base + pod_size && leaf <= v; leaf++) {
+            for (plane = 0; plane < planes; plane++) {
+                lsdb_graph_add_edge(&graph, pod_base + plane, leaf, weights[3]);
+            }
+        }
+        node = pod_base + pod_size;
+    }
+
+    print_graph(ctx, &graph);
+    lsdb_graph_free(&graph);
+}
+
+/*
+ * Generate a ring of rings topology. The nodes are split into access rings of
+ * roughly sqrt(v) nodes. The first node of each access ring is part of the core
+ * ring, which connects all access rings. Core links have a lower metric.
+ */
+static void
+lsdb_ring_graph(lsdb_ctx_t *ctx, uint32_t v)
+{
+    struct lsdb_graph_ graph;
+    uint32_t ring_size, rings, ring, first, last, node;
+
+    ring_size = 3;
+    while (ring_size * ring_size < v) {
+        ring_size++;
+    }
+    rings = (v + ring_size - 1) / ring_size;
+
+    LOG(NORMAL, "Generating a ring graph of %u nodes, %u rings of %u nodes\n", v, rings, ring_size);
+
+    if (!lsdb_graph_init(&graph, v + rings)) {
+        LOG(ERROR, "Not enough room for %u nodes ring graph\n", v);
+        return;
+    }
+
+    for (ring = 0; ring < rings; ring++) {
+        first = ring * ring_size + 1;
+        last = first + ring_size - 1;
+        if (last > v) {
+            last = v;
+        }
+        for (node = first; node < last; node++) {
+            lsdb_graph_add_edge(&graph, node, node + 1, weights[3]);
+        }
+        if (last - first > 1) {
+            lsdb_graph_add_edge(&graph, last, first, weights[3]);
+        }
+
+        /*
+         * Core ring.
+         */
+        if (rings > 1) {
+            lsdb_graph_add_edge(&graph, first, ((ring + 1) % rings) * ring_size + 1, weights[0]);
+        }
+    }
+
+    print_graph(ctx, &graph);
+    lsdb_graph_free(&graph);
+}
+
+/*
+ * Generate a scale-free (power-law) topology using Barabasi-Albert preferential
+ * attachment. Each new node connects to m existing nodes, where the probability
+ * of selecting a node is proportional to its degree. Selection is done by picking
+ * a random endpoint of all edges added so far.
+ */
+static void
+lsdb_power_law_graph(lsdb_ctx_t *ctx, uint32_t v, uint32_t m, int max_wgt)
+{
+    struct lsdb_graph_ graph;
+    uint32_t *endpoint, endpoints, node, target, added, tries;
+
+    LOG(NORMAL, "Generating a power-law graph of %u nodes, %u links per node\n", v, m);
+
+    if (!lsdb_graph_init(&graph, v * m)) {
+        LOG(ERROR, "Not enough room for %u nodes power-law graph\n", v);
+        return;
+    }
+    endpoint = calloc(v * m * 2, sizeof(uint32_t));
+    if (!endpoint) {
+        LOG(ERROR, "Not enough room for %u nodes power-law graph\n", v);
+        lsdb_graph_free(&graph);
+        return;
+    }
+    endpoints = 0;
+
+    /*
+     * Start with a full mesh of m + 1 nodes,
+     * or all nodes if there are not more.
+     */
+    for (node = 1; node <= m + 1 && node <= v; node++) {
+        for (target = 1; target < node; target++) {
+            lsdb_graph_add_edge(&graph, node, target, weights[1 + ran(max_wgt)]);
+            endpoint[endpoints++] = node;
+            endpoint[endpoints++] = target;
+        }
+    }
+
+    for (node = m + 2; node <= v; node++) {
+        added = 0;
+        for (tries = 0; added < m && tries < m * 16; tries++) {
+            target = endpoint[ran(endpoints)];
+            if (lsdb_graph_add_edge(&graph, node, target, weights[1 + ran(max_wgt)])) {
+                endpoint[endpoints++] = node;
+                endpoint[endpoints++] = target;
+                added++;
+            }
+        }
+    }
+
+    print_graph(ctx, &graph);
+
+    free(endpoint);
+    lsdb_graph_free(&graph);
 }
 
 void
@@ -266,8 +600,22 @@ lsdb_init_graph(lsdb_ctx_t *ctx)
 
     srand(ctx->seed);
 
-    lsdb_random_connected_graph(ctx, ctx->num_nodes, ctx->num_nodes << 1,
-                sizeof(weights) / sizeof(int) - 1, 1);
+    switch (ctx->topology) {
+    case TOPOLOGY_CLOS:
+	lsdb_clos_graph(ctx, ctx->num_nodes);
+	break;
+    case TOPOLOGY_RING:
+	lsdb_ring_graph(ctx, ctx->num_nodes);
+	break;
+    case TOPOLOGY_POWER_LAW:
+	lsdb_power_law_graph(ctx, ctx->num_nodes, 2, sizeof(weights) / sizeof(int) - 1);
+	break;
+    case TOPOLOGY_RANDOM: /* fall through */
+    default:
+	lsdb_random_connected_graph(ctx, ctx->num_nodes, ctx->num_nodes << 1,
+				    sizeof(weights) / sizeof(int) - 1, 1);
+	break;
+    }
 
     /*
      * First lookup the root node.
@@ -29,6 +29,14 @@ typedef enum {
     PROTO_OSPF3 = 3
 } lsdb_proto_id_t;
 
+typedef enum {
+    TOPOLOGY_UNKNOWN = 0,
+    TOPOLOGY_RANDOM = 1,
+    TOPOLOGY_CLOS = 2,
+    TOPOLOGY_RING = 3,
+    TOPOLOGY_POWER_LAW = 4
+} lsdb_topology_t;
+
 typedef struct lsdb_node_id_ {
     uint8_t local_link_id[LSDB_MAX_NODE_ID_SIZE];
     uint8_t remote_node_id[LSDB_MAX_NODE_ID_SIZE];
@@ -63,6 +71,7 @@ typedef struct lsdb_ctx_
      * Generator related.
      */
     uint32_t num_nodes;
+    lsdb_topology_t topology; /* e.g. "random, clos, ring, power-law" */
     ipv4_prefix ipv4_node_prefix;
     ipv4_prefix ipv4_link_prefix;
     ipv4_prefix ipv4_ext_prefix;
@@ -108,10 +117,23 @@ typedef struct lsdb_ctx_
     int ctrl_socket_sockfd;
     bool ctrl_packet_first;
     bool quit_loop; /* Terminate loop after draining the LSDB */
+
+    /* Binary PDU stream, JSON is used as fallback */
+    enum {
+	CTRL_STREAM_PENDING,	/* stream command sent, waiting for response */
+	CTRL_STREAM_ENABLED,
+	CTRL_STREAM_DISABLED	/* not supported by remote */
+    } ctrl_stream_state;
+    uint32_t ctrl_stream_batches; /* # unacknowledged batches */
+    uint32_t ctrl_rx_len;
+    char ctrl_rx_buf[256];
+
     struct {
     uint32_t octets_sent;
     uint32_t packets_sent;
     uint32_t packets_queued;    /* # packets on the change_list */
+    uint32_t packets_acked;     /* # packets acknowledged via stream */
+    uint32_t packets_error;     /* # packets rejected via stream */
     } ctrl_stats;
 
     char *graphviz_filename;    /* File name for dumping LSDB in graphviz format. */